@@ -0,0 +1,171 @@
+#pragma once
+
+/*
+**  Copyright(C) 2019, StepToSky and FlightFactor
+**  All rights reserved
+**
+**  Redistribution and use in source and binary forms, with or without
+**  modification, are permitted provided that the following conditions are met:
+**
+**  1.Redistributions of source code must retain the above copyright notice, this
+**    list of conditions and the following disclaimer.
+**  2.Redistributions in binary form must reproduce the above copyright notice,
+**    this list of conditions and the following disclaimer in the documentation
+**    and / or other materials provided with the distribution.
+**  3.The name of StepToSky or the name of FlightFactor or the names of its
+**    contributors may NOT be used to endorse or promote products derived from
+**    this software without specific prior written permission.
+**
+**  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+**  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+**  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+**  DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+**  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+**  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+**  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+**  ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+**  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+**  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**
+**  Contacts: www.steptosky.com or www.flightfactor.aero
+*/
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include "stsff/logging/BaseLogger.h"
+#include "stsff/logging/FormatPattern.h"
+
+/**************************************************************************************************/
+////////////////////////////////////////////////////////////////////////////////////////////////////
+/**************************************************************************************************/
+
+namespace stsff {
+namespace logging {
+
+    /*!
+     * \brief Level handler that writes the messages to a file asynchronously with several buffers in flight.
+     * \details The messages are copied into the current buffer, the full buffer is submitted for writing
+     *          and the next free one becomes the current, so the thread waits for a write to complete
+     *          only when all the buffers are in flight.
+     * \details On Linux the buffers are written through io_uring (the system calls are used directly,
+     *          without the outside libraries), the completions are collected by the logging threads
+     *          when they submit the next buffers. If the kernel doesn't support io_uring,
+     *          and on the other systems, a background thread writes the submitted buffers.
+     * \details The buffers are written with the explicit file offsets, so the several writes in flight
+     *          keep the messages order.
+     * \details The copies of the sink share the file and the buffers, the buffers are written
+     *          and waited for when the last copy is destroyed. The errors are printed to std::cerr.
+     * \code
+     * AsyncFileSink sink("app.log", "%TM(%Y-%m-%d %T.%3N) %LN %MC %MS");
+     * logger.setHandler(BaseLogger::LvlInfo, sink);
+     * \endcode
+     */
+    class AsyncFileSink {
+    public:
+
+        typedef BaseLogger::FlushPolicy FlushPolicy;
+
+        static const std::size_t DefaultBufferSize = 256 * 1024;
+        static const std::size_t DefaultBufferCount = 4;
+
+        enum eBackend {
+            BackendAuto,   //!< io_uring if it is available and the thread otherwise.
+            BackendThread, //!< The background thread.
+        };
+
+        //---------------------------------------------------------------
+        /// @{
+
+        /*!
+         * \details Opens the file for appending, the file is created if it doesn't exist.
+         * \param [in] fileName
+         * \param [in] pattern see \link BaseLogger::defaultHandler \endlink
+         * \param [in] bufferSize
+         * \param [in] bufferCount at least 2.
+         * \param [in] backend
+         */
+        LoggingExp AsyncFileSink(const std::string & fileName, const FormatPattern & pattern,
+                                 std::size_t bufferSize = DefaultBufferSize,
+                                 std::size_t bufferCount = DefaultBufferCount,
+                                 eBackend backend = BackendAuto);
+
+        /*!
+         * \param [in] fileName
+         * \param [in] formatting see \link BaseLogger::defaultHandler \endlink
+         * \param [in] bufferSize
+         * \param [in] bufferCount at least 2.
+         * \param [in] backend
+         */
+        AsyncFileSink(const std::string & fileName, const std::string & formatting,
+                      const std::size_t bufferSize = DefaultBufferSize,
+                      const std::size_t bufferCount = DefaultBufferCount,
+                      const eBackend backend = BackendAuto)
+            : AsyncFileSink(fileName, FormatPattern(formatting), bufferSize, bufferCount, backend) {}
+
+        AsyncFileSink(const AsyncFileSink &) = default;
+        AsyncFileSink(AsyncFileSink &&) = default;
+        AsyncFileSink & operator=(const AsyncFileSink &) = default;
+        AsyncFileSink & operator=(AsyncFileSink &&) = default;
+
+        ~AsyncFileSink() = default;
+
+        /// @}
+        //---------------------------------------------------------------
+        /// @{
+
+        /*!
+         * \details Writes the message, it has the signature of \link BaseLogger::LevelHandler \endlink
+         * \param [in] logger
+         * \param [in] logMsg
+         */
+        LoggingExp void operator()(const BaseLogger & logger, const BaseLogger::LogMsg & logMsg) const;
+
+        /*!
+         * \details Submits the current buffer and waits until all the buffers are written.
+         */
+        LoggingExp void flush() const noexcept;
+
+        /*!
+         * \details When the current buffer is submitted before it is full, the submission is not waited for.
+         *          Default is \link BaseLogger::FlushPolicy::never \endlink, so only the critical messages
+         *          are submitted at once.
+         * \param [in] policy
+         */
+        LoggingExp void setFlushPolicy(const FlushPolicy & policy) noexcept;
+
+        /// @}
+        //---------------------------------------------------------------
+        /// @{
+
+        LoggingExp const std::string & fileName() const noexcept;
+        LoggingExp bool isOpen() const noexcept;
+
+        /*!
+         * \return True if the buffers are written through io_uring.
+         */
+        LoggingExp bool usesIoUring() const noexcept;
+
+        /*!
+         * \return Number of the bytes whose writing is completed.
+         */
+        LoggingExp std::uint64_t written() const noexcept;
+
+        /// @}
+        //---------------------------------------------------------------
+
+    private:
+
+        class File;
+
+        std::shared_ptr<File> mFile;
+
+    };
+
+    /**************************************************************************************************/
+    ////////////////////////////////////////////////////////////////////////////////////////////////////
+    /**************************************************************************************************/
+
+}
+}
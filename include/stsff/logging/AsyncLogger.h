@@ -0,0 +1,275 @@
+#pragma once
+
+/*
+**  Copyright(C) 2019, StepToSky and FlightFactor
+**  All rights reserved
+**
+**  Redistribution and use in source and binary forms, with or without
+**  modification, are permitted provided that the following conditions are met:
+**
+**  1.Redistributions of source code must retain the above copyright notice, this
+**    list of conditions and the following disclaimer.
+**  2.Redistributions in binary form must reproduce the above copyright notice,
+**    this list of conditions and the following disclaimer in the documentation
+**    and / or other materials provided with the distribution.
+**  3.The name of StepToSky or the name of FlightFactor or the names of its
+**    contributors may NOT be used to endorse or promote products derived from
+**    this software without specific prior written permission.
+**
+**  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+**  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+**  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+**  DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+**  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+**  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+**  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+**  ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+**  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+**  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**
+**  Contacts: www.steptosky.com or www.flightfactor.aero
+*/
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "BaseLogger.h"
+#include "internal/AsyncQueue.h"
+#include "internal/ThreadRing.h"
+
+/**************************************************************************************************/
+////////////////////////////////////////////////////////////////////////////////////////////////////
+/**************************************************************************************************/
+
+namespace stsff {
+namespace logging {
+
+    /*!
+     * \brief Logger that calls the level handlers on its own thread.
+     * \details \link AsyncLogger::log \endlink copies the message (text, category, code location,
+     *          level and the time of the call) into the bounded lock-free queue
+     *          and the worker thread passes it to the handlers, so a slow stream doesn't stall the callers.
+     * \details What happens when the queue is full is defined by \link AsyncLogger::eOverflow \endlink policy,
+     *          by default the caller waits until the worker frees a place.
+     *          The dropped messages are counted and the worker periodically reports them
+     *          with a \link BaseLogger::LvlWarning \endlink message, see \link AsyncLogger::setDropReportInterval \endlink
+     * \details The messages logged by the handlers themselves are handled immediately.
+     * \details The handlers are called from the worker thread
+     *          so they should be set before the logger is used from the other threads.
+     * \details The destructor handles all the queued messages.
+     * \details By default all the threads use one queue,
+     *          see \link AsyncLogger::QueuePerThread \endlink for the many threads that log intensively.
+     * \code
+     * AsyncLogger logger("my logger");
+     * LMessage(logger) << "my message";
+     * logger.flush(); // waits until the message is printed
+     * // during a log storm drop the messages that are less important than the errors
+     * logger.setOverflowPolicy(AsyncLogger::OverflowDropBelowLevel, BaseLogger::LvlError);
+     * \endcode
+     */
+    class AsyncLogger : public BaseLogger {
+    public:
+
+        static const std::size_t DefaultQueueSize = 8192;
+        static const std::size_t DefaultThreadBufferSize = 256 * 1024;
+
+        //---------------------------------------------------------------
+        /// @{
+
+        /*!
+         * \brief What the logger does with a new message when the queue is full.
+         */
+        enum eOverflow {
+            OverflowBlock,          //!< the caller waits until the worker frees a place.
+            OverflowDropNewest,     //!< the new message is dropped.
+            OverflowDropOldest,     //!< the oldest queued message is dropped to free the place, the new one is dropped if the oldest one can't be.
+            OverflowDropBelowLevel, //!< the new message is dropped if its level is less important than the specified one, otherwise the caller waits.
+        };
+
+        /*!
+         * \brief The way the messages are passed to the worker thread.
+         */
+        enum eQueue {
+            /*!
+             * One lock-free queue for all the threads.
+             */
+            QueueShared,
+            /*!
+             * Each thread has its own buffer, so the threads don't compete for the queue.
+             * The buffer is created when the thread logs first time and it is released after the thread exits.
+             * The worker merges the messages of the threads by their time.
+             * \note \link AsyncLogger::OverflowDropOldest \endlink works as \link AsyncLogger::OverflowDropNewest \endlink
+             *       in this mode because only the worker can remove the messages from the thread's buffer.
+             */
+            QueuePerThread,
+        };
+
+        /// @}
+        //---------------------------------------------------------------
+        /// @{
+
+        /*!
+         * \details Starts the worker thread, the handlers are the same as \link BaseLogger \endlink has.
+         * \param [in] name
+         * \param [in] queueSize maximum number of the queued messages, it is rounded up to the power of 2.
+         */
+        LoggingExp explicit AsyncLogger(StringView name = StringView(), std::size_t queueSize = DefaultQueueSize);
+
+        /*!
+         * \details Starts the worker thread.
+         * \param [in] name
+         * \param [in] levelsConf
+         * \param [in] queueSize maximum number of the queued messages, it is rounded up to the power of 2.
+         */
+        LoggingExp AsyncLogger(StringView name, LevelHandlers levelsConf, std::size_t queueSize = DefaultQueueSize);
+
+        /*!
+         * \details Starts the worker thread, the handlers are the same as \link BaseLogger \endlink has.
+         * \param [in] name
+         * \param [in] queue
+         * \param [in] size for \link AsyncLogger::QueueShared \endlink it is maximum number of the queued messages,
+         *                  for \link AsyncLogger::QueuePerThread \endlink it is the size of each thread's buffer in bytes.
+         *                  It is rounded up to the power of 2.
+         */
+        LoggingExp AsyncLogger(StringView name, eQueue queue, std::size_t size);
+
+        /*!
+         * \details Starts the worker thread.
+         * \param [in] name
+         * \param [in] levelsConf
+         * \param [in] queue
+         * \param [in] size see \link AsyncLogger::AsyncLogger(StringView, eQueue, std::size_t) \endlink
+         */
+        LoggingExp AsyncLogger(StringView name, LevelHandlers levelsConf, eQueue queue, std::size_t size);
+
+        /*!
+         * \details Handles all the queued messages and stops the worker thread.
+         */
+        LoggingExp virtual ~AsyncLogger() noexcept;
+
+        AsyncLogger(const AsyncLogger &) = delete;
+        AsyncLogger(AsyncLogger &&) = delete;
+        AsyncLogger & operator=(const AsyncLogger &) = delete;
+        AsyncLogger & operator=(AsyncLogger &&) = delete;
+
+        /// @}
+        //---------------------------------------------------------------
+        /// @{
+
+        /*!
+         * \details Queues the message for the worker thread.
+         * \param [in] logMsg
+         */
+        LoggingExp void log(const LogMsg & logMsg) const override;
+
+        /*!
+         * \details Waits until all the messages logged before the call are handled
+         *          and flushes the streams, see \link BaseLogger::flushStreams \endlink
+         *          It does nothing if it is called from a handler.
+         */
+        LoggingExp void flush() const noexcept;
+
+        /// @}
+        //---------------------------------------------------------------
+        /// @{
+
+        eQueue queueType() const noexcept { return mRings ? QueuePerThread : QueueShared; }
+
+        /*!
+         * \details The value is approximate if it is called while the logger is being used.
+         * \return Number of the messages waiting for the worker thread.
+         */
+        LoggingExp std::size_t queueSize() const noexcept;
+
+        /*!
+         * \return For \link AsyncLogger::QueueShared \endlink it is maximum number of the queued messages,
+         *         for \link AsyncLogger::QueuePerThread \endlink it is the size of each thread's buffer in bytes.
+         */
+        LoggingExp std::size_t queueCapacity() const noexcept;
+
+        /// @}
+        //---------------------------------------------------------------
+        /// @{
+
+        /*!
+         * \details Sets what to do with a new message when the queue is full.
+         *          Default is \link AsyncLogger::OverflowBlock \endlink
+         * \param [in] policy
+         * \param [in] keepLevel for \link AsyncLogger::OverflowDropBelowLevel \endlink,
+         *             the messages with this level and the more important ones are never dropped.
+         */
+        void setOverflowPolicy(const eOverflow policy, const std::size_t keepLevel = LvlError) noexcept {
+            mKeepLevel.store(keepLevel, std::memory_order_relaxed);
+            mOverflow.store(policy, std::memory_order_relaxed);
+        }
+
+        eOverflow overflowPolicy() const noexcept { return mOverflow.load(std::memory_order_relaxed); }
+        std::size_t overflowKeepLevel() const noexcept { return mKeepLevel.load(std::memory_order_relaxed); }
+
+        /*!
+         * \param [in] policy
+         * \return Number of the messages dropped by the policy since the logger was created.
+         */
+        LoggingExp std::size_t dropped(eOverflow policy) const noexcept;
+
+        /*!
+         * \details How often the worker reports the dropped messages if there are new ones.
+         *          Default is 1 second, 0 disables the reports.
+         * \param [in] interval
+         */
+        void setDropReportInterval(const std::chrono::milliseconds interval) noexcept {
+            mDropReportInterval.store(interval.count(), std::memory_order_relaxed);
+        }
+
+        /// @}
+        //---------------------------------------------------------------
+
+    private:
+
+        void start(eQueue queue, std::size_t size);
+        void run() noexcept;
+        void wake() const noexcept;
+        bool overflow(const LogMsg & logMsg) const noexcept;
+        void push(const LogMsg & logMsg, const TimeSource::Stamp & time) const;
+        void pushLocal(const LogMsg & logMsg, const TimeSource::Stamp & time) const;
+        std::size_t handleQueue() noexcept;
+        struct MergeState;
+        std::size_t handleRings(MergeState & state) noexcept;
+        bool hasQueued() const noexcept;
+        void reportDropped(std::chrono::steady_clock::time_point now, bool force) noexcept;
+
+        std::unique_ptr<internal::AsyncQueue> mQueue;
+        std::unique_ptr<internal::ThreadRings> mRings;
+        mutable std::atomic<std::uint64_t> mFlushRequested{0};
+        std::uint64_t mFlushDone = 0;
+        mutable std::mutex mMutex;
+        mutable std::condition_variable mWake;
+        mutable std::condition_variable mFlushed;
+        mutable std::atomic<bool> mSleeping{false};
+        mutable std::atomic<std::size_t> mFlushWaiters{0};
+
+        std::atomic<eOverflow> mOverflow{OverflowBlock};
+        std::atomic<std::size_t> mKeepLevel{LvlError};
+        mutable std::atomic<std::size_t> mDroppedNewest{0};
+        mutable std::atomic<std::size_t> mDroppedOldest{0};
+        mutable std::atomic<std::size_t> mDroppedBelowLevel{0};
+        std::atomic<std::chrono::milliseconds::rep> mDropReportInterval{1000};
+        std::size_t mReportedDrops = 0;
+        std::chrono::steady_clock::time_point mLastDropReport;
+
+        bool mStop = false;
+        std::thread mThread;
+        std::thread::id mThreadId;
+
+    };
+
+}
+}
+
+/**************************************************************************************************/
+////////////////////////////////////////////////////////////////////////////////////////////////////
+/**************************************************************************************************/
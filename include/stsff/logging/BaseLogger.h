@@ -30,16 +30,26 @@
 **  Contacts: www.steptosky.com or www.flightfactor.aero
 */
 
+#include <atomic>
 #include <cassert>
+#include <cstdint>
 #include <iostream>
 #include <sstream>
 #include <functional>
 #include <unordered_map>
 #include <limits>
+#include <memory>
+#include <mutex>
 #include <exception>
+#include <type_traits>
+#include <vector>
 #include "utils/SourceName.h"
 #include "utils/Colorize.h"
 #include "utils/CodeLocation.h"
+#include "utils/TimeSource.h"
+#include "internal/MessageBuffer.h"
+#include "internal/FastFormat.h"
+#include "FormatPattern.h"
 
 /**************************************************************************************************/
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -48,6 +58,8 @@
 namespace stsff {
 namespace logging {
 
+    class FlightRecorder;
+
     /*!
      * \brief This is a base logger interface.
      * \details This log is useful on library border when you have to print some log but
@@ -121,6 +133,7 @@ namespace logging {
             StringView mMsg;            //!< message itself.
             std::size_t mLevel;         //!< level of current message.
             CodeLocation mCodeLocation; //!< code location.
+            std::int64_t mTime = 0;     //!< creation time, nanoseconds since std::chrono::system_clock epoch, 0 means now.
         };
 
         /// @}
@@ -151,10 +164,79 @@ namespace logging {
         //---------------------------------------------------------------
         /// @{
 
+        /*!
+         * \brief When the handlers flush the streams.
+         * \details The stream is flushed after a message if any of the conditions is true:
+         *          \li the message level is \link FlushPolicy::mLevel \endlink or more important,
+         *              the \link BaseLogger::LvlCritical \endlink messages are always flushed;
+         *          \li \link FlushPolicy::mEveryMessages \endlink messages have been written since the last flush;
+         *          \li \link FlushPolicy::mIntervalMs \endlink milliseconds have passed since the last flush.
+         *              The time is checked when a message is written, there is no timer thread.
+         * \details The standard streams are flushed by \link BaseLogger::flushStreams \endlink
+         *          and when the logger that has not flushed messages is destroyed.
+         */
+        struct FlushPolicy {
+            std::size_t mEveryMessages = 1; //!< 0 means that the number of messages isn't checked.
+            std::int64_t mIntervalMs = 0;   //!< 0 means that the time isn't checked.
+            std::size_t mLevel = LvlCritical;
+
+            //! Flush after each message, it is the default one.
+            static FlushPolicy always() noexcept { return FlushPolicy(); }
+
+            //! Flush only the critical messages.
+            static FlushPolicy never() noexcept { return everyMessages(0); }
+
+            static FlushPolicy everyMessages(const std::size_t count) noexcept {
+                FlushPolicy policy;
+                policy.mEveryMessages = count;
+                return policy;
+            }
+
+            static FlushPolicy everyMilliseconds(const std::int64_t interval) noexcept {
+                FlushPolicy policy;
+                policy.mEveryMessages = 0;
+                policy.mIntervalMs = interval;
+                return policy;
+            }
+
+            //! Also flush the messages with the specified level and the more important ones.
+            FlushPolicy & withLevel(const std::size_t level) noexcept {
+                mLevel = level;
+                return *this;
+            }
+
+            /*!
+             * \details Checks the conditions for the sinks that count their messages themselves.
+             * \param [in] level of the written message.
+             * \param [in] unflushed number of the messages written since the last flush including this one.
+             * \param [in] lastFlush time of the last flush by \link TimeSource::ClockCoarse \endlink
+             * \return True if the stream must be flushed after the message.
+             */
+            bool isDue(const std::size_t level, const std::size_t unflushed, const std::int64_t lastFlush) const noexcept {
+                if (level <= mLevel || level <= LvlCritical) {
+                    return true;
+                }
+                if (mEveryMessages != 0 && unflushed >= mEveryMessages) {
+                    return true;
+                }
+                return mIntervalMs > 0 && TimeSource::now(TimeSource::ClockCoarse) - lastFlush >= mIntervalMs * 1000000;
+            }
+        };
+
+        /// @}
+        //---------------------------------------------------------------
+        /// @{
+
+        /*!
+         * \details The logger uses the default handlers that are shared by all the loggers
+         *          until its handlers are changed, so creating and copying it doesn't allocate
+         *          anything except the name.
+         * \param [in] name
+         */
         LoggingExp explicit BaseLogger(StringView name = StringView()) noexcept;
 
         explicit BaseLogger(const StringView name, LevelHandlers levelsConf) noexcept
-            : mLevels(std::move(levelsConf)),
+            : mHandlers(std::make_shared<HandlerSet>(std::move(levelsConf))),
               mCategory(name.data(), name.size()) {}
 
         LoggingExp virtual ~BaseLogger() noexcept;
@@ -172,9 +254,11 @@ namespace logging {
          * \details Print a message.
          * \details Usually developers should not call this method directly.
          *          Use \link LogMessage \endlink
+         * \details It is virtual so the derived loggers (e.g. \link AsyncLogger \endlink)
+         *          can change the way the messages are delivered to the handlers.
          * \param [in] logMsg
          */
-        LoggingExp void log(const LogMsg & logMsg) const;
+        LoggingExp virtual void log(const LogMsg & logMsg) const;
 
         /// @}
         //---------------------------------------------------------------
@@ -190,12 +274,18 @@ namespace logging {
         /*!
          * \return Levels handler map.
          */
-        const LevelHandlers & handlers() const noexcept { return mLevels; }
+        const LevelHandlers & handlers() const noexcept { return mHandlers.current().mLevels; }
 
         /*!
+         * \details The map can be changed through the returned reference at any time,
+         *          so after this call the logger looks the handlers up in the map instead of its lookup table
+         *          until the handlers are changed with \link BaseLogger::setHandler \endlink
+         * \details The handlers that are shared with the other loggers are copied first.
+         * \warning Changing the map while the other threads are logging is a data race,
+         *          use \link BaseLogger::setHandler \endlink for the runtime changes.
          * \return Levels handler map.
          */
-        LevelHandlers & handlers() noexcept { return mLevels; }
+        LoggingExp LevelHandlers & handlers() noexcept;
 
         /// @}
         //---------------------------------------------------------------
@@ -204,14 +294,26 @@ namespace logging {
         /*!
          * \details Constraint for level printing.
          *          Default is \link BaseLogger::LvlDebug \endlink
+         * \details It can be changed while the other threads are logging.
          * \param [in] level
          */
-        void setLevel(const std::size_t level) noexcept { mLevel = level; }
+        void setLevel(const std::size_t level) noexcept { mLevel.store(level, std::memory_order_relaxed); }
 
         /*!
          * \return Current level for printing.
          */
-        std::size_t level() const noexcept { return mLevel; }
+        std::size_t level() const noexcept { return mLevel.load(std::memory_order_relaxed); }
+
+        /*!
+         * \details Checks whether a message with the specified level will be printed
+         *          or recorded by the \link FlightRecorder \endlink.
+         *          The logger macros use it to skip the message construction entirely.
+         * \param [in] level
+         * \return True if the message with the level will be printed or recorded.
+         */
+        bool isEnabled(const std::size_t level) const noexcept {
+            return level <= mLevel.load(std::memory_order_relaxed) || level <= mCaptureLevel.load(std::memory_order_relaxed);
+        }
 
         /*!
          * \details Set logger name.
@@ -228,16 +330,79 @@ namespace logging {
         //---------------------------------------------------------------
         /// @{
 
+        /*!
+         * \details It can be changed while the other threads are logging.
+         *          Default is \link FlushPolicy::always \endlink
+         * \param [in] policy
+         */
+        LoggingExp void setFlushPolicy(const FlushPolicy & policy) noexcept;
+
+        /*!
+         * \return Current flush policy.
+         */
+        LoggingExp FlushPolicy flushPolicy() const noexcept;
+
+        /*!
+         * \details Counts a written message and checks the \link FlushPolicy \endlink.
+         *          The handlers call it after writing each message and flush their stream if it returns true.
+         * \param [in] level level of the written message.
+         * \return True if the stream should be flushed.
+         */
+        LoggingExp bool flushRequired(std::size_t level) const noexcept;
+
+        /*!
+         * \details Flushes std::clog, std::cout and std::cerr and resets the flush policy counters.
+         */
+        LoggingExp void flushStreams() const noexcept;
+
+        /// @}
+        //---------------------------------------------------------------
+        /// @{
+
+        /*!
+         * \details Attaches the recorder that keeps the messages which are below the logger's level
+         *          down to the capture level. They are passed to the handlers before the next message
+         *          with the trigger level or a more important one, see \link FlightRecorder \endlink
+         * \details It can be changed while the other threads are logging, nullptr detaches the recorder.
+         *          The copies of the logger share the recorder like the handlers.
+         * \param [in] recorder
+         * \param [in] captureLevel the least important level that is recorded.
+         * \param [in] triggerLevel the least important level that dumps the recorded messages.
+         */
+        LoggingExp void setFlightRecorder(std::shared_ptr<FlightRecorder> recorder, std::size_t captureLevel = LvlDebug,
+                                          std::size_t triggerLevel = LvlError) noexcept;
+
+        /*!
+         * \return Attached recorder or nullptr.
+         */
+        LoggingExp std::shared_ptr<FlightRecorder> flightRecorder() const noexcept;
+
+        /*!
+         * \details Passes the recorded messages to the handlers without waiting for the trigger level,
+         *          e.g. before the application exits because of a fatal error.
+         * \return Number of the passed messages.
+         */
+        LoggingExp std::size_t dumpFlightRecorder() const noexcept;
+
+        /// @}
+        //---------------------------------------------------------------
+        /// @{
+
         /*!
          * \details Default handler for log printing.
          * \details Formatting example: \code "ERR: %LN %MC [%TM(%Y-%m-%d %T)] %MS \n\t[%FN -> %FI(%LI)]" \endcode
-         *          \li \%TM(\%Y-\%m-\%d \%T) - time that takes format string for the std::strftime function inside brackets.
+         *          \li \%TM(\%Y-\%m-\%d \%T) - time that takes format string for the std::strftime function inside brackets,
+         *              see \link BaseLogger::timeStamp \endlink for the additional commands.
          *          \li \%LN - log name.
          *          \li \%MC - message category.
          *          \li \%MS - message.
          *          \li \%FN - function name.
          *          \li \%FI - file name.
          *          \li \%LI - file line.
+         *          \li \%LV - message level number.
+         * \details The formatting string is parsed for each call and the errors in it
+         *          are printed in red with each message, use the \link FormatPattern \endlink overload
+         *          in the handlers that are called often.
          * \param [in] logger
          * \param [in] logMsg
          * \param [in] stream
@@ -247,21 +412,306 @@ namespace logging {
         LoggingExp static void defaultHandler(const BaseLogger & logger, const LogMsg & logMsg, std::ostream & stream,
                                               const std::string & formatting, ColorFn color);
 
+        /*!
+         * \details Default handler for log printing with the pre-parsed formatting string.
+         * \details The message is rendered into the thread's buffer and written into the stream
+         *          with one call under the lock of the stream, so the lines of the different threads
+         *          are not mixed if all of them are written by this function.
+         * \param [in] logger
+         * \param [in] logMsg
+         * \param [in] stream
+         * \param [in] pattern
+         * \param [in] color
+         */
+        LoggingExp static void defaultHandler(const BaseLogger & logger, const LogMsg & logMsg, std::ostream & stream,
+                                              const FormatPattern & pattern, ColorFn color);
+
+        /*!
+         * \details Renders the message by the pattern without the line end.
+         *          It is the formatting of \link BaseLogger::defaultHandler \endlink for the sinks
+         *          that write the message themselves.
+         * \param [in, out] out the message is appended to it.
+         * \param [in] logger
+         * \param [in] logMsg
+         * \param [in] pattern
+         * \param [in] errorPrefix text before the errors of the pattern, e.g. color.
+         * \param [in] errorSuffix text after the errors of the pattern.
+         */
+        LoggingExp static void renderMessage(internal::MessageBuffer & out, const BaseLogger & logger, const LogMsg & logMsg,
+                                             const FormatPattern & pattern, StringView errorPrefix = StringView(),
+                                             StringView errorSuffix = StringView());
+
         /*!
          * \details Makes timestamp string.
+         * \details The format supports the fractions of the second in addition to the std::strftime commands:
+         *          \li \%3N - milliseconds.
+         *          \li \%6N - microseconds.
+         *          \li \%9N - nanoseconds.
+         * \details The local time is got with the thread safe functions, the time zone is looked up
+         *          once per 15 minutes interval of the time for each thread.
          * \param [in] format see description of C++ std::strftime function.
          * \warning Maximum string size is 99.
          */
         LoggingExp static std::string timeStamp(const std::string & format = "%Y-%m-%d %T") noexcept;
 
+        /*!
+         * \details Makes timestamp string for the specified time.
+         * \param [in] format see description of C++ std::strftime function.
+         * \param [in] time see \link LogMsg::mTime \endlink
+         * \warning Maximum string size is 99.
+         */
+        LoggingExp static std::string timeStamp(const std::string & format, std::int64_t time) noexcept;
+
+        /*!
+         * \details Makes timestamp for the specified time without the heap allocations.
+         * \details The last rendered strings are cached per thread for several formats,
+         *          so std::strftime is called only when the second of the time changes.
+         * \param [out] out buffer for the result, it is not null-terminated.
+         * \param [in] outSize size of the buffer.
+         * \param [in] format null-terminated format, see \link BaseLogger::timeStamp \endlink
+         * \param [in] time see \link LogMsg::mTime \endlink
+         * \return Number of written bytes or 0 if the result doesn't fit the buffer.
+         */
+        LoggingExp static std::size_t timeStamp(char * out, std::size_t outSize,
+                                                const char * format, std::int64_t time) noexcept;
+
         /// @}
         //---------------------------------------------------------------
 
     private:
 
-        LevelHandlers mLevels;
+        typedef void (*RawHandler)(const BaseLogger &, const LogMsg &);
+
+        /*!
+         * \details Lookup of the level handlers that is built from the handlers map.
+         *          The standard levels are in the array that is indexed by level / 100,
+         *          the other levels are in the sorted vector.
+         *          The handlers that keep a plain function are called without std::function.
+         * \details The table is rebuilt by the first \link BaseLogger::log \endlink call
+         *          after it is invalidated, the concurrent calls use the map while it is being rebuilt.
+         *          The detached table isn't rebuilt, the map is always used instead of it.
+         */
+        class HandlerTable {
+        public:
+
+            struct Entry {
+                LevelHandler mHandler;
+                RawHandler mRaw = nullptr;
+            };
+
+            HandlerTable() = default;
+            // the copy is rebuilt from the map of the copied logger.
+            HandlerTable(const HandlerTable &) noexcept { }
+            HandlerTable & operator=(const HandlerTable &) noexcept {
+                invalidate();
+                return *this;
+            }
+
+            void invalidate() noexcept { mState.store(Dirty, std::memory_order_release); }
+
+            /*!
+             * \details It is used when the map can be changed without the table knowing it.
+             *          The copies of the table aren't detached.
+             */
+            void detach() noexcept { mState.store(Detached, std::memory_order_release); }
+
+            /*!
+             * \param [in] level
+             * \param [in] levels the map the table is built from.
+             * \param [out] outEntry the level's entry or nullptr if the level doesn't have the handler.
+             * \return False if the table isn't ready and the map should be used.
+             */
+            bool find(const std::size_t level, const LevelHandlers & levels, const Entry *& outEntry) const noexcept {
+                if (mState.load(std::memory_order_acquire) != Ready && !rebuild(levels)) {
+                    return false;
+                }
+                if (level % 100 == 0 && level / 100 < StandardLevels) {
+                    outEntry = mStandard[level / 100].mHandler ? &mStandard[level / 100] : nullptr;
+                    return true;
+                }
+                outEntry = findCustom(level);
+                return true;
+            }
+
+        private:
+
+            enum eState { Ready, Dirty, Building, Detached };
+            static const std::size_t StandardLevels = LvlDebug / 100 + 1;
+
+            LoggingExp bool rebuild(const LevelHandlers & levels) const noexcept;
+            LoggingExp const Entry * findCustom(std::size_t level) const noexcept;
+
+            mutable std::atomic<int> mState{Dirty};
+            mutable Entry mStandard[StandardLevels];
+            mutable std::vector<std::pair<std::size_t, Entry>> mCustom;
+
+        };
+
+        /*!
+         * \details The handlers map with its lookup table, it is shared by the copies of the logger
+         *          and by all the loggers with the default handlers until one of them changes it.
+         */
+        struct HandlerSet {
+            explicit HandlerSet(LevelHandlers levels)
+                : mLevels(std::move(levels)) {}
+
+            LevelHandlers mLevels;
+            HandlerTable mTable;
+            std::shared_ptr<FlightRecorder> mRecorder;
+            std::size_t mTriggerLevel = 0;
+        };
+
+        /*!
+         * \details Current handler set of the logger that is read without locking (RCU).
+         * \details A reader registers in the counter of the current epoch and loads the set pointer.
+         *          A writer publishes a new set and retires the previous one,
+         *          it is released after the epoch is advanced twice, each advance requires
+         *          the readers of the other epoch to leave, so nobody uses the released set.
+         *          The writers don't wait for the readers, the retired sets are checked with the next change.
+         */
+        class HandlerSnapshot {
+        public:
+
+            /*!
+             * \details Keeps the current set while the message is handled.
+             */
+            class Reader {
+            public:
+
+                explicit Reader(const HandlerSnapshot & snapshot) noexcept
+                    : mCounter(&snapshot.mReaders[snapshot.mEpoch.load(std::memory_order_acquire) & 1]) {
+                    mCounter->fetch_add(1, std::memory_order_seq_cst);
+                    mSet = snapshot.mCurrent.load(std::memory_order_seq_cst);
+                }
+
+                ~Reader() { mCounter->fetch_sub(1, std::memory_order_release); }
+
+                Reader(const Reader &) = delete;
+                Reader & operator=(const Reader &) = delete;
+
+                const HandlerSet & operator*() const noexcept { return *mSet; }
+                const HandlerSet * operator->() const noexcept { return mSet; }
+
+            private:
+
+                std::atomic<std::size_t> * mCounter;
+                const HandlerSet * mSet;
+
+            };
+
+            explicit HandlerSnapshot(std::shared_ptr<HandlerSet> set) noexcept
+                : mCurrent(set.get()),
+                  mOwner(std::move(set)) { }
+
+            LoggingExp HandlerSnapshot(const HandlerSnapshot & other);
+            LoggingExp HandlerSnapshot & operator=(const HandlerSnapshot & other);
+
+            ~HandlerSnapshot() = default;
+
+            /*!
+             * \details Copies the current set, changes it and publishes the copy.
+             * \param [in] change function that takes \link BaseLogger::HandlerSet \endlink
+             */
+            template<typename Fn>
+            void update(Fn change) {
+                std::lock_guard<std::mutex> lock(mWriteMutex);
+                auto set = std::make_shared<HandlerSet>(*mOwner);
+                change(*set);
+                publish(std::move(set));
+            }
+
+            /*!
+             * \return Current set that is not shared with the other loggers, it can be changed in place.
+             */
+            LoggingExp HandlerSet & own();
+
+            /*!
+             * \return Current set without the reader registration.
+             */
+            const HandlerSet & current() const noexcept { return *mCurrent.load(std::memory_order_acquire); }
+
+        private:
+
+            LoggingExp void publish(std::shared_ptr<HandlerSet> set);
+
+            std::atomic<const HandlerSet *> mCurrent;
+            mutable std::atomic<std::size_t> mReaders[2] = {{0}, {0}};
+            std::atomic<std::uint64_t> mEpoch{0};
+            mutable std::mutex mWriteMutex;
+            std::shared_ptr<HandlerSet> mOwner;
+            std::vector<std::pair<std::uint64_t, std::shared_ptr<HandlerSet>>> mRetired;
+
+        };
+
+        /*!
+         * \details std::atomic that can be copied with the logger.
+         */
+        class AtomicLevel {
+        public:
+
+            AtomicLevel(const std::size_t level) noexcept
+                : mLevel(level) {}
+
+            AtomicLevel(const AtomicLevel & other) noexcept
+                : mLevel(other.load(std::memory_order_relaxed)) {}
+
+            AtomicLevel & operator=(const AtomicLevel & other) noexcept {
+                store(other.load(std::memory_order_relaxed), std::memory_order_relaxed);
+                return *this;
+            }
+
+            std::size_t load(const std::memory_order order) const noexcept { return mLevel.load(order); }
+            void store(const std::size_t level, const std::memory_order order) noexcept { mLevel.store(level, order); }
+
+        private:
+
+            std::atomic<std::size_t> mLevel;
+
+        };
+
+        /*!
+         * \details The flush policy and its counters that can be used by the concurrent handlers.
+         *          The copy gets the policy only, its counters start from zero.
+         */
+        class FlushControl {
+        public:
+
+            FlushControl() noexcept = default;
+
+            FlushControl(const FlushControl & other) noexcept {
+                store(other.load());
+            }
+
+            FlushControl & operator=(const FlushControl & other) noexcept {
+                store(other.load());
+                return *this;
+            }
+
+            LoggingExp FlushPolicy load() const noexcept;
+            LoggingExp void store(const FlushPolicy & policy) noexcept;
+
+            LoggingExp bool required(std::size_t level) noexcept;
+            LoggingExp bool reset() noexcept;
+
+        private:
+
+            std::atomic<std::size_t> mEveryMessages{1};
+            std::atomic<std::int64_t> mInterval{0};
+            std::atomic<std::size_t> mLevel{LvlCritical};
+            std::atomic<std::size_t> mUnflushed{0};
+            std::atomic<std::int64_t> mLastFlush{0};
+
+        };
+
+        LoggingExp static const std::shared_ptr<HandlerSet> & defaultHandlers() noexcept;
+
+        LoggingExp void dispatch(const HandlerSet & handlers, const LogMsg & logMsg) const;
+
+        HandlerSnapshot mHandlers;
         std::string mCategory;
-        std::size_t mLevel = LvlDebug;
+        AtomicLevel mLevel{LvlDebug};
+        AtomicLevel mCaptureLevel{0}; //!< 0 if the recorder isn't attached.
+        mutable FlushControl mFlush;
 
     };
 
@@ -269,6 +719,58 @@ namespace logging {
     ////////////////////////////////////////////////////////////////////////////////////////////////////
     /**************************************************************************************************/
 
+    namespace internal {
+
+        /*!
+         * \details The ways \link LogMessage \endlink writes the values.
+         */
+        enum eMessageFormat {
+            FmtStream,
+            FmtChar,
+            FmtBool,
+            FmtSigned,
+            FmtUnsigned,
+            FmtFloat,
+            FmtDouble,
+            FmtCString,
+            FmtString,
+            FmtPointer,
+        };
+
+        /*!
+         * \details The way \link LogMessage \endlink writes a value of the type.
+         *          The types without special handling are written with std::ostream.
+         */
+        template<typename T>
+        struct MessageFormat {
+            typedef typename std::remove_cv<T>::type Type;
+            typedef typename std::decay<T>::type Decayed;
+            typedef typename std::remove_cv<typename std::remove_pointer<Decayed>::type>::type Pointee;
+
+            static const eMessageFormat kind =
+                    std::is_same<Type, char>::value || std::is_same<Type, signed char>::value ||
+                    std::is_same<Type, unsigned char>::value ? FmtChar :
+                    std::is_same<Type, bool>::value ? FmtBool :
+                    std::is_same<Type, wchar_t>::value || std::is_same<Type, char16_t>::value ||
+                    std::is_same<Type, char32_t>::value ? FmtStream :
+                    std::is_integral<Type>::value && std::is_signed<Type>::value ? FmtSigned :
+                    std::is_integral<Type>::value ? FmtUnsigned :
+                    std::is_same<Type, float>::value ? FmtFloat :
+                    std::is_same<Type, double>::value ? FmtDouble :
+                    std::is_same<Type, std::string>::value || std::is_same<Type, CustStringView>::value ? FmtString :
+                    !std::is_pointer<Decayed>::value ? FmtStream :
+                    std::is_same<Pointee, char>::value ? FmtCString :
+                    // the std::ostream prints them as strings or as bool
+                    std::is_same<Pointee, signed char>::value || std::is_same<Pointee, unsigned char>::value ||
+                    std::is_function<Pointee>::value ? FmtStream : FmtPointer;
+        };
+
+    }
+
+    /**************************************************************************************************/
+    ////////////////////////////////////////////////////////////////////////////////////////////////////
+    /**************************************************************************************************/
+
     /*!
      * \brief Message for \link BaseLogger \endlink.
      * \details Represents one log message.
@@ -277,6 +779,13 @@ namespace logging {
      *       The macros use \link sourcePath \endlink for extracting file name instead of full source path.
      *       You can define STSFF_LOGGER_USE_FULL_SOURCES_PATH to change this behaviour.
      *       If you write your own macros you may want to use function \link sourceFileName \endlink.
+     * \details The level macros check the logger's level before the message is constructed,
+     *          so if the level is filtered out neither the message is created nor its arguments are evaluated.
+     * \code LDebug(logger) << expensiveCall(); // expensiveCall() isn't called if the debug level is disabled \endcode
+     * \details You can define STSFF_LOGGER_COMPILED_LEVEL with a numeric level value (e.g. 600 for LvlInfo)
+     *          to remove the messages with the less important levels from the binary at compile time.
+     *          It has the same meaning as \link BaseLogger::setLevel \endlink.
+     *          The cmake variable with the same name adds this definition to the library target.
      * \details If the logger macros conflict with your ones or you want to define your own
      *          you can define STSFF_LOGGER_DON_NOT_USE_MACROS to disable default logger's macros.
      * \details The message will be printed when destructor is called
@@ -286,6 +795,9 @@ namespace logging {
      * \code LWarning(logger) << "My warning" << LPush; \endcode
      *       It can be needed when you process the exceptions or
      *       want printing the message before its destructor calls.
+     * \details The message text is kept in the inline buffer, the heap is used only for the long messages.
+     *          The types without special handling are printed with std::ostream that is reused by
+     *          all the messages of the thread, its formatting state is reset for each message.
      * \details As the class has template operator << you can define log printing for your own types.
      * \code
      * // define somewhere
@@ -333,14 +845,60 @@ namespace logging {
             assert(mLog);
         }
 
+        LogMessage(const BaseLogger & logger, const CodeLocation codeLocation, const std::size_t level) noexcept
+            : LogMessage(&logger, codeLocation, level) {}
+
+        /*!
+         * \details The message created with the level ignores the data written into it
+         *          while its level is filtered out, the other messages keep the data until they are pushed
+         *          because their level is usually set after the data.
+         */
+        LogMessage(const BaseLogger * logger, const CodeLocation codeLocation, const std::size_t level) noexcept
+            : mLogMsg(level, StringView(), StringView(), codeLocation),
+              mLog(logger),
+              mSkipDisabled(true) {
+            assert(mLog);
+        }
+
         ~LogMessage() {
             push();
+            internal::releaseMessageStream(mStream);
         }
 
         LogMessage(const LogMessage &) = delete;
-        LogMessage(LogMessage &&) = default;
         LogMessage & operator=(const LogMessage &) = delete;
-        LogMessage & operator=(LogMessage &&) = default;
+
+        LogMessage(LogMessage && other) noexcept
+            : mBuffer(std::move(other.mBuffer)),
+              mStream(other.mStream),
+              mLogMsg(other.mLogMsg),
+              mLog(other.mLog),
+              mPushed(other.mPushed),
+              mSkipDisabled(other.mSkipDisabled) {
+            other.mStream = nullptr;
+            other.mPushed = true;
+            if (mStream) {
+                internal::retargetMessageStream(mStream, mBuffer);
+            }
+        }
+
+        LogMessage & operator=(LogMessage && other) noexcept {
+            if (this != &other) {
+                internal::releaseMessageStream(mStream);
+                mBuffer = std::move(other.mBuffer);
+                mStream = other.mStream;
+                mLogMsg = other.mLogMsg;
+                mLog = other.mLog;
+                mPushed = other.mPushed;
+                mSkipDisabled = other.mSkipDisabled;
+                other.mStream = nullptr;
+                other.mPushed = true;
+                if (mStream) {
+                    internal::retargetMessageStream(mStream, mBuffer);
+                }
+            }
+            return *this;
+        }
 
         /// @}
         //---------------------------------------------------------------
@@ -380,8 +938,11 @@ namespace logging {
 
         template<class T>
         LogMessage & operator<<(const T & msg) noexcept {
+            if (mSkipDisabled && !isEnabled()) {
+                return *this;
+            }
             try {
-                mStream << msg;
+                put(msg, FormatTag<internal::MessageFormat<T>::kind>());
             }
             catch (const std::exception & e) {
                 std::cerr << colorize::red << e.what() << " [" << __STS_FUNC_NAME__ << "]"
@@ -472,11 +1033,20 @@ namespace logging {
             mPushed = true;
         }
 
+        /*!
+         * \details The disabled message isn't printed, the data written into it is ignored
+         *          only if the message has been created with the level.
+         * \return True if the message is going to be printed with its current level.
+         */
+        bool isEnabled() const noexcept {
+            return mLog && mLog->isEnabled(mLogMsg.mLevel);
+        }
+
         /*!
          * \return Log message string.
          */
         std::string string() const noexcept {
-            return mStream.str();
+            return std::string(mBuffer.data(), mBuffer.size());
         }
 
         /// @}
@@ -484,13 +1054,214 @@ namespace logging {
 
     private:
 
-        std::stringstream mStream;
+        typedef internal::FastFormat FastFormat;
+
+        template<internal::eMessageFormat F>
+        using FormatTag = std::integral_constant<internal::eMessageFormat, F>;
+
+        // The numbers and the text are written with the std::ostream if it has been used,
+        // so the manipulators like std::hex and std::setw keep working.
+
+        template<typename T>
+        void put(const T & msg, FormatTag<internal::FmtStream>) {
+            stream() << msg;
+        }
+
+        template<typename T>
+        void put(const T & msg, FormatTag<internal::FmtChar>) {
+            const char ch = char(msg);
+            if (mStream) {
+                putText(&ch, 1);
+                return;
+            }
+            mBuffer.append(ch);
+        }
+
+        template<typename T>
+        void put(const T & msg, FormatTag<internal::FmtBool>) {
+            if (mStream) {
+                stream() << msg;
+                return;
+            }
+            mBuffer.append(msg ? '1' : '0');
+        }
+
+        template<typename T>
+        void put(const T & msg, FormatTag<internal::FmtSigned>) {
+            if (mStream) {
+                stream() << msg;
+                return;
+            }
+            mBuffer.commit(FastFormat::formatSigned(mBuffer.reserve(FastFormat::MaxSignedChars), msg));
+        }
+
+        template<typename T>
+        void put(const T & msg, FormatTag<internal::FmtUnsigned>) {
+            if (mStream) {
+                stream() << msg;
+                return;
+            }
+            mBuffer.commit(FastFormat::formatUnsigned(mBuffer.reserve(FastFormat::MaxUnsignedChars), msg));
+        }
+
+        template<typename T>
+        void put(const T & msg, FormatTag<internal::FmtFloat>) {
+            if (mStream) {
+                stream() << msg;
+                return;
+            }
+            mBuffer.commit(FastFormat::formatFloat(mBuffer.reserve(FastFormat::MaxFloatChars), msg));
+        }
+
+        template<typename T>
+        void put(const T & msg, FormatTag<internal::FmtDouble>) {
+            if (mStream) {
+                stream() << msg;
+                return;
+            }
+            mBuffer.commit(FastFormat::formatDouble(mBuffer.reserve(FastFormat::MaxFloatChars), msg));
+        }
+
+        void put(const char * msg, FormatTag<internal::FmtCString>) {
+            if (msg) {
+                if (mStream) {
+                    putText(msg, std::strlen(msg));
+                    return;
+                }
+                mBuffer.append(msg, std::strlen(msg));
+            }
+        }
+
+        template<typename T>
+        void put(const T & msg, FormatTag<internal::FmtString>) {
+            if (mStream) {
+                putText(msg.data(), msg.size());
+                return;
+            }
+            mBuffer.append(msg.data(), msg.size());
+        }
+
+        /*!
+         * \details Writes the text into the stream with its width, fill and alignment
+         *          like the std::ostream operator for the strings, but without making std::string.
+         */
+        void putText(const char * text, const std::size_t size) {
+            std::ostream & out = stream();
+            const std::streamsize width = out.width();
+            out.width(0);
+            const std::size_t padding = width > std::streamsize(size) ? std::size_t(width) - size : 0;
+            const bool left = (out.flags() & std::ios_base::adjustfield) == std::ios_base::left;
+            for (std::size_t i = 0; !left && i < padding; ++i) {
+                out.put(out.fill());
+            }
+            out.write(text, std::streamsize(size));
+            for (std::size_t i = 0; left && i < padding; ++i) {
+                out.put(out.fill());
+            }
+        }
+
+        template<typename T>
+        void put(const T & msg, FormatTag<internal::FmtPointer>) {
+            if (mStream) {
+                stream() << msg;
+                return;
+            }
+            mBuffer.commit(FastFormat::formatPointer(mBuffer.reserve(FastFormat::MaxPointerChars), msg));
+        }
+
+        std::ostream & stream() {
+            if (!mStream) {
+                mStream = internal::acquireMessageStream(mBuffer);
+            }
+            return internal::messageOstream(mStream);
+        }
+
+        internal::MessageBuffer mBuffer;
+        internal::MessageStream * mStream = nullptr;
         BaseLogger::LogMsg mLogMsg;
         const BaseLogger * mLog = nullptr;
         bool mPushed = false;
+        bool mSkipDisabled = false;
 
     };
 
+    /**************************************************************************************************/
+    ////////////////////////////////////////////////////////////////////////////////////////////////////
+    /**************************************************************************************************/
+
+    namespace internal {
+
+        /*!
+         * \details Level check for the logger macros,
+         *          it accepts the logger both by reference and by pointer as \link LogMessage \endlink does.
+         */
+        inline bool isLoggerEnabled(const BaseLogger & logger, const std::size_t level) noexcept {
+            return logger.isEnabled(level);
+        }
+
+        inline bool isLoggerEnabled(const BaseLogger * logger, const std::size_t level) noexcept {
+            return logger && logger->isEnabled(level);
+        }
+
+        /*!
+         * \details Stub with the \link LogMessage \endlink interface
+         *          that is used instead of the messages removed with STSFF_LOGGER_COMPILED_LEVEL.
+         *          The macros never evaluate it, it is only needed to keep the user's code compiling.
+         */
+        class NullLogMessage final {
+        public:
+
+            typedef BaseLogger::StringView StringView;
+
+            template<typename L>
+            explicit NullLogMessage(const L &) noexcept {}
+
+            template<typename... Args>
+            NullLogMessage & write(const Args & ...) noexcept { return *this; }
+
+            template<typename... Args>
+            NullLogMessage & writeSp(const Args & ...) noexcept { return *this; }
+
+            template<class T>
+            NullLogMessage & operator<<(const T &) noexcept { return *this; }
+
+            template<typename T>
+            NullLogMessage & level(const T) noexcept { return *this; }
+
+            NullLogMessage & critical() noexcept { return *this; }
+            NullLogMessage & error() noexcept { return *this; }
+            NullLogMessage & fail() noexcept { return *this; }
+            NullLogMessage & warning() noexcept { return *this; }
+            NullLogMessage & success() noexcept { return *this; }
+            NullLogMessage & info() noexcept { return *this; }
+            NullLogMessage & message() noexcept { return *this; }
+            NullLogMessage & debug() noexcept { return *this; }
+
+            NullLogMessage & setCategory(const StringView) noexcept { return *this; }
+            NullLogMessage & setFunction(const StringView) noexcept { return *this; }
+            NullLogMessage & setFile(const StringView) noexcept { return *this; }
+            NullLogMessage & setFileLine(const int) noexcept { return *this; }
+
+            void push() noexcept {}
+            void abort() noexcept {}
+            bool isEnabled() const noexcept { return false; }
+            std::string string() const noexcept { return std::string(); }
+
+        };
+
+        /*!
+         * \details Turns the message expression of the logger macros into void
+         *          so it can be used as a branch of the conditional operator.
+         *          The operator & has lower precedence than operator << so all the message arguments
+         *          are bound to the message before.
+         */
+        struct LogMessageVoidify {
+            void operator&(const LogMessage &) const noexcept {}
+            void operator&(const NullLogMessage &) const noexcept {}
+        };
+
+    }
+
 }
 }
 
@@ -504,33 +1275,102 @@ namespace logging {
  */
 #ifndef STSFF_LOGGER_DON_NOT_USE_MACROS
 
+// The level is checked before the message is constructed, so if the level is filtered out
+// neither the message nor its arguments are evaluated.
+// Note: the logger argument is evaluated twice.
+#   define STSFF_LOGGER_IF_ENABLED(L,LVL) \
+        !(STSFF_LOGGER_IS_COMPILED(LVL) && stsff::logging::internal::isLoggerEnabled(L, LVL)) \
+            ? (void)0 : stsff::logging::internal::LogMessageVoidify() &
+
+// Compile time level, see STSFF_LOGGER_COMPILED_LEVEL.
+// The messages with the predefined levels above the compiled one are replaced with the never evaluated stub,
+// so they don't leave anything in the binary even without optimization.
+// The messages with the custom levels (LLevel, LcLevel) are removed by the compiler's optimizer
+// as their condition is a constant if the level is a constant.
+#   ifdef STSFF_LOGGER_COMPILED_LEVEL
+#       define STSFF_LOGGER_IS_COMPILED(LVL) (std::size_t(LVL) <= std::size_t(STSFF_LOGGER_COMPILED_LEVEL))
+#   else
+#       define STSFF_LOGGER_IS_COMPILED(LVL) true
+#   endif
+
+#   define STSFF_LOGGER_STRIPPED_MSG(L) \
+        true ? (void)0 : stsff::logging::internal::LogMessageVoidify() & stsff::logging::internal::NullLogMessage(L)
+
+#   define STSFF_LOGGER_MSG(L,LVL) \
+        STSFF_LOGGER_IF_ENABLED(L, stsff::logging::BaseLogger::LVL) stsff::logging::LogMessage(L, MakeCodeLocation())
+
+#   if defined(STSFF_LOGGER_COMPILED_LEVEL) && (STSFF_LOGGER_COMPILED_LEVEL < 100)
+#       define STSFF_LOGGER_CRITICAL_MSG(L) STSFF_LOGGER_STRIPPED_MSG(L)
+#   else
+#       define STSFF_LOGGER_CRITICAL_MSG(L) STSFF_LOGGER_MSG(L, LvlCritical)
+#   endif
+#   if defined(STSFF_LOGGER_COMPILED_LEVEL) && (STSFF_LOGGER_COMPILED_LEVEL < 200)
+#       define STSFF_LOGGER_ERROR_MSG(L) STSFF_LOGGER_STRIPPED_MSG(L)
+#   else
+#       define STSFF_LOGGER_ERROR_MSG(L) STSFF_LOGGER_MSG(L, LvlError)
+#   endif
+#   if defined(STSFF_LOGGER_COMPILED_LEVEL) && (STSFF_LOGGER_COMPILED_LEVEL < 300)
+#       define STSFF_LOGGER_FAIL_MSG(L) STSFF_LOGGER_STRIPPED_MSG(L)
+#   else
+#       define STSFF_LOGGER_FAIL_MSG(L) STSFF_LOGGER_MSG(L, LvlFail)
+#   endif
+#   if defined(STSFF_LOGGER_COMPILED_LEVEL) && (STSFF_LOGGER_COMPILED_LEVEL < 400)
+#       define STSFF_LOGGER_WARNING_MSG(L) STSFF_LOGGER_STRIPPED_MSG(L)
+#   else
+#       define STSFF_LOGGER_WARNING_MSG(L) STSFF_LOGGER_MSG(L, LvlWarning)
+#   endif
+#   if defined(STSFF_LOGGER_COMPILED_LEVEL) && (STSFF_LOGGER_COMPILED_LEVEL < 500)
+#       define STSFF_LOGGER_SUCCESS_MSG(L) STSFF_LOGGER_STRIPPED_MSG(L)
+#   else
+#       define STSFF_LOGGER_SUCCESS_MSG(L) STSFF_LOGGER_MSG(L, LvlSuccess)
+#   endif
+#   if defined(STSFF_LOGGER_COMPILED_LEVEL) && (STSFF_LOGGER_COMPILED_LEVEL < 600)
+#       define STSFF_LOGGER_INFO_MSG(L) STSFF_LOGGER_STRIPPED_MSG(L)
+#   else
+#       define STSFF_LOGGER_INFO_MSG(L) STSFF_LOGGER_MSG(L, LvlInfo)
+#   endif
+#   if defined(STSFF_LOGGER_COMPILED_LEVEL) && (STSFF_LOGGER_COMPILED_LEVEL < 700)
+#       define STSFF_LOGGER_MESSAGE_MSG(L) STSFF_LOGGER_STRIPPED_MSG(L)
+#   else
+#       define STSFF_LOGGER_MESSAGE_MSG(L) STSFF_LOGGER_MSG(L, LvlMsg)
+#   endif
+#   if defined(STSFF_LOGGER_COMPILED_LEVEL) && (STSFF_LOGGER_COMPILED_LEVEL < 800)
+#       define STSFF_LOGGER_DEBUG_MSG(L) STSFF_LOGGER_STRIPPED_MSG(L)
+#   else
+#       define STSFF_LOGGER_DEBUG_MSG(L) STSFF_LOGGER_MSG(L, LvlDebug)
+#   endif
+
 // Log messages
 
 // Just creates LogMessage variable and you can use it then 
 #   define LVar(VAR,L)      stsff::logging::LogMessage VAR(L, MakeCodeLocation());VAR
-#   define LCritical(L)         stsff::logging::LogMessage(L, MakeCodeLocation()).critical()
-#   define LError(L)            stsff::logging::LogMessage(L, MakeCodeLocation()).error()
-#   define LFail(L)             stsff::logging::LogMessage(L, MakeCodeLocation()).fail()
-#   define LWarning(L)          stsff::logging::LogMessage(L, MakeCodeLocation()).warning()
-#   define LSuccess(L)          stsff::logging::LogMessage(L, MakeCodeLocation()).success()
-#   define LInfo(L)             stsff::logging::LogMessage(L, MakeCodeLocation()).info()
-#   define LMessage(L)          stsff::logging::LogMessage(L, MakeCodeLocation()).message()
-#   define LDebug(L)            stsff::logging::LogMessage(L, MakeCodeLocation()).debug()
-#   define LLevel(L,LVL)        stsff::logging::LogMessage(L, MakeCodeLocation()).level(LVL)
+// Creates LogMessage variable with the level, the data written into it is ignored if the level is filtered out.
+#   define LVarLvl(VAR,L,LVL)   stsff::logging::LogMessage VAR(L, MakeCodeLocation(), LVL);VAR
+#   define LCritical(L)         STSFF_LOGGER_CRITICAL_MSG(L).critical()
+#   define LError(L)            STSFF_LOGGER_ERROR_MSG(L).error()
+#   define LFail(L)             STSFF_LOGGER_FAIL_MSG(L).fail()
+#   define LWarning(L)          STSFF_LOGGER_WARNING_MSG(L).warning()
+#   define LSuccess(L)          STSFF_LOGGER_SUCCESS_MSG(L).success()
+#   define LInfo(L)             STSFF_LOGGER_INFO_MSG(L).info()
+#   define LMessage(L)          STSFF_LOGGER_MESSAGE_MSG(L).message()
+#   define LDebug(L)            STSFF_LOGGER_DEBUG_MSG(L).debug()
+#   define LLevel(L,LVL)        STSFF_LOGGER_IF_ENABLED(L, LVL) stsff::logging::LogMessage(L, MakeCodeLocation()).level(LVL)
 #   define LTimeStamp(F)        stsff::logging::BaseLogger::timeStamp(F)
 
 // Category log messages
 
 // Just creates LogMessage variable and you can use it then 
 #   define LcVar(VAR,L,C)   stsff::logging::LogMessage VAR(L, MakeCodeLocation());VAR.setCategory(C)
-#   define LcCritical(L,C)      stsff::logging::LogMessage(L, MakeCodeLocation()).setCategory(C).critical()
-#   define LcError(L,C)         stsff::logging::LogMessage(L, MakeCodeLocation()).setCategory(C).error()
-#   define LcWarning(L,C)       stsff::logging::LogMessage(L, MakeCodeLocation()).setCategory(C).warning()
-#   define LcSuccess(L,C)       stsff::logging::LogMessage(L, MakeCodeLocation()).setCategory(C).success()
-#   define LcInfo(L,C)          stsff::logging::LogMessage(L, MakeCodeLocation()).setCategory(C).info()
-#   define LcMessage(L,C)       stsff::logging::LogMessage(L, MakeCodeLocation()).setCategory(C).message()
-#   define LcDebug(L,C)         stsff::logging::LogMessage(L, MakeCodeLocation()).setCategory(C).debug()
-#   define LcLevel(L,C,LVL)     stsff::logging::LogMessage(L, MakeCodeLocation()).setCategory(C).level(LVL)
+// Creates LogMessage variable with the level, the data written into it is ignored if the level is filtered out.
+#   define LcVarLvl(VAR,L,C,LVL) stsff::logging::LogMessage VAR(L, MakeCodeLocation(), LVL);VAR.setCategory(C)
+#   define LcCritical(L,C)      STSFF_LOGGER_CRITICAL_MSG(L).setCategory(C).critical()
+#   define LcError(L,C)         STSFF_LOGGER_ERROR_MSG(L).setCategory(C).error()
+#   define LcWarning(L,C)       STSFF_LOGGER_WARNING_MSG(L).setCategory(C).warning()
+#   define LcSuccess(L,C)       STSFF_LOGGER_SUCCESS_MSG(L).setCategory(C).success()
+#   define LcInfo(L,C)          STSFF_LOGGER_INFO_MSG(L).setCategory(C).info()
+#   define LcMessage(L,C)       STSFF_LOGGER_MESSAGE_MSG(L).setCategory(C).message()
+#   define LcDebug(L,C)         STSFF_LOGGER_DEBUG_MSG(L).setCategory(C).debug()
+#   define LcLevel(L,C,LVL)     STSFF_LOGGER_IF_ENABLED(L, LVL) stsff::logging::LogMessage(L, MakeCodeLocation()).setCategory(C).level(LVL)
 
 // Force push
 #   define LPush stsff::logging::LogMessage::CmdPush()
@@ -0,0 +1,153 @@
+#pragma once
+
+/*
+**  Copyright(C) 2019, StepToSky and FlightFactor
+**  All rights reserved
+**
+**  Redistribution and use in source and binary forms, with or without
+**  modification, are permitted provided that the following conditions are met:
+**
+**  1.Redistributions of source code must retain the above copyright notice, this
+**    list of conditions and the following disclaimer.
+**  2.Redistributions in binary form must reproduce the above copyright notice,
+**    this list of conditions and the following disclaimer in the documentation
+**    and / or other materials provided with the distribution.
+**  3.The name of StepToSky or the name of FlightFactor or the names of its
+**    contributors may NOT be used to endorse or promote products derived from
+**    this software without specific prior written permission.
+**
+**  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+**  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+**  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+**  DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+**  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+**  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+**  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+**  ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+**  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+**  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**
+**  Contacts: www.steptosky.com or www.flightfactor.aero
+*/
+
+#include <cstddef>
+#include <string>
+#include "stsff/logging/BaseLogger.h"
+#include "stsff/logging/FormatPattern.h"
+
+/**************************************************************************************************/
+////////////////////////////////////////////////////////////////////////////////////////////////////
+/**************************************************************************************************/
+
+namespace stsff {
+namespace logging {
+
+    /*!
+     * \brief Level handler that writes the messages into a file descriptor without std::ostream.
+     * \details It is a replacement of \link BaseLogger::defaultHandler \endlink for the console.
+     *          The message is written with one writev call, the literals of the pattern and the strings
+     *          of the message are passed as they are, only the numbers and the time are rendered
+     *          into the thread's buffer.
+     * \details The colors are resolved into the escape sequences when the sink is created,
+     *          so the terminal isn't checked for each message. The windows console colors
+     *          are set with the API calls of the streams, so there the colors are used
+     *          only with \link ConsoleSink::ColorsAlways \endlink and the terminal that supports the escape sequences.
+     * \details The descriptor isn't buffered, so the flush policy of the logger isn't used.
+     *          The output of std::cout and std::cerr isn't synchronized with the sink.
+     * \code
+     * logger.setHandler(BaseLogger::LvlInfo, ConsoleSink(ConsoleSink::StdErr, "INF: %LN %MC %MS", colorize::cyan));
+     * \endcode
+     */
+    class ConsoleSink {
+    public:
+
+        typedef BaseLogger::ColorFn ColorFn;
+
+        //---------------------------------------------------------------
+        /// @{
+
+        static const int StdOut = 1;
+        static const int StdErr = 2;
+
+        /*!
+         * \details When the colors are used.
+         */
+        enum eColors {
+            ColorsAuto,   //!< if the descriptor is a terminal.
+            ColorsAlways, //!< always, e.g. for the pipes to the programs that print the escape sequences.
+            ColorsNever,  //!< never.
+        };
+
+        /// @}
+        //---------------------------------------------------------------
+        /// @{
+
+        /*!
+         * \param [in] fileDescriptor usually \link ConsoleSink::StdOut \endlink or \link ConsoleSink::StdErr \endlink
+         * \param [in] pattern see \link BaseLogger::defaultHandler \endlink
+         * \param [in] color color manipulator from \link colorize \endlink or nullptr.
+         * \param [in] colors
+         */
+        LoggingExp ConsoleSink(int fileDescriptor, const FormatPattern & pattern, ColorFn color, eColors colors = ColorsAuto);
+
+        /*!
+         * \param [in] fileDescriptor usually \link ConsoleSink::StdOut \endlink or \link ConsoleSink::StdErr \endlink
+         * \param [in] formatting see \link BaseLogger::defaultHandler \endlink
+         * \param [in] color color manipulator from \link colorize \endlink or nullptr.
+         * \param [in] colors
+         */
+        ConsoleSink(const int fileDescriptor, const std::string & formatting, const ColorFn color, const eColors colors = ColorsAuto)
+            : ConsoleSink(fileDescriptor, FormatPattern(formatting), color, colors) {}
+
+        ConsoleSink(const ConsoleSink &) = default;
+        ConsoleSink(ConsoleSink &&) = default;
+        ConsoleSink & operator=(const ConsoleSink &) = default;
+        ConsoleSink & operator=(ConsoleSink &&) = default;
+
+        ~ConsoleSink() = default;
+
+        /// @}
+        //---------------------------------------------------------------
+        /// @{
+
+        /*!
+         * \details Writes the message, it has the signature of \link BaseLogger::LevelHandler \endlink
+         * \param [in] logger
+         * \param [in] logMsg
+         */
+        LoggingExp void operator()(const BaseLogger & logger, const BaseLogger::LogMsg & logMsg) const;
+
+        /// @}
+        //---------------------------------------------------------------
+        /// @{
+
+        int fileDescriptor() const noexcept { return mFileDescriptor; }
+        const FormatPattern & pattern() const noexcept { return mPattern; }
+
+        /*!
+         * \return True if the messages are written with the colors.
+         */
+        bool isColorized() const noexcept { return mColorized; }
+
+        /// @}
+        //---------------------------------------------------------------
+
+    private:
+
+        FormatPattern mPattern;
+        std::string mPrefix;
+        std::string mSuffix;
+        std::string mErrorPrefix;
+        std::string mErrorSuffix;
+        std::size_t mScratchSize = 0;
+        int mFileDescriptor;
+        bool mColorized = false;
+
+    };
+
+    /**************************************************************************************************/
+    ////////////////////////////////////////////////////////////////////////////////////////////////////
+    /**************************************************************************************************/
+
+}
+}
@@ -0,0 +1,399 @@
+#pragma once
+
+/*
+**  Copyright(C) 2019, StepToSky and FlightFactor
+**  All rights reserved
+**
+**  Redistribution and use in source and binary forms, with or without
+**  modification, are permitted provided that the following conditions are met:
+**
+**  1.Redistributions of source code must retain the above copyright notice, this
+**    list of conditions and the following disclaimer.
+**  2.Redistributions in binary form must reproduce the above copyright notice,
+**    this list of conditions and the following disclaimer in the documentation
+**    and / or other materials provided with the distribution.
+**  3.The name of StepToSky or the name of FlightFactor or the names of its
+**    contributors may NOT be used to endorse or promote products derived from
+**    this software without specific prior written permission.
+**
+**  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+**  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+**  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+**  DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+**  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+**  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+**  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+**  ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+**  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+**  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**
+**  Contacts: www.steptosky.com or www.flightfactor.aero
+*/
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include "BaseLogger.h"
+#include "internal/ThreadRing.h"
+
+/**************************************************************************************************/
+////////////////////////////////////////////////////////////////////////////////////////////////////
+/**************************************************************************************************/
+
+namespace stsff {
+namespace logging {
+
+    /*!
+     * \brief Static description of the \link DeferredLogger \endlink call site.
+     * \details Only the pointer to it is copied by the log call
+     *          so it must live as long as the logger, usually it is a function static variable
+     *          that is created by the LDeferred macro.
+     */
+    struct DeferredSite {
+        typedef BaseLogger::StringView StringView;
+
+        DeferredSite(const std::size_t level, const StringView category, const CodeLocation codeLocation) noexcept
+            : mLevel(level),
+              mCategory(category),
+              mCodeLocation(codeLocation) {}
+
+        std::size_t mLevel;         //!< message level.
+        StringView mCategory;       //!< message category.
+        CodeLocation mCodeLocation; //!< code location.
+    };
+
+    /**************************************************************************************************/
+    ////////////////////////////////////////////////////////////////////////////////////////////////////
+    /**************************************************************************************************/
+
+    namespace internal {
+
+        /*!
+         * \details Binary encoding of the \link DeferredLogger \endlink arguments.
+         *          Each argument is a byte of its \link eMessageFormat \endlink
+         *          followed by the raw value, the strings are written as 32 bit length and the bytes.
+         *          The strings are cut if they don't fit the budget.
+         */
+        class DeferredArgs final {
+        public:
+
+            /*!
+             * \details Type of the encoded value.
+             */
+            template<eMessageFormat F>
+            struct ValueType {
+                typedef typename std::conditional<F == FmtChar, char,
+                    typename std::conditional<F == FmtBool, bool,
+                        typename std::conditional<F == FmtSigned, std::int64_t,
+                            typename std::conditional<F == FmtFloat, float,
+                                typename std::conditional<F == FmtDouble, double,
+                                    std::uint64_t>::type>::type>::type>::type>::type type;
+            };
+
+            //---------------------------------------------------------------
+
+            /*!
+             * \details Size of the encoded arguments without the string bytes.
+             */
+            static std::size_t fixedSize() noexcept {
+                return 0;
+            }
+
+            template<typename T, typename... Args>
+            static std::size_t fixedSize(const T &, const Args & ... args) noexcept {
+                static_assert(MessageFormat<T>::kind != FmtStream,
+                    "DeferredLogger can copy the numbers, pointers and strings only, use LogMessage for this type.");
+                return 1 + FixedSize<MessageFormat<T>::kind>::value + fixedSize(args...);
+            }
+
+            /*!
+             * \details Size of the string bytes.
+             * \param [in, out] budget maximum number of the string bytes, the strings that don't fit it are cut.
+             */
+            static std::size_t stringsSize(std::size_t &) noexcept {
+                return 0;
+            }
+
+            template<typename T, typename... Args>
+            static std::size_t stringsSize(std::size_t & budget, const T & arg, const Args & ... args) noexcept {
+                const std::size_t size = spend(budget, stringSize(arg, Tag<MessageFormat<T>::kind>()));
+                return size + stringsSize(budget, args...);
+            }
+
+            /*!
+             * \param [in] out memory of fixedSize() + stringsSize() bytes.
+             * \param [in, out] budget the same value that is passed to stringsSize().
+             */
+            static char * write(char * out, std::size_t &) noexcept {
+                return out;
+            }
+
+            template<typename T, typename... Args>
+            static char * write(char * out, std::size_t & budget, const T & arg, const Args & ... args) noexcept {
+                typedef Tag<MessageFormat<T>::kind> ArgTag;
+                *out++ = char(ArgTag::value);
+                out = encode(out, budget, arg, ArgTag());
+                return write(out, budget, args...);
+            }
+
+        private:
+
+            template<eMessageFormat F>
+            using Tag = std::integral_constant<eMessageFormat, F>;
+
+            template<eMessageFormat F>
+            using FixedSize = std::integral_constant<std::size_t,
+                F == FmtCString || F == FmtString ? sizeof(std::uint32_t) : sizeof(typename ValueType<F>::type)>;
+
+            //---------------------------------------------------------------
+
+            template<typename V>
+            static char * copy(char * out, const V value) noexcept {
+                std::memcpy(out, &value, sizeof(value));
+                return out + sizeof(value);
+            }
+
+            static std::size_t spend(std::size_t & budget, const std::size_t size) noexcept {
+                const std::size_t spent = size < budget ? size : budget;
+                budget -= spent;
+                return spent;
+            }
+
+            static std::size_t cStringSize(const char * str) noexcept { return str ? std::strlen(str) : 0; }
+            static const char * cStringData(const char * str) noexcept { return str ? str : ""; }
+
+            template<typename T>
+            static std::size_t stringSize(const T & str, Tag<FmtCString>) noexcept { return cStringSize(str); }
+
+            template<typename T>
+            static std::size_t stringSize(const T & str, Tag<FmtString>) noexcept { return str.size(); }
+
+            template<typename T, eMessageFormat F>
+            static std::size_t stringSize(const T &, Tag<F>) noexcept { return 0; }
+
+            //---------------------------------------------------------------
+
+            template<typename T, eMessageFormat F>
+            static char * encode(char * out, std::size_t &, const T & arg, Tag<F>) noexcept {
+                return copy(out, typename ValueType<F>::type(arg));
+            }
+
+            template<typename T>
+            static char * encode(char * out, std::size_t &, const T & arg, Tag<FmtPointer>) noexcept {
+                return copy(out, std::uint64_t(reinterpret_cast<std::uintptr_t>(arg)));
+            }
+
+            template<typename T>
+            static char * encode(char * out, std::size_t & budget, const T & arg, Tag<FmtCString>) noexcept {
+                return encodeString(out, budget, cStringData(arg), cStringSize(arg));
+            }
+
+            template<typename T>
+            static char * encode(char * out, std::size_t & budget, const T & arg, Tag<FmtString>) noexcept {
+                return encodeString(out, budget, arg.data(), arg.size());
+            }
+
+            static char * encodeString(char * out, std::size_t & budget, const char * data, std::size_t length) noexcept {
+                length = spend(budget, length);
+                out = copy(out, std::uint32_t(length));
+                std::memcpy(out, data, length);
+                return out + length;
+            }
+
+        };
+
+    }
+
+    /**************************************************************************************************/
+    ////////////////////////////////////////////////////////////////////////////////////////////////////
+    /**************************************************************************************************/
+
+    /*!
+     * \brief Logger that moves the message formatting to a background thread.
+     * \details A log call copies the raw arguments (numbers, pointers and string bytes),
+     *          the pointer to the static \link DeferredSite \endlink and the time
+     *          into the buffer of the calling thread.
+     *          The background thread formats the messages the same way as \link LogMessage \endlink does
+     *          and passes them to the target logger, so the target's handlers
+     *          (e.g. \link BaseLogger::defaultHandler \endlink patterns) are used for printing,
+     *          and they are called from the background thread.
+     *          %TM prints the time of the log call.
+     * \details The messages of one thread are printed in their order,
+     *          the messages of different threads may be interleaved in any way.
+     *          If the thread's buffer is full the log call waits until the background thread frees it,
+     *          except the calls of the target's handlers on the background thread itself,
+     *          their messages are dropped and counted, see \link DeferredLogger::dropped \endlink
+     *          The strings of the message that doesn't fit the half of the buffer are cut.
+     * \details The target logger must outlive this one.
+     * \code
+     * BaseLogger logger("my logger");
+     * DeferredLogger deferred(logger);
+     * LDeferred(deferred, BaseLogger::LvlInfo, "value: ", 42, " ratio: ", 0.5);
+     * LcDeferred(deferred, "my category", BaseLogger::LvlDebug, "name: ", name);
+     * \endcode
+     */
+    class DeferredLogger final {
+    public:
+
+        typedef BaseLogger::StringView StringView;
+
+        static const std::size_t DefaultBufferSize = 256 * 1024;
+
+        //---------------------------------------------------------------
+        /// @{
+
+        /*!
+         * \details Starts the background thread.
+         * \param [in] target the logger that prints the messages.
+         * \param [in] bufferSize size of the buffer of each thread that logs, bytes.
+         */
+        LoggingExp explicit DeferredLogger(const BaseLogger & target, std::size_t bufferSize = DefaultBufferSize);
+
+        /*!
+         * \details Prints all the logged messages and stops the background thread.
+         */
+        LoggingExp ~DeferredLogger() noexcept;
+
+        DeferredLogger(const DeferredLogger &) = delete;
+        DeferredLogger & operator=(const DeferredLogger &) = delete;
+
+        /// @}
+        //---------------------------------------------------------------
+        /// @{
+
+        /*!
+         * \details Copies the message to the buffer of the calling thread.
+         *          The arguments are concatenated like \link LogMessage::write \endlink does.
+         * \param [in] site
+         * \param [in] args numbers, pointers, chars and strings.
+         */
+        template<typename... Args>
+        void log(const DeferredSite & site, const Args & ... args) noexcept {
+            try {
+                internal::SpscRing & ring = mRings.local();
+                const std::size_t fixedSize = HeaderSize + internal::DeferredArgs::fixedSize(args...);
+                if (fixedSize > ring.maxRecordSize()) {
+                    return;
+                }
+                std::size_t budget = ring.maxRecordSize() - fixedSize;
+                const std::size_t stringsBudget = budget;
+                char * out = reserve(ring, fixedSize + internal::DeferredArgs::stringsSize(budget, args...));
+                if (!out) {
+                    return;
+                }
+                const DeferredSite * sitePtr = &site;
+                const TimeSource::Stamp time = TimeSource::capture();
+                std::memcpy(out, &sitePtr, sizeof(sitePtr));
+                std::memcpy(out + sizeof(sitePtr), &time, sizeof(time));
+                budget = stringsBudget;
+                internal::DeferredArgs::write(out + HeaderSize, budget, args...);
+                ring.commit();
+            }
+            catch (const std::exception & e) {
+                std::cerr << colorize::red << e.what() << " [" << __STS_FUNC_NAME__ << "]"
+                        << colorize::reset << std::endl;
+            }
+            catch (...) {
+                std::cerr << colorize::red << "unknown exception [" << __STS_FUNC_NAME__ << "]"
+                        << colorize::reset << std::endl;
+            }
+        }
+
+        /*!
+         * \details Waits until all the messages logged before the call are printed.
+         */
+        LoggingExp void flush() noexcept;
+
+        /// @}
+        //---------------------------------------------------------------
+        /// @{
+
+        /*!
+         * \details Checks whether a message with the specified level will be printed by the target logger.
+         * \param [in] level
+         */
+        bool isEnabled(const std::size_t level) const noexcept { return mTarget.isEnabled(level); }
+
+        /*!
+         * \return Number of the messages that were logged by the background thread when its buffer was full.
+         */
+        std::size_t dropped() const noexcept { return mDropped.load(std::memory_order_relaxed); }
+
+        const BaseLogger & target() const noexcept { return mTarget; }
+
+        /// @}
+        //---------------------------------------------------------------
+
+    private:
+
+        static const std::size_t HeaderSize = sizeof(const DeferredSite *) + sizeof(TimeSource::Stamp);
+
+        /*!
+         * \return Memory for the record or nullptr if it is dropped.
+         */
+        LoggingExp char * reserve(internal::SpscRing & ring, std::size_t size) noexcept;
+
+        void run() noexcept;
+        std::size_t drain(internal::SpscRing & ring, internal::MessageBuffer & buffer) noexcept;
+        void print(const char * record, std::size_t size, internal::MessageBuffer & buffer) const;
+
+        const BaseLogger & mTarget;
+        internal::ThreadRings mRings;
+
+        std::mutex mMutex;
+        std::condition_variable mWake;
+        std::condition_variable mFlushed;
+        std::uint64_t mFlushRequested = 0;
+        std::uint64_t mFlushDone = 0;
+        bool mStop = false;
+        std::atomic<std::size_t> mDropped{0};
+        std::thread mThread;
+
+    };
+
+}
+}
+
+/**************************************************************************************************/
+////////////////////////////////////////////////////////////////////////////////////////////////////
+/**************************************************************************************************/
+
+/*!
+ * \details define this macro if you have macro conflicts
+ *          and then make your one macros like this.
+ */
+#ifndef STSFF_LOGGER_DON_NOT_USE_MACROS
+
+// The call site is described with a static variable, only the pointer to it is copied by the log call,
+// so the level must be a compile time constant and the category must be a string literal.
+// The arguments aren't evaluated if the level is filtered out.
+#   define LDeferred(D,LVL,...) \
+        do { \
+            static const stsff::logging::DeferredSite stsffDeferredSite( \
+                    std::integral_constant<std::size_t, (LVL)>::value, \
+                    stsff::logging::DeferredSite::StringView(), MakeCodeLocation()); \
+            if (STSFF_LOGGER_IS_COMPILED(LVL) && (D).isEnabled(LVL)) { \
+                (D).log(stsffDeferredSite, __VA_ARGS__); \
+            } \
+        } while (false)
+
+#   define LcDeferred(D,C,LVL,...) \
+        do { \
+            static const stsff::logging::DeferredSite stsffDeferredSite( \
+                    std::integral_constant<std::size_t, (LVL)>::value, \
+                    stsff::logging::DeferredSite::StringView("" C), MakeCodeLocation()); \
+            if (STSFF_LOGGER_IS_COMPILED(LVL) && (D).isEnabled(LVL)) { \
+                (D).log(stsffDeferredSite, __VA_ARGS__); \
+            } \
+        } while (false)
+
+#endif
+
+/**************************************************************************************************/
+////////////////////////////////////////////////////////////////////////////////////////////////////
+/**************************************************************************************************/
@@ -0,0 +1,166 @@
+#pragma once
+
+/*
+**  Copyright(C) 2019, StepToSky and FlightFactor
+**  All rights reserved
+**
+**  Redistribution and use in source and binary forms, with or without
+**  modification, are permitted provided that the following conditions are met:
+**
+**  1.Redistributions of source code must retain the above copyright notice, this
+**    list of conditions and the following disclaimer.
+**  2.Redistributions in binary form must reproduce the above copyright notice,
+**    this list of conditions and the following disclaimer in the documentation
+**    and / or other materials provided with the distribution.
+**  3.The name of StepToSky or the name of FlightFactor or the names of its
+**    contributors may NOT be used to endorse or promote products derived from
+**    this software without specific prior written permission.
+**
+**  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+**  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+**  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+**  DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+**  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+**  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+**  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+**  ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+**  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+**  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**
+**  Contacts: www.steptosky.com or www.flightfactor.aero
+*/
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include "stsff/logging/BaseLogger.h"
+#include "stsff/logging/FormatPattern.h"
+
+/**************************************************************************************************/
+////////////////////////////////////////////////////////////////////////////////////////////////////
+/**************************************************************************************************/
+
+namespace stsff {
+namespace logging {
+
+    /*!
+     * \brief Level handler that appends the messages to a file through a large buffer.
+     * \details The message is rendered into the thread's buffer and copied into the sink's buffer,
+     *          the buffer is written with one call when it is full, when the flush policy requires it
+     *          or when \link FileSink::flush \endlink is called.
+     * \details The copies of the sink share the file and the buffer, so the same sink can be set
+     *          for several levels and several loggers. The buffer is written when the last copy is destroyed.
+     * \details The errors are printed to std::cerr, the messages are dropped if the file can't be opened.
+     * \code
+     * FileSink sink("app.log", "%TM(%Y-%m-%d %T.%3N) %LN %MC %MS");
+     * sink.setSyncLevel(BaseLogger::LvlError);
+     * logger.setHandler(BaseLogger::LvlInfo, sink);
+     * logger.setHandler(BaseLogger::LvlError, sink);
+     * \endcode
+     */
+    class FileSink {
+    public:
+
+        typedef BaseLogger::FlushPolicy FlushPolicy;
+
+        static const std::size_t DefaultBufferSize = 1024 * 1024;
+
+        //---------------------------------------------------------------
+        /// @{
+
+        /*!
+         * \details Opens the file for appending, the file is created if it doesn't exist.
+         * \param [in] fileName
+         * \param [in] pattern see \link BaseLogger::defaultHandler \endlink
+         * \param [in] bufferSize
+         */
+        LoggingExp FileSink(const std::string & fileName, const FormatPattern & pattern,
+                            std::size_t bufferSize = DefaultBufferSize);
+
+        /*!
+         * \param [in] fileName
+         * \param [in] formatting see \link BaseLogger::defaultHandler \endlink
+         * \param [in] bufferSize
+         */
+        FileSink(const std::string & fileName, const std::string & formatting,
+                 const std::size_t bufferSize = DefaultBufferSize)
+            : FileSink(fileName, FormatPattern(formatting), bufferSize) {}
+
+        FileSink(const FileSink &) = default;
+        FileSink(FileSink &&) = default;
+        FileSink & operator=(const FileSink &) = default;
+        FileSink & operator=(FileSink &&) = default;
+
+        ~FileSink() = default;
+
+        /// @}
+        //---------------------------------------------------------------
+        /// @{
+
+        /*!
+         * \details Writes the message, it has the signature of \link BaseLogger::LevelHandler \endlink
+         * \param [in] logger
+         * \param [in] logMsg
+         */
+        LoggingExp void operator()(const BaseLogger & logger, const BaseLogger::LogMsg & logMsg) const;
+
+        /*!
+         * \details Writes the buffered messages into the file.
+         */
+        LoggingExp void flush() const noexcept;
+
+        /*!
+         * \details Writes the buffered messages and waits until the file data is on the disk.
+         */
+        LoggingExp void sync() const noexcept;
+
+        /// @}
+        //---------------------------------------------------------------
+        /// @{
+
+        /*!
+         * \details When the buffer is written before it is full.
+         *          Default is \link BaseLogger::FlushPolicy::never \endlink, so only the critical messages
+         *          are written at once.
+         * \param [in] policy
+         */
+        LoggingExp void setFlushPolicy(const FlushPolicy & policy) noexcept;
+
+        /*!
+         * \details The messages with the level or more important ones are written
+         *          and synchronized with the disk at once, see \link FileSink::sync \endlink
+         *          Default is 0 that means no synchronization.
+         * \param [in] level
+         */
+        LoggingExp void setSyncLevel(std::size_t level) noexcept;
+
+        /// @}
+        //---------------------------------------------------------------
+        /// @{
+
+        LoggingExp const std::string & fileName() const noexcept;
+        LoggingExp bool isOpen() const noexcept;
+
+        /*!
+         * \return Number of the bytes written into the file, the buffered ones are not counted.
+         */
+        LoggingExp std::uint64_t written() const noexcept;
+
+        /// @}
+        //---------------------------------------------------------------
+
+    private:
+
+        class File;
+
+        std::shared_ptr<File> mFile;
+
+    };
+
+    /**************************************************************************************************/
+    ////////////////////////////////////////////////////////////////////////////////////////////////////
+    /**************************************************************************************************/
+
+}
+}
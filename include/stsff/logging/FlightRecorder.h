@@ -0,0 +1,158 @@
+#pragma once
+
+/*
+**  Copyright(C) 2019, StepToSky and FlightFactor
+**  All rights reserved
+**
+**  Redistribution and use in source and binary forms, with or without
+**  modification, are permitted provided that the following conditions are met:
+**
+**  1.Redistributions of source code must retain the above copyright notice, this
+**    list of conditions and the following disclaimer.
+**  2.Redistributions in binary form must reproduce the above copyright notice,
+**    this list of conditions and the following disclaimer in the documentation
+**    and / or other materials provided with the distribution.
+**  3.The name of StepToSky or the name of FlightFactor or the names of its
+**    contributors may NOT be used to endorse or promote products derived from
+**    this software without specific prior written permission.
+**
+**  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+**  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+**  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+**  DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+**  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+**  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+**  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+**  ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+**  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+**  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**
+**  Contacts: www.steptosky.com or www.flightfactor.aero
+*/
+
+#include <cstddef>
+#include <cstdint>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include "stsff/logging/BaseLogger.h"
+
+/**************************************************************************************************/
+////////////////////////////////////////////////////////////////////////////////////////////////////
+/**************************************************************************************************/
+
+namespace stsff {
+namespace logging {
+
+    /*!
+     * \brief Fixed-size in-memory history of the messages that are below the logger's level.
+     * \details The logger with the attached recorder copies the messages that are more verbose than
+     *          its level but not more verbose than the capture level (text, category, code location,
+     *          level and the time of the call) into the recorder instead of skipping them.
+     *          The messages are not formatted and the memory is allocated once by the constructor,
+     *          the oldest messages are overwritten when the ring is full.
+     *          When a message with the trigger level or a more important one is logged, the recorded messages
+     *          are passed to the logger's handlers in the order they were logged, with their original time,
+     *          before the triggering message. See \link BaseLogger::setFlightRecorder \endlink
+     * \details The memory is split into the rings, each thread writes to the ring that is chosen
+     *          by the thread's number, so the threads usually don't contend. The messages
+     *          that don't fit a quarter of the ring are cut.
+     * \code
+     * logger.setLevel(BaseLogger::LvlInfo);
+     * logger.setFlightRecorder(std::make_shared<FlightRecorder>(64 * 1024, 8),
+     *                          BaseLogger::LvlDebug, BaseLogger::LvlError);
+     * LDebug(logger) << "not printed, recorded"; // printed before the next error.
+     * \endcode
+     */
+    class FlightRecorder {
+    public:
+
+        typedef BaseLogger::LogMsg LogMsg;
+
+        static const std::size_t DefaultRingSize = 32 * 1024;
+        static const std::size_t DefaultRings = 8;
+        static const std::size_t MinRingSize = 1024;
+
+        //---------------------------------------------------------------
+        /// @{
+
+        /*!
+         * \details The memory budget is ringSize * rings bytes.
+         * \param [in] ringSize bytes of each ring, it is rounded up to 8 and to \link FlightRecorder::MinRingSize \endlink
+         * \param [in] rings number of the rings, at least 1.
+         * \exception std::bad_alloc if the memory can't be allocated.
+         */
+        LoggingExp explicit FlightRecorder(std::size_t ringSize = DefaultRingSize, std::size_t rings = DefaultRings);
+        LoggingExp ~FlightRecorder() noexcept;
+
+        FlightRecorder(const FlightRecorder &) = delete;
+        FlightRecorder & operator=(const FlightRecorder &) = delete;
+
+        /// @}
+        //---------------------------------------------------------------
+        /// @{
+
+        /*!
+         * \details Copies the message into the ring of the calling thread, it doesn't allocate.
+         * \param [in] logMsg
+         */
+        LoggingExp void capture(const LogMsg & logMsg) noexcept;
+
+        /*!
+         * \details Takes all the recorded messages out of the rings and passes them to the function
+         *          in the order they were captured. The function is called without the locks,
+         *          so it can log, the messages captured meanwhile are kept for the next dump.
+         * \param [in] fn
+         * \return Number of the passed messages.
+         */
+        LoggingExp std::size_t dump(const std::function<void(const LogMsg &)> & fn);
+
+        /*!
+         * \details Discards the recorded messages.
+         */
+        LoggingExp void clear() noexcept;
+
+        /// @}
+        //---------------------------------------------------------------
+        /// @{
+
+        /*!
+         * \return Number of the messages that are in the rings now.
+         */
+        LoggingExp std::size_t records() const noexcept;
+
+        /*!
+         * \return Number of the messages that were overwritten before they were dumped.
+         */
+        std::uint64_t overwritten() const noexcept { return mOverwritten.load(std::memory_order_relaxed); }
+
+        /*!
+         * \return Bytes of all the rings.
+         */
+        std::size_t memoryBudget() const noexcept { return mRingSize * mRingCount; }
+
+        std::size_t ringSize() const noexcept { return mRingSize; }
+        std::size_t rings() const noexcept { return mRingCount; }
+
+        /// @}
+        //---------------------------------------------------------------
+
+    private:
+
+        struct Ring;
+
+        const std::size_t mRingSize;
+        const std::size_t mRingCount;
+        std::unique_ptr<char[]> mMemory;
+        std::unique_ptr<Ring[]> mRings;
+        std::atomic<std::uint64_t> mSequence{0};
+        std::atomic<std::uint64_t> mOverwritten{0};
+
+    };
+
+    /**************************************************************************************************/
+    ////////////////////////////////////////////////////////////////////////////////////////////////////
+    /**************************************************************************************************/
+
+}
+}
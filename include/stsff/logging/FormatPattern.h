@@ -0,0 +1,170 @@
+#pragma once
+
+/*
+**  Copyright(C) 2019, StepToSky and FlightFactor
+**  All rights reserved
+**
+**  Redistribution and use in source and binary forms, with or without
+**  modification, are permitted provided that the following conditions are met:
+**
+**  1.Redistributions of source code must retain the above copyright notice, this
+**    list of conditions and the following disclaimer.
+**  2.Redistributions in binary form must reproduce the above copyright notice,
+**    this list of conditions and the following disclaimer in the documentation
+**    and / or other materials provided with the distribution.
+**  3.The name of StepToSky or the name of FlightFactor or the names of its
+**    contributors may NOT be used to endorse or promote products derived from
+**    this software without specific prior written permission.
+**
+**  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+**  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+**  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+**  DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+**  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+**  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+**  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+**  ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+**  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+**  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**
+**  Contacts: www.steptosky.com or www.flightfactor.aero
+*/
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "stsff/logging/Export.h"
+#include "internal/InternalUtils.h"
+
+/**************************************************************************************************/
+////////////////////////////////////////////////////////////////////////////////////////////////////
+/**************************************************************************************************/
+
+namespace stsff {
+namespace logging {
+
+    /*!
+     * \brief Formatting string of \link BaseLogger::defaultHandler \endlink that is parsed once.
+     * \details The formatting string is split into the literal spans and the commands
+     *          at construction, so printing a message just walks the tokens.
+     * \details The errors in the formatting string are reported once to std::cerr when the pattern is created,
+     *          the invalid commands are skipped while printing.
+     * \code
+     * static const FormatPattern pattern("INF: %LN %MC %MS");
+     * BaseLogger::defaultHandler(l, m, std::clog, pattern, colorize::cyan);
+     * \endcode
+     * \see \link BaseLogger::defaultHandler \endlink for the commands description.
+     */
+    class FormatPattern {
+    public:
+
+        typedef internal::CustStringView StringView;
+
+        //---------------------------------------------------------------
+        /// @{
+
+        /*!
+         * \details The token operations.
+         */
+        enum eOp : std::uint8_t {
+            OpLiteral,         //!< text of the token.
+            OpError,           //!< error text of the token, only with \link FormatPattern::ErrorsInline \endlink
+            OpLogName,         //!< \%LN
+            OpMessageCategory, //!< \%MC
+            OpMessage,         //!< \%MS
+            OpFunctionName,    //!< \%FN
+            OpFileName,        //!< \%FI
+            OpFileLine,        //!< \%LI
+            OpLevel,           //!< \%LV
+            OpTime,            //!< \%TM(...), text of the token is the null-terminated std::strftime format.
+        };
+
+        /*!
+         * \details How the formatting errors are reported.
+         */
+        enum eErrors {
+            ErrorsOnce,   //!< print the errors to std::cerr once while parsing.
+            ErrorsInline, //!< keep the errors as the tokens, so they are printed with each message.
+        };
+
+        /*!
+         * \details One operation of the pattern.
+         */
+        struct Token {
+            eOp mOp;
+            std::uint32_t mOffset; //!< offset of the token's text in the pattern's text.
+            std::uint32_t mSize;   //!< size of the token's text.
+        };
+
+        /// @}
+        //---------------------------------------------------------------
+        /// @{
+
+        FormatPattern() = default;
+
+        /*!
+         * \param [in] formatting see \link BaseLogger::defaultHandler \endlink
+         * \param [in] errors
+         */
+        LoggingExp explicit FormatPattern(const std::string & formatting, eErrors errors = ErrorsOnce);
+
+        FormatPattern(const FormatPattern &) = default;
+        FormatPattern(FormatPattern &&) = default;
+        FormatPattern & operator=(const FormatPattern &) = default;
+        FormatPattern & operator=(FormatPattern &&) = default;
+
+        ~FormatPattern() = default;
+
+        /// @}
+        //---------------------------------------------------------------
+        /// @{
+
+        /*!
+         * \return Formatting string the pattern was created from.
+         */
+        const std::string & formatting() const noexcept { return mFormatting; }
+
+        /*!
+         * \return Tokens in the printing order.
+         */
+        const std::vector<Token> & tokens() const noexcept { return mTokens; }
+
+        /*!
+         * \param [in] token
+         * \return Text of the token.
+         */
+        StringView text(const Token & token) const noexcept {
+            return StringView(mText.data() + token.mOffset, token.mSize);
+        }
+
+        /*!
+         * \return True if the formatting string doesn't have errors.
+         */
+        bool isValid() const noexcept { return mErrors.empty(); }
+
+        /*!
+         * \return Errors of the formatting string, one per line, or empty string.
+         */
+        const std::string & errors() const noexcept { return mErrors; }
+
+        /// @}
+        //---------------------------------------------------------------
+
+    private:
+
+        void add(eOp op, const char * data, std::size_t size);
+        void error(eErrors errors, const std::string & text);
+
+        std::string mFormatting;
+        std::string mText;
+        std::string mErrors;
+        std::vector<Token> mTokens;
+
+    };
+
+    /**************************************************************************************************/
+    ////////////////////////////////////////////////////////////////////////////////////////////////////
+    /**************************************************************************************************/
+
+}
+}
@@ -0,0 +1,183 @@
+#pragma once
+
+/*
+**  Copyright(C) 2019, StepToSky and FlightFactor
+**  All rights reserved
+**
+**  Redistribution and use in source and binary forms, with or without
+**  modification, are permitted provided that the following conditions are met:
+**
+**  1.Redistributions of source code must retain the above copyright notice, this
+**    list of conditions and the following disclaimer.
+**  2.Redistributions in binary form must reproduce the above copyright notice,
+**    this list of conditions and the following disclaimer in the documentation
+**    and / or other materials provided with the distribution.
+**  3.The name of StepToSky or the name of FlightFactor or the names of its
+**    contributors may NOT be used to endorse or promote products derived from
+**    this software without specific prior written permission.
+**
+**  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+**  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+**  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+**  DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+**  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+**  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+**  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+**  ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+**  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+**  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**
+**  Contacts: www.steptosky.com or www.flightfactor.aero
+*/
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include "stsff/logging/BaseLogger.h"
+#include "stsff/logging/FormatPattern.h"
+
+/**************************************************************************************************/
+////////////////////////////////////////////////////////////////////////////////////////////////////
+/**************************************************************************************************/
+
+namespace stsff {
+namespace logging {
+
+    /*!
+     * \brief Level handler that writes the messages into the memory-mapped preallocated files.
+     * \details The messages are written into the segments "<name>.1", "<name>.2" etc.,
+     *          the numbering continues after the largest existing segment.
+     *          Each segment is preallocated with the fixed size and mapped into the memory.
+     *          The thread reserves the space for its rendered line with an atomic increment
+     *          and copies the line into the mapping, so writing a message has no system calls and no locks.
+     * \details The background thread creates, preallocates and maps the next segment beforehand
+     *          and writes into its pages, so neither the switchover nor the first write into a page
+     *          makes the logging thread enter the kernel.
+     *          It also unmaps the full segments when all the threads have finished copying into them
+     *          and truncates the unused tail, so a closed segment has the lines only.
+     * \details The data is written back by the system unless the synchronization is set with
+     *          \link MappedFileSink::setSyncInterval \endlink or \link MappedFileSink::setSyncLevel \endlink
+     * \details The first byte of a line is stored after the others, so after a crash
+     *          the segment consists of the complete lines followed by the partially written ones
+     *          and the zeros of the unused tail, see \link MappedFileSink::recover \endlink.
+     *          The segments left by the crashed process are recovered when the sink is created,
+     *          the empty ones at the end, e.g. the spare one, are removed.
+     * \details The lines are in the order of the reservation, a line longer than the segment is cut.
+     * \details It is implemented for the POSIX systems only, on the other systems an error is printed
+     *          and the messages are dropped.
+     * \code
+     * MappedFileSink sink("app.log", "%TM(%Y-%m-%d %T.%3N) %LN %MC %MS");
+     * sink.setSyncInterval(1000);
+     * logger.setHandler(BaseLogger::LvlInfo, sink);
+     * \endcode
+     */
+    class MappedFileSink {
+    public:
+
+        static const std::size_t DefaultSegmentSize = 64 * 1024 * 1024;
+
+        //---------------------------------------------------------------
+        /// @{
+
+        /*!
+         * \details Recovers the segments left by the crashed process, creates the new one
+         *          and starts the background thread.
+         * \param [in] fileName base name of the segments.
+         * \param [in] pattern see \link BaseLogger::defaultHandler \endlink
+         * \param [in] segmentSize
+         */
+        LoggingExp MappedFileSink(const std::string & fileName, const FormatPattern & pattern,
+                                  std::size_t segmentSize = DefaultSegmentSize);
+
+        /*!
+         * \param [in] fileName base name of the segments.
+         * \param [in] formatting see \link BaseLogger::defaultHandler \endlink
+         * \param [in] segmentSize
+         */
+        MappedFileSink(const std::string & fileName, const std::string & formatting,
+                       const std::size_t segmentSize = DefaultSegmentSize)
+            : MappedFileSink(fileName, FormatPattern(formatting), segmentSize) {}
+
+        MappedFileSink(const MappedFileSink &) = default;
+        MappedFileSink(MappedFileSink &&) = default;
+        MappedFileSink & operator=(const MappedFileSink &) = default;
+        MappedFileSink & operator=(MappedFileSink &&) = default;
+
+        ~MappedFileSink() = default;
+
+        /// @}
+        //---------------------------------------------------------------
+        /// @{
+
+        /*!
+         * \details Writes the message, it has the signature of \link BaseLogger::LevelHandler \endlink
+         * \param [in] logger
+         * \param [in] logMsg
+         */
+        LoggingExp void operator()(const BaseLogger & logger, const BaseLogger::LogMsg & logMsg) const;
+
+        /*!
+         * \details The background thread synchronizes the current segment with the disk
+         *          with the interval. Default is 0 that means no periodic synchronization.
+         * \param [in] milliseconds
+         */
+        LoggingExp void setSyncInterval(std::int64_t milliseconds) noexcept;
+
+        /*!
+         * \details The thread that writes a message with the level or a more important one
+         *          synchronizes the message pages with the disk.
+         *          Default is 0 that means no synchronization.
+         * \param [in] level
+         */
+        LoggingExp void setSyncLevel(std::size_t level) noexcept;
+
+        /// @}
+        //---------------------------------------------------------------
+        /// @{
+
+        LoggingExp const std::string & fileName() const noexcept;
+        LoggingExp std::size_t segmentSize() const noexcept;
+        LoggingExp bool isOpen() const noexcept;
+
+        /*!
+         * \return Number of the current segment, its file name is "<name>.<number>".
+         */
+        LoggingExp std::size_t segment() const noexcept;
+
+        /*!
+         * \return Number of the bytes copied into the segments.
+         */
+        LoggingExp std::uint64_t written() const noexcept;
+
+        /// @}
+        //---------------------------------------------------------------
+        /// @{
+
+        /*!
+         * \details Truncates the segment after the last complete line.
+         *          The segment is scanned from the beginning line by line,
+         *          the scanning stops at the line that starts with a zero byte or doesn't have the end.
+         *          The complete lines after a partially written one are lost.
+         * \param [in] segmentFileName
+         * \return The new size of the file or -1 if the file can't be read.
+         */
+        LoggingExp static std::int64_t recover(const std::string & segmentFileName) noexcept;
+
+        /// @}
+        //---------------------------------------------------------------
+
+    private:
+
+        class Mapping;
+
+        std::shared_ptr<Mapping> mMapping;
+
+    };
+
+    /**************************************************************************************************/
+    ////////////////////////////////////////////////////////////////////////////////////////////////////
+    /**************************************************************************************************/
+
+}
+}
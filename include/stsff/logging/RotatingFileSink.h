@@ -0,0 +1,196 @@
+#pragma once
+
+/*
+**  Copyright(C) 2019, StepToSky and FlightFactor
+**  All rights reserved
+**
+**  Redistribution and use in source and binary forms, with or without
+**  modification, are permitted provided that the following conditions are met:
+**
+**  1.Redistributions of source code must retain the above copyright notice, this
+**    list of conditions and the following disclaimer.
+**  2.Redistributions in binary form must reproduce the above copyright notice,
+**    this list of conditions and the following disclaimer in the documentation
+**    and / or other materials provided with the distribution.
+**  3.The name of StepToSky or the name of FlightFactor or the names of its
+**    contributors may NOT be used to endorse or promote products derived from
+**    this software without specific prior written permission.
+**
+**  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+**  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+**  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+**  DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+**  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+**  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+**  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+**  ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+**  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+**  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**
+**  Contacts: www.steptosky.com or www.flightfactor.aero
+*/
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include "stsff/logging/BaseLogger.h"
+#include "stsff/logging/FormatPattern.h"
+
+/**************************************************************************************************/
+////////////////////////////////////////////////////////////////////////////////////////////////////
+/**************************************************************************************************/
+
+namespace stsff {
+namespace logging {
+
+    /*!
+     * \brief Level handler that writes the messages to a file and rotates it by size or by time.
+     * \details The messages are buffered like with \link FileSink \endlink.
+     *          When the file reaches \link Rotation::mMaxSize \endlink bytes or the wall-clock time
+     *          crosses the \link Rotation::mIntervalSec \endlink boundary, the logging thread only switches
+     *          its descriptor to the spare file "<name>.next" that the background thread has opened beforehand.
+     *          The background thread closes the old file, renames "<name>" to "<name>.1"
+     *          (the older ones are shifted to "<name>.2" etc., the ones beyond \link Rotation::mKeepFiles \endlink
+     *          are deleted), renames "<name>.next" to "<name>", opens the next spare file and then
+     *          compresses "<name>.1" to "<name>.1.lz" with \link LzCodec \endlink
+     *          If the spare file isn't ready yet, the current file is used until the next message.
+     * \details If "<name>.next" isn't empty when the sink is created, the previous process was stopped
+     *          in the middle of the rotation, so the rotation is finished before the file is opened.
+     *          The empty one is just the idle spare file of the previous process and it is reused.
+     *          The old files that the previous process hasn't compressed are compressed in the background.
+     * \details The renaming relies on the POSIX semantics, on Windows the opened files can't be renamed,
+     *          so the errors are printed and the messages continue to go to the spare file.
+     * \details The copies of the sink share the file, the background thread is stopped
+     *          when the last copy is destroyed, after it has finished the started rotations.
+     * \code
+     * RotatingFileSink sink("app.log", "%TM(%Y-%m-%d %T.%3N) %LN %MC %MS",
+     *                       RotatingFileSink::Rotation::bySize(64 * 1024 * 1024).keep(10));
+     * logger.setHandler(BaseLogger::LvlInfo, sink);
+     * \endcode
+     */
+    class RotatingFileSink {
+    public:
+
+        typedef BaseLogger::FlushPolicy FlushPolicy;
+
+        static const std::size_t DefaultBufferSize = 1024 * 1024;
+
+        /*!
+         * \details When the file is rotated and how many old files are kept.
+         *          Both the size and the time can be set, the file is rotated when any of them is reached.
+         */
+        struct Rotation {
+            std::uint64_t mMaxSize = 0;    //!< 0 means that the size isn't checked.
+            std::int64_t mIntervalSec = 0; //!< 0 means that the time isn't checked, the boundaries are aligned to UTC.
+            std::size_t mKeepFiles = 5;    //!< Number of the old files, 0 means that the old file is deleted.
+            bool mCompress = true;         //!< The old files are compressed with \link LzCodec \endlink.
+
+            static Rotation bySize(const std::uint64_t maxSize) noexcept {
+                Rotation rotation;
+                rotation.mMaxSize = maxSize;
+                return rotation;
+            }
+
+            //! E.g. 86400 rotates the file at the midnight UTC.
+            static Rotation byInterval(const std::int64_t seconds) noexcept {
+                Rotation rotation;
+                rotation.mIntervalSec = seconds;
+                return rotation;
+            }
+
+            Rotation & keep(const std::size_t files) noexcept {
+                mKeepFiles = files;
+                return *this;
+            }
+
+            Rotation & compress(const bool enabled) noexcept {
+                mCompress = enabled;
+                return *this;
+            }
+        };
+
+        //---------------------------------------------------------------
+        /// @{
+
+        /*!
+         * \details Opens the file for appending, the file is created if it doesn't exist,
+         *          and starts the background thread.
+         * \param [in] fileName
+         * \param [in] pattern see \link BaseLogger::defaultHandler \endlink
+         * \param [in] rotation
+         * \param [in] bufferSize
+         */
+        LoggingExp RotatingFileSink(const std::string & fileName, const FormatPattern & pattern,
+                                    const Rotation & rotation, std::size_t bufferSize = DefaultBufferSize);
+
+        /*!
+         * \param [in] fileName
+         * \param [in] formatting see \link BaseLogger::defaultHandler \endlink
+         * \param [in] rotation
+         * \param [in] bufferSize
+         */
+        RotatingFileSink(const std::string & fileName, const std::string & formatting,
+                         const Rotation & rotation, const std::size_t bufferSize = DefaultBufferSize)
+            : RotatingFileSink(fileName, FormatPattern(formatting), rotation, bufferSize) {}
+
+        RotatingFileSink(const RotatingFileSink &) = default;
+        RotatingFileSink(RotatingFileSink &&) = default;
+        RotatingFileSink & operator=(const RotatingFileSink &) = default;
+        RotatingFileSink & operator=(RotatingFileSink &&) = default;
+
+        ~RotatingFileSink() = default;
+
+        /// @}
+        //---------------------------------------------------------------
+        /// @{
+
+        /*!
+         * \details Writes the message, it has the signature of \link BaseLogger::LevelHandler \endlink
+         * \param [in] logger
+         * \param [in] logMsg
+         */
+        LoggingExp void operator()(const BaseLogger & logger, const BaseLogger::LogMsg & logMsg) const;
+
+        /*!
+         * \details Writes the buffered messages into the current file.
+         */
+        LoggingExp void flush() const noexcept;
+
+        /*!
+         * \details When the buffer is written before it is full.
+         *          Default is \link BaseLogger::FlushPolicy::never \endlink
+         * \param [in] policy
+         */
+        LoggingExp void setFlushPolicy(const FlushPolicy & policy) noexcept;
+
+        /// @}
+        //---------------------------------------------------------------
+        /// @{
+
+        LoggingExp const std::string & fileName() const noexcept;
+        LoggingExp const Rotation & rotation() const noexcept;
+        LoggingExp bool isOpen() const noexcept;
+
+        /*!
+         * \return Number of the rotations that the background thread has finished.
+         */
+        LoggingExp std::size_t rotations() const noexcept;
+
+        /// @}
+        //---------------------------------------------------------------
+
+    private:
+
+        class File;
+
+        std::shared_ptr<File> mFile;
+
+    };
+
+    /**************************************************************************************************/
+    ////////////////////////////////////////////////////////////////////////////////////////////////////
+    /**************************************************************************************************/
+
+}
+}
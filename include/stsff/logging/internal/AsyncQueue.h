@@ -0,0 +1,262 @@
+#pragma once
+
+/*
+**  Copyright(C) 2019, StepToSky and FlightFactor
+**  All rights reserved
+**
+**  Redistribution and use in source and binary forms, with or without
+**  modification, are permitted provided that the following conditions are met:
+**
+**  1.Redistributions of source code must retain the above copyright notice, this
+**    list of conditions and the following disclaimer.
+**  2.Redistributions in binary form must reproduce the above copyright notice,
+**    this list of conditions and the following disclaimer in the documentation
+**    and / or other materials provided with the distribution.
+**  3.The name of StepToSky or the name of FlightFactor or the names of its
+**    contributors may NOT be used to endorse or promote products derived from
+**    this software without specific prior written permission.
+**
+**  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+**  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+**  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+**  DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+**  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+**  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+**  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+**  ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+**  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+**  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**
+**  Contacts: www.steptosky.com or www.flightfactor.aero
+*/
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include "stsff/logging/BaseLogger.h"
+#include "MessageBuffer.h"
+
+/**************************************************************************************************/
+////////////////////////////////////////////////////////////////////////////////////////////////////
+/**************************************************************************************************/
+
+namespace stsff {
+namespace logging {
+    namespace internal {
+
+        /*!
+         * \brief Copy of \link BaseLogger::LogMsg \endlink that owns its strings.
+         * \details All the strings are kept in one buffer
+         *          so the typical messages don't need the heap.
+         */
+        class LogRecord final {
+        public:
+
+            //---------------------------------------------------------------
+            /// @{
+
+            /*!
+             * \details Copies the message.
+             * \exception std::bad_alloc if the message doesn't fit the inline buffer and can't be allocated.
+             * \param [in] logMsg
+             * \param [in] time time of the message that is used instead of \link BaseLogger::LogMsg::mTime \endlink
+             */
+            LoggingExp void assign(const BaseLogger::LogMsg & logMsg, const TimeSource::Stamp & time);
+
+            /*!
+             * \details The time is converted with \link TimeSource::toNanoseconds \endlink
+             * \return The message that refers to the record's strings.
+             */
+            LoggingExp BaseLogger::LogMsg logMsg() const noexcept;
+
+            std::size_t level() const noexcept { return mLevel; }
+            const TimeSource::Stamp & time() const noexcept { return mTime; }
+
+            /// @}
+            //---------------------------------------------------------------
+
+        private:
+
+            MessageBuffer mText;
+            std::size_t mCategorySize = 0;
+            std::size_t mMsgSize = 0;
+            std::size_t mFunctionSize = 0;
+            std::size_t mFileSize = 0;
+            std::size_t mLevel = 0;
+            TimeSource::Stamp mTime = {0, false};
+            int mLine = 0;
+
+        };
+
+        /**************************************************************************************************/
+        ////////////////////////////////////////////////////////////////////////////////////////////////////
+        /**************************************************************************************************/
+
+        /*!
+         * \brief Bounded lock-free multi-producer/multi-consumer queue of the log messages.
+         * \details It is D. Vyukov's bounded MPMC queue, each cell has a sequence number
+         *          that tells whether the cell is free for the producer with the position
+         *          or it is ready for the consumer.
+         *          The messages are copied into the preallocated cells so pushing doesn't allocate
+         *          unless a message doesn't fit the cell's inline buffer.
+         */
+        class AsyncQueue final {
+        public:
+
+            //---------------------------------------------------------------
+            /// @{
+
+            /*!
+             * \param [in] capacity number of the messages, it is rounded up to the power of 2.
+             */
+            LoggingExp explicit AsyncQueue(std::size_t capacity);
+
+            AsyncQueue(const AsyncQueue &) = delete;
+            AsyncQueue & operator=(const AsyncQueue &) = delete;
+
+            /// @}
+            //---------------------------------------------------------------
+            /// @{
+
+            /*!
+             * \details Copies the message into the queue.
+             * \param [in] logMsg
+             * \param [in] time see \link LogRecord::assign \endlink
+             * \return False if the queue is full.
+             */
+            bool tryPush(const BaseLogger::LogMsg & logMsg, const TimeSource::Stamp & time) noexcept {
+                std::size_t position = mEnqueuePos.load(std::memory_order_relaxed);
+                Cell * cell;
+                for (;;) {
+                    cell = &mCells[position & mMask];
+                    const std::size_t sequence = cell->mSequence.load(std::memory_order_acquire);
+                    const std::ptrdiff_t diff = std::ptrdiff_t(sequence) - std::ptrdiff_t(position);
+                    if (diff == 0) {
+                        if (mEnqueuePos.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                            break;
+                        }
+                    }
+                    else if (diff < 0) {
+                        return false;
+                    }
+                    else {
+                        position = mEnqueuePos.load(std::memory_order_relaxed);
+                    }
+                }
+                cell->mValid = copy(cell->mRecord, logMsg, time);
+                cell->mSequence.store(position + 1, std::memory_order_release);
+                return true;
+            }
+
+            /*!
+             * \details Calls the function for the oldest message and removes the message after that.
+             *          The messages are removed in their order but if there are several consumers
+             *          their functions may be called concurrently.
+             * \param [in] fn function that takes const \link LogRecord \endlink &
+             * \return False if the queue is empty or the oldest message is still being copied.
+             */
+            template<typename Fn>
+            bool tryPop(Fn && fn) {
+                std::size_t position = mDequeuePos.load(std::memory_order_relaxed);
+                Cell * cell;
+                for (;;) {
+                    cell = &mCells[position & mMask];
+                    const std::size_t sequence = cell->mSequence.load(std::memory_order_acquire);
+                    const std::ptrdiff_t diff = std::ptrdiff_t(sequence) - std::ptrdiff_t(position + 1);
+                    if (diff == 0) {
+                        if (mDequeuePos.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                            break;
+                        }
+                    }
+                    else if (diff < 0) {
+                        return false;
+                    }
+                    else {
+                        position = mDequeuePos.load(std::memory_order_relaxed);
+                    }
+                }
+                struct Release {
+                    ~Release() {
+                        mCell.mSequence.store(mPosition + mQueue.mMask + 1, std::memory_order_release);
+                        mQueue.mReleased.fetch_add(1, std::memory_order_release);
+                    }
+
+                    AsyncQueue & mQueue;
+                    Cell & mCell;
+                    const std::size_t mPosition;
+                } release{*this, *cell, position};
+                if (cell->mValid) {
+                    fn(static_cast<const LogRecord &>(cell->mRecord));
+                }
+                return true;
+            }
+
+            /*!
+             * \details Removes the oldest message without handling it.
+             * \return False if the queue is empty or the oldest message is still being copied.
+             */
+            bool tryDiscard() noexcept {
+                return tryPop([](const LogRecord &) {});
+            }
+
+            /// @}
+            //---------------------------------------------------------------
+            /// @{
+
+            /*!
+             * \details The value is approximate if it is called while the queue is being used.
+             * \return Number of the messages in the queue.
+             */
+            std::size_t size() const noexcept {
+                const std::size_t enqueued = mEnqueuePos.load(std::memory_order_acquire);
+                const std::size_t dequeued = mDequeuePos.load(std::memory_order_acquire);
+                return enqueued > dequeued ? enqueued - dequeued : 0;
+            }
+
+            /*!
+             * \return Number of the messages that have been pushed or are being pushed.
+             */
+            std::size_t pushed() const noexcept { return mEnqueuePos.load(std::memory_order_acquire); }
+
+            /*!
+             * \return Number of the messages that have been handled or discarded.
+             */
+            std::size_t released() const noexcept { return mReleased.load(std::memory_order_acquire); }
+
+            std::size_t capacity() const noexcept { return mMask + 1; }
+
+            /// @}
+            //---------------------------------------------------------------
+
+        private:
+
+            struct Cell {
+                std::atomic<std::size_t> mSequence;
+                bool mValid;
+                LogRecord mRecord;
+            };
+
+            LoggingExp static bool copy(LogRecord & record, const BaseLogger::LogMsg & logMsg,
+                                        const TimeSource::Stamp & time) noexcept;
+
+            std::unique_ptr<Cell[]> mCells;
+            std::size_t mMask;
+
+            // the producers' and the consumer's positions are kept in the different cache lines.
+            char mPad0[64];
+            std::atomic<std::size_t> mEnqueuePos{0};
+            char mPad1[64];
+            std::atomic<std::size_t> mDequeuePos{0};
+            std::atomic<std::size_t> mReleased{0};
+            char mPad2[64];
+
+        };
+
+    }
+}
+}
+
+/**************************************************************************************************/
+////////////////////////////////////////////////////////////////////////////////////////////////////
+/**************************************************************************************************/
@@ -0,0 +1,91 @@
+#pragma once
+
+/*
+**  Copyright(C) 2019, StepToSky and FlightFactor
+**  All rights reserved
+**
+**  Redistribution and use in source and binary forms, with or without
+**  modification, are permitted provided that the following conditions are met:
+**
+**  1.Redistributions of source code must retain the above copyright notice, this
+**    list of conditions and the following disclaimer.
+**  2.Redistributions in binary form must reproduce the above copyright notice,
+**    this list of conditions and the following disclaimer in the documentation
+**    and / or other materials provided with the distribution.
+**  3.The name of StepToSky or the name of FlightFactor or the names of its
+**    contributors may NOT be used to endorse or promote products derived from
+**    this software without specific prior written permission.
+**
+**  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+**  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+**  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+**  DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+**  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+**  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+**  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+**  ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+**  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+**  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**
+**  Contacts: www.steptosky.com or www.flightfactor.aero
+*/
+
+#include <cstddef>
+#include <cstdint>
+#include "stsff/logging/Export.h"
+
+/**************************************************************************************************/
+////////////////////////////////////////////////////////////////////////////////////////////////////
+/**************************************************************************************************/
+
+namespace stsff {
+namespace logging {
+    namespace internal {
+
+        /*!
+         * \brief Locale independent formatting of the numbers.
+         * \details The functions write into the specified memory and return the number of written chars,
+         *          the output is not null-terminated.
+         *          The memory must have at least the corresponding Max*Chars size.
+         */
+        struct FastFormat {
+
+            static const std::size_t MaxUnsignedChars = 20;
+            static const std::size_t MaxSignedChars = 20;
+            static const std::size_t MaxFloatChars = 32;
+            static const std::size_t MaxPointerChars = 2 + sizeof(void*) * 2;
+
+            LoggingExp static std::size_t formatUnsigned(char * out, std::uint64_t value) noexcept;
+            LoggingExp static std::size_t formatSigned(char * out, std::int64_t value) noexcept;
+
+            /*!
+             * \details Representation that is read back to the same value.
+             *          The fixed or the scientific notation is chosen by the length
+             *          the way std::to_chars does it. Examples: "0.1", "100", "1e+21", "1.5e-07", "nan", "-inf".
+             * \details The C++17 builds use std::to_chars, so the representation is the shortest one.
+             *          The C++11 builds use Grisu2 that gives the shortest representation for the most values,
+             *          but a few of them get up to 3 extra digits and the big integers in the fixed notation
+             *          are padded with zeros instead of the exact digits, e.g. "5267145897839138000"
+             *          instead of "5267145897839137792". The output of the two builds may differ for such values.
+             */
+            LoggingExp static std::size_t formatDouble(char * out, double value) noexcept;
+
+            /*!
+             * \copydoc FastFormat::formatDouble
+             */
+            LoggingExp static std::size_t formatFloat(char * out, float value) noexcept;
+
+            /*!
+             * \details Hexadecimal address with the 0x prefix.
+             */
+            LoggingExp static std::size_t formatPointer(char * out, const void * value) noexcept;
+
+        };
+
+    }
+}
+}
+
+/**************************************************************************************************/
+////////////////////////////////////////////////////////////////////////////////////////////////////
+/**************************************************************************************************/
@@ -0,0 +1,147 @@
+#pragma once
+
+/*
+**  Copyright(C) 2019, StepToSky and FlightFactor
+**  All rights reserved
+**
+**  Redistribution and use in source and binary forms, with or without
+**  modification, are permitted provided that the following conditions are met:
+**
+**  1.Redistributions of source code must retain the above copyright notice, this
+**    list of conditions and the following disclaimer.
+**  2.Redistributions in binary form must reproduce the above copyright notice,
+**    this list of conditions and the following disclaimer in the documentation
+**    and / or other materials provided with the distribution.
+**  3.The name of StepToSky or the name of FlightFactor or the names of its
+**    contributors may NOT be used to endorse or promote products derived from
+**    this software without specific prior written permission.
+**
+**  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+**  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+**  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+**  DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+**  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+**  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+**  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+**  ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+**  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+**  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**
+**  Contacts: www.steptosky.com or www.flightfactor.aero
+*/
+
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <iostream>
+#include <string>
+#include "stsff/logging/BaseLogger.h"
+
+/**************************************************************************************************/
+////////////////////////////////////////////////////////////////////////////////////////////////////
+/**************************************************************************************************/
+
+namespace stsff {
+namespace logging {
+    namespace internal {
+
+        /*!
+         * \brief Writes the data of the file sinks into the file descriptor.
+         * \details A write error is reported once for the file, the next writes are tried anyway,
+         *          so the log continues when, for example, the disk has the free space again.
+         */
+        class FileWriter final {
+        public:
+
+            //---------------------------------------------------------------
+            /// @{
+
+            explicit FileWriter(std::string fileName)
+                : mFileName(std::move(fileName)) {}
+
+            FileWriter(const FileWriter &) = delete;
+            FileWriter & operator=(const FileWriter &) = delete;
+
+            /// @}
+            //---------------------------------------------------------------
+            /// @{
+
+            /*!
+             * \details Writes all the data, repeats the short and the interrupted writes.
+             * \param [in] fd
+             * \param [in] data
+             * \param [in] size
+             * \return Number of the written bytes, it is less than the size if the write has failed.
+             */
+            LoggingExp std::size_t write(int fd, const char * data, std::size_t size) noexcept;
+
+            /*!
+             * \details Reports the write error if it is the first one.
+             * \param [in] error errno value.
+             */
+            LoggingExp void reportWriteError(int error) noexcept;
+
+            const std::string & fileName() const noexcept { return mFileName; }
+
+            /*!
+             * \details Prints the file error to std::cerr.
+             * \param [in] what
+             * \param [in] fileName
+             * \param [in] error errno value.
+             * \param [in] function where the error has happened.
+             */
+            LoggingExp static void printError(const char * what, const std::string & fileName,
+                                              int error, const char * function);
+
+            /// @}
+            //---------------------------------------------------------------
+
+        private:
+
+            const std::string mFileName;
+            std::atomic<bool> mWriteFailed{false};
+
+        };
+
+        /**************************************************************************************************/
+        ////////////////////////////////////////////////////////////////////////////////////////////////////
+        /**************************************************************************************************/
+
+        /*!
+         * \details Renders the message with the line end into the buffer of the calling thread.
+         *          The file sinks render the message before they are locked,
+         *          so the threads wait for each other only for the copying.
+         * \param [in] logger
+         * \param [in] logMsg
+         * \param [in] pattern
+         * \return The buffer that is valid until the next call in the same thread.
+         */
+        LoggingExp const MessageBuffer & renderLine(const BaseLogger & logger, const BaseLogger::LogMsg & logMsg,
+                                                    const FormatPattern & pattern);
+
+        /*!
+         * \details Calls the function for the noexcept methods of the sinks,
+         *          the exceptions are printed to std::cerr.
+         * \param [in] function name of the calling method for the error message.
+         * \param [in] fn
+         */
+        template<typename Fn>
+        void callNoexcept(const char * function, Fn fn) noexcept {
+            try {
+                fn();
+            }
+            catch (const std::exception & e) {
+                std::cerr << colorize::red << e.what() << " [" << function << "]" << colorize::reset << std::endl;
+            }
+            catch (...) {
+                std::cerr << colorize::red << "unknown exception [" << function << "]" << colorize::reset << std::endl;
+            }
+        }
+
+    }
+}
+}
+
+/**************************************************************************************************/
+////////////////////////////////////////////////////////////////////////////////////////////////////
+/**************************************************************************************************/
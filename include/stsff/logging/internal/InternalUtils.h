@@ -111,7 +111,7 @@ namespace logging {
             explicit CustStringView(const std::string & str)
                 : CustStringView(str.data(), str.size()) {}
 
-            CustStringView(const char * data, const std::size_t size)
+            constexpr CustStringView(const char * data, const std::size_t size)
                 : mData(data),
                   mSize(size) {}
 
@@ -125,9 +125,9 @@ namespace logging {
             //---------------------------------------------------------------
             /// @{
 
-            bool empty() const { return !mData || mSize == 0; }
-            std::size_t size() const { return mSize; }
-            const char * data() const { return mData; }
+            constexpr bool empty() const { return !mData || mSize == 0; }
+            constexpr std::size_t size() const { return mSize; }
+            constexpr const char * data() const { return mData; }
 
             /// @}
             //---------------------------------------------------------------
@@ -0,0 +1,212 @@
+#pragma once
+
+/*
+**  Copyright(C) 2019, StepToSky and FlightFactor
+**  All rights reserved
+**
+**  Redistribution and use in source and binary forms, with or without
+**  modification, are permitted provided that the following conditions are met:
+**
+**  1.Redistributions of source code must retain the above copyright notice, this
+**    list of conditions and the following disclaimer.
+**  2.Redistributions in binary form must reproduce the above copyright notice,
+**    this list of conditions and the following disclaimer in the documentation
+**    and / or other materials provided with the distribution.
+**  3.The name of StepToSky or the name of FlightFactor or the names of its
+**    contributors may NOT be used to endorse or promote products derived from
+**    this software without specific prior written permission.
+**
+**  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+**  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+**  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+**  DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+**  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+**  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+**  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+**  ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+**  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+**  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**
+**  Contacts: www.steptosky.com or www.flightfactor.aero
+*/
+
+#include <cstddef>
+#include <cstring>
+#include <iosfwd>
+#include "stsff/logging/Export.h"
+
+/**************************************************************************************************/
+////////////////////////////////////////////////////////////////////////////////////////////////////
+/**************************************************************************************************/
+
+namespace stsff {
+namespace logging {
+    namespace internal {
+
+        /*!
+         * \brief Text storage of the log message.
+         * \details It has inline storage for typical messages
+         *          and uses the heap only when a message doesn't fit it.
+         */
+        class MessageBuffer final {
+        public:
+
+            static const std::size_t InlineCapacity = 256;
+
+            //---------------------------------------------------------------
+            /// @{
+
+            MessageBuffer() noexcept = default;
+
+            MessageBuffer(MessageBuffer && other) noexcept {
+                moveFrom(other);
+            }
+
+            MessageBuffer & operator=(MessageBuffer && other) noexcept {
+                if (this != &other) {
+                    release();
+                    moveFrom(other);
+                }
+                return *this;
+            }
+
+            MessageBuffer(const MessageBuffer &) = delete;
+            MessageBuffer & operator=(const MessageBuffer &) = delete;
+
+            ~MessageBuffer() noexcept {
+                release();
+            }
+
+            /// @}
+            //---------------------------------------------------------------
+            /// @{
+
+            void append(const char * data, const std::size_t size) {
+                if (size == 0) {
+                    return;
+                }
+                std::memcpy(reserve(size), data, size);
+                mSize += size;
+            }
+
+            void append(const char ch) {
+                *reserve(1) = ch;
+                ++mSize;
+            }
+
+            /*!
+             * \details Makes sure that the specified number of bytes can be written after the current data.
+             *          Use \link MessageBuffer::commit \endlink after writing.
+             * \param [in] size
+             * \return Pointer for writing.
+             */
+            char * reserve(const std::size_t size) {
+                if (size > mCapacity - mSize) {
+                    grow(mSize + size);
+                }
+                return mData + mSize;
+            }
+
+            /*!
+             * \details Adds the bytes written into the memory returned by \link MessageBuffer::reserve \endlink
+             * \param [in] size
+             */
+            void commit(const std::size_t size) noexcept {
+                mSize += size;
+            }
+
+            void clear() noexcept {
+                mSize = 0;
+            }
+
+            /// @}
+            //---------------------------------------------------------------
+            /// @{
+
+            const char * data() const noexcept { return mData; }
+            std::size_t size() const noexcept { return mSize; }
+            std::size_t capacity() const noexcept { return mCapacity; }
+            bool empty() const noexcept { return mSize == 0; }
+            bool isInline() const noexcept { return mData == mInline; }
+
+            /// @}
+            //---------------------------------------------------------------
+
+        private:
+
+            LoggingExp void grow(std::size_t required);
+
+            void release() noexcept {
+                if (!isInline()) {
+                    delete[] mData;
+                }
+                mData = mInline;
+                mSize = 0;
+                mCapacity = InlineCapacity;
+            }
+
+            void moveFrom(MessageBuffer & other) noexcept {
+                if (other.isInline()) {
+                    std::memcpy(mInline, other.mInline, other.mSize);
+                    mData = mInline;
+                    mCapacity = InlineCapacity;
+                }
+                else {
+                    mData = other.mData;
+                    mCapacity = other.mCapacity;
+                    other.mData = other.mInline;
+                    other.mCapacity = InlineCapacity;
+                }
+                mSize = other.mSize;
+                other.mSize = 0;
+            }
+
+            char * mData = mInline;
+            std::size_t mSize = 0;
+            std::size_t mCapacity = InlineCapacity;
+            char mInline[InlineCapacity];
+
+        };
+
+        /**************************************************************************************************/
+        ////////////////////////////////////////////////////////////////////////////////////////////////////
+        /**************************************************************************************************/
+
+        class MessageStream;
+
+        /*!
+         * \details Gives std::ostream that writes into the buffer.
+         *          It is used for the types that can be printed with std::ostream only.
+         *          Usually it doesn't allocate anything as each thread reuses its own stream,
+         *          the stream has default formatting state when it is acquired.
+         * \param [in] buffer
+         * \return Stream that must be returned with \link releaseMessageStream \endlink
+         */
+        LoggingExp MessageStream * acquireMessageStream(MessageBuffer & buffer);
+
+        /*!
+         * \details Returns the stream gotten with \link acquireMessageStream \endlink
+         * \param [in] stream
+         */
+        LoggingExp void releaseMessageStream(MessageStream * stream) noexcept;
+
+        /*!
+         * \details Makes the stream write into another buffer keeping its formatting state.
+         * \param [in] stream
+         * \param [in] buffer
+         */
+        LoggingExp void retargetMessageStream(MessageStream * stream, MessageBuffer & buffer) noexcept;
+
+        /*!
+         * \param [in] stream
+         * \return std::ostream of the message stream.
+         */
+        LoggingExp std::ostream & messageOstream(MessageStream * stream) noexcept;
+
+    }
+}
+}
+
+/**************************************************************************************************/
+////////////////////////////////////////////////////////////////////////////////////////////////////
+/**************************************************************************************************/
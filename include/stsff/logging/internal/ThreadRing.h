@@ -0,0 +1,322 @@
+#pragma once
+
+/*
+**  Copyright(C) 2019, StepToSky and FlightFactor
+**  All rights reserved
+**
+**  Redistribution and use in source and binary forms, with or without
+**  modification, are permitted provided that the following conditions are met:
+**
+**  1.Redistributions of source code must retain the above copyright notice, this
+**    list of conditions and the following disclaimer.
+**  2.Redistributions in binary form must reproduce the above copyright notice,
+**    this list of conditions and the following disclaimer in the documentation
+**    and / or other materials provided with the distribution.
+**  3.The name of StepToSky or the name of FlightFactor or the names of its
+**    contributors may NOT be used to endorse or promote products derived from
+**    this software without specific prior written permission.
+**
+**  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+**  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+**  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+**  DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+**  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+**  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+**  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+**  ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+**  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+**  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**
+**  Contacts: www.steptosky.com or www.flightfactor.aero
+*/
+
+#include <atomic>
+#include <cstring>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "stsff/logging/Export.h"
+
+/**************************************************************************************************/
+////////////////////////////////////////////////////////////////////////////////////////////////////
+/**************************************************************************************************/
+
+namespace stsff {
+namespace logging {
+    namespace internal {
+
+        /*!
+         * \brief Bounded single producer/single consumer queue of variable size records.
+         * \details The producer reserves space for a record, writes it and commits,
+         *          the consumer reads the records in the same order.
+         *          A record is never split, if it doesn't fit the end of the memory
+         *          the rest of the memory is skipped and the record is written from the beginning.
+         */
+        class SpscRing final {
+        public:
+
+            //---------------------------------------------------------------
+            /// @{
+
+            /*!
+             * \param [in] capacity bytes, it is rounded up to the power of 2.
+             */
+            LoggingExp explicit SpscRing(std::size_t capacity);
+
+            SpscRing(const SpscRing &) = delete;
+            SpscRing & operator=(const SpscRing &) = delete;
+
+            /// @}
+            //---------------------------------------------------------------
+            /// @{
+
+            /*!
+             * \details Producer side.
+             * \param [in] size of the record, it must not be greater than \link SpscRing::maxRecordSize \endlink
+             * \return Memory for the record or nullptr if the ring is full.
+             *         The record is available for the consumer after \link SpscRing::commit \endlink
+             */
+            char * tryReserve(const std::size_t size) noexcept {
+                const std::size_t total = HeaderSize + alignedSize(size);
+                std::size_t head = mHead.load(std::memory_order_relaxed);
+                const std::size_t contiguous = mCapacity - (head & mMask);
+                const std::size_t required = total > contiguous ? contiguous + total : total;
+                if (head + required - mCachedTail > mCapacity) {
+                    mCachedTail = mTail.load(std::memory_order_acquire);
+                    if (head + required - mCachedTail > mCapacity) {
+                        return nullptr;
+                    }
+                }
+                if (total > contiguous) {
+                    writeHeader(head, WrapMark);
+                    head += contiguous;
+                }
+                writeHeader(head, std::uint32_t(size));
+                mReserved = head + total;
+                return mData.get() + (head & mMask) + HeaderSize;
+            }
+
+            /*!
+             * \details Producer side, publishes the record reserved with \link SpscRing::tryReserve \endlink
+             */
+            void commit() noexcept {
+                mCommitted.store(mCommitted.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+                mHead.store(mReserved, std::memory_order_release);
+            }
+
+            /*!
+             * \details Consumer side.
+             * \param [out] outSize size of the record.
+             * \return The oldest record or nullptr if the ring is empty.
+             *         The record must be released with \link SpscRing::pop \endlink
+             */
+            const char * front(std::size_t & outSize) noexcept {
+                std::size_t tail = mTail.load(std::memory_order_relaxed);
+                if (tail == mCachedHead) {
+                    mCachedHead = mHead.load(std::memory_order_acquire);
+                    if (tail == mCachedHead) {
+                        return nullptr;
+                    }
+                }
+                std::uint32_t size = readHeader(tail);
+                if (size == WrapMark) {
+                    tail += mCapacity - (tail & mMask);
+                    size = readHeader(tail);
+                }
+                outSize = size;
+                mPopped = tail + HeaderSize + alignedSize(size);
+                return mData.get() + (tail & mMask) + HeaderSize;
+            }
+
+            /*!
+             * \details Consumer side, releases the record gotten with \link SpscRing::front \endlink
+             */
+            void pop() noexcept {
+                mTail.store(mPopped, std::memory_order_release);
+                mConsumed.store(mConsumed.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+            }
+
+            /// @}
+            //---------------------------------------------------------------
+            /// @{
+
+            /*!
+             * \return Maximum record size that is guaranteed to fit the ring.
+             */
+            std::size_t maxRecordSize() const noexcept { return mCapacity / 2 - HeaderSize; }
+
+            std::size_t capacity() const noexcept { return mCapacity; }
+
+            /*!
+             * \details The value is approximate if it is called while the ring is being used.
+             * \return Number of bytes that are occupied by the records.
+             */
+            std::size_t usedBytes() const noexcept {
+                return mHead.load(std::memory_order_acquire) - mTail.load(std::memory_order_acquire);
+            }
+
+            bool empty() const noexcept { return usedBytes() == 0; }
+
+            /*!
+             * \return Number of the records that have been committed.
+             */
+            std::size_t committed() const noexcept { return mCommitted.load(std::memory_order_acquire); }
+
+            /*!
+             * \return Number of the records that have been popped.
+             */
+            std::size_t consumed() const noexcept { return mConsumed.load(std::memory_order_acquire); }
+
+            /// @}
+            //---------------------------------------------------------------
+            /// @{
+
+            /*!
+             * \details The producer thread has exited, nothing will be written anymore.
+             */
+            void abandon() noexcept { mAbandoned.store(true, std::memory_order_release); }
+            bool isAbandoned() const noexcept { return mAbandoned.load(std::memory_order_acquire); }
+
+            /*!
+             * \details The consumer has gone, nothing will be read anymore.
+             */
+            void close() noexcept { mClosed.store(true, std::memory_order_release); }
+            bool isClosed() const noexcept { return mClosed.load(std::memory_order_acquire); }
+
+            /// @}
+            //---------------------------------------------------------------
+
+        private:
+
+            static const std::size_t HeaderSize = 8;
+            static const std::uint32_t WrapMark = 0xFFFFFFFF;
+
+            static std::size_t alignedSize(const std::size_t size) noexcept {
+                return (size + HeaderSize - 1) & ~(HeaderSize - 1);
+            }
+
+            void writeHeader(const std::size_t position, const std::uint32_t value) noexcept {
+                std::memcpy(mData.get() + (position & mMask), &value, sizeof(value));
+            }
+
+            std::uint32_t readHeader(const std::size_t position) const noexcept {
+                std::uint32_t value;
+                std::memcpy(&value, mData.get() + (position & mMask), sizeof(value));
+                return value;
+            }
+
+            std::unique_ptr<char[]> mData;
+            std::size_t mCapacity;
+            std::size_t mMask;
+
+            // the producer's and the consumer's data are kept in the different cache lines.
+            char mPad0[64];
+            std::atomic<std::size_t> mHead{0};
+            std::atomic<std::size_t> mCommitted{0};
+            std::size_t mCachedTail = 0;
+            std::size_t mReserved = 0;
+            char mPad1[64];
+            std::atomic<std::size_t> mTail{0};
+            std::atomic<std::size_t> mConsumed{0};
+            std::size_t mCachedHead = 0;
+            std::size_t mPopped = 0;
+            char mPad2[64];
+
+            std::atomic<bool> mAbandoned{false};
+            std::atomic<bool> mClosed{false};
+
+        };
+
+        /**************************************************************************************************/
+        ////////////////////////////////////////////////////////////////////////////////////////////////////
+        /**************************************************************************************************/
+
+        /*!
+         * \brief Set of the \link SpscRing \endlink one per producer thread.
+         * \details A thread gets its ring with \link ThreadRings::local \endlink,
+         *          the ring is created when the thread uses it first time
+         *          and it is abandoned when the thread exits.
+         *          The consumer must drain the abandoned ring before it is removed
+         *          with \link ThreadRings::collect \endlink.
+         */
+        class ThreadRings final {
+        public:
+
+            typedef std::shared_ptr<SpscRing> RingPtr;
+
+            //---------------------------------------------------------------
+            /// @{
+
+            /*!
+             * \param [in] ringCapacity bytes for each thread.
+             */
+            LoggingExp explicit ThreadRings(std::size_t ringCapacity);
+            LoggingExp ~ThreadRings() noexcept;
+
+            ThreadRings(const ThreadRings &) = delete;
+            ThreadRings & operator=(const ThreadRings &) = delete;
+
+            /// @}
+            //---------------------------------------------------------------
+            /// @{
+
+            /*!
+             * \details Producer side.
+             * \return The ring of the calling thread.
+             * \exception std::bad_alloc if the ring of the thread is not created yet and can't be allocated.
+             */
+            LoggingExp SpscRing & local();
+
+            /// @}
+            //---------------------------------------------------------------
+            /// @{
+
+            /*!
+             * \details Consumer side, copies the current rings.
+             *          The vector is only updated if the set has been changed since the previous call.
+             * \param [in, out] rings
+             * \param [in, out] version must be 0 for the first call.
+             */
+            LoggingExp void snapshot(std::vector<RingPtr> & rings, std::uint64_t & version) const;
+
+            /*!
+             * \details Consumer side, removes the empty rings whose threads have exited.
+             * \return Number of the removed rings.
+             */
+            LoggingExp std::size_t collect() noexcept;
+
+            /*!
+             * \return Number of the rings.
+             */
+            LoggingExp std::size_t size() const noexcept;
+
+            /*!
+             * \details The value is approximate if it is called while the rings are being used.
+             * \return Number of the records in all the rings.
+             */
+            LoggingExp std::size_t records() const noexcept;
+
+            std::size_t ringCapacity() const noexcept { return mRingCapacity; }
+
+            /// @}
+            //---------------------------------------------------------------
+
+        private:
+
+            const std::uint64_t mId;
+            const std::size_t mRingCapacity;
+            mutable std::mutex mMutex;
+            std::vector<RingPtr> mRings;
+            std::atomic<std::uint64_t> mVersion{1};
+
+        };
+
+    }
+}
+}
+
+/**************************************************************************************************/
+////////////////////////////////////////////////////////////////////////////////////////////////////
+/**************************************************************************************************/
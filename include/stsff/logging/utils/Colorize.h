@@ -30,8 +30,10 @@
 **  Contacts: www.steptosky.com or www.flightfactor.aero
 */
 
+#include <cstddef>
 #include <iosfwd>
 #include "stsff/logging/Export.h"
+#include "stsff/logging/internal/InternalUtils.h"
 
 namespace stsff {
 namespace logging {
@@ -113,6 +115,110 @@ namespace logging {
         ////////////////////////////////////////////////////////////////////////////////////////////////////
         /**************************************************************************************************/
 
+        //! Makes the manipulators print the colors into the stream even if it isn't a terminal.
+        LoggingExp std::ostream & colorized(std::ostream & stream) noexcept;
+        //! Cancels \link colorized \endlink, the terminals are still colorized.
+        LoggingExp std::ostream & nocolorized(std::ostream & stream) noexcept;
+
+        //! Says whether the manipulators print the colors into the stream.
+        //! The terminal state of the standard streams is checked once and cached.
+        LoggingExp bool isColorized(std::ostream & stream) noexcept;
+
+        //! Checks the terminal state of the standard streams again with the next manipulator,
+        //! e.g. after stdout or stderr is redirected.
+        LoggingExp void refreshTerminals() noexcept;
+
+        /**************************************************************************************************/
+        ////////////////////////////////////////////////////////////////////////////////////////////////////
+        /**************************************************************************************************/
+
+        typedef std::ostream & (*Manipulator)(std::ostream &);
+        typedef internal::CustStringView StringView;
+
+        //---------------------------------------------------------------
+        // ANSI escape sequences of the colors for writing them into the buffers.
+        // The dark manipulators print the same sequences as the normal ones.
+
+        constexpr StringView AnsiGrey("\033[30m", 5);
+        constexpr StringView AnsiRed("\033[31m", 5);
+        constexpr StringView AnsiGreen("\033[32m", 5);
+        constexpr StringView AnsiYellow("\033[33m", 5);
+        constexpr StringView AnsiBlue("\033[34m", 5);
+        constexpr StringView AnsiMagenta("\033[35m", 5);
+        constexpr StringView AnsiCyan("\033[36m", 5);
+        constexpr StringView AnsiWhite("\033[37m", 5);
+
+        constexpr StringView AnsiOnGrey("\033[40m", 5);
+        constexpr StringView AnsiOnRed("\033[41m", 5);
+        constexpr StringView AnsiOnGreen("\033[42m", 5);
+        constexpr StringView AnsiOnYellow("\033[43m", 5);
+        constexpr StringView AnsiOnBlue("\033[44m", 5);
+        constexpr StringView AnsiOnMagenta("\033[45m", 5);
+        constexpr StringView AnsiOnCyan("\033[46m", 5);
+        constexpr StringView AnsiOnWhite("\033[47m", 5);
+
+        constexpr StringView AnsiReset("\033[00m", 5);
+
+        /*!
+         * \details Gets the ANSI escape sequence of the manipulator, so it can be copied
+         *          into the buffer of the message instead of calling the manipulator.
+         *          Use \link isColorized \endlink of the target stream to decide whether to copy it.
+         * \param [in] manipulator one of the color manipulators or \link reset \endlink
+         * \return Escape sequence or empty view if the manipulator isn't a color.
+         */
+        LoggingExp StringView escapeSequence(Manipulator manipulator) noexcept;
+
+        /*!
+         * \details Appends the escape sequence to the buffer if the colors are enabled.
+         * \param [in, out] buffer any type with append(const char *, std::size_t), e.g. std::string.
+         * \param [in] color e.g. \link AnsiRed \endlink
+         * \param [in] enabled
+         */
+        template<typename Buffer>
+        void appendColor(Buffer & buffer, const StringView color, const bool enabled) {
+            if (enabled) {
+                buffer.append(color.data(), color.size());
+            }
+        }
+
+        /*!
+         * \details Writes the escape sequence if the colors are enabled.
+         * \param [out] out it must have place for the sequence.
+         * \param [in] color e.g. \link AnsiRed \endlink
+         * \param [in] enabled
+         * \return Pointer after the written sequence.
+         */
+        inline char * appendColor(char * out, const StringView color, const bool enabled) noexcept {
+            if (enabled) {
+                std::memcpy(out, color.data(), color.size());
+                out += color.size();
+            }
+            return out;
+        }
+
+        /*!
+         * \details Removes the ANSI escape sequences from the text, e.g. to write the colored
+         *          message into a file. The control sequences (ESC [ ... final byte) and
+         *          the two-byte escapes are removed, an unfinished sequence at the end is removed too.
+         * \param [in] text
+         * \param [in] size
+         * \param [out] out it must have place for size bytes, it may be the same as text.
+         * \return Size of the text without the sequences.
+         */
+        LoggingExp std::size_t stripAnsi(const char * text, std::size_t size, char * out) noexcept;
+
+        /*!
+         * \details Removes the ANSI escape sequences from the string, see the overload above.
+         * \param [in, out] text
+         */
+        inline void stripAnsi(std::string & text) noexcept {
+            text.resize(stripAnsi(&text[0], text.size(), &text[0]));
+        }
+
+        /**************************************************************************************************/
+        ////////////////////////////////////////////////////////////////////////////////////////////////////
+        /**************************************************************************************************/
+
     }
 }
 }
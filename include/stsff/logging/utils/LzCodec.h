@@ -0,0 +1,87 @@
+#pragma once
+
+/*
+**  Copyright(C) 2019, StepToSky and FlightFactor
+**  All rights reserved
+**
+**  Redistribution and use in source and binary forms, with or without
+**  modification, are permitted provided that the following conditions are met:
+**
+**  1.Redistributions of source code must retain the above copyright notice, this
+**    list of conditions and the following disclaimer.
+**  2.Redistributions in binary form must reproduce the above copyright notice,
+**    this list of conditions and the following disclaimer in the documentation
+**    and / or other materials provided with the distribution.
+**  3.The name of StepToSky or the name of FlightFactor or the names of its
+**    contributors may NOT be used to endorse or promote products derived from
+**    this software without specific prior written permission.
+**
+**  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+**  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+**  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+**  DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+**  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+**  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+**  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+**  ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+**  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+**  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**
+**  Contacts: www.steptosky.com or www.flightfactor.aero
+*/
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include "stsff/logging/Export.h"
+
+namespace stsff {
+namespace logging {
+
+    /**************************************************************************************************/
+    ////////////////////////////////////////////////////////////////////////////////////////////////////
+    /**************************************************************************************************/
+
+    /*!
+     * \brief Small LZ77 codec for the closed log files.
+     * \details It is the LZ4 like byte oriented format that is fast enough to compress
+     *          the log files in the background without the outside libraries.
+     * \details The stream starts with the magic "SLZ1" and consists of the blocks,
+     *          each block has 4 bytes of the original size, 4 bytes of the compressed size (both little-endian)
+     *          and the sequences: the token with 4 bits of the literals number and 4 bits of the match length,
+     *          the extra length bytes if the value is 15, the literals, 2 bytes of the match offset
+     *          and the extra match length bytes. The last sequence of the block has the literals only.
+     * \details The concatenated streams are decompressed as one stream,
+     *          so a large file can be compressed by chunks.
+     */
+    class LzCodec {
+        LzCodec() = default;
+    public:
+
+        static const std::size_t BlockSize = 64 * 1024;
+
+        /*!
+         * \details Compresses the data into the stream with the magic.
+         * \param [in] data
+         * \param [in] size
+         * \param [out] out the stream is appended to it.
+         */
+        LoggingExp static void compress(const char * data, std::size_t size, std::string & out);
+
+        /*!
+         * \details Decompresses the stream made by \link LzCodec::compress \endlink
+         * \param [in] data
+         * \param [in] size
+         * \param [out] out the data is appended to it.
+         * \return False if the stream is corrupted, the blocks before the corrupted one are appended.
+         */
+        LoggingExp static bool decompress(const char * data, std::size_t size, std::string & out);
+
+    };
+
+    /**************************************************************************************************/
+    ////////////////////////////////////////////////////////////////////////////////////////////////////
+    /**************************************************************************************************/
+
+}
+}
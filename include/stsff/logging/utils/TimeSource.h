@@ -0,0 +1,142 @@
+#pragma once
+
+/*
+**  Copyright(C) 2019, StepToSky and FlightFactor
+**  All rights reserved
+**
+**  Redistribution and use in source and binary forms, with or without
+**  modification, are permitted provided that the following conditions are met:
+**
+**  1.Redistributions of source code must retain the above copyright notice, this
+**    list of conditions and the following disclaimer.
+**  2.Redistributions in binary form must reproduce the above copyright notice,
+**    this list of conditions and the following disclaimer in the documentation
+**    and / or other materials provided with the distribution.
+**  3.The name of StepToSky or the name of FlightFactor or the names of its
+**    contributors may NOT be used to endorse or promote products derived from
+**    this software without specific prior written permission.
+**
+**  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+**  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+**  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+**  DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+**  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+**  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+**  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+**  ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+**  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+**  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**
+**  Contacts: www.steptosky.com or www.flightfactor.aero
+*/
+
+#include <cstdint>
+#include "stsff/logging/Export.h"
+
+namespace stsff {
+namespace logging {
+
+    /**************************************************************************************************/
+    ////////////////////////////////////////////////////////////////////////////////////////////////////
+    /**************************************************************************************************/
+
+    /*!
+     * \details The clock that the loggers use for the message time.
+     * \details The time is nanoseconds since std::chrono::system_clock epoch,
+     *          see \link BaseLogger::LogMsg::mTime \endlink
+     * \details The clock is process wide and can be changed at any time.
+     */
+    class TimeSource {
+        TimeSource() = default;
+    public:
+
+        //---------------------------------------------------------------
+        /// @{
+
+        enum eClock {
+            /*!
+             * \details std::chrono::system_clock, default.
+             */
+            ClockSystem,
+            /*!
+             * \details CLOCK_REALTIME_COARSE on Linux, it is several times cheaper to read
+             *          but its resolution is the kernel tick (usually 1-4 ms).
+             *          It is \link TimeSource::ClockSystem \endlink on the other platforms.
+             */
+            ClockCoarse,
+            /*!
+             * \details The CPU timestamp counter, it is read when the time is captured
+             *          by \link TimeSource::capture \endlink and converted to the wall clock time later
+             *          by \link TimeSource::toNanoseconds \endlink with the calibration that is
+             *          periodically updated against std::chrono::system_clock.
+             *          It is \link TimeSource::ClockSystem \endlink if the CPU doesn't have
+             *          the invariant timestamp counter, see \link TimeSource::isTscAvailable \endlink
+             */
+            ClockTsc,
+        };
+
+        /*!
+         * \details Captured time, see \link TimeSource::capture \endlink
+         */
+        struct Stamp {
+            std::int64_t mValue; //!< nanoseconds since std::chrono::system_clock epoch or the timestamp counter ticks.
+            bool mTicks;         //!< true if the value is the timestamp counter ticks.
+        };
+
+        /// @}
+        //---------------------------------------------------------------
+        /// @{
+
+        /*!
+         * \param [in] clock
+         */
+        LoggingExp static void setClock(eClock clock) noexcept;
+
+        /*!
+         * \return Current clock.
+         */
+        LoggingExp static eClock clock() noexcept;
+
+        /*!
+         * \return Current time of the current clock in nanoseconds since std::chrono::system_clock epoch.
+         */
+        LoggingExp static std::int64_t now() noexcept;
+
+        /*!
+         * \param [in] clock
+         * \return Current time of the specified clock in nanoseconds since std::chrono::system_clock epoch.
+         */
+        LoggingExp static std::int64_t now(eClock clock) noexcept;
+
+        /*!
+         * \details Reads the current clock as cheap as possible, the timestamp counter value
+         *          is not converted to the wall clock time.
+         * \details It is used by the loggers that handle the messages later
+         *          (e.g. \link AsyncLogger \endlink), so the conversion is made on the handling side.
+         * \return Captured time.
+         */
+        LoggingExp static Stamp capture() noexcept;
+
+        /*!
+         * \param [in] stamp
+         * \return Time in nanoseconds since std::chrono::system_clock epoch.
+         */
+        LoggingExp static std::int64_t toNanoseconds(const Stamp & stamp) noexcept;
+
+        /*!
+         * \return True if the CPU has the invariant timestamp counter that can be used
+         *         with \link TimeSource::ClockTsc \endlink
+         */
+        LoggingExp static bool isTscAvailable() noexcept;
+
+        /// @}
+        //---------------------------------------------------------------
+
+    };
+
+    /**************************************************************************************************/
+    ////////////////////////////////////////////////////////////////////////////////////////////////////
+    /**************************************************************************************************/
+
+}
+}
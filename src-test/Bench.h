@@ -0,0 +1,119 @@
+#pragma once
+
+/*
+**  Copyright(C) 2019, StepToSky and FlightFactor
+**  All rights reserved
+**
+**  Redistribution and use in source and binary forms, with or without
+**  modification, are permitted provided that the following conditions are met:
+**
+**  1.Redistributions of source code must retain the above copyright notice, this
+**    list of conditions and the following disclaimer.
+**  2.Redistributions in binary form must reproduce the above copyright notice,
+**    this list of conditions and the following disclaimer in the documentation
+**    and / or other materials provided with the distribution.
+**  3.The name of StepToSky or the name of FlightFactor or the names of its
+**    contributors may NOT be used to endorse or promote products derived from
+**    this software without specific prior written permission.
+**
+**  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+**  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+**  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+**  DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+**  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+**  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+**  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+**  ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+**  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+**  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**
+**  Contacts: www.steptosky.com or www.flightfactor.aero
+*/
+
+#include <chrono>
+#include <cstddef>
+#include <iostream>
+#include <iomanip>
+
+/**************************************************************************************************/
+////////////////////////////////////////////////////////////////////////////////////////////////////
+/**************************************************************************************************/
+
+/*!
+ * \details Simple helpers for the benchmark tests.
+ *          The benchmarks just print the results, they are not supposed to fail because of timings.
+ */
+namespace bench {
+
+    /*!
+     * \details The benchmark executable replaces the global operator new to count the heap allocations.
+     * \return Number of the heap allocations made by the process so far.
+     */
+    std::size_t allocations() noexcept;
+
+    /*!
+     * \details The benchmark executable replaces isatty on linux to count the terminal checks.
+     * \return Number of the terminal checks made by the process so far, it is always 0 on the other systems.
+     */
+    std::size_t terminalChecks() noexcept;
+
+    /*!
+     * \details Runs the function for the specified number of iterations and prints the time per iteration.
+     * \param [in] name
+     * \param [in] iterations
+     * \param [in] fn function that takes iteration index.
+     * \return Nanoseconds per iteration.
+     */
+    template<typename Fn>
+    double measure(const char * name, const std::size_t iterations, Fn fn) {
+        const auto start = std::chrono::steady_clock::now();
+        for (std::size_t i = 0; i < iterations; ++i) {
+            fn(i);
+        }
+        const auto end = std::chrono::steady_clock::now();
+        const double ns = double(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count());
+        const double perIteration = ns / double(iterations);
+        std::cout << "    " << std::left << std::setw(48) << name
+                << std::right << std::setw(12) << std::fixed << std::setprecision(2) << perIteration << " ns/op"
+                << std::defaultfloat << std::endl;
+        return perIteration;
+    }
+
+    /*!
+     * \details Like \link measure \endlink but runs the iterations in the small batches
+     *          and prints the time of the fastest batch, so the time that the other threads
+     *          (e.g. the logger's background one) take from the same CPU core isn't counted.
+     * \param [in] name
+     * \param [in] iterations
+     * \param [in] fn function that takes iteration index.
+     * \return Nanoseconds per iteration of the fastest batch.
+     */
+    template<typename Fn>
+    double measureBest(const char * name, const std::size_t iterations, Fn fn) {
+        const std::size_t batch = 1000;
+        double best = -1.0;
+        for (std::size_t i = 0; i < iterations;) {
+            const auto start = std::chrono::steady_clock::now();
+            const std::size_t end = i + batch < iterations ? i + batch : iterations;
+            const std::size_t count = end - i;
+            for (; i < end; ++i) {
+                fn(i);
+            }
+            const auto finish = std::chrono::steady_clock::now();
+            const double ns = double(std::chrono::duration_cast<std::chrono::nanoseconds>(finish - start).count());
+            const double perIteration = ns / double(count);
+            if (best < 0.0 || perIteration < best) {
+                best = perIteration;
+            }
+        }
+        std::cout << "    " << std::left << std::setw(48) << name
+                << std::right << std::setw(12) << std::fixed << std::setprecision(2) << best << " ns/op (best batch)"
+                << std::defaultfloat << std::endl;
+        return best;
+    }
+
+}
+
+/**************************************************************************************************/
+////////////////////////////////////////////////////////////////////////////////////////////////////
+/**************************************************************************************************/
@@ -0,0 +1,118 @@
+/*
+**  Copyright(C) 2019, StepToSky and FlightFactor
+**  All rights reserved
+**
+**  Redistribution and use in source and binary forms, with or without
+**  modification, are permitted provided that the following conditions are met:
+**
+**  1.Redistributions of source code must retain the above copyright notice, this
+**    list of conditions and the following disclaimer.
+**  2.Redistributions in binary form must reproduce the above copyright notice,
+**    this list of conditions and the following disclaimer in the documentation
+**    and / or other materials provided with the distribution.
+**  3.The name of StepToSky or the name of FlightFactor or the names of its
+**    contributors may NOT be used to endorse or promote products derived from
+**    this software without specific prior written permission.
+**
+**  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+**  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+**  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+**  DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+**  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+**  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+**  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+**  ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+**  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+**  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**
+**  Contacts: www.steptosky.com or www.flightfactor.aero
+*/
+#include "ph/stdafx.h"
+
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <stsff/logging/AsyncLogger.h>
+#include <gtest/gtest.h>
+#include "Bench.h"
+
+using namespace stsff::logging;
+
+/**************************************************************************************************/
+////////////////////////////////////////////////////////////////////////////////////////////////////
+/**************************************************************************************************/
+
+namespace {
+
+    /*!
+     * \details Runs the function from the specified number of threads at the same time
+     *          and prints the wall time per call including the time to flush the logger.
+     */
+    template<typename Fn, typename Flush>
+    void contention(const char * name, const std::size_t threadsNum, const std::size_t iterations, Fn fn, Flush flush) {
+        std::atomic<bool> go(false);
+        std::vector<std::thread> threads;
+        for (std::size_t t = 0; t < threadsNum; ++t) {
+            threads.emplace_back([&go, &fn, iterations]() {
+                while (!go) {
+                    std::this_thread::yield();
+                }
+                for (std::size_t i = 0; i < iterations; ++i) {
+                    fn(i);
+                }
+            });
+        }
+        bench::measure(name, threadsNum * iterations, [&](const std::size_t i) {
+            if (i == 0) {
+                go = true;
+                for (auto & thread : threads) {
+                    thread.join();
+                }
+                flush();
+            }
+        });
+    }
+
+}
+
+/**************************************************************************************************/
+////////////////////////////////////////////////////////////////////////////////////////////////////
+/**************************************************************************************************/
+
+TEST(BenchAsyncLogger, contention) {
+    const std::size_t threadsNum = 4;
+    const std::size_t iterations = 50000;
+    std::atomic<std::size_t> printed{0};
+    const auto handler = [&printed](const BaseLogger &, const BaseLogger::LogMsg & logMsg) {
+        printed += logMsg.mMsg.size();
+    };
+    //---------------
+    std::cout << std::endl;
+    std::mutex mutex;
+    BaseLogger logger("bench");
+    logger.setHandler(BaseLogger::LvlMsg, handler);
+    contention("BaseLogger + mutex", threadsNum, iterations, [&](const std::size_t i) {
+        std::lock_guard<std::mutex> lock(mutex);
+        LMessage(logger) << "value: " << i;
+    }, []() {});
+    //---------------
+    AsyncLogger shared("bench", AsyncLogger::QueueShared, AsyncLogger::DefaultQueueSize);
+    shared.setHandler(BaseLogger::LvlMsg, handler);
+    contention("AsyncLogger, QueueShared", threadsNum, iterations, [&](const std::size_t i) {
+        LMessage(shared) << "value: " << i;
+    }, [&]() { shared.flush(); });
+    //---------------
+    AsyncLogger perThread("bench", AsyncLogger::QueuePerThread, AsyncLogger::DefaultThreadBufferSize);
+    perThread.setHandler(BaseLogger::LvlMsg, handler);
+    contention("AsyncLogger, QueuePerThread", threadsNum, iterations, [&](const std::size_t i) {
+        LMessage(perThread) << "value: " << i;
+    }, [&]() { perThread.flush(); });
+    //---------------
+    EXPECT_NE(std::size_t(0), printed.load());
+    std::cout << std::endl;
+}
+
+/**************************************************************************************************/
+////////////////////////////////////////////////////////////////////////////////////////////////////
+/**************************************************************************************************/
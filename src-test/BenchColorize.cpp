@@ -0,0 +1,109 @@
+/*
+**  Copyright(C) 2019, StepToSky and FlightFactor
+**  All rights reserved
+**
+**  Redistribution and use in source and binary forms, with or without
+**  modification, are permitted provided that the following conditions are met:
+**
+**  1.Redistributions of source code must retain the above copyright notice, this
+**    list of conditions and the following disclaimer.
+**  2.Redistributions in binary form must reproduce the above copyright notice,
+**    this list of conditions and the following disclaimer in the documentation
+**    and / or other materials provided with the distribution.
+**  3.The name of StepToSky or the name of FlightFactor or the names of its
+**    contributors may NOT be used to endorse or promote products derived from
+**    this software without specific prior written permission.
+**
+**  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+**  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+**  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+**  DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+**  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+**  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+**  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+**  ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+**  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+**  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**
+**  Contacts: www.steptosky.com or www.flightfactor.aero
+*/
+
+#include "ph/stdafx.h"
+
+#include <sstream>
+#include <string>
+#include <stsff/logging/BaseLogger.h>
+#include <gtest/gtest.h>
+#include "Bench.h"
+
+using namespace stsff::logging;
+
+/**************************************************************************************************/
+////////////////////////////////////////////////////////////////////////////////////////////////////
+/**************************************************************************************************/
+
+TEST(BenchColorize, colored_message) {
+    const FormatPattern pattern("ERR: %LN %MC %MS");
+    const BaseLogger logger("bench");
+    const BaseLogger::LogMsg logMsg(BaseLogger::LvlError, "category", "message", CodeLocation("function", "file", 42));
+    const std::size_t iterations = 200000;
+    std::stringstream text;
+    auto * cerrBuff = std::cerr.rdbuf(text.rdbuf());
+    std::size_t checks = 0;
+    std::size_t messageChecks = 0;
+    try {
+        colorize::refreshTerminals();
+        colorize::red(std::cerr);
+        checks = bench::terminalChecks();
+        //---------------
+        std::cout << std::endl;
+        bench::measure("colorize::red(std::cerr)", iterations, [&](const std::size_t) {
+            colorize::red(std::cerr);
+        });
+        bench::measure("defaultHandler(std::cerr, colorize::red)", iterations, [&](const std::size_t) {
+            BaseLogger::defaultHandler(logger, logMsg, std::cerr, pattern, colorize::red);
+        });
+        messageChecks = bench::terminalChecks() - checks;
+        std::cout << "    terminal checks per colored message: " << double(messageChecks) / double(iterations) << std::endl;
+        std::cout << std::endl;
+        //---------------
+        colorize::refreshTerminals();
+        colorize::red(std::cerr);
+        colorize::red(std::cerr);
+        std::cerr.rdbuf(cerrBuff);
+    }
+    catch (...) {
+        std::cerr.rdbuf(cerrBuff);
+        throw;
+    }
+    EXPECT_EQ(std::size_t(0), messageChecks);
+#if defined(__linux__)
+    EXPECT_EQ(checks + 1, bench::terminalChecks());
+#endif
+}
+
+/**************************************************************************************************/
+////////////////////////////////////////////////////////////////////////////////////////////////////
+/**************************************************************************************************/
+
+TEST(BenchColorize, strip_ansi) {
+    std::string colored;
+    colorize::appendColor(colored, colorize::AnsiRed, true);
+    colored.append("ERR: bench category the message of the usual size\n\t[function -> file(42)]");
+    colorize::appendColor(colored, colorize::AnsiReset, true);
+    colored.push_back('\n');
+    char buffer[256];
+    std::size_t size = 0;
+    const std::size_t iterations = 1000000;
+    //---------------
+    std::cout << std::endl;
+    bench::measure("stripAnsi(colored message)", iterations, [&](const std::size_t) {
+        size = colorize::stripAnsi(colored.data(), colored.size(), buffer);
+    });
+    std::cout << std::endl;
+    EXPECT_EQ(colored.size() - colorize::AnsiRed.size() - colorize::AnsiReset.size(), size);
+}
+
+/**************************************************************************************************/
+////////////////////////////////////////////////////////////////////////////////////////////////////
+/**************************************************************************************************/
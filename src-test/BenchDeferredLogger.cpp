@@ -0,0 +1,77 @@
+/*
+**  Copyright(C) 2019, StepToSky and FlightFactor
+**  All rights reserved
+**
+**  Redistribution and use in source and binary forms, with or without
+**  modification, are permitted provided that the following conditions are met:
+**
+**  1.Redistributions of source code must retain the above copyright notice, this
+**    list of conditions and the following disclaimer.
+**  2.Redistributions in binary form must reproduce the above copyright notice,
+**    this list of conditions and the following disclaimer in the documentation
+**    and / or other materials provided with the distribution.
+**  3.The name of StepToSky or the name of FlightFactor or the names of its
+**    contributors may NOT be used to endorse or promote products derived from
+**    this software without specific prior written permission.
+**
+**  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+**  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+**  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+**  DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+**  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+**  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+**  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+**  ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+**  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+**  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**
+**  Contacts: www.steptosky.com or www.flightfactor.aero
+*/
+
+#include "ph/stdafx.h"
+
+#include <atomic>
+#include <stsff/logging/DeferredLogger.h>
+#include <gtest/gtest.h>
+#include "Bench.h"
+
+using namespace stsff::logging;
+
+/**************************************************************************************************/
+////////////////////////////////////////////////////////////////////////////////////////////////////
+/**************************************************************************************************/
+
+TEST(BenchDeferredLogger, caller_cost) {
+    std::atomic<std::size_t> printed{0};
+    BaseLogger logger("bench");
+    logger.setHandler(BaseLogger::LvlMsg, [&printed](const BaseLogger &, const BaseLogger::LogMsg & logMsg) {
+        printed += logMsg.mMsg.size();
+    });
+    const std::size_t iterations = 200000;
+    //---------------
+    std::cout << std::endl;
+    bench::measureBest("LMessage(logger)", iterations, [&](const std::size_t i) {
+        LMessage(logger) << "value: " << i << " double: " << double(i) * 0.5 << " int: " << -int(i);
+    });
+    //---------------
+    // The buffer is big enough to keep all the messages of a batch, so the caller doesn't wait
+    // for the background thread. It is warmed up first, so the page faults aren't measured.
+    DeferredLogger deferred(logger);
+    const std::string warmUp(1024, 'w');
+    for (std::size_t i = 0; i < 1024; ++i) {
+        LDeferred(deferred, BaseLogger::LvlMsg, warmUp);
+    }
+    deferred.flush();
+    const auto allocations = bench::allocations();
+    bench::measureBest("LDeferred(deferred), caller side", iterations, [&](const std::size_t i) {
+        LDeferred(deferred, BaseLogger::LvlMsg, "value: ", i, " double: ", double(i) * 0.5, " int: ", -int(i));
+    });
+    EXPECT_EQ(allocations, bench::allocations());
+    deferred.flush();
+    EXPECT_NE(std::size_t(0), printed.load());
+    std::cout << std::endl;
+}
+
+/**************************************************************************************************/
+////////////////////////////////////////////////////////////////////////////////////////////////////
+/**************************************************************************************************/
@@ -0,0 +1,163 @@
+/*
+**  Copyright(C) 2019, StepToSky and FlightFactor
+**  All rights reserved
+**
+**  Redistribution and use in source and binary forms, with or without
+**  modification, are permitted provided that the following conditions are met:
+**
+**  1.Redistributions of source code must retain the above copyright notice, this
+**    list of conditions and the following disclaimer.
+**  2.Redistributions in binary form must reproduce the above copyright notice,
+**    this list of conditions and the following disclaimer in the documentation
+**    and / or other materials provided with the distribution.
+**  3.The name of StepToSky or the name of FlightFactor or the names of its
+**    contributors may NOT be used to endorse or promote products derived from
+**    this software without specific prior written permission.
+**
+**  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+**  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+**  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+**  DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+**  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+**  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+**  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+**  ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+**  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+**  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**
+**  Contacts: www.steptosky.com or www.flightfactor.aero
+*/
+
+#include "ph/stdafx.h"
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <stsff/logging/AsyncFileSink.h>
+#include <stsff/logging/BaseLogger.h>
+#include <stsff/logging/FileSink.h>
+#include <stsff/logging/MappedFileSink.h>
+#include <gtest/gtest.h>
+#include "Bench.h"
+
+#if !defined(_WIN32) && !defined(_WIN64)
+#   include <fcntl.h>
+#   include <unistd.h>
+#endif
+
+using namespace stsff::logging;
+
+/**************************************************************************************************/
+////////////////////////////////////////////////////////////////////////////////////////////////////
+/**************************************************************************************************/
+
+namespace {
+
+    std::size_t fileSize(const std::string & fileName) {
+        std::ifstream file(fileName, std::ios::binary | std::ios::ate);
+        return file ? std::size_t(file.tellg()) : 0;
+    }
+
+    void printThroughput(const double ns, const double bytes) {
+        std::cout << "        " << std::fixed << std::setprecision(1) << bytes / ns * 1000.0 << " MB/s, "
+                << std::setprecision(0) << 1000000000.0 / ns << " msgs/s" << std::defaultfloat << std::endl;
+    }
+
+    /*!
+     * \details Logs the messages with the handler and prints the throughput by the file size.
+     */
+    template<typename Fn>
+    void throughput(const char * name, const std::string & fileName, const std::size_t iterations, Fn fn) {
+        const double ns = bench::measure(name, iterations, fn);
+        printThroughput(ns, double(fileSize(fileName)) / double(iterations));
+        std::remove(fileName.c_str());
+    }
+
+}
+
+/**************************************************************************************************/
+////////////////////////////////////////////////////////////////////////////////////////////////////
+/**************************************************************************************************/
+
+TEST(BenchFileSink, throughput) {
+    const std::string fileName("bench-file-sink.log");
+    const FormatPattern pattern("%TM(%Y-%m-%d %T.%6N) INF: %LN %MC %MS [%FN -> %FI(%LI)]");
+    const BaseLogger::LogMsg logMsg(BaseLogger::LvlInfo, "category", "the message of the usual size with some details",
+                                    CodeLocation("function", "file", 42));
+    BaseLogger logger("bench");
+    const std::size_t iterations = 200000;
+    std::remove(fileName.c_str());
+    //---------------
+    std::cout << std::endl;
+    {
+        std::ofstream stream(fileName);
+        throughput("defaultHandler(std::ofstream), flush each", fileName, iterations, [&](const std::size_t) {
+            BaseLogger::defaultHandler(logger, logMsg, stream, pattern, nullptr);
+        });
+    }
+    {
+        std::ofstream stream(fileName);
+        logger.setFlushPolicy(BaseLogger::FlushPolicy::never());
+        throughput("defaultHandler(std::ofstream), no flush", fileName, iterations, [&](const std::size_t i) {
+            BaseLogger::defaultHandler(logger, logMsg, stream, pattern, nullptr);
+            if (i + 1 == iterations) {
+                stream.flush();
+            }
+        });
+    }
+#if !defined(_WIN32) && !defined(_WIN64)
+    {
+        const int fd = ::open(fileName.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+        internal::MessageBuffer buffer;
+        throughput("renderMessage + write(2) each", fileName, iterations, [&](const std::size_t) {
+            buffer.clear();
+            BaseLogger::renderMessage(buffer, logger, logMsg, pattern);
+            buffer.append('\n');
+            if (::write(fd, buffer.data(), buffer.size()) < 0) {
+                FAIL();
+            }
+        });
+        ::close(fd);
+    }
+#endif
+    {
+        const FileSink sink(fileName, pattern);
+        throughput("FileSink, 1 MiB buffer", fileName, iterations, [&](const std::size_t i) {
+            sink(logger, logMsg);
+            if (i + 1 == iterations) {
+                sink.flush();
+            }
+        });
+    }
+    for (const auto backend : {AsyncFileSink::BackendAuto, AsyncFileSink::BackendThread}) {
+        const AsyncFileSink sink(fileName, pattern, AsyncFileSink::DefaultBufferSize,
+                                 AsyncFileSink::DefaultBufferCount, backend);
+        const std::string name = std::string("AsyncFileSink, 4 x 256 KiB, ") + (sink.usesIoUring() ? "io_uring" : "thread");
+        throughput(name.c_str(), fileName, iterations, [&](const std::size_t i) {
+            sink(logger, logMsg);
+            if (i + 1 == iterations) {
+                sink.flush();
+            }
+        });
+    }
+#if !defined(_WIN32) && !defined(_WIN64)
+    {
+        // the segments are preallocated, so the throughput is counted by the written bytes.
+        const MappedFileSink sink(fileName, pattern);
+        // the background thread prepares the spare segment, it is not the logging time.
+        std::this_thread::sleep_for(std::chrono::milliseconds(300));
+        const double ns = bench::measure("MappedFileSink, 64 MiB segments", iterations, [&](const std::size_t) {
+            sink(logger, logMsg);
+        });
+        printThroughput(ns, double(sink.written()) / double(iterations));
+    }
+    for (std::size_t i = 1; std::remove((fileName + "." + std::to_string(i)).c_str()) == 0; ++i) {}
+#endif
+    std::cout << std::endl;
+}
+
+/**************************************************************************************************/
+////////////////////////////////////////////////////////////////////////////////////////////////////
+/**************************************************************************************************/
@@ -0,0 +1,79 @@
+/*
+**  Copyright(C) 2019, StepToSky and FlightFactor
+**  All rights reserved
+**
+**  Redistribution and use in source and binary forms, with or without
+**  modification, are permitted provided that the following conditions are met:
+**
+**  1.Redistributions of source code must retain the above copyright notice, this
+**    list of conditions and the following disclaimer.
+**  2.Redistributions in binary form must reproduce the above copyright notice,
+**    this list of conditions and the following disclaimer in the documentation
+**    and / or other materials provided with the distribution.
+**  3.The name of StepToSky or the name of FlightFactor or the names of its
+**    contributors may NOT be used to endorse or promote products derived from
+**    this software without specific prior written permission.
+**
+**  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+**  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+**  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+**  DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+**  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+**  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+**  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+**  ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+**  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+**  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**
+**  Contacts: www.steptosky.com or www.flightfactor.aero
+*/
+
+#include "ph/stdafx.h"
+
+#include <memory>
+#include <stsff/logging/FlightRecorder.h>
+#include <gtest/gtest.h>
+#include "Bench.h"
+
+using namespace stsff::logging;
+
+/**************************************************************************************************/
+////////////////////////////////////////////////////////////////////////////////////////////////////
+/**************************************************************************************************/
+
+TEST(BenchFlightRecorder, capture_cost) {
+    std::size_t printed = 0;
+    BaseLogger logger("bench");
+    logger.setLevel(BaseLogger::LvlInfo);
+    logger.setHandler(BaseLogger::LvlDebug, [&printed](const BaseLogger &, const BaseLogger::LogMsg & logMsg) {
+        printed += logMsg.mMsg.size();
+    });
+    const std::size_t iterations = 200000;
+    //---------------
+    std::cout << std::endl;
+    bench::measure("disabled LDebug(logger)", iterations, [&](const std::size_t i) {
+        LDebug(logger) << "value: " << i << " double: " << 0.5 << " text";
+    });
+    //---------------
+    logger.setFlightRecorder(std::make_shared<FlightRecorder>());
+    LDebug(logger) << "warm up " << 1;
+    const auto allocations = bench::allocations();
+    bench::measure("captured LDebug(logger)", iterations, [&](const std::size_t i) {
+        LDebug(logger) << "value: " << i << " double: " << 0.5 << " text";
+    });
+    const auto captureAllocations = bench::allocations() - allocations;
+    std::cout << "    allocations per message: " << double(captureAllocations) / double(iterations) << std::endl;
+    EXPECT_EQ(std::size_t(0), captureAllocations);
+    EXPECT_EQ(std::size_t(0), printed);
+    //---------------
+    logger.setLevel(BaseLogger::LvlDebug);
+    bench::measure("handled LDebug(logger)", iterations, [&](const std::size_t i) {
+        LDebug(logger) << "value: " << i << " double: " << 0.5 << " text";
+    });
+    EXPECT_NE(std::size_t(0), printed);
+    std::cout << std::endl;
+}
+
+/**************************************************************************************************/
+////////////////////////////////////////////////////////////////////////////////////////////////////
+/**************************************************************************************************/
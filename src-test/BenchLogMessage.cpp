@@ -0,0 +1,331 @@
+/*
+**  Copyright(C) 2019, StepToSky and FlightFactor
+**  All rights reserved
+**
+**  Redistribution and use in source and binary forms, with or without
+**  modification, are permitted provided that the following conditions are met:
+**
+**  1.Redistributions of source code must retain the above copyright notice, this
+**    list of conditions and the following disclaimer.
+**  2.Redistributions in binary form must reproduce the above copyright notice,
+**    this list of conditions and the following disclaimer in the documentation
+**    and / or other materials provided with the distribution.
+**  3.The name of StepToSky or the name of FlightFactor or the names of its
+**    contributors may NOT be used to endorse or promote products derived from
+**    this software without specific prior written permission.
+**
+**  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+**  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+**  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+**  DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+**  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+**  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+**  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+**  ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+**  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+**  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**
+**  Contacts: www.steptosky.com or www.flightfactor.aero
+*/
+
+#include "ph/stdafx.h"
+
+#include <cstdio>
+#include <fstream>
+#if !defined(_WIN32) && !defined(_WIN64)
+#   include <fcntl.h>
+#   include <unistd.h>
+#endif
+#include <stsff/logging/BaseLogger.h>
+#include <stsff/logging/ConsoleSink.h>
+#include <gtest/gtest.h>
+#include "Bench.h"
+
+using namespace stsff::logging;
+
+/**************************************************************************************************/
+////////////////////////////////////////////////////////////////////////////////////////////////////
+/**************************************************************************************************/
+
+TEST(BenchLogMessage, disabled_level) {
+    BaseLogger logger("bench");
+    logger.setLevel(BaseLogger::LvlInfo);
+    const std::size_t iterations = 1000000;
+    std::size_t evaluated = 0;
+    auto argument = [&](const std::size_t i) {
+        ++evaluated;
+        return i;
+    };
+    //---------------
+    std::cout << std::endl;
+    const auto constructed = bench::measure("disabled LogMessage(logger).debug()", iterations, [&](const std::size_t i) {
+        LogMessage(logger).debug() << "value: " << argument(i) << " double: " << 0.5;
+    });
+    EXPECT_EQ(iterations, evaluated);
+    //---------------
+    evaluated = 0;
+    const auto guarded = bench::measure("disabled LDebug(logger)", iterations, [&](const std::size_t i) {
+        LDebug(logger) << "value: " << argument(i) << " double: " << 0.5;
+    });
+    EXPECT_EQ(std::size_t(0), evaluated);
+    std::cout << "    speedup: " << constructed / guarded << std::endl << std::endl;
+}
+
+/**************************************************************************************************/
+////////////////////////////////////////////////////////////////////////////////////////////////////
+/**************************************************************************************************/
+
+TEST(BenchLogMessage, message_allocations) {
+    BaseLogger logger("bench");
+    std::size_t printed = 0;
+    logger.setHandler(BaseLogger::LvlMsg, [&printed](const BaseLogger &, const BaseLogger::LogMsg & logMsg) {
+        printed += logMsg.mMsg.size();
+    });
+    const std::size_t iterations = 200000;
+    LMessage(logger) << "warm up " << 1;
+    //---------------
+    std::cout << std::endl;
+    auto allocations = bench::allocations();
+    bench::measure("std::stringstream + std::string copy", iterations, [&](const std::size_t i) {
+        std::stringstream stream;
+        stream << "value: " << i << " double: " << 0.5 << " text";
+        const auto str = stream.str();
+        printed += str.size();
+    });
+    std::cout << "    allocations per message: "
+            << double(bench::allocations() - allocations) / double(iterations) << std::endl;
+    //---------------
+    allocations = bench::allocations();
+    bench::measure("LMessage(logger)", iterations, [&](const std::size_t i) {
+        LMessage(logger) << "value: " << i << " double: " << 0.5 << " text";
+    });
+    const auto messageAllocations = bench::allocations() - allocations;
+    std::cout << "    allocations per message: " << double(messageAllocations) / double(iterations) << std::endl;
+    EXPECT_EQ(std::size_t(0), messageAllocations);
+    //---------------
+    const std::string longText(internal::MessageBuffer::InlineCapacity, 'x');
+    allocations = bench::allocations();
+    LMessage(logger) << longText << " does not fit the inline buffer";
+    EXPECT_NE(allocations, bench::allocations());
+    std::cout << std::endl;
+}
+
+/**************************************************************************************************/
+////////////////////////////////////////////////////////////////////////////////////////////////////
+/**************************************************************************************************/
+
+TEST(BenchLogMessage, numeric_formatting) {
+    BaseLogger logger("bench");
+    std::size_t printed = 0;
+    logger.setHandler(BaseLogger::LvlMsg, [&printed](const BaseLogger &, const BaseLogger::LogMsg & logMsg) {
+        printed += logMsg.mMsg.size();
+    });
+    const std::size_t iterations = 200000;
+    //---------------
+    std::cout << std::endl;
+    // std::dec forces the std::ostream path, which is what every message used before.
+    const auto streamed = bench::measure("LMessage(logger) via std::ostream", iterations, [&](const std::size_t i) {
+        LMessage(logger) << std::dec << i << ' ' << -std::int64_t(i) << ' ' << double(i) * 0.001 << ' ' << float(i) * 0.5f;
+    });
+    const auto fast = bench::measure("LMessage(logger) via FastFormat", iterations, [&](const std::size_t i) {
+        LMessage(logger) << i << ' ' << -std::int64_t(i) << ' ' << double(i) * 0.001 << ' ' << float(i) * 0.5f;
+    });
+    std::cout << "    speedup: " << streamed / fast << std::endl;
+    //---------------
+    char buff[128];
+    bench::measure("snprintf", iterations, [&](const std::size_t i) {
+        printed += std::size_t(std::snprintf(buff, sizeof(buff), "%zu %lld %.17g %.9g", i,
+                                             -static_cast<long long>(i), double(i) * 0.001, double(float(i) * 0.5f)));
+    });
+    EXPECT_NE(std::size_t(0), printed);
+    std::cout << std::endl;
+}
+
+/**************************************************************************************************/
+////////////////////////////////////////////////////////////////////////////////////////////////////
+/**************************************************************************************************/
+
+TEST(BenchLogMessage, default_handler) {
+    const std::string formatting("ERR: %LN %MC %MS \n\t[%FN -> %FI(%LI)]");
+    const FormatPattern pattern(formatting);
+    std::stringstream stream;
+    BaseLogger logger("bench");
+    const BaseLogger::LogMsg logMsg(BaseLogger::LvlError, "category", "message", CodeLocation("function", "file", 42));
+    const std::size_t iterations = 200000;
+    //---------------
+    std::cout << std::endl;
+    bench::measure("parse the formatting for each message", iterations, [&](const std::size_t) {
+        BaseLogger::defaultHandler(logger, logMsg, stream, FormatPattern(formatting, FormatPattern::ErrorsInline), nullptr);
+    });
+    stream.str(std::string());
+    bench::measure("defaultHandler(formatting string)", iterations, [&](const std::size_t) {
+        BaseLogger::defaultHandler(logger, logMsg, stream, formatting, nullptr);
+    });
+    stream.str(std::string());
+    bench::measure("defaultHandler(FormatPattern)", iterations, [&](const std::size_t) {
+        BaseLogger::defaultHandler(logger, logMsg, stream, pattern, nullptr);
+    });
+    EXPECT_NE(std::size_t(0), stream.str().size());
+    std::cout << std::endl;
+}
+
+/**************************************************************************************************/
+////////////////////////////////////////////////////////////////////////////////////////////////////
+/**************************************************************************************************/
+
+TEST(BenchLogMessage, flush_policy) {
+    const char * fileName = "bench-flush-policy.log";
+    const FormatPattern pattern("ERR: %LN %MC %MS \n\t[%FN -> %FI(%LI)]");
+    std::ofstream stream(fileName);
+    ASSERT_TRUE(stream.is_open());
+    BaseLogger logger("bench");
+    const BaseLogger::LogMsg logMsg(BaseLogger::LvlError, "category", "message", CodeLocation("function", "file", 42));
+    const std::size_t iterations = 200000;
+    //---------------
+    std::cout << std::endl;
+    bench::measure("file, flush each message", iterations, [&](const std::size_t) {
+        BaseLogger::defaultHandler(logger, logMsg, stream, pattern, nullptr);
+    });
+    logger.setFlushPolicy(BaseLogger::FlushPolicy::everyMessages(256));
+    bench::measure("file, flush each 256 messages", iterations, [&](const std::size_t) {
+        BaseLogger::defaultHandler(logger, logMsg, stream, pattern, nullptr);
+    });
+    logger.setFlushPolicy(BaseLogger::FlushPolicy::everyMilliseconds(100));
+    bench::measure("file, flush each 100 ms", iterations, [&](const std::size_t) {
+        BaseLogger::defaultHandler(logger, logMsg, stream, pattern, nullptr);
+    });
+    std::cout << std::endl;
+    stream.close();
+    std::remove(fileName);
+}
+
+/**************************************************************************************************/
+////////////////////////////////////////////////////////////////////////////////////////////////////
+/**************************************************************************************************/
+
+#if !defined(_WIN32) && !defined(_WIN64)
+
+TEST(BenchLogMessage, console_sink) {
+    const FormatPattern pattern("ERR: %LN %MC %MS \n\t[%FN -> %FI(%LI)]");
+    std::ofstream stream("/dev/null");
+    const int fileDescriptor = ::open("/dev/null", O_WRONLY);
+    ASSERT_NE(-1, fileDescriptor);
+    const ConsoleSink sink(fileDescriptor, pattern, colorize::red, ConsoleSink::ColorsAlways);
+    stream << colorize::colorized;
+    BaseLogger logger("bench");
+    const BaseLogger::LogMsg logMsg(BaseLogger::LvlError, "category", "message", CodeLocation("function", "file", 42));
+    const std::size_t iterations = 200000;
+    //---------------
+    std::cout << std::endl;
+    bench::measure("defaultHandler into std::ofstream", iterations, [&](const std::size_t) {
+        BaseLogger::defaultHandler(logger, logMsg, stream, pattern, colorize::red);
+    });
+    bench::measure("ConsoleSink", iterations, [&](const std::size_t) {
+        sink(logger, logMsg);
+    });
+    std::cout << std::endl;
+    ::close(fileDescriptor);
+}
+
+/**************************************************************************************************/
+////////////////////////////////////////////////////////////////////////////////////////////////////
+/**************************************************************************************************/
+
+#endif
+
+TEST(BenchLogMessage, time_stamp) {
+    const std::string format("%Y-%m-%d %T");
+    const std::int64_t time = std::int64_t(1551700800) * 1000000000;
+    const std::size_t iterations = 200000;
+    std::size_t printed = 0;
+    //---------------
+    std::cout << std::endl;
+    bench::measure("timeStamp(std::string)", iterations, [&](const std::size_t i) {
+        printed += BaseLogger::timeStamp(format, time + std::int64_t(i)).size();
+    });
+    char buffer[100];
+    const auto allocations = bench::allocations();
+    bench::measure("timeStamp(buffer), same second", iterations, [&](const std::size_t i) {
+        printed += BaseLogger::timeStamp(buffer, sizeof buffer, format.c_str(), time + std::int64_t(i));
+    });
+    EXPECT_EQ(allocations, bench::allocations());
+    bench::measure("timeStamp(buffer), new second", iterations, [&](const std::size_t i) {
+        printed += BaseLogger::timeStamp(buffer, sizeof buffer, format.c_str(), time + std::int64_t(i) * 1000000000);
+    });
+    EXPECT_NE(std::size_t(0), printed);
+    std::cout << std::endl;
+}
+
+/**************************************************************************************************/
+////////////////////////////////////////////////////////////////////////////////////////////////////
+/**************************************************************************************************/
+
+namespace {
+
+    std::size_t benchRawHandled = 0;
+
+}
+
+TEST(BenchLogMessage, dispatch) {
+    typedef std::unordered_map<std::size_t, BaseLogger::LevelHandler> Map;
+    std::size_t handled = 0;
+    const auto handler = [&handled](const BaseLogger &, const BaseLogger::LogMsg &) { ++handled; };
+    BaseLogger logger("bench", {{BaseLogger::LvlMsg, handler}, {750, handler}});
+    const Map map{{BaseLogger::LvlMsg, handler}, {750, handler}};
+    const BaseLogger::LogMsg standard(BaseLogger::LvlMsg, "", "message", CodeLocation());
+    const BaseLogger::LogMsg custom(750, "", "message", CodeLocation());
+    const std::size_t iterations = 1000000;
+    //---------------
+    std::cout << std::endl;
+    bench::measure("unordered_map::find + std::function", iterations, [&](const std::size_t) {
+        const auto it = map.find(standard.mLevel);
+        if (it != map.end()) {
+            it->second(logger, standard);
+        }
+    });
+    bench::measure("BaseLogger::log, standard level", iterations, [&](const std::size_t) {
+        logger.log(standard);
+    });
+    bench::measure("BaseLogger::log, custom level", iterations, [&](const std::size_t) {
+        logger.log(custom);
+    });
+    BaseLogger raw("bench", {{BaseLogger::LvlMsg, +[](const BaseLogger &, const BaseLogger::LogMsg & logMsg) {
+        benchRawHandled += logMsg.mLevel;
+    }}});
+    bench::measure("BaseLogger::log, plain function handler", iterations, [&](const std::size_t) {
+        raw.log(standard);
+    });
+    EXPECT_EQ(3 * iterations, handled);
+    EXPECT_EQ(iterations * BaseLogger::LvlMsg, benchRawHandled);
+    std::cout << std::endl;
+}
+
+/**************************************************************************************************/
+////////////////////////////////////////////////////////////////////////////////////////////////////
+/**************************************************************************************************/
+
+TEST(BenchLogMessage, logger_creation) {
+    const std::size_t iterations = 200000;
+    std::size_t handlers = 0;
+    const BaseLogger prototype("bench");
+    //---------------
+    std::cout << std::endl;
+    auto allocations = bench::allocations();
+    bench::measure("BaseLogger(name)", iterations, [&](const std::size_t) {
+        const BaseLogger logger("bench");
+        handlers += logger.handlers().size();
+    });
+    std::cout << "    allocations per logger: " << double(bench::allocations() - allocations) / double(iterations) << std::endl;
+    allocations = bench::allocations();
+    bench::measure("BaseLogger(const BaseLogger &)", iterations, [&](const std::size_t) {
+        const BaseLogger logger(prototype);
+        handlers += logger.handlers().size();
+    });
+    std::cout << "    allocations per logger: " << double(bench::allocations() - allocations) / double(iterations) << std::endl;
+    EXPECT_NE(std::size_t(0), handlers);
+    std::cout << std::endl;
+}
+
+/**************************************************************************************************/
+////////////////////////////////////////////////////////////////////////////////////////////////////
+/**************************************************************************************************/
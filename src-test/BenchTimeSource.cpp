@@ -0,0 +1,125 @@
+/*
+**  Copyright(C) 2019, StepToSky and FlightFactor
+**  All rights reserved
+**
+**  Redistribution and use in source and binary forms, with or without
+**  modification, are permitted provided that the following conditions are met:
+**
+**  1.Redistributions of source code must retain the above copyright notice, this
+**    list of conditions and the following disclaimer.
+**  2.Redistributions in binary form must reproduce the above copyright notice,
+**    this list of conditions and the following disclaimer in the documentation
+**    and / or other materials provided with the distribution.
+**  3.The name of StepToSky or the name of FlightFactor or the names of its
+**    contributors may NOT be used to endorse or promote products derived from
+**    this software without specific prior written permission.
+**
+**  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+**  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+**  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+**  DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+**  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+**  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+**  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+**  ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+**  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+**  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**
+**  Contacts: www.steptosky.com or www.flightfactor.aero
+*/
+
+#include "ph/stdafx.h"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <stsff/logging/BaseLogger.h>
+#include <gtest/gtest.h>
+#include "Bench.h"
+
+using namespace stsff::logging;
+
+/**************************************************************************************************/
+////////////////////////////////////////////////////////////////////////////////////////////////////
+/**************************************************************************************************/
+
+namespace {
+
+    /*!
+     * \details Renders the current time from the specified number of threads
+     *          and prints the number of the timestamps per second.
+     */
+    void timeStamps(const char * name, const std::size_t threadsNum, const std::size_t iterations) {
+        std::atomic<std::size_t> printed{0};
+        const auto start = std::chrono::steady_clock::now();
+        std::vector<std::thread> threads;
+        for (std::size_t t = 0; t < threadsNum; ++t) {
+            threads.emplace_back([&printed, iterations]() {
+                char buffer[100];
+                std::size_t size = 0;
+                for (std::size_t i = 0; i < iterations; ++i) {
+                    size += BaseLogger::timeStamp(buffer, sizeof buffer, "%Y-%m-%d %T.%6N", 0);
+                }
+                printed += size;
+            });
+        }
+        for (auto & thread : threads) {
+            thread.join();
+        }
+        const auto end = std::chrono::steady_clock::now();
+        const double seconds = std::chrono::duration<double>(end - start).count();
+        std::cout << "    " << std::left << std::setw(48) << name
+                << std::right << std::setw(12) << std::fixed << std::setprecision(0)
+                << double(threadsNum * iterations) / seconds << " timestamps/s"
+                << std::defaultfloat << std::endl;
+        EXPECT_NE(std::size_t(0), printed.load());
+    }
+
+}
+
+/**************************************************************************************************/
+////////////////////////////////////////////////////////////////////////////////////////////////////
+/**************************************************************************************************/
+
+TEST(BenchTimeSource, clocks) {
+    const std::size_t iterations = 1000000;
+    std::int64_t sum = 0;
+    //---------------
+    std::cout << std::endl;
+    bench::measure("TimeSource::now(ClockSystem)", iterations, [&](const std::size_t) {
+        sum += TimeSource::now(TimeSource::ClockSystem);
+    });
+    bench::measure("TimeSource::now(ClockCoarse)", iterations, [&](const std::size_t) {
+        sum += TimeSource::now(TimeSource::ClockCoarse);
+    });
+    bench::measure("TimeSource::now(ClockTsc)", iterations, [&](const std::size_t) {
+        sum += TimeSource::now(TimeSource::ClockTsc);
+    });
+    TimeSource::setClock(TimeSource::ClockTsc);
+    bench::measure("TimeSource::capture(), ClockTsc", iterations, [&](const std::size_t) {
+        sum += TimeSource::capture().mValue;
+    });
+    TimeSource::setClock(TimeSource::ClockSystem);
+    if (!TimeSource::isTscAvailable()) {
+        std::cout << "    the invariant TSC isn't available, ClockTsc is ClockSystem" << std::endl;
+    }
+    EXPECT_NE(0, sum);
+    std::cout << std::endl;
+}
+
+TEST(BenchTimeSource, time_stamps) {
+    const std::size_t iterations = 200000;
+    //---------------
+    std::cout << std::endl;
+    timeStamps("1 thread, ClockSystem", 1, iterations);
+    timeStamps("4 threads, ClockSystem", 4, iterations);
+    TimeSource::setClock(TimeSource::ClockCoarse);
+    timeStamps("1 thread, ClockCoarse", 1, iterations);
+    timeStamps("4 threads, ClockCoarse", 4, iterations);
+    TimeSource::setClock(TimeSource::ClockSystem);
+    std::cout << std::endl;
+}
+
+/**************************************************************************************************/
+////////////////////////////////////////////////////////////////////////////////////////////////////
+/**************************************************************************************************/
@@ -0,0 +1,208 @@
+/*
+**  Copyright(C) 2019, StepToSky and FlightFactor
+**  All rights reserved
+**
+**  Redistribution and use in source and binary forms, with or without
+**  modification, are permitted provided that the following conditions are met:
+**
+**  1.Redistributions of source code must retain the above copyright notice, this
+**    list of conditions and the following disclaimer.
+**  2.Redistributions in binary form must reproduce the above copyright notice,
+**    this list of conditions and the following disclaimer in the documentation
+**    and / or other materials provided with the distribution.
+**  3.The name of StepToSky or the name of FlightFactor or the names of its
+**    contributors may NOT be used to endorse or promote products derived from
+**    this software without specific prior written permission.
+**
+**  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+**  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+**  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+**  DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+**  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+**  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+**  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+**  ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+**  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+**  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**
+**  Contacts: www.steptosky.com or www.flightfactor.aero
+*/
+
+#include "ph/stdafx.h"
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <stsff/logging/AsyncFileSink.h>
+#include <stsff/logging/BaseLogger.h>
+#include <gtest/gtest.h>
+
+using namespace stsff::logging;
+
+/**************************************************************************************************/
+////////////////////////////////////////////////////////////////////////////////////////////////////
+/**************************************************************************************************/
+
+namespace {
+
+    std::string readFile(const std::string & fileName) {
+        std::ifstream file(fileName, std::ios::binary);
+        std::stringstream text;
+        text << file.rdbuf();
+        return text.str();
+    }
+
+    bool waitFor(const std::function<bool()> & condition) {
+        for (std::size_t i = 0; i < 500; ++i) {
+            if (condition()) {
+                return true;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        return condition();
+    }
+
+    const AsyncFileSink::eBackend Backends[] = {AsyncFileSink::BackendAuto, AsyncFileSink::BackendThread};
+
+}
+
+/**************************************************************************************************/
+////////////////////////////////////////////////////////////////////////////////////////////////////
+/**************************************************************************************************/
+
+TEST(AsyncFileSink, buffers_in_flight) {
+    const std::string fileName("test-async-file-sink-buffers.log");
+    for (const auto backend : Backends) {
+        std::remove(fileName.c_str());
+        std::string expected;
+        {
+            AsyncFileSink sink(fileName, "%MS", 64, 3, backend);
+            ASSERT_TRUE(sink.isOpen());
+            if (backend == AsyncFileSink::BackendThread) {
+                ASSERT_FALSE(sink.usesIoUring());
+            }
+            BaseLogger logger;
+            logger.setHandler(BaseLogger::LvlMsg, sink);
+            //---------------
+            LMessage(logger) << "first" << LPush;
+            sink.flush();
+            ASSERT_EQ("first\n", readFile(fileName));
+            ASSERT_EQ(std::uint64_t(6), sink.written());
+            expected.append("first\n");
+            //---------------
+            // the lines are split between the buffers and the lines longer than the buffer too.
+            for (std::size_t i = 0; i < 1000; ++i) {
+                const std::string text = std::to_string(i) + " " + std::string(i % 150, 'x');
+                LMessage(logger) << text << LPush;
+                expected.append(text).append("\n");
+            }
+            LMessage(logger) << "written by destructor" << LPush;
+            expected.append("written by destructor\n");
+        }
+        ASSERT_EQ(expected, readFile(fileName)) << backend;
+        //---------------
+        // the messages are appended to the existing file.
+        {
+            const AsyncFileSink sink(fileName, "%MS", 64, 2, backend);
+            BaseLogger logger;
+            logger.setHandler(BaseLogger::LvlMsg, sink);
+            LMessage(logger) << "appended" << LPush;
+        }
+        ASSERT_EQ(expected + "appended\n", readFile(fileName)) << backend;
+    }
+    std::remove(fileName.c_str());
+}
+
+TEST(AsyncFileSink, flush_policy) {
+    const std::string fileName("test-async-file-sink-policy.log");
+    for (const auto backend : Backends) {
+        std::remove(fileName.c_str());
+        AsyncFileSink sink(fileName, "%MS", 1024, 4, backend);
+        BaseLogger logger;
+        for (auto level : {BaseLogger::LvlMsg, BaseLogger::LvlCritical}) {
+            logger.setHandler(level, sink);
+        }
+        LMessage(logger) << "message" << LPush;
+        LCritical(logger) << "critical" << LPush;
+        // the critical message is submitted at once.
+        ASSERT_TRUE(waitFor([&]() { return readFile(fileName) == "message\ncritical\n"; }));
+        //---------------
+        sink.setFlushPolicy(AsyncFileSink::FlushPolicy::everyMessages(2));
+        LMessage(logger) << "1" << LPush;
+        LMessage(logger) << "2" << LPush;
+        LMessage(logger) << "3" << LPush;
+        sink.flush();
+        ASSERT_EQ("message\ncritical\n1\n2\n3\n", readFile(fileName));
+        ASSERT_EQ(std::uint64_t(23), sink.written());
+    }
+    std::remove(fileName.c_str());
+}
+
+TEST(AsyncFileSink, concurrent_writes) {
+    const std::string fileName("test-async-file-sink-concurrent.log");
+    const std::size_t threadCount = 8;
+    const std::size_t messageCount = 2000;
+    for (const auto backend : Backends) {
+        std::remove(fileName.c_str());
+        {
+            BaseLogger logger("log");
+            logger.setHandler(BaseLogger::LvlMsg, AsyncFileSink(fileName, "%LN %MS", 4096, 4, backend));
+            std::vector<std::thread> threads;
+            for (std::size_t t = 0; t < threadCount; ++t) {
+                threads.emplace_back([&, t]() {
+                    for (std::size_t i = 0; i < messageCount; ++i) {
+                        LMessage(logger) << t << " " << i << " " << std::string(i % 50, 'z') << LPush;
+                    }
+                });
+            }
+            for (auto & thread : threads) {
+                thread.join();
+            }
+        }
+        //---------------
+        std::istringstream text(readFile(fileName));
+        std::vector<std::size_t> next(threadCount, 0);
+        std::string line;
+        std::size_t lines = 0;
+        while (std::getline(text, line)) {
+            std::istringstream fields(line);
+            std::string name;
+            std::size_t thread = 0;
+            std::size_t index = 0;
+            std::string tail;
+            fields >> name >> thread >> index;
+            std::getline(fields, tail);
+            ASSERT_EQ("log", name) << line;
+            ASSERT_LT(thread, threadCount) << line;
+            ASSERT_EQ(next[thread]++, index) << line;
+            ASSERT_EQ(" " + std::string(index % 50, 'z'), tail) << line;
+            ++lines;
+        }
+        ASSERT_EQ(threadCount * messageCount, lines) << backend;
+    }
+    std::remove(fileName.c_str());
+}
+
+TEST(AsyncFileSink, invalid_file) {
+    std::stringstream errors;
+    auto * cerrBuff = std::cerr.rdbuf(errors.rdbuf());
+    const AsyncFileSink sink("not-existing-directory/file.log", "%MS");
+    std::cerr.rdbuf(cerrBuff);
+    ASSERT_FALSE(sink.isOpen());
+    ASSERT_NE(std::string::npos, errors.str().find("can't open the log file"));
+    //---------------
+    BaseLogger logger;
+    logger.setHandler(BaseLogger::LvlMsg, sink);
+    LMessage(logger) << "dropped" << LPush;
+    sink.flush();
+    ASSERT_EQ(std::uint64_t(0), sink.written());
+}
+
+/**************************************************************************************************/
+////////////////////////////////////////////////////////////////////////////////////////////////////
+/**************************************************************************************************/
@@ -0,0 +1,470 @@
+/*
+**  Copyright(C) 2019, StepToSky and FlightFactor
+**  All rights reserved
+**
+**  Redistribution and use in source and binary forms, with or without
+**  modification, are permitted provided that the following conditions are met:
+**
+**  1.Redistributions of source code must retain the above copyright notice, this
+**    list of conditions and the following disclaimer.
+**  2.Redistributions in binary form must reproduce the above copyright notice,
+**    this list of conditions and the following disclaimer in the documentation
+**    and / or other materials provided with the distribution.
+**  3.The name of StepToSky or the name of FlightFactor or the names of its
+**    contributors may NOT be used to endorse or promote products derived from
+**    this software without specific prior written permission.
+**
+**  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+**  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+**  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+**  DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+**  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+**  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+**  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+**  ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+**  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+**  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**
+**  Contacts: www.steptosky.com or www.flightfactor.aero
+*/
+
+#include "ph/stdafx.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <vector>
+#include <stsff/logging/AsyncLogger.h>
+#include <gtest/gtest.h>
+
+using namespace stsff::logging;
+
+/**************************************************************************************************/
+////////////////////////////////////////////////////////////////////////////////////////////////////
+/**************************************************************************************************/
+
+TEST(AsyncLogger, formatting) {
+    std::stringstream stream;
+    std::thread::id handlerThread;
+    AsyncLogger logger("log-category");
+    logger.setHandler(BaseLogger::LvlMsg, [&](const BaseLogger & l, const BaseLogger::LogMsg & logMsg) {
+        handlerThread = std::this_thread::get_id();
+        BaseLogger::defaultHandler(l, logMsg, stream, "%LN,%MC,%MS,%FN,%FI,%LI", nullptr);
+    });
+    //---------------
+    const std::string function("function");
+    LogMessage(logger, CodeLocation(function, "file", 5)).setCategory("msg-cat").message() << "message " << 42;
+    logger.flush();
+    EXPECT_STREQ("log-category,msg-cat,message 42,function,file,5\n", stream.str().c_str());
+    EXPECT_NE(std::this_thread::get_id(), handlerThread);
+    EXPECT_EQ(std::size_t(0), logger.queueSize());
+}
+
+TEST(AsyncLogger, time_of_call) {
+    std::int64_t time = 0;
+    std::int64_t handled = 0;
+    AsyncLogger logger;
+    logger.setHandler(BaseLogger::LvlMsg, [&](const BaseLogger &, const BaseLogger::LogMsg & logMsg) {
+        time = logMsg.mTime;
+        handled = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::system_clock::now().time_since_epoch()).count();
+    });
+    //---------------
+    LMessage(logger) << "message";
+    logger.flush();
+    EXPECT_NE(0, time);
+    EXPECT_LE(time, handled);
+}
+
+TEST(AsyncLogger, time_of_call_tsc) {
+    std::int64_t time = 0;
+    std::int64_t handled = 0;
+    TimeSource::setClock(TimeSource::ClockTsc);
+    const std::int64_t before = TimeSource::now(TimeSource::ClockSystem);
+    {
+        AsyncLogger logger("", AsyncLogger::QueuePerThread, 4096);
+        logger.setHandler(BaseLogger::LvlMsg, [&](const BaseLogger &, const BaseLogger::LogMsg & logMsg) {
+            time = logMsg.mTime;
+            handled = TimeSource::now(TimeSource::ClockSystem);
+        });
+        //---------------
+        LMessage(logger) << "message";
+        logger.flush();
+    }
+    TimeSource::setClock(TimeSource::ClockSystem);
+    // the conversion error of the timestamp counter is much less than a millisecond.
+    EXPECT_LE(before - 1000000, time);
+    EXPECT_LE(time, handled + 1000000);
+}
+
+TEST(AsyncLogger, level) {
+    std::size_t handled = 0;
+    AsyncLogger logger;
+    logger.setLevel(BaseLogger::LvlInfo);
+    logger.setHandler(BaseLogger::LvlDebug, [&](const BaseLogger &, const BaseLogger::LogMsg &) {
+        ++handled;
+    });
+    //---------------
+    LogMessage(logger).debug() << "message";
+    logger.flush();
+    EXPECT_EQ(std::size_t(0), handled);
+}
+
+TEST(AsyncLogger, long_message) {
+    std::string result;
+    AsyncLogger logger;
+    logger.setHandler(BaseLogger::LvlMsg, [&](const BaseLogger &, const BaseLogger::LogMsg & logMsg) {
+        result.assign(logMsg.mMsg.data(), logMsg.mMsg.size());
+    });
+    //---------------
+    const std::string text(4096, 'x');
+    LMessage(logger) << text;
+    logger.flush();
+    EXPECT_EQ(text, result);
+}
+
+TEST(AsyncLogger, logging_from_handler) {
+    std::vector<std::string> messages;
+    AsyncLogger logger;
+    logger.setHandler(BaseLogger::LvlMsg, [&](const BaseLogger & l, const BaseLogger::LogMsg & logMsg) {
+        messages.emplace_back(logMsg.mMsg.data(), logMsg.mMsg.size());
+        LInfo(l) << "from handler";
+        static_cast<const AsyncLogger &>(l).flush();
+    });
+    logger.setHandler(BaseLogger::LvlInfo, [&](const BaseLogger &, const BaseLogger::LogMsg & logMsg) {
+        messages.emplace_back(logMsg.mMsg.data(), logMsg.mMsg.size());
+    });
+    //---------------
+    LMessage(logger) << "message";
+    logger.flush();
+    ASSERT_EQ(std::size_t(2), messages.size());
+    EXPECT_EQ("message", messages[0]);
+    EXPECT_EQ("from handler", messages[1]);
+}
+
+/**************************************************************************************************/
+////////////////////////////////////////////////////////////////////////////////////////////////////
+/**************************************************************************************************/
+
+TEST(AsyncLogger, queue_size_and_drain_on_destruction) {
+    std::mutex mutex;
+    std::condition_variable condition;
+    bool blocked = true;
+    std::size_t handled = 0;
+    {
+        AsyncLogger logger("", 16);
+        EXPECT_EQ(std::size_t(16), logger.queueCapacity());
+        logger.setHandler(BaseLogger::LvlMsg, [&](const BaseLogger &, const BaseLogger::LogMsg &) {
+            std::unique_lock<std::mutex> lock(mutex);
+            condition.wait(lock, [&]() { return !blocked; });
+            ++handled;
+        });
+        for (std::size_t i = 0; i < 10; ++i) {
+            LMessage(logger) << i;
+        }
+        // the worker is blocked with the first or the second message.
+        EXPECT_LE(std::size_t(8), logger.queueSize());
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            blocked = false;
+        }
+        condition.notify_all();
+    }
+    EXPECT_EQ(std::size_t(10), handled);
+}
+
+TEST(AsyncLogger, threads) {
+    const std::size_t threadsNum = 4;
+    const std::size_t messagesNum = 10000;
+    std::vector<std::size_t> next(threadsNum, 0);
+    std::size_t outOfOrder = 0;
+    AsyncLogger logger("", 64);
+    logger.setHandler(BaseLogger::LvlMsg, [&](const BaseLogger &, const BaseLogger::LogMsg & logMsg) {
+        // "thread message"
+        const std::string text(logMsg.mMsg.data(), logMsg.mMsg.size());
+        const auto space = text.find(' ');
+        const auto thread = std::stoul(text.substr(0, space));
+        const auto message = std::stoul(text.substr(space + 1));
+        if (next[thread] != message) {
+            ++outOfOrder;
+        }
+        next[thread] = message + 1;
+    });
+    //---------------
+    std::vector<std::thread> threads;
+    for (std::size_t t = 0; t < threadsNum; ++t) {
+        threads.emplace_back([&logger, t, messagesNum]() {
+            for (std::size_t i = 0; i < messagesNum; ++i) {
+                LMessage(logger) << t << ' ' << i;
+            }
+        });
+    }
+    for (auto & thread : threads) {
+        thread.join();
+    }
+    logger.flush();
+    for (std::size_t t = 0; t < threadsNum; ++t) {
+        EXPECT_EQ(messagesNum, next[t]);
+    }
+    EXPECT_EQ(std::size_t(0), outOfOrder);
+}
+
+/**************************************************************************************************/
+////////////////////////////////////////////////////////////////////////////////////////////////////
+/**************************************************************************************************/
+
+namespace {
+
+    /*!
+     * \details Blocks the handlers until it is opened.
+     */
+    class Gate {
+    public:
+
+        void wait() {
+            std::unique_lock<std::mutex> lock(mMutex);
+            mCondition.wait(lock, [&]() { return mOpened; });
+        }
+
+        void open() {
+            {
+                std::lock_guard<std::mutex> lock(mMutex);
+                mOpened = true;
+            }
+            mCondition.notify_all();
+        }
+
+    private:
+
+        std::mutex mMutex;
+        std::condition_variable mCondition;
+        bool mOpened = false;
+
+    };
+
+}
+
+TEST(AsyncLogger, overflow_drop_newest) {
+    Gate gate;
+    std::vector<std::size_t> handled;
+    std::vector<std::string> reports;
+    {
+        AsyncLogger logger("", 16);
+        logger.setOverflowPolicy(AsyncLogger::OverflowDropNewest);
+        logger.setHandler(BaseLogger::LvlMsg, [&](const BaseLogger &, const BaseLogger::LogMsg & logMsg) {
+            gate.wait();
+            handled.push_back(std::stoul(std::string(logMsg.mMsg.data(), logMsg.mMsg.size())));
+        });
+        logger.setHandler(BaseLogger::LvlWarning, [&](const BaseLogger &, const BaseLogger::LogMsg & logMsg) {
+            reports.emplace_back(logMsg.mMsg.data(), logMsg.mMsg.size());
+        });
+        for (std::size_t i = 0; i < 40; ++i) {
+            LMessage(logger) << i;
+        }
+        gate.open();
+        logger.flush();
+        EXPECT_EQ(std::size_t(40), handled.size() + logger.dropped(AsyncLogger::OverflowDropNewest));
+        EXPECT_LE(std::size_t(40 - 17), logger.dropped(AsyncLogger::OverflowDropNewest));
+        EXPECT_EQ(std::size_t(0), logger.dropped(AsyncLogger::OverflowDropOldest));
+    }
+    // the first messages are kept
+    for (std::size_t i = 0; i < handled.size(); ++i) {
+        EXPECT_EQ(i, handled[i]);
+    }
+    // the report is forced when the logger is destroyed.
+    ASSERT_FALSE(reports.empty());
+    EXPECT_NE(std::string::npos, reports.back().find("dropped"));
+}
+
+TEST(AsyncLogger, overflow_drop_oldest) {
+    Gate gate;
+    std::atomic<bool> entered(false);
+    std::vector<std::size_t> handled;
+    AsyncLogger logger("", 16);
+    logger.setOverflowPolicy(AsyncLogger::OverflowDropOldest);
+    logger.setDropReportInterval(std::chrono::milliseconds(0));
+    logger.setHandler(BaseLogger::LvlMsg, [&](const BaseLogger &, const BaseLogger::LogMsg & logMsg) {
+        entered = true;
+        gate.wait();
+        handled.push_back(std::stoul(std::string(logMsg.mMsg.data(), logMsg.mMsg.size())));
+    });
+    // the worker is blocked in the handler, it doesn't keep the message's place in the queue.
+    LMessage(logger) << 0;
+    while (!entered) {
+        std::this_thread::yield();
+    }
+    for (std::size_t i = 1; i < 40; ++i) {
+        LMessage(logger) << i;
+    }
+    gate.open();
+    logger.flush();
+    EXPECT_EQ(std::size_t(40), handled.size() + logger.dropped(AsyncLogger::OverflowDropOldest) +
+                               logger.dropped(AsyncLogger::OverflowDropNewest));
+    EXPECT_EQ(std::size_t(0), logger.dropped(AsyncLogger::OverflowDropNewest));
+    // the last messages are kept
+    ASSERT_FALSE(handled.empty());
+    EXPECT_EQ(std::size_t(39), handled.back());
+    EXPECT_LE(std::size_t(16), handled.size());
+}
+
+TEST(AsyncLogger, overflow_drop_below_level) {
+    Gate gate;
+    std::size_t handledDebug = 0;
+    std::size_t handledErrors = 0;
+    AsyncLogger logger("", 16);
+    logger.setOverflowPolicy(AsyncLogger::OverflowDropBelowLevel, BaseLogger::LvlError);
+    logger.setDropReportInterval(std::chrono::milliseconds(0));
+    logger.setHandler(BaseLogger::LvlDebug, [&](const BaseLogger &, const BaseLogger::LogMsg &) {
+        gate.wait();
+        ++handledDebug;
+    });
+    logger.setHandler(BaseLogger::LvlError, [&](const BaseLogger &, const BaseLogger::LogMsg &) {
+        ++handledErrors;
+    });
+    for (std::size_t i = 0; i < 40; ++i) {
+        LDebug(logger) << i;
+    }
+    EXPECT_LE(std::size_t(40 - 17), logger.dropped(AsyncLogger::OverflowDropBelowLevel));
+    // the queue is still full, the error waits for the place.
+    std::thread opener([&gate]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        gate.open();
+    });
+    LError(logger) << "error";
+    opener.join();
+    logger.flush();
+    EXPECT_EQ(std::size_t(1), handledErrors);
+    EXPECT_EQ(std::size_t(40), handledDebug + logger.dropped(AsyncLogger::OverflowDropBelowLevel));
+}
+
+/**************************************************************************************************/
+////////////////////////////////////////////////////////////////////////////////////////////////////
+/**************************************************************************************************/
+
+TEST(AsyncLogger, per_thread_formatting) {
+    std::stringstream stream;
+    AsyncLogger logger("log-category", AsyncLogger::QueuePerThread, 4096);
+    EXPECT_EQ(AsyncLogger::QueuePerThread, logger.queueType());
+    EXPECT_EQ(std::size_t(4096), logger.queueCapacity());
+    logger.setHandler(BaseLogger::LvlMsg, [&](const BaseLogger & l, const BaseLogger::LogMsg & logMsg) {
+        BaseLogger::defaultHandler(l, logMsg, stream, "%LN,%MC,%MS,%FN,%FI,%LI", nullptr);
+    });
+    //---------------
+    LogMessage(logger, CodeLocation("function", "file", 5)).setCategory("msg-cat").message() << "message " << 42;
+    logger.flush();
+    EXPECT_STREQ("log-category,msg-cat,message 42,function,file,5\n", stream.str().c_str());
+    EXPECT_EQ(std::size_t(0), logger.queueSize());
+    //---------------
+    const std::string longText(8192, 'x');
+    std::string result;
+    logger.setHandler(BaseLogger::LvlInfo, [&](const BaseLogger &, const BaseLogger::LogMsg & logMsg) {
+        result.assign(logMsg.mMsg.data(), logMsg.mMsg.size());
+    });
+    LInfo(logger) << longText;
+    logger.flush();
+    // the message is cut to fit the thread's buffer.
+    EXPECT_FALSE(result.empty());
+    EXPECT_GT(std::size_t(2048), result.size());
+}
+
+TEST(AsyncLogger, per_thread_merges_by_time) {
+    Gate gate;
+    std::atomic<bool> entered(false);
+    std::vector<std::int64_t> times;
+    AsyncLogger logger("", AsyncLogger::QueuePerThread, 4096);
+    logger.setHandler(BaseLogger::LvlMsg, [&](const BaseLogger &, const BaseLogger::LogMsg & logMsg) {
+        entered = true;
+        gate.wait();
+        times.push_back(logMsg.mTime);
+    });
+    auto logAt = [&logger](const std::int64_t time) {
+        BaseLogger::LogMsg logMsg(BaseLogger::LvlMsg, "", "message", CodeLocation());
+        logMsg.mTime = time;
+        logger.log(logMsg);
+    };
+    //---------------
+    // the worker is blocked with the first message while the threads are logging.
+    logAt(1);
+    while (!entered) {
+        std::this_thread::yield();
+    }
+    std::thread first([&]() {
+        for (std::int64_t time : {2, 4, 6, 8}) {
+            logAt(time);
+        }
+    });
+    std::thread second([&]() {
+        for (std::int64_t time : {3, 5, 7, 9}) {
+            logAt(time);
+        }
+    });
+    first.join();
+    second.join();
+    gate.open();
+    logger.flush();
+    const std::vector<std::int64_t> expected{1, 2, 3, 4, 5, 6, 7, 8, 9};
+    EXPECT_EQ(expected, times);
+}
+
+TEST(AsyncLogger, per_thread_threads) {
+    const std::size_t threadsNum = 4;
+    const std::size_t messagesNum = 10000;
+    std::vector<std::size_t> next(threadsNum, 0);
+    std::size_t outOfOrder = 0;
+    AsyncLogger logger("", AsyncLogger::QueuePerThread, 1024);
+    logger.setHandler(BaseLogger::LvlMsg, [&](const BaseLogger &, const BaseLogger::LogMsg & logMsg) {
+        // "thread message"
+        const std::string text(logMsg.mMsg.data(), logMsg.mMsg.size());
+        const auto space = text.find(' ');
+        const auto thread = std::stoul(text.substr(0, space));
+        const auto message = std::stoul(text.substr(space + 1));
+        if (next[thread] != message) {
+            ++outOfOrder;
+        }
+        next[thread] = message + 1;
+    });
+    //---------------
+    std::vector<std::thread> threads;
+    for (std::size_t t = 0; t < threadsNum; ++t) {
+        threads.emplace_back([&logger, t, messagesNum]() {
+            for (std::size_t i = 0; i < messagesNum; ++i) {
+                LMessage(logger) << t << ' ' << i;
+            }
+        });
+    }
+    for (auto & thread : threads) {
+        thread.join();
+    }
+    logger.flush();
+    for (std::size_t t = 0; t < threadsNum; ++t) {
+        EXPECT_EQ(messagesNum, next[t]);
+    }
+    EXPECT_EQ(std::size_t(0), outOfOrder);
+    EXPECT_EQ(std::size_t(0), logger.queueSize());
+}
+
+TEST(AsyncLogger, per_thread_overflow) {
+    Gate gate;
+    std::size_t handled = 0;
+    AsyncLogger logger("", AsyncLogger::QueuePerThread, 1024);
+    logger.setOverflowPolicy(AsyncLogger::OverflowDropNewest);
+    logger.setDropReportInterval(std::chrono::milliseconds(0));
+    logger.setHandler(BaseLogger::LvlMsg, [&](const BaseLogger &, const BaseLogger::LogMsg &) {
+        gate.wait();
+        ++handled;
+    });
+    for (std::size_t i = 0; i < 100; ++i) {
+        LMessage(logger) << i;
+    }
+    gate.open();
+    logger.flush();
+    EXPECT_NE(std::size_t(0), logger.dropped(AsyncLogger::OverflowDropNewest));
+    EXPECT_EQ(std::size_t(100), handled + logger.dropped(AsyncLogger::OverflowDropNewest));
+}
+
+/**************************************************************************************************/
+////////////////////////////////////////////////////////////////////////////////////////////////////
+/**************************************************************************************************/
@@ -34,7 +34,12 @@
 #   define STSFF_LOGGER_USE_FULL_SOURCES_PATH
 #endif
 
+#include <chrono>
+#include <ctime>
+#include <atomic>
 #include <sstream>
+#include <thread>
+#include <vector>
 #include <stsff/logging/BaseLogger.h>
 #include <stsff/logging/utils/Colorize.h>
 
@@ -101,6 +106,157 @@ TEST(BaseLogger, formatting_custom_level) {
     //---------------
 }
 
+namespace {
+
+    std::vector<std::size_t> gHandledLevels;
+
+    void rawHandler(const BaseLogger &, const BaseLogger::LogMsg & logMsg) {
+        gHandledLevels.push_back(logMsg.mLevel);
+    }
+
+}
+
+TEST(BaseLogger, handlers_dispatch) {
+    gHandledLevels.clear();
+    std::vector<std::size_t> levels;
+    BaseLogger logger;
+    logger.setLevel(10000);
+    logger.setHandler(BaseLogger::LvlInfo, rawHandler);
+    logger.setHandler(250, rawHandler);
+    logger.setHandler(5000, [&](const BaseLogger &, const BaseLogger::LogMsg & logMsg) {
+        levels.push_back(logMsg.mLevel);
+    });
+    logger.setHandler(BaseLogger::LvlMsg, [&](const BaseLogger &, const BaseLogger::LogMsg & logMsg) {
+        levels.push_back(logMsg.mLevel);
+    });
+    //---------------
+    LogMessage(logger).info() << "message" << LPush;
+    LogMessage(logger).level(250) << "message" << LPush;
+    LogMessage(logger).level(5000) << "message" << LPush;
+    LMessage(logger) << "message";
+    EXPECT_EQ(std::vector<std::size_t>({BaseLogger::LvlInfo, 250}), gHandledLevels);
+    EXPECT_EQ(std::vector<std::size_t>({5000, BaseLogger::LvlMsg}), levels);
+    //---------------
+    // the changes through the map are used by the next messages.
+    logger.handlers().erase(250);
+    logger.handlers()[BaseLogger::LvlInfo] = [&](const BaseLogger &, const BaseLogger::LogMsg & logMsg) {
+        levels.push_back(logMsg.mLevel + 1);
+    };
+    const std::stringstream stream;
+    auto * coutBuff = std::cout.rdbuf();
+    std::cout.rdbuf(stream.rdbuf());
+    LogMessage(logger).level(250) << "message" << LPush;
+    std::cout.rdbuf(coutBuff);
+    LogMessage(logger).info() << "message" << LPush;
+    EXPECT_EQ(std::vector<std::size_t>({BaseLogger::LvlInfo, 250}), gHandledLevels);
+    EXPECT_EQ(std::vector<std::size_t>({5000, BaseLogger::LvlMsg, BaseLogger::LvlInfo + 1}), levels);
+    EXPECT_STREQ("LVL(250):   message \n\t[ -> (0)]\n", stream.str().c_str());
+}
+
+TEST(BaseLogger, handlers_map_reference) {
+    std::vector<std::string> handled;
+    BaseLogger logger;
+    logger.setLevel(10000);
+    BaseLogger::LevelHandlers & handlers = logger.handlers();
+    handlers[BaseLogger::LvlInfo] = [&](const BaseLogger &, const BaseLogger::LogMsg & logMsg) {
+        handled.emplace_back("A " + std::string(logMsg.mMsg.data(), logMsg.mMsg.size()));
+    };
+    LInfo(logger) << "one";
+    //---------------
+    // the changes made through the same reference after the logging are used too.
+    handlers[BaseLogger::LvlInfo] = [&](const BaseLogger &, const BaseLogger::LogMsg & logMsg) {
+        handled.emplace_back("B " + std::string(logMsg.mMsg.data(), logMsg.mMsg.size()));
+    };
+    handlers[650] = [&](const BaseLogger &, const BaseLogger::LogMsg & logMsg) {
+        handled.emplace_back("C " + std::string(logMsg.mMsg.data(), logMsg.mMsg.size()));
+    };
+    LInfo(logger) << "two";
+    LLevel(logger, std::size_t(650)) << "three";
+    //---------------
+    logger.setHandler(BaseLogger::LvlInfo, rawHandler);
+    gHandledLevels.clear();
+    LInfo(logger) << "four";
+    LLevel(logger, std::size_t(650)) << "five";
+    EXPECT_EQ(std::vector<std::string>({"A one", "B two", "C three", "C five"}), handled);
+    EXPECT_EQ(std::vector<std::size_t>({BaseLogger::LvlInfo}), gHandledLevels);
+}
+
+TEST(BaseLogger, handlers_copy) {
+    std::vector<std::string> handled;
+    BaseLogger logger;
+    logger.setHandler(BaseLogger::LvlMsg, [&](const BaseLogger &, const BaseLogger::LogMsg &) {
+        handled.emplace_back("original");
+    });
+    LMessage(logger) << "message";
+    //---------------
+    BaseLogger copy(logger);
+    copy.setHandler(BaseLogger::LvlMsg, [&](const BaseLogger &, const BaseLogger::LogMsg &) {
+        handled.emplace_back("copy");
+    });
+    LMessage(copy) << "message";
+    LMessage(logger) << "message";
+    logger = copy;
+    LMessage(logger) << "message";
+    EXPECT_EQ(std::vector<std::string>({"original", "copy", "original", "copy"}), handled);
+}
+
+TEST(BaseLogger, shared_default_handlers) {
+    const BaseLogger first("name");
+    {
+        const BaseLogger logger("name");
+        const BaseLogger copy(logger);
+        EXPECT_EQ(first.handlers().size(), copy.handlers().size());
+    }
+    //---------------
+    std::size_t handled = 0;
+    BaseLogger changed(first);
+    changed.setHandler(BaseLogger::LvlMsg, [&](const BaseLogger &, const BaseLogger::LogMsg &) {
+        ++handled;
+    });
+    BaseLogger changedCopy(changed);
+    changedCopy.handlers().erase(BaseLogger::LvlMsg);
+    LMessage(changed) << "message";
+    EXPECT_EQ(std::size_t(1), handled);
+    EXPECT_EQ(std::size_t(0), changedCopy.handlers().count(BaseLogger::LvlMsg));
+    EXPECT_EQ(std::size_t(1), changed.handlers().count(BaseLogger::LvlMsg));
+    EXPECT_EQ(std::size_t(8), first.handlers().size());
+    EXPECT_EQ(std::size_t(8), BaseLogger().handlers().size());
+}
+
+TEST(BaseLogger, runtime_reconfiguration) {
+    const std::size_t threadsNum = 4;
+    std::atomic<bool> stop(false);
+    std::atomic<std::size_t> first(0);
+    std::atomic<std::size_t> second(0);
+    BaseLogger logger("", {});
+    logger.setHandler(BaseLogger::LvlMsg, [&](const BaseLogger &, const BaseLogger::LogMsg &) { ++first; });
+    //---------------
+    std::vector<std::thread> threads;
+    for (std::size_t t = 0; t < threadsNum; ++t) {
+        threads.emplace_back([&]() {
+            while (!stop) {
+                LMessage(logger) << "message";
+            }
+        });
+    }
+    for (std::size_t i = 0; i < 200; ++i) {
+        if (i % 2 == 0) {
+            logger.setHandler(BaseLogger::LvlMsg, [&](const BaseLogger &, const BaseLogger::LogMsg &) { ++second; });
+        }
+        else {
+            logger.setHandler(BaseLogger::LvlMsg, [&](const BaseLogger &, const BaseLogger::LogMsg &) { ++first; });
+        }
+        logger.setLevel(i % 3 == 0 ? BaseLogger::LvlInfo : BaseLogger::LvlDebug);
+        std::this_thread::yield();
+    }
+    stop = true;
+    for (auto & thread : threads) {
+        thread.join();
+    }
+    //---------------
+    EXPECT_NE(std::size_t(0), first + second);
+}
+
 TEST(BaseLogger, formatting_unknown_level) {
     const std::stringstream stream;
     const BaseLogger logger;
@@ -139,6 +295,75 @@ TEST(BaseLogger, formatting_level) {
     ASSERT_STREQ("WRN:   message\n", result.c_str());
 }
 
+TEST(BaseLogger, formatting_level_macros) {
+    std::stringstream stream;
+    BaseLogger logger;
+    logger.setHandler(BaseLogger::LvlDebug, [&](const BaseLogger & l, const BaseLogger::LogMsg & logMsg) {
+        BaseLogger::defaultHandler(l, logMsg, stream, "DBG: %MC %MS", nullptr);
+    });
+    logger.setHandler(BaseLogger::LvlWarning, [&](const BaseLogger & l, const BaseLogger::LogMsg & logMsg) {
+        BaseLogger::defaultHandler(l, logMsg, stream, "WRN: %MC %MS", nullptr);
+    });
+    logger.setLevel(BaseLogger::LvlWarning);
+    int evaluated = 0;
+    auto argument = [&]() {
+        ++evaluated;
+        return "message";
+    };
+    //---------------
+    LDebug(logger) << argument() << LPush;
+    LcDebug(logger, "cat") << argument();
+    LLevel(&logger, std::size_t(BaseLogger::LvlDebug)) << argument();
+    LVarLvl(debugVar, logger, BaseLogger::LvlDebug) << argument();
+    debugVar.push();
+    EXPECT_EQ(1, evaluated); // only the variable evaluates its arguments
+    ASSERT_STREQ("", stream.str().c_str());
+    //---------------
+    LWarning(logger) << argument();
+    LcWarning(logger, "cat") << argument();
+    LcVarLvl(warningVar, logger, "var", BaseLogger::LvlWarning) << argument();
+    warningVar.push();
+    EXPECT_EQ(4, evaluated);
+    ASSERT_STREQ("WRN:  message\nWRN: cat message\nWRN: var message\n", stream.str().c_str());
+}
+
+TEST(BaseLogger, formatting_level_macros_null_logger) {
+    const BaseLogger * logger = nullptr;
+    LDebug(logger) << "message";
+    LcError(logger, "cat") << "message";
+}
+
+TEST(BaseLogger, formatting_level_after_writing) {
+    std::stringstream stream;
+    BaseLogger logger;
+    logger.setHandler(BaseLogger::LvlError, [&](const BaseLogger & l, const BaseLogger::LogMsg & logMsg) {
+        BaseLogger::defaultHandler(l, logMsg, stream, "ERR: %MC %MS", nullptr);
+    });
+    logger.setLevel(BaseLogger::LvlInfo);
+    //---------------
+    {
+        LVar(var, logger) << "var";
+        var.error();
+    }
+    {
+        LcVar(var, logger, "cat") << "var";
+        var.error();
+    }
+    {
+        LogMessage msg(logger);
+        msg << "message " << 1;
+        msg.error();
+    }
+    ASSERT_STREQ("ERR:  var\nERR: cat var\nERR:  message 1\n", stream.str().c_str());
+    //---------------
+    stream.str("");
+    {
+        LVar(var, logger) << "debug";
+        var.debug();
+    }
+    ASSERT_STREQ("", stream.str().c_str());
+}
+
 #ifdef NDEBUG // 'Only file name' is enabled in release mode
 TEST(BaseLogger, formatting_sources_only_filename_case1) {
     std::stringstream stream;
@@ -181,6 +406,171 @@ TEST(BaseLogger, colorize) {
     LCritical(logger) << "critical message" << LPush;
 }
 
+TEST(BaseLogger, colorize_forced) {
+    std::stringstream stream;
+    stream << colorize::colorized;
+    BaseLogger logger;
+    logger.setHandler(BaseLogger::LvlMsg, [&](const BaseLogger & l, const BaseLogger::LogMsg & logMsg) {
+        BaseLogger::defaultHandler(l, logMsg, stream, "%MS", colorize::green);
+    });
+    LMessage(logger) << "text" << LPush;
+    ASSERT_EQ("\033[32mtext\033[00m\n", stream.str());
+    //---------------
+    stream.str("");
+    stream << colorize::nocolorized;
+    LMessage(logger) << "text" << LPush;
+    ASSERT_EQ("text\n", stream.str());
+}
+
+TEST(BaseLogger, whole_line_writes) {
+    // The stream isn't thread-safe itself, all the writes are done under the handler's lock.
+    std::stringstream stream;
+    stream << colorize::colorized;
+    BaseLogger logger("stress");
+    logger.setHandler(BaseLogger::LvlMsg, [&](const BaseLogger & l, const BaseLogger::LogMsg & logMsg) {
+        BaseLogger::defaultHandler(l, logMsg, stream, "%LN %MS", colorize::green);
+    });
+    //---------------
+    const std::size_t threadCount = 32;
+    const std::size_t messageCount = 500;
+    const std::string payload(300, '.');
+    std::vector<std::thread> threads;
+    for (std::size_t t = 0; t < threadCount; ++t) {
+        threads.emplace_back([&, t]() {
+            for (std::size_t i = 0; i < messageCount; ++i) {
+                LMessage(logger) << t << ":" << i << payload << LPush;
+            }
+        });
+    }
+    for (auto & thread : threads) {
+        thread.join();
+    }
+    //---------------
+    std::vector<std::size_t> next(threadCount, 0);
+    std::size_t lines = 0;
+    std::string line;
+    while (std::getline(stream, line)) {
+        const std::string prefix = "\033[32mstress ";
+        const std::string suffix = payload + "\033[00m";
+        ASSERT_EQ(0, line.compare(0, prefix.size(), prefix)) << line;
+        ASSERT_GT(line.size(), prefix.size() + suffix.size()) << line;
+        ASSERT_EQ(0, line.compare(line.size() - suffix.size(), suffix.size(), suffix)) << line;
+        const std::string id = line.substr(prefix.size(), line.size() - prefix.size() - suffix.size());
+        const std::size_t colon = id.find(':');
+        ASSERT_NE(std::string::npos, colon) << line;
+        const std::size_t thread = std::stoul(id.substr(0, colon));
+        ASSERT_LT(thread, threadCount) << line;
+        ASSERT_EQ(next[thread], std::stoul(id.substr(colon + 1))) << line;
+        ++next[thread];
+        ++lines;
+    }
+    ASSERT_EQ(threadCount * messageCount, lines);
+}
+
+namespace {
+
+    /*!
+     * \details Counts the flushes of the stream.
+     */
+    class SyncCounter : public std::stringbuf {
+    public:
+        std::size_t mSyncs = 0;
+    protected:
+        int sync() override {
+            ++mSyncs;
+            return std::stringbuf::sync();
+        }
+    };
+
+}
+
+TEST(BaseLogger, flush_policy) {
+    SyncCounter buffer;
+    std::ostream stream(&buffer);
+    BaseLogger logger;
+    for (auto level : {BaseLogger::LvlMsg, BaseLogger::LvlError, BaseLogger::LvlCritical}) {
+        logger.setHandler(level, [&](const BaseLogger & l, const BaseLogger::LogMsg & logMsg) {
+            BaseLogger::defaultHandler(l, logMsg, stream, "%MS", nullptr);
+        });
+    }
+    //---------------
+    LMessage(logger) << "always" << LPush;
+    ASSERT_EQ(std::size_t(1), buffer.mSyncs);
+    //---------------
+    buffer.mSyncs = 0;
+    logger.setFlushPolicy(BaseLogger::FlushPolicy::never());
+    for (int i = 0; i < 10; ++i) {
+        LMessage(logger) << "never" << LPush;
+    }
+    LError(logger) << "error" << LPush;
+    ASSERT_EQ(std::size_t(0), buffer.mSyncs);
+    LCritical(logger) << "critical" << LPush;
+    ASSERT_EQ(std::size_t(1), buffer.mSyncs);
+    //---------------
+    buffer.mSyncs = 0;
+    logger.setFlushPolicy(BaseLogger::FlushPolicy::everyMessages(4).withLevel(BaseLogger::LvlError));
+    for (int i = 0; i < 10; ++i) {
+        LMessage(logger) << "every 4" << LPush;
+    }
+    ASSERT_EQ(std::size_t(2), buffer.mSyncs);
+    LError(logger) << "error" << LPush;
+    ASSERT_EQ(std::size_t(3), buffer.mSyncs);
+    LMessage(logger) << "counter is reset" << LPush;
+    ASSERT_EQ(std::size_t(3), buffer.mSyncs);
+    //---------------
+    buffer.mSyncs = 0;
+    logger.setFlushPolicy(BaseLogger::FlushPolicy::everyMilliseconds(50));
+    ASSERT_EQ(std::int64_t(50), logger.flushPolicy().mIntervalMs);
+    LMessage(logger) << "interval" << LPush;
+    ASSERT_EQ(std::size_t(0), buffer.mSyncs);
+    std::this_thread::sleep_for(std::chrono::milliseconds(80));
+    LMessage(logger) << "interval" << LPush;
+    ASSERT_EQ(std::size_t(1), buffer.mSyncs);
+}
+
+TEST(BaseLogger, flush_policy_is_due) {
+    const std::int64_t now = TimeSource::now(TimeSource::ClockCoarse);
+    const auto never = BaseLogger::FlushPolicy::never();
+    ASSERT_FALSE(never.isDue(BaseLogger::LvlError, 1000, now));
+    ASSERT_TRUE(never.isDue(BaseLogger::LvlCritical, 1, now));
+    //---------------
+    const auto every = BaseLogger::FlushPolicy::everyMessages(4).withLevel(BaseLogger::LvlError);
+    ASSERT_FALSE(every.isDue(BaseLogger::LvlMsg, 3, now));
+    ASSERT_TRUE(every.isDue(BaseLogger::LvlMsg, 4, now));
+    ASSERT_TRUE(every.isDue(BaseLogger::LvlError, 1, now));
+    //---------------
+    const auto interval = BaseLogger::FlushPolicy::everyMilliseconds(50);
+    ASSERT_FALSE(interval.isDue(BaseLogger::LvlMsg, 1000, now));
+    ASSERT_TRUE(interval.isDue(BaseLogger::LvlMsg, 1, now - 80 * 1000000));
+}
+
+TEST(BaseLogger, flush_policy_on_destruction) {
+    SyncCounter buffer;
+    auto * clogBuff = std::clog.rdbuf(&buffer);
+    try {
+        {
+            BaseLogger logger;
+            logger.setFlushPolicy(BaseLogger::FlushPolicy::never());
+            logger.setHandler(BaseLogger::LvlMsg, [&](const BaseLogger & l, const BaseLogger::LogMsg & logMsg) {
+                BaseLogger::defaultHandler(l, logMsg, std::clog, "%MS", nullptr);
+            });
+            LMessage(logger) << "message" << LPush;
+            ASSERT_EQ(std::size_t(0), buffer.mSyncs);
+            //---------------
+            const BaseLogger copy(logger);
+            ASSERT_EQ(std::size_t(0), copy.flushPolicy().mEveryMessages);
+        }
+        // the copy has nothing to flush, the logger flushes once.
+        ASSERT_EQ(std::size_t(1), buffer.mSyncs);
+        std::clog.rdbuf(clogBuff);
+    }
+    catch (...) {
+        std::clog.rdbuf(clogBuff);
+        throw;
+    }
+    ASSERT_EQ("message\n", buffer.str());
+}
+
 TEST(BaseLogger, time_stamp) {
     std::stringstream stream;
     BaseLogger logger;
@@ -194,6 +584,51 @@ TEST(BaseLogger, time_stamp) {
     //---------------
 }
 
+TEST(BaseLogger, time_stamp_buffer) {
+    // 2019-03-04 and 2019-03-05, the formats are switched so the cache entries are reused and replaced.
+    const std::int64_t day = std::int64_t(24) * 60 * 60 * 1000000000;
+    const std::int64_t first = std::int64_t(1551700800) * 1000000000;
+    const std::int64_t second = first + day;
+    const char * formats[] = {"%Y-%m-%d", "%d", "%m", "%y", "%j", "%Y-%m-%d"};
+    char buffer[100];
+    for (const std::int64_t time : {first, first + 1, second, first}) {
+        for (const char * format : formats) {
+            const auto size = BaseLogger::timeStamp(buffer, sizeof buffer, format, time);
+            EXPECT_EQ(BaseLogger::timeStamp(format, time), std::string(buffer, size)) << format;
+        }
+    }
+    //---------------
+    EXPECT_EQ(std::size_t(0), BaseLogger::timeStamp(buffer, 4, "%Y-%m-%d", first));
+    EXPECT_EQ(std::size_t(0), BaseLogger::timeStamp(buffer, sizeof buffer, "", first));
+}
+
+TEST(BaseLogger, time_stamp_fractions) {
+    const std::int64_t time = std::int64_t(1551700800) * 1000000000 + 12345678;
+    char buffer[100];
+    const auto size = BaseLogger::timeStamp(buffer, sizeof buffer, "%S.%3N|%6N|%9N|%%3N", time);
+    EXPECT_EQ(BaseLogger::timeStamp("%S", time) + ".012|012345|012345678|%3N", std::string(buffer, size));
+    //---------------
+    EXPECT_EQ(BaseLogger::timeStamp("%S", time) + ".999", BaseLogger::timeStamp("%S.%3N", time + 987000000));
+    EXPECT_EQ(BaseLogger::timeStamp("%S", -1) + ".999999", BaseLogger::timeStamp("%S.%6N", -1));
+}
+
+TEST(BaseLogger, time_stamp_local_time) {
+    // the local time of the 15 minutes intervals is cached, so the times are compared with std::strftime.
+    char expected[100];
+    for (std::int64_t second = 1551700800 - 86400; second < 1551700800 + 86400; second += 619) {
+        const std::time_t t = std::time_t(second);
+        tm timeInfo = {};
+#ifdef _MSC_VER
+        localtime_s(&timeInfo, &t);
+#else
+        localtime_r(&t, &timeInfo);
+#endif
+        const auto size = std::strftime(expected, sizeof expected, "%Y-%m-%d %H:%M:%S %z %j %a", &timeInfo);
+        EXPECT_EQ(std::string(expected, size),
+                  BaseLogger::timeStamp("%Y-%m-%d %H:%M:%S %z %j %a", second * 1000000000));
+    }
+}
+
 /**************************************************************************************************/
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 /**************************************************************************************************/
@@ -317,6 +752,53 @@ TEST(BaseLogger, invalid_callback_data_time_command_case3) {
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 /**************************************************************************************************/
 
+TEST(LogMessage, long_message) {
+    std::stringstream stream;
+    BaseLogger logger;
+    logger.setHandler(BaseLogger::LvlMsg, [&](const BaseLogger & l, const BaseLogger::LogMsg & logMsg) {
+        BaseLogger::defaultHandler(l, logMsg, stream, "%MS", nullptr);
+    });
+    //---------------
+    const std::string text(1000, 'x');
+    LogMessage(logger).message() << text << 5 << text << LPush;
+    ASSERT_EQ(text + "5" + text + "\n", stream.str());
+}
+
+TEST(LogMessage, move) {
+    std::stringstream stream;
+    BaseLogger logger;
+    logger.setHandler(BaseLogger::LvlMsg, [&](const BaseLogger & l, const BaseLogger::LogMsg & logMsg) {
+        BaseLogger::defaultHandler(l, logMsg, stream, "%MS", nullptr);
+    });
+    //---------------
+    LogMessage msg1(logger);
+    msg1.message() << std::hex << 255 << " ";
+    LogMessage msg2(std::move(msg1));
+    msg2 << 255;
+    msg1.push();
+    ASSERT_STREQ("", stream.str().c_str());
+    msg2.push();
+    ASSERT_STREQ("ff ff\n", stream.str().c_str());
+}
+
+TEST(LogMessage, stream_state_is_not_shared) {
+    std::stringstream stream;
+    BaseLogger logger;
+    logger.setHandler(BaseLogger::LvlMsg, [&](const BaseLogger & l, const BaseLogger::LogMsg & logMsg) {
+        BaseLogger::defaultHandler(l, logMsg, stream, "%MS", nullptr);
+    });
+    //---------------
+    LogMessage(logger).message() << std::hex << 255 << LPush;
+    LogMessage(logger).message() << 255 << LPush;
+    {
+        LogMessage outer(logger);
+        outer << std::hex << 255 << " ";
+        LogMessage(logger).message() << 255 << LPush;
+        outer << 255;
+    }
+    ASSERT_STREQ("ff\n255\n255\nff ff\n", stream.str().c_str());
+}
+
 TEST(LogMessage, abort) {
     std::stringstream stream;
     BaseLogger logger;
@@ -30,6 +30,8 @@
 
 #include "ph/stdafx.h"
 
+#include <sstream>
+#include <string>
 #include <gtest/gtest.h>
 #include <stsff/logging/utils/Colorize.h>
 
@@ -113,3 +115,56 @@ TEST(Colorize, background_dark) {
 /**************************************************************************************************/
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 /**************************************************************************************************/
+
+TEST(Colorize, escape_sequence) {
+    const colorize::Manipulator manipulators[] = {
+        colorize::grey, colorize::red, colorize::darkGreen, colorize::onBlue,
+        colorize::onDarkWhite, colorize::cyan, colorize::reset,
+    };
+    for (auto manipulator : manipulators) {
+        std::stringstream stream;
+        stream << colorize::colorized << manipulator;
+        const auto sequence = colorize::escapeSequence(manipulator);
+        ASSERT_FALSE(sequence.empty());
+#if !defined(_WIN32) && !defined(_WIN64)
+        ASSERT_EQ(stream.str(), std::string(sequence.data(), sequence.size()));
+#endif
+    }
+    ASSERT_TRUE(colorize::escapeSequence(colorize::colorized).empty());
+}
+
+TEST(Colorize, append_color) {
+    std::string text;
+    colorize::appendColor(text, colorize::AnsiRed, true);
+    text.append("red");
+    colorize::appendColor(text, colorize::AnsiReset, true);
+    colorize::appendColor(text, colorize::AnsiGreen, false);
+    ASSERT_EQ("\033[31mred\033[00m", text);
+    //---------------
+    char buffer[32];
+    char * out = colorize::appendColor(buffer, colorize::AnsiOnBlue, true);
+    out = colorize::appendColor(out, colorize::AnsiReset, false);
+    ASSERT_EQ("\033[44m", std::string(buffer, out));
+}
+
+TEST(Colorize, strip_ansi) {
+    std::string text("\033[31mERR:\033[00m message \033[1;44mbold\033[0m\033c end");
+    colorize::stripAnsi(text);
+    ASSERT_EQ("ERR: message bold end", text);
+    //---------------
+    const std::string plain("no colors\n");
+    char buffer[32];
+    ASSERT_EQ(plain.size(), colorize::stripAnsi(plain.data(), plain.size(), buffer));
+    ASSERT_EQ(plain, std::string(buffer, plain.size()));
+    //---------------
+    std::string unfinished("text\033[3");
+    colorize::stripAnsi(unfinished);
+    ASSERT_EQ("text", unfinished);
+    std::string malformed("a\033[1\nb");
+    colorize::stripAnsi(malformed);
+    ASSERT_EQ("a\nb", malformed);
+}
+
+/**************************************************************************************************/
+////////////////////////////////////////////////////////////////////////////////////////////////////
+/**************************************************************************************************/
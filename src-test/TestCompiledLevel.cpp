@@ -0,0 +1,161 @@
+/*
+**  Copyright(C) 2019, StepToSky and FlightFactor
+**  All rights reserved
+**
+**  Redistribution and use in source and binary forms, with or without
+**  modification, are permitted provided that the following conditions are met:
+**
+**  1.Redistributions of source code must retain the above copyright notice, this
+**    list of conditions and the following disclaimer.
+**  2.Redistributions in binary form must reproduce the above copyright notice,
+**    this list of conditions and the following disclaimer in the documentation
+**    and / or other materials provided with the distribution.
+**  3.The name of StepToSky or the name of FlightFactor or the names of its
+**    contributors may NOT be used to endorse or promote products derived from
+**    this software without specific prior written permission.
+**
+**  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+**  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+**  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+**  DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+**  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+**  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+**  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+**  ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+**  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+**  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**
+**  Contacts: www.steptosky.com or www.flightfactor.aero
+*/
+
+#include "ph/stdafx.h"
+
+// This translation unit checks the compile time level,
+// so it overrides the value that might be specified for the whole project.
+#undef STSFF_LOGGER_COMPILED_LEVEL
+#define STSFF_LOGGER_COMPILED_LEVEL 600 // LvlInfo
+
+#include <sstream>
+#include <fstream>
+#include <iterator>
+#include <stsff/logging/BaseLogger.h>
+
+#include <gtest/gtest.h>
+
+using namespace stsff::logging;
+
+/**************************************************************************************************/
+////////////////////////////////////////////////////////////////////////////////////////////////////
+/**************************************************************************************************/
+
+namespace {
+
+    void setupHandlers(BaseLogger & logger, std::stringstream & stream) {
+        for (const std::size_t lvl : {
+                 std::size_t(BaseLogger::LvlDebug), std::size_t(BaseLogger::LvlMsg),
+                 std::size_t(BaseLogger::LvlInfo), std::size_t(BaseLogger::LvlWarning),
+                 std::size_t(650), std::size_t(550)
+             }) {
+            logger.setHandler(lvl, [&stream](const BaseLogger & l, const BaseLogger::LogMsg & logMsg) {
+                BaseLogger::defaultHandler(l, logMsg, stream, "%MC %MS", nullptr);
+            });
+        }
+    }
+
+}
+
+/**************************************************************************************************/
+////////////////////////////////////////////////////////////////////////////////////////////////////
+/**************************************************************************************************/
+
+TEST(CompiledLevel, arguments_are_not_evaluated) {
+    std::stringstream stream;
+    BaseLogger logger;
+    setupHandlers(logger, stream);
+    ASSERT_EQ(std::size_t(BaseLogger::LvlDebug), logger.level());
+    int evaluated = 0;
+    auto argument = [&]() {
+        ++evaluated;
+        return "message";
+    };
+    //---------------
+    LDebug(logger) << argument();
+    LMessage(logger) << argument() << LPush;
+    LcDebug(logger, "cat").write(argument(), argument());
+    LcMessage(&logger, "cat") << argument();
+    LLevel(logger, 700) << argument();
+    LLevel(logger, 650) << argument();
+    LcLevel(logger, "cat", 650) << argument();
+    EXPECT_EQ(0, evaluated);
+    ASSERT_STREQ("", stream.str().c_str());
+    //---------------
+    LInfo(logger) << argument();
+    LcWarning(logger, "cat") << argument();
+    LLevel(logger, 550) << argument();
+    EXPECT_EQ(3, evaluated);
+    ASSERT_STREQ(" message\ncat message\n message\n", stream.str().c_str());
+}
+
+TEST(CompiledLevel, runtime_level_still_works) {
+    std::stringstream stream;
+    BaseLogger logger;
+    setupHandlers(logger, stream);
+    logger.setLevel(BaseLogger::LvlWarning);
+    //---------------
+    LInfo(logger) << "message";
+    LWarning(logger) << "message";
+    ASSERT_STREQ(" message\n", stream.str().c_str());
+}
+
+#if defined(NDEBUG) && defined(STSFF_LOGGER_OS_LINUX)
+
+namespace {
+
+    // The function must not leave anything in the binary except its own code.
+    void strippedOnlyCalls(const BaseLogger & logger) {
+        LDebug(logger) << "stsff-stripped-" "debug-marker";
+        LcMessage(logger, "stsff-stripped-" "category-marker") << "message";
+        LLevel(logger, 700) << "stsff-stripped-" "level-marker";
+    }
+
+    // The function is the control of the test, its strings must be presented in the binary.
+    void compiledCalls(const BaseLogger & logger) {
+        LInfo(logger) << "stsff-compiled-" "info-marker";
+    }
+
+    std::size_t countInBinary(const std::string & needle) {
+        std::ifstream file("/proc/self/exe", std::ios::binary);
+        const std::string binary((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+        std::size_t count = 0;
+        for (auto pos = binary.find(needle); pos != std::string::npos; pos = binary.find(needle, pos + 1)) {
+            ++count;
+        }
+        return count;
+    }
+
+}
+
+// The strings of the removed messages may be left in not optimized binaries for the custom levels.
+TEST(CompiledLevel, strings_are_removed_from_binary) {
+    std::stringstream stream;
+    BaseLogger logger;
+    setupHandlers(logger, stream);
+    strippedOnlyCalls(logger);
+    compiledCalls(logger);
+    ASSERT_STREQ(" stsff-compiled-info-marker\n", stream.str().c_str());
+    //---------------
+    // the needles are made at runtime, so they are not in the binary themselves.
+    const std::string prefix = "stsff-";
+    EXPECT_NE(std::size_t(0), countInBinary(prefix + "compiled-info-marker"));
+    EXPECT_EQ(std::size_t(0), countInBinary(prefix + "stripped-debug-marker"));
+    EXPECT_EQ(std::size_t(0), countInBinary(prefix + "stripped-category-marker"));
+    EXPECT_EQ(std::size_t(0), countInBinary(prefix + "stripped-level-marker"));
+    // __STS_FUNC_NAME__ of the functions
+    EXPECT_NE(std::size_t(0), countInBinary(std::string("compiledCalls") + "(const"));
+    EXPECT_EQ(std::size_t(0), countInBinary(std::string("strippedOnlyCalls") + "(const"));
+}
+#endif
+
+/**************************************************************************************************/
+////////////////////////////////////////////////////////////////////////////////////////////////////
+/**************************************************************************************************/
@@ -0,0 +1,175 @@
+/*
+**  Copyright(C) 2019, StepToSky and FlightFactor
+**  All rights reserved
+**
+**  Redistribution and use in source and binary forms, with or without
+**  modification, are permitted provided that the following conditions are met:
+**
+**  1.Redistributions of source code must retain the above copyright notice, this
+**    list of conditions and the following disclaimer.
+**  2.Redistributions in binary form must reproduce the above copyright notice,
+**    this list of conditions and the following disclaimer in the documentation
+**    and / or other materials provided with the distribution.
+**  3.The name of StepToSky or the name of FlightFactor or the names of its
+**    contributors may NOT be used to endorse or promote products derived from
+**    this software without specific prior written permission.
+**
+**  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+**  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+**  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+**  DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+**  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+**  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+**  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+**  ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+**  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+**  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**
+**  Contacts: www.steptosky.com or www.flightfactor.aero
+*/
+
+#include "ph/stdafx.h"
+
+#if !defined(_WIN32) && !defined(_WIN64)
+
+#include <cstdio>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+#include <stsff/logging/BaseLogger.h>
+#include <stsff/logging/ConsoleSink.h>
+#include <gtest/gtest.h>
+
+using namespace stsff::logging;
+
+/**************************************************************************************************/
+////////////////////////////////////////////////////////////////////////////////////////////////////
+/**************************************************************************************************/
+
+namespace {
+
+    /*!
+     * \details Pipe whose output is read by a thread until the write end is closed.
+     */
+    class PipeReader {
+    public:
+
+        PipeReader() {
+            if (::pipe(mFds) != 0) {
+                throw std::runtime_error("can't create pipe");
+            }
+            mThread = std::thread([this]() {
+                char buffer[4096];
+                ssize_t size;
+                while ((size = ::read(mFds[0], buffer, sizeof buffer)) > 0) {
+                    mText.append(buffer, std::size_t(size));
+                }
+            });
+        }
+
+        ~PipeReader() {
+            finish();
+        }
+
+        int writeEnd() const { return mFds[1]; }
+
+        const std::string & finish() {
+            if (mThread.joinable()) {
+                ::close(mFds[1]);
+                mThread.join();
+                ::close(mFds[0]);
+            }
+            return mText;
+        }
+
+    private:
+
+        int mFds[2];
+        std::thread mThread;
+        std::string mText;
+
+    };
+
+}
+
+/**************************************************************************************************/
+////////////////////////////////////////////////////////////////////////////////////////////////////
+/**************************************************************************************************/
+
+TEST(ConsoleSink, same_as_default_handler) {
+    const FormatPattern pattern("ERR(%LV): %LN %MC %MS %TG [%TM(%Y-%m-%d %T)] [%FN -> %FI(%LI)]", FormatPattern::ErrorsInline);
+    BaseLogger::LogMsg logMsg(BaseLogger::LvlError, "category", "message", CodeLocation("function", "file", 42));
+    logMsg.mTime = std::int64_t(1551700800) * 1000000000;
+    const BaseLogger logger("sink");
+    //---------------
+    std::stringstream stream;
+    stream << colorize::colorized;
+    BaseLogger::defaultHandler(logger, logMsg, stream, pattern, colorize::red);
+    //---------------
+    PipeReader pipe;
+    const ConsoleSink sink(pipe.writeEnd(), pattern, colorize::red, ConsoleSink::ColorsAlways);
+    ASSERT_TRUE(sink.isColorized());
+    sink(logger, logMsg);
+    ASSERT_EQ(stream.str(), pipe.finish());
+}
+
+TEST(ConsoleSink, colors) {
+    PipeReader pipe;
+    BaseLogger logger("sink");
+    const ConsoleSink autoSink(pipe.writeEnd(), "%MS", colorize::green);
+    ASSERT_FALSE(autoSink.isColorized());
+    const ConsoleSink neverSink(pipe.writeEnd(), "%MS", colorize::green, ConsoleSink::ColorsNever);
+    ASSERT_FALSE(neverSink.isColorized());
+    const ConsoleSink alwaysSink(pipe.writeEnd(), "%MS", colorize::green, ConsoleSink::ColorsAlways);
+    ASSERT_TRUE(alwaysSink.isColorized());
+    //---------------
+    logger.setHandler(BaseLogger::LvlMsg, autoSink);
+    LMessage(logger) << "auto" << LPush;
+    logger.setHandler(BaseLogger::LvlMsg, alwaysSink);
+    LMessage(logger) << "always" << LPush;
+    ASSERT_EQ("auto\n\033[32malways\033[00m\n", pipe.finish());
+}
+
+TEST(ConsoleSink, whole_line_writes) {
+    PipeReader pipe;
+    BaseLogger logger("stress");
+    logger.setHandler(BaseLogger::LvlMsg, ConsoleSink(pipe.writeEnd(), "%LN %MS", nullptr));
+    //---------------
+    const std::size_t threadCount = 8;
+    const std::size_t messageCount = 1000;
+    std::vector<std::thread> threads;
+    for (std::size_t t = 0; t < threadCount; ++t) {
+        threads.emplace_back([&, t]() {
+            for (std::size_t i = 0; i < messageCount; ++i) {
+                LMessage(logger) << t << ":" << i << " " << std::string(100, char('a' + t)) << LPush;
+            }
+        });
+    }
+    for (auto & thread : threads) {
+        thread.join();
+    }
+    //---------------
+    std::istringstream text(pipe.finish());
+    std::vector<std::size_t> next(threadCount, 0);
+    std::string line;
+    std::size_t lines = 0;
+    while (std::getline(text, line)) {
+        std::size_t thread = 0;
+        std::size_t index = 0;
+        ASSERT_EQ(2, std::sscanf(line.c_str(), "stress %zu:%zu", &thread, &index)) << line;
+        ASSERT_LT(thread, threadCount) << line;
+        ASSERT_EQ(next[thread]++, index) << line;
+        ASSERT_EQ(std::string(100, char('a' + thread)), line.substr(line.size() - 100)) << line;
+        ++lines;
+    }
+    ASSERT_EQ(threadCount * messageCount, lines);
+}
+
+/**************************************************************************************************/
+////////////////////////////////////////////////////////////////////////////////////////////////////
+/**************************************************************************************************/
+
+#endif
@@ -0,0 +1,275 @@
+/*
+**  Copyright(C) 2019, StepToSky and FlightFactor
+**  All rights reserved
+**
+**  Redistribution and use in source and binary forms, with or without
+**  modification, are permitted provided that the following conditions are met:
+**
+**  1.Redistributions of source code must retain the above copyright notice, this
+**    list of conditions and the following disclaimer.
+**  2.Redistributions in binary form must reproduce the above copyright notice,
+**    this list of conditions and the following disclaimer in the documentation
+**    and / or other materials provided with the distribution.
+**  3.The name of StepToSky or the name of FlightFactor or the names of its
+**    contributors may NOT be used to endorse or promote products derived from
+**    this software without specific prior written permission.
+**
+**  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+**  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+**  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+**  DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+**  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+**  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+**  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+**  ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+**  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+**  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**
+**  Contacts: www.steptosky.com or www.flightfactor.aero
+*/
+
+#include "ph/stdafx.h"
+
+#include <ctime>
+#include <sstream>
+#include <thread>
+#include <vector>
+#include <stsff/logging/DeferredLogger.h>
+#include <gtest/gtest.h>
+
+using namespace stsff::logging;
+
+/**************************************************************************************************/
+////////////////////////////////////////////////////////////////////////////////////////////////////
+/**************************************************************************************************/
+
+TEST(DeferredLogger, formatting) {
+    std::stringstream stream;
+    BaseLogger logger("log-category");
+    logger.setHandler(BaseLogger::LvlInfo, [&](const BaseLogger & l, const BaseLogger::LogMsg & logMsg) {
+        BaseLogger::defaultHandler(l, logMsg, stream, "%LN,%MC,%MS,%FN,%FI,%LI", nullptr);
+    });
+    //---------------
+    const std::string str("string");
+    char cStr[] = "c-string";
+    char * mutableStr = cStr;
+    const int * pointer = reinterpret_cast<const int *>(0xABC);
+    {
+        DeferredLogger deferred(logger);
+        const DeferredSite site(BaseLogger::LvlInfo, "msg-cat", CodeLocation("function", "file", 5));
+        deferred.log(site, "value: ", 42, ' ', -7LL, ' ', 0.5, ' ', 0.25f, ' ', true, ' ',
+                     str, ' ', mutableStr, ' ', pointer, ' ', static_cast<const char *>(nullptr), 'x');
+    }
+    EXPECT_STREQ("log-category,msg-cat,value: 42 -7 0.5 0.25 1 string c-string 0xabc x,function,file,5\n",
+                 stream.str().c_str());
+}
+
+TEST(DeferredLogger, same_text_as_log_message) {
+    std::vector<std::string> messages;
+    BaseLogger logger;
+    logger.setHandler(BaseLogger::LvlMsg, [&](const BaseLogger &, const BaseLogger::LogMsg & logMsg) {
+        messages.emplace_back(logMsg.mMsg.data(), logMsg.mMsg.size());
+    });
+    //---------------
+    const unsigned short us = 65535;
+    const double d = 0.1 + 0.2;
+    const char array[] = "array";
+    {
+        DeferredLogger deferred(logger);
+        LDeferred(deferred, BaseLogger::LvlMsg, us, ' ', d, ' ', array, ' ', 1e21, ' ', std::size_t(0));
+    }
+    LMessage(logger) << us << ' ' << d << ' ' << array << ' ' << 1e21 << ' ' << std::size_t(0);
+    ASSERT_EQ(std::size_t(2), messages.size());
+    EXPECT_EQ(messages[1], messages[0]);
+}
+
+TEST(DeferredLogger, call_site_and_time) {
+    BaseLogger::LogMsg received(0, "", "", CodeLocation());
+    std::string category;
+    BaseLogger logger;
+    logger.setHandler(BaseLogger::LvlWarning, [&](const BaseLogger &, const BaseLogger::LogMsg & logMsg) {
+        received = logMsg;
+        category.assign(logMsg.mCategory.data(), logMsg.mCategory.size());
+    });
+    //---------------
+    const auto before = std::time(nullptr);
+    {
+        DeferredLogger deferred(logger);
+        LcDeferred(deferred, "category", BaseLogger::LvlWarning, "message");
+        deferred.flush();
+    }
+    const auto after = std::time(nullptr);
+    EXPECT_EQ(std::size_t(BaseLogger::LvlWarning), received.mLevel);
+    EXPECT_EQ("category", category);
+    EXPECT_NE(0, received.mCodeLocation.mLine);
+    EXPECT_LE(std::int64_t(before), received.mTime / 1000000000);
+    EXPECT_GE(std::int64_t(after), received.mTime / 1000000000);
+}
+
+TEST(DeferredLogger, level) {
+    std::size_t printed = 0;
+    BaseLogger logger;
+    logger.setLevel(BaseLogger::LvlInfo);
+    logger.setHandler(BaseLogger::LvlDebug, [&](const BaseLogger &, const BaseLogger::LogMsg &) {
+        ++printed;
+    });
+    std::size_t evaluated = 0;
+    auto argument = [&]() {
+        return ++evaluated;
+    };
+    //---------------
+    {
+        DeferredLogger deferred(logger);
+        LDeferred(deferred, BaseLogger::LvlDebug, "value: ", argument());
+    }
+    EXPECT_EQ(std::size_t(0), evaluated);
+    EXPECT_EQ(std::size_t(0), printed);
+}
+
+TEST(DeferredLogger, long_strings_are_cut) {
+    std::string result;
+    BaseLogger logger;
+    logger.setHandler(BaseLogger::LvlMsg, [&](const BaseLogger &, const BaseLogger::LogMsg & logMsg) {
+        result.assign(logMsg.mMsg.data(), logMsg.mMsg.size());
+    });
+    //---------------
+    const std::string longText(4096, 'x');
+    {
+        DeferredLogger deferred(logger, 1024);
+        LDeferred(deferred, BaseLogger::LvlMsg, 123, longText, 456);
+    }
+    ASSERT_FALSE(result.empty());
+    EXPECT_GT(std::size_t(512), result.size());
+    EXPECT_EQ("123xxx", result.substr(0, 6));
+}
+
+/**************************************************************************************************/
+////////////////////////////////////////////////////////////////////////////////////////////////////
+/**************************************************************************************************/
+
+TEST(DeferredLogger, handler_logs_when_buffer_is_full) {
+    std::size_t handled = 0;
+    BaseLogger logger;
+    DeferredLogger * deferredPtr = nullptr;
+    logger.setHandler(BaseLogger::LvlMsg, [&](const BaseLogger &, const BaseLogger::LogMsg &) {
+        // the background thread can't wait for itself to free its buffer.
+        for (std::size_t i = 0; i < 100; ++i) {
+            LDeferred(*deferredPtr, BaseLogger::LvlInfo, "from handler ", i);
+        }
+    });
+    logger.setHandler(BaseLogger::LvlInfo, [&](const BaseLogger &, const BaseLogger::LogMsg &) {
+        ++handled;
+    });
+    //---------------
+    {
+        DeferredLogger deferred(logger, 1024);
+        deferredPtr = &deferred;
+        LDeferred(deferred, BaseLogger::LvlMsg, "message");
+        deferred.flush();
+        deferred.flush();
+        EXPECT_NE(std::size_t(0), deferred.dropped());
+        EXPECT_EQ(std::size_t(100), handled + deferred.dropped());
+    }
+}
+
+TEST(DeferredLogger, threads) {
+    const std::size_t threadsNum = 4;
+    const std::size_t messagesNum = 20000;
+    std::vector<std::size_t> next(threadsNum, 0);
+    std::size_t outOfOrder = 0;
+    BaseLogger logger;
+    logger.setHandler(BaseLogger::LvlMsg, [&](const BaseLogger &, const BaseLogger::LogMsg & logMsg) {
+        // "thread message"
+        const std::string text(logMsg.mMsg.data(), logMsg.mMsg.size());
+        const auto space = text.find(' ');
+        const auto thread = std::stoul(text.substr(0, space));
+        const auto message = std::stoul(text.substr(space + 1));
+        if (next[thread] != message) {
+            ++outOfOrder;
+        }
+        next[thread] = message + 1;
+    });
+    //---------------
+    {
+        // the small buffer makes the threads wait for the background one.
+        DeferredLogger deferred(logger, 4096);
+        std::vector<std::thread> threads;
+        for (std::size_t t = 0; t < threadsNum; ++t) {
+            threads.emplace_back([&deferred, t, messagesNum]() {
+                for (std::size_t i = 0; i < messagesNum; ++i) {
+                    LDeferred(deferred, BaseLogger::LvlMsg, t, ' ', i);
+                }
+            });
+        }
+        for (auto & thread : threads) {
+            thread.join();
+        }
+        deferred.flush();
+        for (std::size_t t = 0; t < threadsNum; ++t) {
+            EXPECT_EQ(messagesNum, next[t]);
+        }
+    }
+    EXPECT_EQ(std::size_t(0), outOfOrder);
+}
+
+/**************************************************************************************************/
+////////////////////////////////////////////////////////////////////////////////////////////////////
+/**************************************************************************************************/
+
+TEST(ThreadRings, wrap_around) {
+    internal::SpscRing ring(256);
+    std::size_t written = 0;
+    std::size_t read = 0;
+    for (std::size_t i = 0; i < 1000; ++i) {
+        const std::size_t size = 1 + (i * 7) % 60;
+        while (char * out = ring.tryReserve(size)) {
+            std::memset(out, int(written % 256), size);
+            ring.commit();
+            ++written;
+            break;
+        }
+        std::size_t recordSize = 0;
+        if (i % 3 != 0) {
+            if (const char * record = ring.front(recordSize)) {
+                EXPECT_EQ(char(read % 256), record[0]);
+                EXPECT_EQ(char(read % 256), record[recordSize - 1]);
+                ring.pop();
+                ++read;
+            }
+        }
+    }
+    std::size_t recordSize = 0;
+    while (const char * record = ring.front(recordSize)) {
+        EXPECT_EQ(char(read % 256), record[0]);
+        ring.pop();
+        ++read;
+    }
+    EXPECT_EQ(written, read);
+    EXPECT_TRUE(ring.empty());
+}
+
+TEST(ThreadRings, thread_exit) {
+    internal::ThreadRings rings(1024);
+    std::thread([&rings]() {
+        internal::SpscRing & ring = rings.local();
+        ring.tryReserve(8);
+        ring.commit();
+    }).join();
+    EXPECT_EQ(std::size_t(1), rings.size());
+    // not drained yet
+    EXPECT_EQ(std::size_t(0), rings.collect());
+
+    std::vector<internal::ThreadRings::RingPtr> snapshot;
+    std::uint64_t version = 0;
+    rings.snapshot(snapshot, version);
+    ASSERT_EQ(std::size_t(1), snapshot.size());
+    std::size_t size = 0;
+    ASSERT_NE(nullptr, snapshot[0]->front(size));
+    snapshot[0]->pop();
+    EXPECT_EQ(std::size_t(1), rings.collect());
+    EXPECT_EQ(std::size_t(0), rings.size());
+}
+
+/**************************************************************************************************/
+////////////////////////////////////////////////////////////////////////////////////////////////////
+/**************************************************************************************************/
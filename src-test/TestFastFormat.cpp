@@ -0,0 +1,222 @@
+/*
+**  Copyright(C) 2019, StepToSky and FlightFactor
+**  All rights reserved
+**
+**  Redistribution and use in source and binary forms, with or without
+**  modification, are permitted provided that the following conditions are met:
+**
+**  1.Redistributions of source code must retain the above copyright notice, this
+**    list of conditions and the following disclaimer.
+**  2.Redistributions in binary form must reproduce the above copyright notice,
+**    this list of conditions and the following disclaimer in the documentation
+**    and / or other materials provided with the distribution.
+**  3.The name of StepToSky or the name of FlightFactor or the names of its
+**    contributors may NOT be used to endorse or promote products derived from
+**    this software without specific prior written permission.
+**
+**  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+**  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+**  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+**  DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+**  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+**  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+**  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+**  ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+**  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+**  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**
+**  Contacts: www.steptosky.com or www.flightfactor.aero
+*/
+
+#include "ph/stdafx.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <iomanip>
+#include <limits>
+#include <random>
+#include <stsff/logging/BaseLogger.h>
+#include <stsff/logging/internal/FastFormat.h>
+#include <gtest/gtest.h>
+
+using namespace stsff::logging;
+using internal::FastFormat;
+
+/**************************************************************************************************/
+////////////////////////////////////////////////////////////////////////////////////////////////////
+/**************************************************************************************************/
+
+namespace {
+
+    std::string formatSigned(const std::int64_t value) {
+        char buff[FastFormat::MaxSignedChars];
+        return std::string(buff, FastFormat::formatSigned(buff, value));
+    }
+
+    std::string formatUnsigned(const std::uint64_t value) {
+        char buff[FastFormat::MaxUnsignedChars];
+        return std::string(buff, FastFormat::formatUnsigned(buff, value));
+    }
+
+    std::string formatDouble(const double value) {
+        char buff[FastFormat::MaxFloatChars];
+        return std::string(buff, FastFormat::formatDouble(buff, value));
+    }
+
+    std::string formatFloat(const float value) {
+        char buff[FastFormat::MaxFloatChars];
+        return std::string(buff, FastFormat::formatFloat(buff, value));
+    }
+
+    std::string message(const std::function<void(LogMessage &)> & fn) {
+        std::string result;
+        BaseLogger logger;
+        logger.setHandler(BaseLogger::LvlMsg, [&](const BaseLogger &, const BaseLogger::LogMsg & logMsg) {
+            result.assign(logMsg.mMsg.data(), logMsg.mMsg.size());
+        });
+        LogMessage msg(logger);
+        fn(msg);
+        msg.push();
+        return result;
+    }
+
+}
+
+/**************************************************************************************************/
+////////////////////////////////////////////////////////////////////////////////////////////////////
+/**************************************************************************************************/
+
+TEST(FastFormat, integers) {
+    EXPECT_EQ("0", formatUnsigned(0));
+    EXPECT_EQ("0", formatSigned(0));
+    EXPECT_EQ("-1", formatSigned(-1));
+    EXPECT_EQ("18446744073709551615", formatUnsigned(std::numeric_limits<std::uint64_t>::max()));
+    EXPECT_EQ("9223372036854775807", formatSigned(std::numeric_limits<std::int64_t>::max()));
+    EXPECT_EQ("-9223372036854775808", formatSigned(std::numeric_limits<std::int64_t>::min()));
+    std::uint64_t pow10 = 1;
+    for (int i = 0; i < 19; ++i, pow10 *= 10) {
+        EXPECT_EQ(std::to_string(pow10), formatUnsigned(pow10));
+        EXPECT_EQ(std::to_string(pow10 - 1), formatUnsigned(pow10 - 1));
+        EXPECT_EQ(std::to_string(pow10 + 1), formatUnsigned(pow10 + 1));
+        EXPECT_EQ(std::to_string(-std::int64_t(pow10)), formatSigned(-std::int64_t(pow10)));
+    }
+}
+
+TEST(FastFormat, double_notation) {
+    EXPECT_EQ("0", formatDouble(0.0));
+    EXPECT_EQ("-0", formatDouble(-0.0));
+    EXPECT_EQ("1", formatDouble(1.0));
+    EXPECT_EQ("-2.5", formatDouble(-2.5));
+    EXPECT_EQ("0.1", formatDouble(0.1));
+    EXPECT_EQ("0.3", formatDouble(0.3));
+    EXPECT_EQ("0.30000000000000004", formatDouble(0.1 + 0.2));
+    EXPECT_EQ("3.14159265358979", formatDouble(3.14159265358979));
+    EXPECT_EQ("100", formatDouble(100.0));
+    EXPECT_EQ("123456789", formatDouble(123456789.0));
+    EXPECT_EQ("1e+21", formatDouble(1e21));
+    EXPECT_EQ("1.5e-07", formatDouble(1.5e-7));
+    EXPECT_EQ("0.001", formatDouble(0.001));
+    EXPECT_EQ("1e-05", formatDouble(1e-5));
+    EXPECT_EQ("1.7976931348623157e+308", formatDouble(std::numeric_limits<double>::max()));
+    EXPECT_EQ("5e-324", formatDouble(std::numeric_limits<double>::denorm_min()));
+    EXPECT_EQ("nan", formatDouble(std::numeric_limits<double>::quiet_NaN()));
+    EXPECT_EQ("inf", formatDouble(std::numeric_limits<double>::infinity()));
+    EXPECT_EQ("-inf", formatDouble(-std::numeric_limits<double>::infinity()));
+}
+
+TEST(FastFormat, float_notation) {
+    EXPECT_EQ("0.1", formatFloat(0.1f));
+    EXPECT_EQ("3.4028235e+38", formatFloat(std::numeric_limits<float>::max()));
+    EXPECT_EQ("1e-45", formatFloat(std::numeric_limits<float>::denorm_min()));
+    EXPECT_EQ("16777216", formatFloat(16777216.0f));
+}
+
+TEST(FastFormat, double_round_trip) {
+    std::mt19937_64 random(42);
+    for (int i = 0; i < 100000; ++i) {
+        double value = 0;
+        const auto bits = random();
+        std::memcpy(&value, &bits, sizeof(value));
+        if (value != value || value == std::numeric_limits<double>::infinity() ||
+            value == -std::numeric_limits<double>::infinity()) {
+            continue;
+        }
+        const auto str = formatDouble(value);
+        ASSERT_EQ(value, std::strtod(str.c_str(), nullptr)) << str;
+        ASSERT_GE(std::size_t(24), str.size()) << str;
+    }
+}
+
+TEST(FastFormat, float_round_trip) {
+    std::mt19937 random(42);
+    for (int i = 0; i < 100000; ++i) {
+        float value = 0;
+        const auto bits = std::uint32_t(random());
+        std::memcpy(&value, &bits, sizeof(value));
+        if (value != value || value == std::numeric_limits<float>::infinity() ||
+            value == -std::numeric_limits<float>::infinity()) {
+            continue;
+        }
+        const auto str = formatFloat(value);
+        ASSERT_EQ(value, std::strtof(str.c_str(), nullptr)) << str;
+    }
+}
+
+TEST(FastFormat, pointer) {
+    char buff[FastFormat::MaxPointerChars];
+    EXPECT_EQ("0x0", std::string(buff, FastFormat::formatPointer(buff, nullptr)));
+    EXPECT_EQ("0xabc", std::string(buff, FastFormat::formatPointer(buff, reinterpret_cast<const void *>(0xABC))));
+}
+
+/**************************************************************************************************/
+////////////////////////////////////////////////////////////////////////////////////////////////////
+/**************************************************************************************************/
+
+TEST(FastFormat, log_message_types) {
+    const std::string str = "str";
+    const char * cStr = "c-str";
+    char array[] = "array";
+    const short s = -5;
+    const unsigned long long ull = 7;
+    EXPECT_EQ("a,b,1,0,-5,7,0.25,0.5,str,c-str,array", message([&](LogMessage & m) {
+        m << 'a' << "," << static_cast<unsigned char>('b') << "," << true << "," << false << ","
+                << s << "," << ull << "," << 0.25f << "," << 0.5 << ","
+                << str << "," << cStr << "," << array;
+    }));
+    EXPECT_EQ("0xabc", message([&](LogMessage & m) {
+        m << reinterpret_cast<const int *>(0xABC);
+    }));
+    enum eEnum { EnumValue = 3 };
+    EXPECT_EQ("3", message([&](LogMessage & m) {
+        m << EnumValue;
+    }));
+}
+
+TEST(FastFormat, log_message_manipulators) {
+    EXPECT_EQ("ff 255", message([&](LogMessage & m) {
+        m << std::hex << 255 << std::dec << " " << 255;
+    }));
+    EXPECT_EQ("true 1.50", message([&](LogMessage & m) {
+        m << std::boolalpha << true << " " << std::fixed << std::setprecision(2) << 1.5;
+    }));
+}
+
+TEST(FastFormat, log_message_text_manipulators) {
+    EXPECT_EQ("    ab5", message([&](LogMessage & m) {
+        m << std::setw(6) << "ab" << 5;
+    }));
+    EXPECT_EQ("xy***|", message([&](LogMessage & m) {
+        m << std::setfill('*') << std::left << std::setw(5) << std::string("xy") << '|';
+    }));
+    EXPECT_EQ("--c:view", message([&](LogMessage & m) {
+        m << std::setfill('-') << std::setw(3) << 'c' << ":" << BaseLogger::StringView("view");
+    }));
+    EXPECT_EQ("[  view]", message([&](LogMessage & m) {
+        m << "[" << std::setw(6) << BaseLogger::StringView("view") << "]";
+    }));
+}
+
+/**************************************************************************************************/
+////////////////////////////////////////////////////////////////////////////////////////////////////
+/**************************************************************************************************/
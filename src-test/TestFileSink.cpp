@@ -0,0 +1,184 @@
+/*
+**  Copyright(C) 2019, StepToSky and FlightFactor
+**  All rights reserved
+**
+**  Redistribution and use in source and binary forms, with or without
+**  modification, are permitted provided that the following conditions are met:
+**
+**  1.Redistributions of source code must retain the above copyright notice, this
+**    list of conditions and the following disclaimer.
+**  2.Redistributions in binary form must reproduce the above copyright notice,
+**    this list of conditions and the following disclaimer in the documentation
+**    and / or other materials provided with the distribution.
+**  3.The name of StepToSky or the name of FlightFactor or the names of its
+**    contributors may NOT be used to endorse or promote products derived from
+**    this software without specific prior written permission.
+**
+**  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+**  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+**  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+**  DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+**  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+**  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+**  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+**  ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+**  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+**  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**
+**  Contacts: www.steptosky.com or www.flightfactor.aero
+*/
+
+#include "ph/stdafx.h"
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <stsff/logging/BaseLogger.h>
+#include <stsff/logging/FileSink.h>
+#include <gtest/gtest.h>
+
+using namespace stsff::logging;
+
+/**************************************************************************************************/
+////////////////////////////////////////////////////////////////////////////////////////////////////
+/**************************************************************************************************/
+
+namespace {
+
+    std::string readFile(const std::string & fileName) {
+        std::ifstream file(fileName, std::ios::binary);
+        std::stringstream text;
+        text << file.rdbuf();
+        return text.str();
+    }
+
+}
+
+/**************************************************************************************************/
+////////////////////////////////////////////////////////////////////////////////////////////////////
+/**************************************************************************************************/
+
+TEST(FileSink, buffering) {
+    const std::string fileName("test-file-sink-buffering.log");
+    std::remove(fileName.c_str());
+    {
+        const FileSink sink(fileName, "%LN %MS", 64);
+        ASSERT_TRUE(sink.isOpen());
+        BaseLogger logger("log");
+        logger.setHandler(BaseLogger::LvlMsg, sink);
+        //---------------
+        LMessage(logger) << "first" << LPush;
+        LMessage(logger) << "second" << LPush;
+        ASSERT_EQ(std::uint64_t(0), sink.written());
+        ASSERT_EQ("", readFile(fileName));
+        //---------------
+        // the next line doesn't fit the buffer, so the buffered ones are written.
+        LMessage(logger) << std::string(50, 'x') << LPush;
+        ASSERT_EQ("log first\nlog second\n", readFile(fileName));
+        //---------------
+        // a line that is longer than the buffer is written directly.
+        LMessage(logger) << std::string(100, 'y') << LPush;
+        ASSERT_EQ("log first\nlog second\nlog " + std::string(50, 'x') + "\nlog " + std::string(100, 'y') + "\n",
+                  readFile(fileName));
+        //---------------
+        LMessage(logger) << "last" << LPush;
+        sink.flush();
+        ASSERT_EQ(readFile(fileName).size(), sink.written());
+        LMessage(logger) << "written by destructor" << LPush;
+    }
+    const std::string text = readFile(fileName);
+    ASSERT_EQ("last\nlog written by destructor\n", text.substr(text.size() - 31));
+    std::remove(fileName.c_str());
+}
+
+TEST(FileSink, policy_and_sync_level) {
+    const std::string fileName("test-file-sink-policy.log");
+    std::remove(fileName.c_str());
+    FileSink sink(fileName, "%MS");
+    BaseLogger logger;
+    for (auto level : {BaseLogger::LvlMsg, BaseLogger::LvlError, BaseLogger::LvlCritical}) {
+        logger.setHandler(level, sink);
+    }
+    //---------------
+    LMessage(logger) << "message" << LPush;
+    ASSERT_EQ("", readFile(fileName));
+    LCritical(logger) << "critical" << LPush;
+    ASSERT_EQ("message\ncritical\n", readFile(fileName));
+    //---------------
+    LError(logger) << "error" << LPush;
+    ASSERT_EQ("message\ncritical\n", readFile(fileName));
+    sink.setSyncLevel(BaseLogger::LvlError);
+    LError(logger) << "synced" << LPush;
+    ASSERT_EQ("message\ncritical\nerror\nsynced\n", readFile(fileName));
+    //---------------
+    sink.setFlushPolicy(FileSink::FlushPolicy::everyMessages(2));
+    LMessage(logger) << "1" << LPush;
+    ASSERT_EQ("message\ncritical\nerror\nsynced\n", readFile(fileName));
+    LMessage(logger) << "2" << LPush;
+    ASSERT_EQ("message\ncritical\nerror\nsynced\n1\n2\n", readFile(fileName));
+    std::remove(fileName.c_str());
+}
+
+TEST(FileSink, concurrent_writes) {
+    const std::string fileName("test-file-sink-concurrent.log");
+    std::remove(fileName.c_str());
+    const std::size_t threadCount = 8;
+    const std::size_t messageCount = 2000;
+    {
+        BaseLogger logger("log");
+        logger.setHandler(BaseLogger::LvlMsg, FileSink(fileName, "%LN %MS", 4096));
+        std::vector<std::thread> threads;
+        for (std::size_t t = 0; t < threadCount; ++t) {
+            threads.emplace_back([&, t]() {
+                for (std::size_t i = 0; i < messageCount; ++i) {
+                    LMessage(logger) << t << " " << i << " " << std::string(i % 50, 'z') << LPush;
+                }
+            });
+        }
+        for (auto & thread : threads) {
+            thread.join();
+        }
+    }
+    //---------------
+    std::istringstream text(readFile(fileName));
+    std::vector<std::size_t> next(threadCount, 0);
+    std::string line;
+    std::size_t lines = 0;
+    while (std::getline(text, line)) {
+        std::istringstream fields(line);
+        std::string name;
+        std::size_t thread = 0;
+        std::size_t index = 0;
+        std::string tail;
+        fields >> name >> thread >> index;
+        std::getline(fields, tail);
+        ASSERT_EQ("log", name) << line;
+        ASSERT_LT(thread, threadCount) << line;
+        ASSERT_EQ(next[thread]++, index) << line;
+        ASSERT_EQ(" " + std::string(index % 50, 'z'), tail) << line;
+        ++lines;
+    }
+    ASSERT_EQ(threadCount * messageCount, lines);
+    std::remove(fileName.c_str());
+}
+
+TEST(FileSink, invalid_file) {
+    std::stringstream errors;
+    auto * cerrBuff = std::cerr.rdbuf(errors.rdbuf());
+    const FileSink sink("not-existing-directory/file.log", "%MS");
+    std::cerr.rdbuf(cerrBuff);
+    ASSERT_FALSE(sink.isOpen());
+    ASSERT_NE(std::string::npos, errors.str().find("can't open the log file"));
+    //---------------
+    BaseLogger logger;
+    logger.setHandler(BaseLogger::LvlMsg, sink);
+    LMessage(logger) << "dropped" << LPush;
+    ASSERT_EQ(std::uint64_t(0), sink.written());
+}
+
+/**************************************************************************************************/
+////////////////////////////////////////////////////////////////////////////////////////////////////
+/**************************************************************************************************/
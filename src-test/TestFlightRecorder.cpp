@@ -0,0 +1,216 @@
+/*
+**  Copyright(C) 2019, StepToSky and FlightFactor
+**  All rights reserved
+**
+**  Redistribution and use in source and binary forms, with or without
+**  modification, are permitted provided that the following conditions are met:
+**
+**  1.Redistributions of source code must retain the above copyright notice, this
+**    list of conditions and the following disclaimer.
+**  2.Redistributions in binary form must reproduce the above copyright notice,
+**    this list of conditions and the following disclaimer in the documentation
+**    and / or other materials provided with the distribution.
+**  3.The name of StepToSky or the name of FlightFactor or the names of its
+**    contributors may NOT be used to endorse or promote products derived from
+**    this software without specific prior written permission.
+**
+**  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+**  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+**  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+**  DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+**  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+**  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+**  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+**  ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+**  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+**  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**
+**  Contacts: www.steptosky.com or www.flightfactor.aero
+*/
+
+#include "ph/stdafx.h"
+
+#include <cstdio>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <stsff/logging/FlightRecorder.h>
+#include <gtest/gtest.h>
+
+using namespace stsff::logging;
+
+/**************************************************************************************************/
+////////////////////////////////////////////////////////////////////////////////////////////////////
+/**************************************************************************************************/
+
+namespace {
+
+    /*!
+     * \details Logger at the info level that collects "level:message" of the handled messages.
+     */
+    struct RecordedLogger {
+        explicit RecordedLogger(std::shared_ptr<FlightRecorder> recorder) {
+            logger.setLevel(BaseLogger::LvlInfo);
+            for (const std::size_t level : {BaseLogger::LvlError, BaseLogger::LvlInfo, BaseLogger::LvlDebug}) {
+                logger.setHandler(level, [this](const BaseLogger &, const BaseLogger::LogMsg & logMsg) {
+                    handled.emplace_back(std::to_string(logMsg.mLevel) + ":" + std::string(logMsg.mMsg.data(), logMsg.mMsg.size()));
+                    times.emplace_back(logMsg.mTime);
+                });
+            }
+            logger.setFlightRecorder(std::move(recorder), BaseLogger::LvlDebug, BaseLogger::LvlError);
+        }
+
+        void log(const std::size_t level, const std::string & msg, const std::int64_t time = 0) const {
+            BaseLogger::LogMsg logMsg(level, "category", msg, CodeLocation("function", "file", 7));
+            logMsg.mTime = time;
+            logger.log(logMsg);
+        }
+
+        BaseLogger logger;
+        std::vector<std::string> handled;
+        std::vector<std::int64_t> times;
+    };
+
+}
+
+/**************************************************************************************************/
+////////////////////////////////////////////////////////////////////////////////////////////////////
+/**************************************************************************************************/
+
+TEST(FlightRecorder, dump_on_trigger) {
+    auto recorder = std::make_shared<FlightRecorder>(4096, 2);
+    RecordedLogger rec(recorder);
+    EXPECT_TRUE(rec.logger.isEnabled(BaseLogger::LvlDebug));
+    //---------------
+    rec.log(BaseLogger::LvlDebug, "d1");
+    rec.log(BaseLogger::LvlInfo, "i1");
+    rec.log(BaseLogger::LvlDebug, "d2");
+    EXPECT_EQ(std::vector<std::string>({"600:i1"}), rec.handled);
+    EXPECT_EQ(std::size_t(2), recorder->records());
+    //---------------
+    rec.log(BaseLogger::LvlError, "e1");
+    EXPECT_EQ(std::vector<std::string>({"600:i1", "800:d1", "800:d2", "200:e1"}), rec.handled);
+    EXPECT_EQ(std::size_t(0), recorder->records());
+    //---------------
+    rec.log(BaseLogger::LvlError, "e2");
+    EXPECT_EQ(std::vector<std::string>({"600:i1", "800:d1", "800:d2", "200:e1", "200:e2"}), rec.handled);
+}
+
+TEST(FlightRecorder, original_time) {
+    auto recorder = std::make_shared<FlightRecorder>();
+    RecordedLogger rec(recorder);
+    const std::int64_t before = TimeSource::now();
+    rec.log(BaseLogger::LvlDebug, "now");
+    const std::int64_t after = TimeSource::now();
+    rec.log(BaseLogger::LvlDebug, "given", 1000);
+    rec.log(BaseLogger::LvlError, "error", 5000);
+    //---------------
+    ASSERT_EQ(std::size_t(3), rec.times.size());
+    EXPECT_LE(before, rec.times[0]);
+    EXPECT_GE(after, rec.times[0]);
+    EXPECT_EQ(1000, rec.times[1]);
+    EXPECT_EQ(5000, rec.times[2]);
+}
+
+TEST(FlightRecorder, message_fields) {
+    auto recorder = std::make_shared<FlightRecorder>();
+    std::string result;
+    BaseLogger logger("log-category");
+    logger.setLevel(BaseLogger::LvlInfo);
+    logger.setFlightRecorder(recorder);
+    logger.setHandler(BaseLogger::LvlDebug, [&](const BaseLogger & l, const BaseLogger::LogMsg & logMsg) {
+        std::stringstream stream;
+        BaseLogger::defaultHandler(l, logMsg, stream, "%LN,%MC,%MS,%FN,%FI,%LI", nullptr);
+        result = stream.str();
+    });
+    //---------------
+    const std::string function("function");
+    LogMessage(logger, CodeLocation(function, "file", 5)).setCategory("msg-cat").debug() << "message " << 42;
+    EXPECT_TRUE(result.empty());
+    EXPECT_EQ(std::size_t(1), logger.dumpFlightRecorder());
+    EXPECT_STREQ("log-category,msg-cat,message 42,function,file,5\n", result.c_str());
+}
+
+TEST(FlightRecorder, overwrites_oldest) {
+    auto recorder = std::make_shared<FlightRecorder>(std::size_t(FlightRecorder::MinRingSize), 1);
+    RecordedLogger rec(recorder);
+    const std::size_t count = 1000;
+    for (std::size_t i = 0; i < count; ++i) {
+        rec.log(BaseLogger::LvlDebug, std::to_string(i));
+    }
+    EXPECT_NE(std::uint64_t(0), recorder->overwritten());
+    EXPECT_EQ(count, recorder->records() + recorder->overwritten());
+    rec.log(BaseLogger::LvlError, "error");
+    //---------------
+    ASSERT_LT(std::size_t(2), rec.handled.size());
+    const std::size_t first = count + 1 - rec.handled.size();
+    for (std::size_t i = 0; i + 1 < rec.handled.size(); ++i) {
+        EXPECT_EQ("800:" + std::to_string(first + i), rec.handled[i]);
+    }
+    EXPECT_EQ("200:error", rec.handled.back());
+}
+
+TEST(FlightRecorder, long_message) {
+    auto recorder = std::make_shared<FlightRecorder>(std::size_t(FlightRecorder::MinRingSize), 1);
+    RecordedLogger rec(recorder);
+    const std::string text(10000, 'x');
+    rec.log(BaseLogger::LvlDebug, text);
+    rec.log(BaseLogger::LvlDebug, "short");
+    rec.log(BaseLogger::LvlError, "error");
+    //---------------
+    ASSERT_EQ(std::size_t(3), rec.handled.size());
+    EXPECT_LT(rec.handled[0].size(), std::size_t(FlightRecorder::MinRingSize / 4));
+    EXPECT_EQ(0u, text.compare(0, rec.handled[0].size() - 4, rec.handled[0], 4, std::string::npos));
+    EXPECT_EQ("800:short", rec.handled[1]);
+}
+
+TEST(FlightRecorder, detach) {
+    auto recorder = std::make_shared<FlightRecorder>();
+    RecordedLogger rec(recorder);
+    rec.log(BaseLogger::LvlDebug, "recorded");
+    EXPECT_EQ(recorder, rec.logger.flightRecorder());
+    rec.logger.setFlightRecorder(nullptr);
+    EXPECT_FALSE(rec.logger.isEnabled(BaseLogger::LvlDebug));
+    EXPECT_EQ(nullptr, rec.logger.flightRecorder());
+    //---------------
+    rec.log(BaseLogger::LvlDebug, "skipped");
+    rec.log(BaseLogger::LvlError, "error");
+    EXPECT_EQ(std::vector<std::string>({"200:error"}), rec.handled);
+    EXPECT_EQ(std::size_t(1), recorder->records());
+}
+
+TEST(FlightRecorder, threads) {
+    auto recorder = std::make_shared<FlightRecorder>(64 * 1024, 4);
+    RecordedLogger rec(recorder);
+    const std::size_t threadsCount = 4;
+    const std::size_t messages = 500;
+    std::vector<std::thread> threads;
+    for (std::size_t t = 0; t < threadsCount; ++t) {
+        threads.emplace_back([&rec, t, messages]() {
+            for (std::size_t i = 0; i < messages; ++i) {
+                rec.log(BaseLogger::LvlDebug, std::to_string(t) + " " + std::to_string(i));
+            }
+        });
+    }
+    for (auto & thread : threads) {
+        thread.join();
+    }
+    ASSERT_EQ(std::uint64_t(0), recorder->overwritten());
+    rec.log(BaseLogger::LvlError, "error");
+    //---------------
+    ASSERT_EQ(threadsCount * messages + 1, rec.handled.size());
+    std::vector<std::size_t> next(threadsCount, 0);
+    for (std::size_t i = 0; i + 1 < rec.handled.size(); ++i) {
+        std::size_t thread = 0;
+        std::size_t index = 0;
+        ASSERT_EQ(2, std::sscanf(rec.handled[i].c_str(), "800:%zu %zu", &thread, &index));
+        ASSERT_LT(thread, threadsCount);
+        EXPECT_EQ(next[thread]++, index);
+    }
+}
+
+/**************************************************************************************************/
+////////////////////////////////////////////////////////////////////////////////////////////////////
+/**************************************************************************************************/
@@ -0,0 +1,111 @@
+/*
+**  Copyright(C) 2019, StepToSky and FlightFactor
+**  All rights reserved
+**
+**  Redistribution and use in source and binary forms, with or without
+**  modification, are permitted provided that the following conditions are met:
+**
+**  1.Redistributions of source code must retain the above copyright notice, this
+**    list of conditions and the following disclaimer.
+**  2.Redistributions in binary form must reproduce the above copyright notice,
+**    this list of conditions and the following disclaimer in the documentation
+**    and / or other materials provided with the distribution.
+**  3.The name of StepToSky or the name of FlightFactor or the names of its
+**    contributors may NOT be used to endorse or promote products derived from
+**    this software without specific prior written permission.
+**
+**  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+**  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+**  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+**  DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+**  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+**  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+**  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+**  ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+**  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+**  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**
+**  Contacts: www.steptosky.com or www.flightfactor.aero
+*/
+
+#include "ph/stdafx.h"
+
+#include <sstream>
+#include <stsff/logging/BaseLogger.h>
+#include <gtest/gtest.h>
+
+using namespace stsff::logging;
+
+/**************************************************************************************************/
+////////////////////////////////////////////////////////////////////////////////////////////////////
+/**************************************************************************************************/
+
+namespace {
+
+    std::string text(const FormatPattern & pattern, const FormatPattern::Token & token) {
+        const auto view = pattern.text(token);
+        return std::string(view.data(), view.size());
+    }
+
+}
+
+TEST(FormatPattern, tokens) {
+    const FormatPattern pattern("ERR: %LN %MS [%TM(%Y-%m-%d)] %%FN");
+    ASSERT_TRUE(pattern.isValid());
+    const auto & tokens = pattern.tokens();
+    ASSERT_EQ(std::size_t(8), tokens.size());
+    EXPECT_EQ(FormatPattern::OpLiteral, tokens[0].mOp);
+    EXPECT_EQ("ERR: ", text(pattern, tokens[0]));
+    EXPECT_EQ(FormatPattern::OpLogName, tokens[1].mOp);
+    EXPECT_EQ(FormatPattern::OpLiteral, tokens[2].mOp);
+    EXPECT_EQ(" ", text(pattern, tokens[2]));
+    EXPECT_EQ(FormatPattern::OpMessage, tokens[3].mOp);
+    EXPECT_EQ(" [", text(pattern, tokens[4]));
+    EXPECT_EQ(FormatPattern::OpTime, tokens[5].mOp);
+    EXPECT_EQ("%Y-%m-%d", text(pattern, tokens[5]));
+    EXPECT_EQ("] ", text(pattern, tokens[6]));
+    EXPECT_EQ(FormatPattern::OpFunctionName, tokens[7].mOp);
+}
+
+TEST(FormatPattern, errors_once) {
+    std::stringstream errors;
+    auto * cerrBuff = std::cerr.rdbuf();
+    std::cerr.rdbuf(errors.rdbuf());
+    const FormatPattern pattern("%MS %TG %TM");
+    std::cerr.rdbuf(cerrBuff);
+    EXPECT_FALSE(pattern.isValid());
+    EXPECT_EQ("unknown formatting command: [TG]\n"
+              "unexpected end of formatting string after the time command, expected '()'\n", pattern.errors());
+    EXPECT_NE(std::string::npos, errors.str().find("unknown formatting command: [TG]"));
+    //---------------
+    std::stringstream stream;
+    BaseLogger logger;
+    logger.setHandler(BaseLogger::LvlMsg, [&](const BaseLogger & l, const BaseLogger::LogMsg & logMsg) {
+        BaseLogger::defaultHandler(l, logMsg, stream, pattern, nullptr);
+    });
+    LMessage(logger) << "first";
+    LMessage(logger) << "second";
+    // the invalid commands are skipped.
+    EXPECT_EQ("first  \nsecond  \n", stream.str());
+}
+
+TEST(FormatPattern, same_output_as_string) {
+    const std::string formatting("%LN,%MC,%MS,%FN,%FI,%LI|%TM(%Y)|%XX|");
+    std::stringstream byString;
+    std::stringstream byPattern;
+    const FormatPattern pattern(formatting, FormatPattern::ErrorsInline);
+    BaseLogger logger("log-category");
+    logger.setHandler(BaseLogger::LvlMsg, [&](const BaseLogger & l, const BaseLogger::LogMsg & logMsg) {
+        BaseLogger::defaultHandler(l, logMsg, byString, formatting, nullptr);
+        BaseLogger::defaultHandler(l, logMsg, byPattern, pattern, nullptr);
+    });
+    //---------------
+    LogMessage(logger, CodeLocation("function", "file", 5)).setCategory("msg-cat").message() << "message";
+    EXPECT_EQ(byString.str(), byPattern.str());
+    EXPECT_EQ(0u, byString.str().find("log-category,msg-cat,message,function,file,5|"));
+    EXPECT_NE(std::string::npos, byString.str().find("| unknown formatting command: [XX]|"));
+}
+
+/**************************************************************************************************/
+////////////////////////////////////////////////////////////////////////////////////////////////////
+/**************************************************************************************************/
@@ -0,0 +1,132 @@
+/*
+**  Copyright(C) 2019, StepToSky and FlightFactor
+**  All rights reserved
+**
+**  Redistribution and use in source and binary forms, with or without
+**  modification, are permitted provided that the following conditions are met:
+**
+**  1.Redistributions of source code must retain the above copyright notice, this
+**    list of conditions and the following disclaimer.
+**  2.Redistributions in binary form must reproduce the above copyright notice,
+**    this list of conditions and the following disclaimer in the documentation
+**    and / or other materials provided with the distribution.
+**  3.The name of StepToSky or the name of FlightFactor or the names of its
+**    contributors may NOT be used to endorse or promote products derived from
+**    this software without specific prior written permission.
+**
+**  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+**  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+**  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+**  DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+**  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+**  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+**  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+**  ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+**  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+**  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**
+**  Contacts: www.steptosky.com or www.flightfactor.aero
+*/
+
+#include "ph/stdafx.h"
+
+#include <random>
+#include <string>
+#include <stsff/logging/utils/LzCodec.h>
+#include <gtest/gtest.h>
+
+using namespace stsff::logging;
+
+/**************************************************************************************************/
+////////////////////////////////////////////////////////////////////////////////////////////////////
+/**************************************************************************************************/
+
+namespace {
+
+    std::string roundTrip(const std::string & data) {
+        std::string packed;
+        LzCodec::compress(data.data(), data.size(), packed);
+        std::string unpacked;
+        EXPECT_TRUE(LzCodec::decompress(packed.data(), packed.size(), unpacked));
+        return unpacked;
+    }
+
+    std::string logText(const std::size_t lines) {
+        std::string text;
+        for (std::size_t i = 0; i < lines; ++i) {
+            text.append("2018-03-01 12:00:").append(std::to_string(i % 60)).append(" INFO worker ");
+            text.append(std::to_string(i)).append(" processed the request\n");
+        }
+        return text;
+    }
+
+}
+
+/**************************************************************************************************/
+////////////////////////////////////////////////////////////////////////////////////////////////////
+/**************************************************************************************************/
+
+TEST(LzCodec, round_trip) {
+    ASSERT_EQ("", roundTrip(""));
+    ASSERT_EQ("a", roundTrip("a"));
+    ASSERT_EQ("abcabcabcabc", roundTrip("abcabcabcabc"));
+    //---------------
+    // the long runs make the overlapped matches and the extra length bytes.
+    ASSERT_EQ(std::string(100000, 'a'), roundTrip(std::string(100000, 'a')));
+    //---------------
+    // several blocks.
+    const std::string text = logText(10000);
+    ASSERT_GT(text.size(), 3 * LzCodec::BlockSize);
+    ASSERT_EQ(text, roundTrip(text));
+    std::string packed;
+    LzCodec::compress(text.data(), text.size(), packed);
+    ASSERT_LT(packed.size(), text.size() / 3);
+    //---------------
+    // the incompressible data and the long literals.
+    std::mt19937 random(42);
+    std::string noise(3 * LzCodec::BlockSize + 7, '\0');
+    for (auto & c : noise) {
+        c = char(random());
+    }
+    ASSERT_EQ(noise, roundTrip(noise));
+}
+
+TEST(LzCodec, concatenated_streams) {
+    const std::string first = logText(100);
+    const std::string second = logText(200);
+    std::string packed;
+    LzCodec::compress(first.data(), first.size(), packed);
+    LzCodec::compress(second.data(), second.size(), packed);
+    std::string unpacked;
+    ASSERT_TRUE(LzCodec::decompress(packed.data(), packed.size(), unpacked));
+    ASSERT_EQ(first + second, unpacked);
+}
+
+TEST(LzCodec, corrupted) {
+    const std::string text = logText(100);
+    std::string packed;
+    LzCodec::compress(text.data(), text.size(), packed);
+    std::string unpacked;
+    ASSERT_FALSE(LzCodec::decompress("SLZ", 3, unpacked));
+    ASSERT_FALSE(LzCodec::decompress("XLZ1", 4, unpacked));
+    //---------------
+    // the stream has one block, so any truncation is detected.
+    for (std::size_t size = 5; size < packed.size(); ++size) {
+        unpacked.clear();
+        ASSERT_FALSE(LzCodec::decompress(packed.data(), size, unpacked)) << size;
+    }
+    //---------------
+    // the damaged bytes must not make it read or write out of the bounds.
+    std::mt19937 random(7);
+    for (std::size_t i = 0; i < 1000; ++i) {
+        std::string damaged = packed;
+        damaged[4 + random() % (damaged.size() - 4)] = char(random());
+        unpacked.clear();
+        LzCodec::decompress(damaged.data(), damaged.size(), unpacked);
+        ASSERT_LE(unpacked.size(), text.size());
+    }
+}
+
+/**************************************************************************************************/
+////////////////////////////////////////////////////////////////////////////////////////////////////
+/**************************************************************************************************/
@@ -0,0 +1,257 @@
+/*
+**  Copyright(C) 2019, StepToSky and FlightFactor
+**  All rights reserved
+**
+**  Redistribution and use in source and binary forms, with or without
+**  modification, are permitted provided that the following conditions are met:
+**
+**  1.Redistributions of source code must retain the above copyright notice, this
+**    list of conditions and the following disclaimer.
+**  2.Redistributions in binary form must reproduce the above copyright notice,
+**    this list of conditions and the following disclaimer in the documentation
+**    and / or other materials provided with the distribution.
+**  3.The name of StepToSky or the name of FlightFactor or the names of its
+**    contributors may NOT be used to endorse or promote products derived from
+**    this software without specific prior written permission.
+**
+**  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+**  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+**  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+**  DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+**  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+**  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+**  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+**  ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+**  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+**  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**
+**  Contacts: www.steptosky.com or www.flightfactor.aero
+*/
+
+#include "ph/stdafx.h"
+
+#if !defined(_WIN32) && !defined(_WIN64)
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <stsff/logging/BaseLogger.h>
+#include <stsff/logging/MappedFileSink.h>
+#include <gtest/gtest.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+using namespace stsff::logging;
+
+/**************************************************************************************************/
+////////////////////////////////////////////////////////////////////////////////////////////////////
+/**************************************************************************************************/
+
+namespace {
+
+    bool fileExists(const std::string & fileName) {
+        return std::ifstream(fileName, std::ios::binary).good();
+    }
+
+    std::string readFile(const std::string & fileName) {
+        std::ifstream file(fileName, std::ios::binary);
+        std::stringstream text;
+        text << file.rdbuf();
+        return text.str();
+    }
+
+    void writeFile(const std::string & fileName, const std::string & text) {
+        std::ofstream(fileName, std::ios::binary) << text;
+    }
+
+    std::string segmentName(const std::string & fileName, const std::size_t number) {
+        return fileName + "." + std::to_string(number);
+    }
+
+    /*!
+     * \details Reads the segments in order and removes them.
+     */
+    std::string readSegments(const std::string & fileName, const std::size_t segmentSize, std::size_t & segments) {
+        std::string text;
+        segments = 0;
+        while (fileExists(segmentName(fileName, segments + 1))) {
+            const std::string segment = readFile(segmentName(fileName, ++segments));
+            EXPECT_LE(segment.size(), segmentSize);
+            EXPECT_EQ(std::string::npos, segment.find('\0')) << segments;
+            text.append(segment);
+            std::remove(segmentName(fileName, segments).c_str());
+        }
+        return text;
+    }
+
+    void removeSegments(const std::string & fileName) {
+        std::size_t segments;
+        readSegments(fileName, std::string::npos, segments);
+    }
+
+}
+
+/**************************************************************************************************/
+////////////////////////////////////////////////////////////////////////////////////////////////////
+/**************************************************************************************************/
+
+TEST(MappedFileSink, segments) {
+    const std::string fileName("test-mapped-sink-segments.log");
+    removeSegments(fileName);
+    std::string expected;
+    {
+        const MappedFileSink sink(fileName, "%MS", 256);
+        ASSERT_TRUE(sink.isOpen());
+        ASSERT_EQ(std::size_t(1), sink.segment());
+        BaseLogger logger;
+        logger.setHandler(BaseLogger::LvlMsg, sink);
+        for (std::size_t i = 0; i < 100; ++i) {
+            LMessage(logger) << "message " << i << LPush;
+            expected.append("message " + std::to_string(i) + "\n");
+        }
+        ASSERT_EQ(expected.size(), sink.written());
+        ASSERT_LT(std::size_t(4), sink.segment());
+        //---------------
+        // the line longer than the segment is cut.
+        LMessage(logger) << std::string(300, 'x') << LPush;
+        expected.append(std::string(255, 'x') + "\n");
+    }
+    std::size_t segments;
+    ASSERT_EQ(expected, readSegments(fileName, 256, segments));
+    ASSERT_LT(std::size_t(5), segments);
+    // the spare segment is removed.
+    ASSERT_FALSE(fileExists(segmentName(fileName, segments + 1)));
+}
+
+TEST(MappedFileSink, concurrent_writes) {
+    const std::string fileName("test-mapped-sink-concurrent.log");
+    removeSegments(fileName);
+    const std::size_t threadCount = 8;
+    const std::size_t messageCount = 5000;
+    {
+        BaseLogger logger("log");
+        MappedFileSink sink(fileName, "%LN %MS", 64 * 1024);
+        sink.setSyncInterval(5);
+        logger.setHandler(BaseLogger::LvlMsg, sink);
+        std::vector<std::thread> threads;
+        for (std::size_t t = 0; t < threadCount; ++t) {
+            threads.emplace_back([&, t]() {
+                for (std::size_t i = 0; i < messageCount; ++i) {
+                    LMessage(logger) << t << " " << i << " " << std::string(i % 50, 'z') << LPush;
+                }
+            });
+        }
+        for (auto & thread : threads) {
+            thread.join();
+        }
+    }
+    //---------------
+    std::size_t segments;
+    std::istringstream text(readSegments(fileName, 64 * 1024, segments));
+    ASSERT_LT(std::size_t(10), segments);
+    std::vector<std::size_t> next(threadCount, 0);
+    std::string line;
+    std::size_t lines = 0;
+    while (std::getline(text, line)) {
+        std::istringstream fields(line);
+        std::string name;
+        std::size_t thread = 0;
+        std::size_t index = 0;
+        std::string tail;
+        fields >> name >> thread >> index;
+        std::getline(fields, tail);
+        ASSERT_EQ("log", name) << line;
+        ASSERT_LT(thread, threadCount) << line;
+        ASSERT_EQ(next[thread]++, index) << line;
+        ASSERT_EQ(" " + std::string(index % 50, 'z'), tail) << line;
+        ++lines;
+    }
+    ASSERT_EQ(threadCount * messageCount, lines);
+}
+
+TEST(MappedFileSink, recover) {
+    const std::string fileName("test-mapped-sink-recover.log");
+    removeSegments(fileName);
+    //---------------
+    // the line that is not complete yet starts with the zero byte.
+    const std::string lines = "first\nsecond\n";
+    writeFile(segmentName(fileName, 1), lines + '\0' + "hird\n" + "fourth\n" + std::string(100, '\0'));
+    ASSERT_EQ(std::int64_t(lines.size()), MappedFileSink::recover(segmentName(fileName, 1)));
+    ASSERT_EQ(lines, readFile(segmentName(fileName, 1)));
+    //---------------
+    writeFile(segmentName(fileName, 1), lines + "thi");
+    ASSERT_EQ(std::int64_t(lines.size()), MappedFileSink::recover(segmentName(fileName, 1)));
+    ASSERT_EQ(lines, readFile(segmentName(fileName, 1)));
+    ASSERT_EQ(std::int64_t(lines.size()), MappedFileSink::recover(segmentName(fileName, 1)));
+    ASSERT_EQ(std::int64_t(-1), MappedFileSink::recover(segmentName(fileName, 2)));
+    //---------------
+    // the last segment is recovered by the sink and the numbering continues after it.
+    writeFile(segmentName(fileName, 3), lines + std::string(100, '\0'));
+    {
+        MappedFileSink sink(fileName, "%MS", 1024);
+        ASSERT_EQ(std::size_t(4), sink.segment());
+        BaseLogger logger;
+        logger.setHandler(BaseLogger::LvlMsg, sink);
+        sink.setSyncLevel(BaseLogger::LvlMsg);
+        LMessage(logger) << "synchronized" << LPush;
+    }
+    ASSERT_EQ(lines, readFile(segmentName(fileName, 3)));
+    ASSERT_EQ("synchronized\n", readFile(segmentName(fileName, 4)));
+    ASSERT_FALSE(fileExists(segmentName(fileName, 5)));
+    std::remove(segmentName(fileName, 1).c_str());
+    std::remove(segmentName(fileName, 3).c_str());
+    std::remove(segmentName(fileName, 4).c_str());
+}
+
+TEST(MappedFileSink, recover_after_crash) {
+    const std::string fileName("test-mapped-sink-crash.log");
+    removeSegments(fileName);
+    std::string expected;
+    for (std::size_t i = 0; i < 10; ++i) {
+        expected.append("message " + std::to_string(i) + "\n");
+    }
+    //---------------
+    const pid_t child = ::fork();
+    ASSERT_NE(-1, child);
+    if (child == 0) {
+        MappedFileSink sink(fileName, "%MS", 4096);
+        BaseLogger logger;
+        logger.setHandler(BaseLogger::LvlMsg, sink);
+        for (std::size_t i = 0; i < 10; ++i) {
+            LMessage(logger) << "message " << i << LPush;
+        }
+        // the process is stopped when the spare segment is ready, as it usually is.
+        while (!fileExists(segmentName(fileName, 2))) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        ::_exit(0);
+    }
+    int status = 0;
+    ASSERT_EQ(child, ::waitpid(child, &status, 0));
+    ASSERT_TRUE(WIFEXITED(status));
+    ASSERT_EQ(std::size_t(4096), readFile(segmentName(fileName, 1)).size());
+    ASSERT_EQ(std::string(4096, '\0'), readFile(segmentName(fileName, 2)));
+    //---------------
+    // the spare segment is removed and its number is used by the new sink.
+    {
+        MappedFileSink sink(fileName, "%MS", 4096);
+        ASSERT_EQ(std::size_t(2), sink.segment());
+        ASSERT_EQ(expected, readFile(segmentName(fileName, 1)));
+        BaseLogger logger;
+        logger.setHandler(BaseLogger::LvlMsg, sink);
+        LMessage(logger) << "restarted" << LPush;
+    }
+    std::size_t segments;
+    ASSERT_EQ(expected + "restarted\n", readSegments(fileName, 4096, segments));
+    ASSERT_EQ(std::size_t(2), segments);
+}
+
+/**************************************************************************************************/
+////////////////////////////////////////////////////////////////////////////////////////////////////
+/**************************************************************************************************/
+
+#endif
@@ -0,0 +1,276 @@
+/*
+**  Copyright(C) 2019, StepToSky and FlightFactor
+**  All rights reserved
+**
+**  Redistribution and use in source and binary forms, with or without
+**  modification, are permitted provided that the following conditions are met:
+**
+**  1.Redistributions of source code must retain the above copyright notice, this
+**    list of conditions and the following disclaimer.
+**  2.Redistributions in binary form must reproduce the above copyright notice,
+**    this list of conditions and the following disclaimer in the documentation
+**    and / or other materials provided with the distribution.
+**  3.The name of StepToSky or the name of FlightFactor or the names of its
+**    contributors may NOT be used to endorse or promote products derived from
+**    this software without specific prior written permission.
+**
+**  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+**  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+**  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+**  DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+**  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+**  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+**  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+**  ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+**  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+**  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**
+**  Contacts: www.steptosky.com or www.flightfactor.aero
+*/
+
+#include "ph/stdafx.h"
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <stsff/logging/BaseLogger.h>
+#include <stsff/logging/RotatingFileSink.h>
+#include <stsff/logging/utils/LzCodec.h>
+#include <gtest/gtest.h>
+
+using namespace stsff::logging;
+
+/**************************************************************************************************/
+////////////////////////////////////////////////////////////////////////////////////////////////////
+/**************************************************************************************************/
+
+namespace {
+
+    bool fileExists(const std::string & fileName) {
+        return std::ifstream(fileName, std::ios::binary).good();
+    }
+
+    std::string readFile(const std::string & fileName) {
+        std::ifstream file(fileName, std::ios::binary);
+        std::stringstream text;
+        text << file.rdbuf();
+        return text.str();
+    }
+
+    void writeFile(const std::string & fileName, const std::string & text) {
+        std::ofstream(fileName, std::ios::binary) << text;
+    }
+
+    std::string unpackFile(const std::string & fileName) {
+        const std::string packed = readFile(fileName);
+        std::string text;
+        EXPECT_TRUE(LzCodec::decompress(packed.data(), packed.size(), text)) << fileName;
+        return text;
+    }
+
+    void removeFiles(const std::string & fileName, const std::size_t history) {
+        std::remove(fileName.c_str());
+        std::remove((fileName + ".next").c_str());
+        for (std::size_t i = 1; i <= history; ++i) {
+            std::remove((fileName + "." + std::to_string(i)).c_str());
+            std::remove((fileName + "." + std::to_string(i) + ".lz").c_str());
+        }
+    }
+
+    bool waitFor(const std::function<bool()> & condition) {
+        for (std::size_t i = 0; i < 500; ++i) {
+            if (condition()) {
+                return true;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        return condition();
+    }
+
+}
+
+/**************************************************************************************************/
+////////////////////////////////////////////////////////////////////////////////////////////////////
+/**************************************************************************************************/
+
+TEST(RotatingFileSink, rotation_by_size) {
+    const std::string fileName("test-rotating-sink-size.log");
+    removeFiles(fileName, 3);
+    {
+        // each message is larger than the limit, so the file is rotated after each one
+        // when the background thread has prepared the next spare file.
+        const RotatingFileSink sink(fileName, "%MS", RotatingFileSink::Rotation::bySize(1).keep(2).compress(false));
+        ASSERT_TRUE(sink.isOpen());
+        BaseLogger logger;
+        logger.setHandler(BaseLogger::LvlMsg, sink);
+        for (std::size_t i = 1; i <= 4; ++i) {
+            LMessage(logger) << i << LPush;
+            ASSERT_TRUE(waitFor([&]() { return sink.rotations() == i; }));
+        }
+    }
+    ASSERT_EQ("", readFile(fileName));
+    ASSERT_EQ("4\n", readFile(fileName + ".1"));
+    ASSERT_EQ("3\n", readFile(fileName + ".2"));
+    ASSERT_FALSE(fileExists(fileName + ".3"));
+    ASSERT_FALSE(fileExists(fileName + ".next"));
+    removeFiles(fileName, 3);
+}
+
+TEST(RotatingFileSink, rotation_by_time) {
+    const std::string fileName("test-rotating-sink-time.log");
+    removeFiles(fileName, 2);
+    std::size_t messages = 0;
+    {
+        const RotatingFileSink sink(fileName, "%MS", RotatingFileSink::Rotation::byInterval(1));
+        BaseLogger logger;
+        logger.setHandler(BaseLogger::LvlMsg, sink);
+        // the file is rotated by the first message after the second boundary.
+        ASSERT_TRUE(waitFor([&]() {
+            LMessage(logger) << "message " << messages++ << LPush;
+            return sink.rotations() == 1;
+        }));
+    }
+    std::istringstream text(unpackFile(fileName + ".1.lz") + readFile(fileName));
+    std::string line;
+    std::size_t index = 0;
+    while (std::getline(text, line)) {
+        ASSERT_EQ("message " + std::to_string(index++), line);
+    }
+    ASSERT_EQ(messages, index);
+    ASSERT_FALSE(fileExists(fileName + ".1"));
+    removeFiles(fileName, 2);
+}
+
+TEST(RotatingFileSink, interrupted_rotation) {
+    const std::string fileName("test-rotating-sink-interrupted.log");
+    removeFiles(fileName, 2);
+    writeFile(fileName, "old\n");
+    writeFile(fileName + ".next", "new\n");
+    {
+        const RotatingFileSink sink(fileName, "%MS", RotatingFileSink::Rotation::bySize(1024));
+        BaseLogger logger;
+        logger.setHandler(BaseLogger::LvlMsg, sink);
+        LMessage(logger) << "newest" << LPush;
+    }
+    ASSERT_EQ("new\nnewest\n", readFile(fileName));
+    ASSERT_EQ("old\n", unpackFile(fileName + ".1.lz"));
+    ASSERT_FALSE(fileExists(fileName + ".1"));
+    ASSERT_FALSE(fileExists(fileName + ".next"));
+    removeFiles(fileName, 2);
+}
+
+TEST(RotatingFileSink, idle_spare_file) {
+    const std::string fileName("test-rotating-sink-spare.log");
+    removeFiles(fileName, 2);
+    writeFile(fileName, "old\n");
+    writeFile(fileName + ".next", "");
+    {
+        const RotatingFileSink sink(fileName, "%MS", RotatingFileSink::Rotation::bySize(1024));
+        BaseLogger logger;
+        logger.setHandler(BaseLogger::LvlMsg, sink);
+        LMessage(logger) << "newest" << LPush;
+    }
+    ASSERT_EQ("old\nnewest\n", readFile(fileName));
+    ASSERT_FALSE(fileExists(fileName + ".1"));
+    ASSERT_FALSE(fileExists(fileName + ".1.lz"));
+    ASSERT_FALSE(fileExists(fileName + ".next"));
+    removeFiles(fileName, 2);
+}
+
+TEST(RotatingFileSink, interrupted_compression) {
+    const std::string fileName("test-rotating-sink-compression.log");
+    removeFiles(fileName, 3);
+    writeFile(fileName, "current\n");
+    writeFile(fileName + ".1", "previous\n");
+    {
+        // the previous process was stopped before it has compressed the old file.
+        const RotatingFileSink sink(fileName, "%MS", RotatingFileSink::Rotation::bySize(1).keep(3));
+        BaseLogger logger;
+        logger.setHandler(BaseLogger::LvlMsg, sink);
+        LMessage(logger) << "newest" << LPush;
+        ASSERT_TRUE(waitFor([&]() { return sink.rotations() == 1; }));
+    }
+    ASSERT_EQ("", readFile(fileName));
+    ASSERT_EQ("current\nnewest\n", unpackFile(fileName + ".1.lz"));
+    ASSERT_EQ("previous\n", unpackFile(fileName + ".2.lz"));
+    ASSERT_FALSE(fileExists(fileName + ".1"));
+    ASSERT_FALSE(fileExists(fileName + ".2"));
+    removeFiles(fileName, 3);
+}
+
+TEST(RotatingFileSink, sustained_load) {
+    const std::string fileName("test-rotating-sink-load.log");
+    const std::size_t history = 10000;
+    const std::size_t threadCount = 4;
+    const std::size_t messageCount = 20000;
+    removeFiles(fileName, history);
+    std::size_t rotations = 0;
+    {
+        BaseLogger logger("log");
+        const RotatingFileSink sink(fileName, "%LN %MS", RotatingFileSink::Rotation::bySize(32 * 1024).keep(history), 4096);
+        logger.setHandler(BaseLogger::LvlMsg, sink);
+        std::vector<std::thread> threads;
+        for (std::size_t t = 0; t < threadCount; ++t) {
+            threads.emplace_back([&, t]() {
+                for (std::size_t i = 0; i < messageCount; ++i) {
+                    LMessage(logger) << t << " " << i << " " << std::string(i % 50, 'z') << LPush;
+                    // the pauses let the background thread run even on one core.
+                    if (i % 500 == 0) {
+                        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                    }
+                }
+            });
+        }
+        for (auto & thread : threads) {
+            thread.join();
+        }
+        rotations = sink.rotations();
+    }
+    //---------------
+    // the oldest file has the largest number.
+    std::size_t files = 0;
+    while (fileExists(fileName + "." + std::to_string(files + 1) + ".lz")) {
+        ++files;
+    }
+    ASSERT_GT(files, std::size_t(1));
+    ASSERT_GE(files, rotations);
+    ASSERT_FALSE(fileExists(fileName + "." + std::to_string(files + 1)));
+    ASSERT_FALSE(fileExists(fileName + ".next"));
+    std::string all;
+    for (std::size_t i = files; i != 0; --i) {
+        ASSERT_FALSE(fileExists(fileName + "." + std::to_string(i))) << i;
+        all.append(unpackFile(fileName + "." + std::to_string(i) + ".lz"));
+    }
+    all.append(readFile(fileName));
+    //---------------
+    std::istringstream text(all);
+    std::vector<std::size_t> next(threadCount, 0);
+    std::string line;
+    std::size_t lines = 0;
+    while (std::getline(text, line)) {
+        std::istringstream fields(line);
+        std::string name;
+        std::size_t thread = 0;
+        std::size_t index = 0;
+        std::string tail;
+        fields >> name >> thread >> index;
+        std::getline(fields, tail);
+        ASSERT_EQ("log", name) << line;
+        ASSERT_LT(thread, threadCount) << line;
+        // a lost line breaks the sequence and a duplicated one too.
+        ASSERT_EQ(next[thread]++, index) << line;
+        ASSERT_EQ(" " + std::string(index % 50, 'z'), tail) << line;
+        ++lines;
+    }
+    ASSERT_EQ(threadCount * messageCount, lines);
+    removeFiles(fileName, files);
+}
+
+/**************************************************************************************************/
+////////////////////////////////////////////////////////////////////////////////////////////////////
+/**************************************************************************************************/
@@ -0,0 +1,78 @@
+/*
+**  Copyright(C) 2019, StepToSky and FlightFactor
+**  All rights reserved
+**
+**  Redistribution and use in source and binary forms, with or without
+**  modification, are permitted provided that the following conditions are met:
+**
+**  1.Redistributions of source code must retain the above copyright notice, this
+**    list of conditions and the following disclaimer.
+**  2.Redistributions in binary form must reproduce the above copyright notice,
+**    this list of conditions and the following disclaimer in the documentation
+**    and / or other materials provided with the distribution.
+**  3.The name of StepToSky or the name of FlightFactor or the names of its
+**    contributors may NOT be used to endorse or promote products derived from
+**    this software without specific prior written permission.
+**
+**  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+**  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+**  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+**  DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+**  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+**  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+**  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+**  ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+**  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+**  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**
+**  Contacts: www.steptosky.com or www.flightfactor.aero
+*/
+
+#include "ph/stdafx.h"
+
+#include <chrono>
+#include <stsff/logging/utils/TimeSource.h>
+#include <gtest/gtest.h>
+
+using namespace stsff::logging;
+
+/**************************************************************************************************/
+////////////////////////////////////////////////////////////////////////////////////////////////////
+/**************************************************************************************************/
+
+TEST(TimeSource, clocks) {
+    const std::int64_t second = 1000000000;
+    const std::int64_t system = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+    EXPECT_NEAR(double(system), double(TimeSource::now(TimeSource::ClockSystem)), double(second));
+    EXPECT_NEAR(double(system), double(TimeSource::now(TimeSource::ClockCoarse)), double(second));
+}
+
+TEST(TimeSource, set_clock) {
+    EXPECT_EQ(TimeSource::ClockSystem, TimeSource::clock());
+    TimeSource::setClock(TimeSource::ClockCoarse);
+    EXPECT_EQ(TimeSource::ClockCoarse, TimeSource::clock());
+    EXPECT_NE(0, TimeSource::now());
+    TimeSource::setClock(TimeSource::ClockSystem);
+    EXPECT_EQ(TimeSource::ClockSystem, TimeSource::clock());
+}
+
+TEST(TimeSource, tsc) {
+    const std::int64_t millisecond = 1000000;
+    TimeSource::setClock(TimeSource::ClockTsc);
+    const auto first = TimeSource::capture();
+    const std::int64_t system = TimeSource::now(TimeSource::ClockSystem);
+    const auto second = TimeSource::capture();
+    TimeSource::setClock(TimeSource::ClockSystem);
+    //---------------
+    EXPECT_EQ(TimeSource::isTscAvailable(), first.mTicks);
+    EXPECT_NEAR(double(system), double(TimeSource::toNanoseconds(first)), double(millisecond));
+    EXPECT_LE(TimeSource::toNanoseconds(first), TimeSource::toNanoseconds(second));
+    EXPECT_NEAR(double(system), double(TimeSource::now(TimeSource::ClockTsc)), double(100 * millisecond));
+    // the captured ticks are converted after the clock is changed.
+    EXPECT_NEAR(double(system), double(TimeSource::toNanoseconds(second)), double(millisecond));
+}
+
+/**************************************************************************************************/
+////////////////////////////////////////////////////////////////////////////////////////////////////
+/**************************************************************************************************/
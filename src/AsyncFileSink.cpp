@@ -0,0 +1,555 @@
+/*
+**  Copyright(C) 2019, StepToSky and FlightFactor
+**  All rights reserved
+**
+**  Redistribution and use in source and binary forms, with or without
+**  modification, are permitted provided that the following conditions are met:
+**
+**  1.Redistributions of source code must retain the above copyright notice, this
+**    list of conditions and the following disclaimer.
+**  2.Redistributions in binary form must reproduce the above copyright notice,
+**    this list of conditions and the following disclaimer in the documentation
+**    and / or other materials provided with the distribution.
+**  3.The name of StepToSky or the name of FlightFactor or the names of its
+**    contributors may NOT be used to endorse or promote products derived from
+**    this software without specific prior written permission.
+**
+**  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+**  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+**  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+**  DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+**  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+**  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+**  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+**  ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+**  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+**  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**
+**  Contacts: www.steptosky.com or www.flightfactor.aero
+*/
+
+#include "stdafx.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "stsff/logging/AsyncFileSink.h"
+#include "stsff/logging/internal/FileWriter.h"
+
+#if defined(_WIN32) || defined(_WIN64)
+#   include <io.h>
+#   include <fcntl.h>
+#   include <sys/stat.h>
+#else
+#   include <fcntl.h>
+#   include <unistd.h>
+#endif
+
+#if defined(__linux__) && defined(__has_include)
+#   if __has_include(<linux/io_uring.h>)
+#       include <linux/io_uring.h>
+#       include <sys/mman.h>
+#       include <sys/syscall.h>
+#       include <sys/uio.h>
+#       if defined(__NR_io_uring_setup) && defined(__NR_io_uring_enter)
+#           define STSFF_LOGGING_HAS_IO_URING
+#       endif
+#   endif
+#endif
+
+namespace stsff {
+namespace logging {
+
+    /**************************************************************************************************/
+    /////////////////////////////////////////* Static area *////////////////////////////////////////////
+    /**************************************************************************************************/
+
+    namespace {
+
+        struct Buffer {
+            std::unique_ptr<char[]> mData;
+            std::size_t mSize = 0;
+            std::size_t mDone = 0; //!< Number of the written bytes of the submitted buffer.
+            std::uint64_t mOffset = 0;
+#ifdef STSFF_LOGGING_HAS_IO_URING
+            iovec mIovec;
+#endif
+        };
+
+        //-------------------------------------------------------------------------
+
+#ifdef STSFF_LOGGING_HAS_IO_URING
+
+        /*!
+         * \details Minimal io_uring with the raw system calls, the submissions and the completions
+         *          are made under the sink's mutex, so the ring has one producer and one consumer.
+         */
+        class Ring {
+        public:
+
+            Ring() = default;
+            Ring(const Ring &) = delete;
+            Ring & operator=(const Ring &) = delete;
+
+            ~Ring() noexcept {
+                close();
+            }
+
+            bool open(const unsigned entries) noexcept {
+                io_uring_params params;
+                std::memset(&params, 0, sizeof params);
+                const long fd = ::syscall(__NR_io_uring_setup, entries, &params);
+                if (fd < 0) {
+                    return false;
+                }
+                mFd = int(fd);
+                mSqSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+                mCqSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+                const bool singleMap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+                if (singleMap) {
+                    mSqSize = mCqSize = std::max(mSqSize, mCqSize);
+                }
+                mSq = map(mSqSize, IORING_OFF_SQ_RING);
+                mCq = singleMap ? mSq : map(mCqSize, IORING_OFF_CQ_RING);
+                mSqesSize = params.sq_entries * sizeof(io_uring_sqe);
+                mSqes = static_cast<io_uring_sqe *>(map(mSqesSize, IORING_OFF_SQES));
+                if (!mSq || !mCq || !mSqes) {
+                    close();
+                    return false;
+                }
+                char * sq = static_cast<char *>(mSq);
+                mSqTail = reinterpret_cast<unsigned *>(sq + params.sq_off.tail);
+                mSqMask = *reinterpret_cast<unsigned *>(sq + params.sq_off.ring_mask);
+                mSqArray = reinterpret_cast<unsigned *>(sq + params.sq_off.array);
+                char * cq = static_cast<char *>(mCq);
+                mCqHead = reinterpret_cast<unsigned *>(cq + params.cq_off.head);
+                mCqTail = reinterpret_cast<unsigned *>(cq + params.cq_off.tail);
+                mCqMask = *reinterpret_cast<unsigned *>(cq + params.cq_off.ring_mask);
+                mCqes = reinterpret_cast<io_uring_cqe *>(cq + params.cq_off.cqes);
+                return true;
+            }
+
+            bool isOpen() const noexcept {
+                return mFd >= 0;
+            }
+
+            /*!
+             * \details The ring has the place for the submission because the number of the writes
+             *          in flight is less than the ring size.
+             */
+            bool submitWrite(const int fd, const iovec * iov, const std::uint64_t offset, const std::uint64_t userData) noexcept {
+                const unsigned tail = *mSqTail;
+                const unsigned index = tail & mSqMask;
+                io_uring_sqe & sqe = mSqes[index];
+                std::memset(&sqe, 0, sizeof sqe);
+                sqe.opcode = IORING_OP_WRITEV;
+                sqe.fd = fd;
+                sqe.addr = std::uint64_t(reinterpret_cast<std::uintptr_t>(iov));
+                sqe.len = 1;
+                sqe.off = offset;
+                sqe.user_data = userData;
+                mSqArray[index] = index;
+                __atomic_store_n(mSqTail, tail + 1, __ATOMIC_RELEASE);
+                if (!enter(1, 0, 0)) {
+                    // nothing is submitted, so the entry is taken back
+                    // instead of being submitted with the next call.
+                    __atomic_store_n(mSqTail, tail, __ATOMIC_RELEASE);
+                    return false;
+                }
+                return true;
+            }
+
+            /*!
+             * \details Calls the function with the user data and the result of each completed write.
+             * \param [in] wait wait for one completion at least.
+             * \param [in] fn
+             */
+            template<typename Fn>
+            void complete(const bool wait, Fn fn) {
+                if (wait) {
+                    enter(0, 1, IORING_ENTER_GETEVENTS);
+                }
+                unsigned head = *mCqHead;
+                const unsigned tail = __atomic_load_n(mCqTail, __ATOMIC_ACQUIRE);
+                for (; head != tail; ++head) {
+                    const io_uring_cqe & cqe = mCqes[head & mCqMask];
+                    fn(cqe.user_data, cqe.res);
+                }
+                __atomic_store_n(mCqHead, head, __ATOMIC_RELEASE);
+            }
+
+        private:
+
+            void * map(const std::size_t size, const off_t offset) const noexcept {
+                void * data = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, mFd, offset);
+                return data == MAP_FAILED ? nullptr : data;
+            }
+
+            bool enter(const unsigned toSubmit, const unsigned minComplete, const unsigned flags) const noexcept {
+                long result;
+                do {
+                    result = ::syscall(__NR_io_uring_enter, mFd, toSubmit, minComplete, flags, nullptr, 0);
+                } while (result < 0 && errno == EINTR);
+                return result >= 0;
+            }
+
+            void close() noexcept {
+                if (mSqes) {
+                    ::munmap(mSqes, mSqesSize);
+                }
+                if (mCq && mCq != mSq) {
+                    ::munmap(mCq, mCqSize);
+                }
+                if (mSq) {
+                    ::munmap(mSq, mSqSize);
+                }
+                if (mFd >= 0) {
+                    ::close(mFd);
+                }
+                mSq = mCq = nullptr;
+                mSqes = nullptr;
+                mFd = -1;
+            }
+
+            int mFd = -1;
+            void * mSq = nullptr;
+            void * mCq = nullptr;
+            std::size_t mSqSize = 0;
+            std::size_t mCqSize = 0;
+            std::size_t mSqesSize = 0;
+            io_uring_sqe * mSqes = nullptr;
+            unsigned * mSqTail = nullptr;
+            unsigned * mSqArray = nullptr;
+            unsigned mSqMask = 0;
+            unsigned * mCqHead = nullptr;
+            unsigned * mCqTail = nullptr;
+            unsigned mCqMask = 0;
+            io_uring_cqe * mCqes = nullptr;
+
+        };
+
+#endif
+
+    }
+
+    /**************************************************************************************************/
+    ////////////////////////////////////////////////////////////////////////////////////////////////////
+    /**************************************************************************************************/
+
+    class AsyncFileSink::File final {
+    public:
+
+        File(const std::string & fileName, const FormatPattern & pattern, const std::size_t bufferSize,
+             const std::size_t bufferCount, const eBackend backend)
+            : mWriter(fileName),
+              mPattern(pattern),
+              mCapacity(bufferSize ? bufferSize : 1),
+              mBuffers(std::max<std::size_t>(bufferCount, 2)) {
+#if defined(_WIN32) || defined(_WIN64)
+            mFd = ::_open(fileName.c_str(), _O_WRONLY | _O_CREAT | _O_BINARY, _S_IREAD | _S_IWRITE);
+            const auto end = mFd >= 0 ? ::_lseeki64(mFd, 0, SEEK_END) : -1;
+#else
+            // the file isn't opened for appending because the writes in flight have their own offsets.
+            mFd = ::open(fileName.c_str(), O_WRONLY | O_CREAT | O_CLOEXEC, 0644);
+            const auto end = mFd >= 0 ? ::lseek(mFd, 0, SEEK_END) : -1;
+#endif
+            if (mFd < 0) {
+                internal::FileWriter::printError("can't open the log file", fileName, errno, __STS_FUNC_NAME__);
+                return;
+            }
+            mOffset = end > 0 ? std::uint64_t(end) : 0;
+            for (auto & buffer : mBuffers) {
+                buffer.mData.reset(new char[mCapacity]);
+                mFree.push_back(&buffer);
+            }
+#ifdef STSFF_LOGGING_HAS_IO_URING
+            mUseRing = backend == BackendAuto && mRing.open(unsigned(2 * mBuffers.size()));
+#else
+            (void)backend;
+#endif
+            if (!mUseRing) {
+                mWorker = std::thread(&File::work, this);
+            }
+            mOpen = true;
+        }
+
+        File(const File &) = delete;
+        File & operator=(const File &) = delete;
+
+        ~File() noexcept {
+            if (!mOpen) {
+                return;
+            }
+            {
+                std::lock_guard<std::mutex> order(mOrderMutex);
+                std::unique_lock<std::mutex> lock(mMutex);
+                submitCurrent();
+                waitAll(lock);
+                mStop = true;
+            }
+            if (mWorker.joinable()) {
+                mQueued.notify_one();
+                mWorker.join();
+            }
+#if defined(_WIN32) || defined(_WIN64)
+            ::_close(mFd);
+#else
+            ::close(mFd);
+#endif
+        }
+
+        //-------------------------------------------------------------------------
+
+        void write(const char * data, std::size_t size, const std::size_t level) {
+            // the writer keeps the order lock while it waits for a free buffer,
+            // so the other lines don't get into the middle of its line.
+            std::lock_guard<std::mutex> order(mOrderMutex);
+            std::unique_lock<std::mutex> lock(mMutex);
+            while (size != 0) {
+                if (!mCurrent) {
+                    mCurrent = acquire(lock);
+                }
+                const std::size_t part = std::min(size, mCapacity - mCurrent->mSize);
+                std::memcpy(mCurrent->mData.get() + mCurrent->mSize, data, part);
+                mCurrent->mSize += part;
+                data += part;
+                size -= part;
+                if (mCurrent->mSize == mCapacity) {
+                    submitCurrent();
+                }
+            }
+            ++mUnflushed;
+            if (mPolicy.isDue(level, mUnflushed, mLastFlush)) {
+                submitCurrent();
+            }
+        }
+
+        void flush() {
+            std::lock_guard<std::mutex> order(mOrderMutex);
+            std::unique_lock<std::mutex> lock(mMutex);
+            submitCurrent();
+            waitAll(lock);
+        }
+
+        void setFlushPolicy(const FlushPolicy & policy) {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mPolicy = policy;
+            mLastFlush = TimeSource::now(TimeSource::ClockCoarse);
+        }
+
+        //-------------------------------------------------------------------------
+
+        internal::FileWriter mWriter;
+        const FormatPattern mPattern;
+        bool mOpen = false;
+        bool mUseRing = false;
+        std::atomic<std::uint64_t> mWritten{0};
+
+    private:
+
+        /*!
+         * \details Takes a free buffer, waits for a completed write if all the buffers are in flight.
+         */
+        Buffer * acquire(std::unique_lock<std::mutex> & lock) {
+            while (mFree.empty()) {
+                waitCompletion(lock);
+            }
+            Buffer * buffer = mFree.back();
+            mFree.pop_back();
+            return buffer;
+        }
+
+        void submitCurrent() {
+            mUnflushed = 0;
+            if (mPolicy.mIntervalMs > 0) {
+                mLastFlush = TimeSource::now(TimeSource::ClockCoarse);
+            }
+            if (!mCurrent || mCurrent->mSize == 0) {
+                return;
+            }
+            Buffer * buffer = mCurrent;
+            mCurrent = nullptr;
+            buffer->mOffset = mOffset;
+            buffer->mDone = 0;
+            mOffset += buffer->mSize;
+            ++mInFlight;
+#ifdef STSFF_LOGGING_HAS_IO_URING
+            if (mUseRing) {
+                submitRing(*buffer);
+                // the completed writes are collected without waiting, so the buffers are free sooner.
+                mRing.complete(false, [this](const std::uint64_t index, const int result) { completeRing(index, result); });
+                return;
+            }
+#endif
+            mQueue.push_back(buffer);
+            mQueued.notify_one();
+        }
+
+        void waitCompletion(std::unique_lock<std::mutex> & lock) {
+#ifdef STSFF_LOGGING_HAS_IO_URING
+            if (mUseRing) {
+                mRing.complete(true, [this](const std::uint64_t index, const int result) { completeRing(index, result); });
+                return;
+            }
+#endif
+            mFreed.wait(lock);
+        }
+
+        void waitAll(std::unique_lock<std::mutex> & lock) {
+            while (mInFlight != 0) {
+                waitCompletion(lock);
+            }
+        }
+
+        void release(Buffer & buffer) {
+            mWritten.fetch_add(buffer.mDone, std::memory_order_relaxed);
+            buffer.mSize = 0;
+            mFree.push_back(&buffer);
+            --mInFlight;
+        }
+
+#ifdef STSFF_LOGGING_HAS_IO_URING
+
+        void submitRing(Buffer & buffer) {
+            buffer.mIovec.iov_base = buffer.mData.get() + buffer.mDone;
+            buffer.mIovec.iov_len = buffer.mSize - buffer.mDone;
+            const std::uint64_t index = std::uint64_t(&buffer - mBuffers.data());
+            if (!mRing.submitWrite(mFd, &buffer.mIovec, buffer.mOffset + buffer.mDone, index)) {
+                mWriter.reportWriteError(errno);
+                release(buffer);
+            }
+        }
+
+        void completeRing(const std::uint64_t index, const int result) {
+            Buffer & buffer = mBuffers[std::size_t(index)];
+            if (result == -EINTR || result == -EAGAIN) {
+                submitRing(buffer);
+            }
+            else if (result <= 0) {
+                mWriter.reportWriteError(result < 0 ? -result : EIO);
+                release(buffer);
+            }
+            else {
+                buffer.mDone += std::size_t(result);
+                if (buffer.mDone < buffer.mSize) {
+                    // the rest of the short write.
+                    submitRing(buffer);
+                }
+                else {
+                    release(buffer);
+                }
+            }
+        }
+
+#endif
+
+        /*!
+         * \details The background thread writes the buffers in the submission order,
+         *          so the file position is the buffer's offset.
+         */
+        void work() noexcept {
+            std::unique_lock<std::mutex> lock(mMutex);
+            for (;;) {
+                mQueued.wait(lock, [this]() { return mStop || !mQueue.empty(); });
+                if (mQueue.empty()) {
+                    break;
+                }
+                Buffer * buffer = mQueue.front();
+                mQueue.pop_front();
+                lock.unlock();
+                buffer->mDone += mWriter.write(mFd, buffer->mData.get() + buffer->mDone, buffer->mSize - buffer->mDone);
+                lock.lock();
+                release(*buffer);
+                mFreed.notify_all();
+            }
+        }
+
+        //-------------------------------------------------------------------------
+
+        int mFd = -1;
+        const std::size_t mCapacity;
+        std::uint64_t mOffset = 0;
+
+        std::mutex mOrderMutex;
+        std::mutex mMutex;
+        std::condition_variable mFreed;
+        std::vector<Buffer> mBuffers;
+        std::vector<Buffer *> mFree;
+        Buffer * mCurrent = nullptr;
+        std::size_t mInFlight = 0;
+        FlushPolicy mPolicy = FlushPolicy::never();
+        std::size_t mUnflushed = 0;
+        std::int64_t mLastFlush = 0;
+
+#ifdef STSFF_LOGGING_HAS_IO_URING
+        Ring mRing;
+#endif
+
+        std::condition_variable mQueued;
+        std::deque<Buffer *> mQueue;
+        bool mStop = false;
+        std::thread mWorker;
+
+    };
+
+    /**************************************************************************************************/
+    ////////////////////////////////////* Constructors/Destructor */////////////////////////////////////
+    /**************************************************************************************************/
+
+    AsyncFileSink::AsyncFileSink(const std::string & fileName, const FormatPattern & pattern, const std::size_t bufferSize,
+                                 const std::size_t bufferCount, const eBackend backend)
+        : mFile(std::make_shared<File>(fileName, pattern, bufferSize, bufferCount, backend)) {}
+
+    /**************************************************************************************************/
+    //////////////////////////////////////////* Functions */////////////////////////////////////////////
+    /**************************************************************************************************/
+
+    void AsyncFileSink::operator()(const BaseLogger & logger, const BaseLogger::LogMsg & logMsg) const {
+        if (!mFile->mOpen) {
+            return;
+        }
+        const internal::MessageBuffer & line = internal::renderLine(logger, logMsg, mFile->mPattern);
+        mFile->write(line.data(), line.size(), logMsg.mLevel);
+    }
+
+    void AsyncFileSink::flush() const noexcept {
+        if (!mFile->mOpen) {
+            return;
+        }
+        internal::callNoexcept(__STS_FUNC_NAME__, [&]() { mFile->flush(); });
+    }
+
+    void AsyncFileSink::setFlushPolicy(const FlushPolicy & policy) noexcept {
+        internal::callNoexcept(__STS_FUNC_NAME__, [&]() { mFile->setFlushPolicy(policy); });
+    }
+
+    //-------------------------------------------------------------------------
+
+    const std::string & AsyncFileSink::fileName() const noexcept {
+        return mFile->mWriter.fileName();
+    }
+
+    bool AsyncFileSink::isOpen() const noexcept {
+        return mFile->mOpen;
+    }
+
+    bool AsyncFileSink::usesIoUring() const noexcept {
+        return mFile->mUseRing;
+    }
+
+    std::uint64_t AsyncFileSink::written() const noexcept {
+        return mFile->mWritten.load(std::memory_order_relaxed);
+    }
+
+    /**************************************************************************************************/
+    ////////////////////////////////////////////////////////////////////////////////////////////////////
+    /**************************************************************************************************/
+
+}
+}
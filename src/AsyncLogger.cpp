@@ -0,0 +1,506 @@
+/*
+**  Copyright(C) 2019, StepToSky and FlightFactor
+**  All rights reserved
+**
+**  Redistribution and use in source and binary forms, with or without
+**  modification, are permitted provided that the following conditions are met:
+**
+**  1.Redistributions of source code must retain the above copyright notice, this
+**    list of conditions and the following disclaimer.
+**  2.Redistributions in binary form must reproduce the above copyright notice,
+**    this list of conditions and the following disclaimer in the documentation
+**    and / or other materials provided with the distribution.
+**  3.The name of StepToSky or the name of FlightFactor or the names of its
+**    contributors may NOT be used to endorse or promote products derived from
+**    this software without specific prior written permission.
+**
+**  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+**  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+**  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+**  DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+**  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+**  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+**  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+**  ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+**  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+**  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**
+**  Contacts: www.steptosky.com or www.flightfactor.aero
+*/
+
+#include "stdafx.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <functional>
+#include "stsff/logging/AsyncLogger.h"
+
+namespace stsff {
+namespace logging {
+
+    /**************************************************************************************************/
+    /////////////////////////////////////////* Static area *////////////////////////////////////////////
+    /**************************************************************************************************/
+
+    namespace {
+
+        /*!
+         * \details Message record in the thread's buffer, it is followed by
+         *          the category, the message, the function and the file strings.
+         */
+        struct RecordHeader {
+            std::int64_t mTime;
+            std::uint64_t mLevel;
+            std::int32_t mLine;
+            std::uint32_t mCategorySize;
+            std::uint32_t mMsgSize;
+            std::uint32_t mFunctionSize;
+            std::uint32_t mFileSize;
+            std::uint32_t mTicks; //!< see TimeSource::Stamp::mTicks
+        };
+
+        std::int64_t recordTime(const char * record) noexcept {
+            RecordHeader header;
+            std::memcpy(&header, record, sizeof(header));
+            return TimeSource::toNanoseconds(TimeSource::Stamp{header.mTime, header.mTicks != 0});
+        }
+
+    }
+
+    struct AsyncLogger::MergeState {
+        typedef std::pair<std::int64_t, std::size_t> Entry; // time, ring index
+
+        std::vector<internal::ThreadRings::RingPtr> mRings;
+        std::uint64_t mVersion = 0;
+        std::vector<std::size_t> mLimits;
+        std::vector<Entry> mHeap;
+    };
+
+    /**************************************************************************************************/
+    ////////////////////////////////////* Constructors/Destructor */////////////////////////////////////
+    /**************************************************************************************************/
+
+    AsyncLogger::AsyncLogger(const StringView name, const std::size_t queueSize)
+        : BaseLogger(name) {
+        start(QueueShared, queueSize);
+    }
+
+    AsyncLogger::AsyncLogger(const StringView name, LevelHandlers levelsConf, const std::size_t queueSize)
+        : BaseLogger(name, std::move(levelsConf)) {
+        start(QueueShared, queueSize);
+    }
+
+    AsyncLogger::AsyncLogger(const StringView name, const eQueue queue, const std::size_t size)
+        : BaseLogger(name) {
+        start(queue, size);
+    }
+
+    AsyncLogger::AsyncLogger(const StringView name, LevelHandlers levelsConf, const eQueue queue, const std::size_t size)
+        : BaseLogger(name, std::move(levelsConf)) {
+        start(queue, size);
+    }
+
+    AsyncLogger::~AsyncLogger() noexcept {
+        try {
+            {
+                std::lock_guard<std::mutex> lock(mMutex);
+                mStop = true;
+                mWake.notify_one();
+            }
+            if (mThread.joinable()) {
+                mThread.join();
+            }
+        }
+        catch (const std::exception & e) {
+            std::cerr << colorize::red << e.what() << " [" << __STS_FUNC_NAME__ << "]" << colorize::reset << std::endl;
+        }
+        catch (...) {
+            std::cerr << colorize::red << "unknown exception [" << __STS_FUNC_NAME__ << "]" << colorize::reset << std::endl;
+        }
+    }
+
+    void AsyncLogger::start(const eQueue queue, const std::size_t size) {
+        if (queue == QueuePerThread) {
+            mRings.reset(new internal::ThreadRings(size));
+        }
+        else {
+            mQueue.reset(new internal::AsyncQueue(size));
+        }
+        mThread = std::thread(&AsyncLogger::run, this);
+        mThreadId = mThread.get_id();
+    }
+
+    /**************************************************************************************************/
+    //////////////////////////////////////////* Functions */////////////////////////////////////////////
+    /**************************************************************************************************/
+
+    std::size_t AsyncLogger::queueSize() const noexcept {
+        return mRings ? mRings->records() : mQueue->size();
+    }
+
+    std::size_t AsyncLogger::queueCapacity() const noexcept {
+        return mRings ? mRings->ringCapacity() : mQueue->capacity();
+    }
+
+    std::size_t AsyncLogger::dropped(const eOverflow policy) const noexcept {
+        switch (policy) {
+            case OverflowDropNewest: return mDroppedNewest.load(std::memory_order_relaxed);
+            case OverflowDropOldest: return mDroppedOldest.load(std::memory_order_relaxed);
+            case OverflowDropBelowLevel: return mDroppedBelowLevel.load(std::memory_order_relaxed);
+            case OverflowBlock: break;
+        }
+        return 0;
+    }
+
+    /**************************************************************************************************/
+    //////////////////////////////////////////* Functions */////////////////////////////////////////////
+    /**************************************************************************************************/
+
+    void AsyncLogger::log(const LogMsg & logMsg) const {
+        if (!isEnabled(logMsg.mLevel)) {
+            return;
+        }
+        if (std::this_thread::get_id() == mThreadId) {
+            BaseLogger::log(logMsg);
+            return;
+        }
+        const TimeSource::Stamp time = logMsg.mTime == 0 ? TimeSource::capture() : TimeSource::Stamp{logMsg.mTime, false};
+        if (mRings) {
+            pushLocal(logMsg, time);
+        }
+        else {
+            push(logMsg, time);
+        }
+        // pairs with the fence in run(), either the worker sees the message or we see that it sleeps.
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (mSleeping.load(std::memory_order_relaxed)) {
+            wake();
+        }
+    }
+
+    bool AsyncLogger::overflow(const LogMsg & logMsg) const noexcept {
+        switch (mOverflow.load(std::memory_order_relaxed)) {
+            case OverflowDropNewest:
+            case OverflowDropOldest: {
+                // only the shared queue can drop the oldest message, see push().
+                mDroppedNewest.fetch_add(1, std::memory_order_relaxed);
+                return true;
+            }
+            case OverflowDropBelowLevel: {
+                if (logMsg.mLevel > mKeepLevel.load(std::memory_order_relaxed)) {
+                    mDroppedBelowLevel.fetch_add(1, std::memory_order_relaxed);
+                    return true;
+                }
+                return false;
+            }
+            case OverflowBlock: break;
+        }
+        return false;
+    }
+
+    void AsyncLogger::push(const LogMsg & logMsg, const TimeSource::Stamp & time) const {
+        if (mQueue->tryPush(logMsg, time)) {
+            return;
+        }
+        if (mOverflow.load(std::memory_order_relaxed) == OverflowDropOldest) {
+            // The queue can be full with fewer messages than cells while the worker is copying the oldest one
+            // out of its cell, discarding the others doesn't free the needed cell then.
+            if (mQueue->size() >= mQueue->capacity() && mQueue->tryDiscard()) {
+                mDroppedOldest.fetch_add(1, std::memory_order_relaxed);
+                if (mQueue->tryPush(logMsg, time)) {
+                    return;
+                }
+            }
+            wake();
+            if (!mQueue->tryPush(logMsg, time)) {
+                mDroppedNewest.fetch_add(1, std::memory_order_relaxed);
+            }
+            return;
+        }
+        if (overflow(logMsg)) {
+            return;
+        }
+        do {
+            wake();
+            std::this_thread::yield();
+        } while (!mQueue->tryPush(logMsg, time));
+    }
+
+    void AsyncLogger::pushLocal(const LogMsg & logMsg, const TimeSource::Stamp & time) const {
+        internal::SpscRing & ring = mRings->local();
+        RecordHeader header;
+        header.mTime = time.mValue;
+        header.mTicks = time.mTicks ? 1 : 0;
+        header.mLevel = logMsg.mLevel;
+        header.mLine = logMsg.mCodeLocation.mLine;
+        header.mCategorySize = std::uint32_t(logMsg.mCategory.size());
+        header.mMsgSize = std::uint32_t(logMsg.mMsg.size());
+        header.mFunctionSize = std::uint32_t(logMsg.mCodeLocation.mFunction.size());
+        header.mFileSize = std::uint32_t(logMsg.mCodeLocation.mFile.size());
+        std::size_t size = sizeof(header) + header.mCategorySize + header.mMsgSize + header.mFunctionSize + header.mFileSize;
+        if (size > ring.maxRecordSize()) {
+            // the message text is cut to fit the buffer.
+            const std::size_t excess = std::min(size - ring.maxRecordSize(), std::size_t(header.mMsgSize));
+            header.mMsgSize -= std::uint32_t(excess);
+            size -= excess;
+            if (size > ring.maxRecordSize()) {
+                return;
+            }
+        }
+        char * out = ring.tryReserve(size);
+        if (!out) {
+            if (overflow(logMsg)) {
+                return;
+            }
+            do {
+                wake();
+                std::this_thread::yield();
+            } while (!(out = ring.tryReserve(size)));
+        }
+        std::memcpy(out, &header, sizeof(header));
+        out += sizeof(header);
+        std::memcpy(out, logMsg.mCategory.data(), header.mCategorySize);
+        out += header.mCategorySize;
+        std::memcpy(out, logMsg.mMsg.data(), header.mMsgSize);
+        out += header.mMsgSize;
+        std::memcpy(out, logMsg.mCodeLocation.mFunction.data(), header.mFunctionSize);
+        out += header.mFunctionSize;
+        std::memcpy(out, logMsg.mCodeLocation.mFile.data(), header.mFileSize);
+        ring.commit();
+    }
+
+    /**************************************************************************************************/
+    //////////////////////////////////////////* Functions */////////////////////////////////////////////
+    /**************************************************************************************************/
+
+    void AsyncLogger::flush() const noexcept {
+        if (std::this_thread::get_id() == mThreadId) {
+            return;
+        }
+        try {
+            std::unique_lock<std::mutex> lock(mMutex);
+            ++mFlushWaiters;
+            if (mRings) {
+                const std::uint64_t ticket = mFlushRequested.fetch_add(1) + 1;
+                mWake.notify_one();
+                mFlushed.wait(lock, [&]() { return mFlushDone >= ticket || mStop; });
+            }
+            else {
+                const std::size_t target = mQueue->pushed();
+                mWake.notify_one();
+                mFlushed.wait(lock, [&]() { return mQueue->released() >= target || mStop; });
+            }
+            --mFlushWaiters;
+            lock.unlock();
+            flushStreams();
+        }
+        catch (const std::exception & e) {
+            std::cerr << colorize::red << e.what() << " [" << __STS_FUNC_NAME__ << "]" << colorize::reset << std::endl;
+        }
+        catch (...) {
+            std::cerr << colorize::red << "unknown exception [" << __STS_FUNC_NAME__ << "]" << colorize::reset << std::endl;
+        }
+    }
+
+    void AsyncLogger::wake() const noexcept {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mWake.notify_one();
+    }
+
+    bool AsyncLogger::hasQueued() const noexcept {
+        return queueSize() != 0;
+    }
+
+    /**************************************************************************************************/
+    //////////////////////////////////////////* Functions */////////////////////////////////////////////
+    /**************************************************************************************************/
+
+    void AsyncLogger::run() noexcept {
+        MergeState state;
+        mLastDropReport = std::chrono::steady_clock::now();
+        for (;;) {
+            const std::uint64_t ticket = mFlushRequested.load(std::memory_order_acquire);
+            const std::size_t handled = mRings ? handleRings(state) : handleQueue();
+            reportDropped(std::chrono::steady_clock::now(), false);
+            if (mFlushWaiters.load(std::memory_order_relaxed) != 0) {
+                std::lock_guard<std::mutex> lock(mMutex);
+                mFlushDone = ticket;
+                mFlushed.notify_all();
+            }
+            if (handled != 0) {
+                continue;
+            }
+            if (hasQueued()) {
+                // a producer has taken a place but hasn't finished copying yet.
+                std::this_thread::yield();
+                continue;
+            }
+            std::unique_lock<std::mutex> lock(mMutex);
+            if (mFlushWaiters.load(std::memory_order_relaxed) != 0) {
+                mFlushDone = ticket;
+                mFlushed.notify_all();
+            }
+            if (mStop) {
+                reportDropped(std::chrono::steady_clock::now(), true);
+                mFlushed.notify_all();
+                break;
+            }
+            mSleeping.store(true, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (!hasQueued() && mFlushRequested.load(std::memory_order_relaxed) == ticket) {
+                mWake.wait_for(lock, std::chrono::milliseconds(100));
+            }
+            mSleeping.store(false, std::memory_order_relaxed);
+        }
+    }
+
+    std::size_t AsyncLogger::handleQueue() noexcept {
+        // The message is copied out of the queue before it is handled, so its cell is free
+        // while a slow handler runs and the producers can drop the oldest messages.
+        internal::LogRecord record;
+        bool copied = false;
+        const auto copy = [&](const internal::LogRecord & queued) {
+            try {
+                record.assign(queued.logMsg(), queued.time());
+                copied = true;
+            }
+            catch (const std::exception & e) {
+                std::cerr << colorize::red << e.what() << " [" << __STS_FUNC_NAME__ << "]" << colorize::reset << std::endl;
+            }
+            catch (...) {
+                std::cerr << colorize::red << "unknown exception [" << __STS_FUNC_NAME__ << "]" << colorize::reset << std::endl;
+            }
+        };
+        std::size_t handled = 0;
+        while (mQueue->tryPop(copy)) {
+            ++handled;
+            if (!copied) {
+                continue;
+            }
+            copied = false;
+            try {
+                BaseLogger::log(record.logMsg());
+            }
+            catch (const std::exception & e) {
+                std::cerr << colorize::red << e.what() << " [" << __STS_FUNC_NAME__ << "]" << colorize::reset << std::endl;
+            }
+            catch (...) {
+                std::cerr << colorize::red << "unknown exception [" << __STS_FUNC_NAME__ << "]" << colorize::reset << std::endl;
+            }
+        }
+        return handled;
+    }
+
+    std::size_t AsyncLogger::handleRings(MergeState & state) noexcept {
+        typedef std::greater<MergeState::Entry> Order; // min-heap by time
+        std::size_t handled = 0;
+        try {
+            mRings->snapshot(state.mRings, state.mVersion);
+            state.mLimits.resize(state.mRings.size());
+            state.mHeap.clear();
+            state.mHeap.reserve(state.mRings.size());
+        }
+        catch (...) {
+            return 0;
+        }
+        // Only the records that are in the buffers at the moment are merged,
+        // the new ones will be merged in the next pass.
+        for (std::size_t i = 0; i < state.mRings.size(); ++i) {
+            internal::SpscRing & ring = *state.mRings[i];
+            state.mLimits[i] = ring.committed();
+            std::size_t size = 0;
+            if (ring.consumed() < state.mLimits[i]) {
+                if (const char * record = ring.front(size)) {
+                    state.mHeap.emplace_back(recordTime(record), i);
+                }
+            }
+        }
+        std::make_heap(state.mHeap.begin(), state.mHeap.end(), Order());
+        while (!state.mHeap.empty()) {
+            std::pop_heap(state.mHeap.begin(), state.mHeap.end(), Order());
+            const std::int64_t time = state.mHeap.back().first;
+            const std::size_t index = state.mHeap.back().second;
+            state.mHeap.pop_back();
+            internal::SpscRing & ring = *state.mRings[index];
+
+            std::size_t size = 0;
+            const char * record = ring.front(size);
+            RecordHeader header;
+            std::memcpy(&header, record, sizeof(header));
+            const char * text = record + sizeof(header);
+            const StringView category(text, header.mCategorySize);
+            text += header.mCategorySize;
+            const StringView msg(text, header.mMsgSize);
+            text += header.mMsgSize;
+            const StringView function(text, header.mFunctionSize);
+            text += header.mFunctionSize;
+            const StringView file(text, header.mFileSize);
+            LogMsg logMsg(std::size_t(header.mLevel), category, msg, CodeLocation(function, file, header.mLine));
+            logMsg.mTime = time;
+            try {
+                BaseLogger::log(logMsg);
+            }
+            catch (const std::exception & e) {
+                std::cerr << colorize::red << e.what() << " [" << __STS_FUNC_NAME__ << "]" << colorize::reset << std::endl;
+            }
+            catch (...) {
+                std::cerr << colorize::red << "unknown exception [" << __STS_FUNC_NAME__ << "]" << colorize::reset << std::endl;
+            }
+            ring.pop();
+            ++handled;
+
+            if (ring.consumed() < state.mLimits[index]) {
+                if ((record = ring.front(size))) {
+                    state.mHeap.emplace_back(recordTime(record), index);
+                    std::push_heap(state.mHeap.begin(), state.mHeap.end(), Order());
+                }
+            }
+        }
+        mRings->collect();
+        return handled;
+    }
+
+    /**************************************************************************************************/
+    //////////////////////////////////////////* Functions */////////////////////////////////////////////
+    /**************************************************************************************************/
+
+    void AsyncLogger::reportDropped(const std::chrono::steady_clock::time_point now, const bool force) noexcept {
+        const auto interval = mDropReportInterval.load(std::memory_order_relaxed);
+        if (interval <= 0 || (!force && now - mLastDropReport < std::chrono::milliseconds(interval))) {
+            return;
+        }
+        mLastDropReport = now;
+        const std::size_t newest = mDroppedNewest.load(std::memory_order_relaxed);
+        const std::size_t oldest = mDroppedOldest.load(std::memory_order_relaxed);
+        const std::size_t belowLevel = mDroppedBelowLevel.load(std::memory_order_relaxed);
+        const std::size_t total = newest + oldest + belowLevel;
+        if (total == mReportedDrops) {
+            return;
+        }
+        try {
+            const std::string text = std::string("the queue is full, dropped ")
+                                     .append(std::to_string(total - mReportedDrops))
+                                     .append(" messages (total: newest ").append(std::to_string(newest))
+                                     .append(", oldest ").append(std::to_string(oldest))
+                                     .append(", below level ").append(std::to_string(belowLevel))
+                                     .append(")");
+            mReportedDrops = total;
+            LogMsg logMsg(LvlWarning, "AsyncLogger", text, CodeLocation());
+            logMsg.mTime = TimeSource::now();
+            BaseLogger::log(logMsg);
+        }
+        catch (const std::exception & e) {
+            std::cerr << colorize::red << e.what() << " [" << __STS_FUNC_NAME__ << "]" << colorize::reset << std::endl;
+        }
+        catch (...) {
+            std::cerr << colorize::red << "unknown exception [" << __STS_FUNC_NAME__ << "]" << colorize::reset << std::endl;
+        }
+    }
+
+    /**************************************************************************************************/
+    ////////////////////////////////////////////////////////////////////////////////////////////////////
+    /**************************************************************************************************/
+
+}
+}
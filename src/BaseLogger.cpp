@@ -30,63 +30,264 @@
 
 #include "stdafx.h"
 
-#include <ctime>
 #include <algorithm>
+#include <ctime>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
 #include "stsff/logging/BaseLogger.h"
+#include "stsff/logging/FlightRecorder.h"
+#include "stsff/logging/internal/MessageBuffer.h"
 #include "stsff/logging/utils/Colorize.h"
 
 namespace stsff {
 namespace logging {
 
+    namespace {
+
+        const std::size_t TimeStampCacheEntries = 4;
+        const std::size_t TimeStampCacheStringSize = 100;
+        const std::size_t TimeStampMaxFractions = 4;
+
+        /*!
+         * \details All the time zone offsets and their changes are aligned to 15 minutes,
+         *          so the local time of any second can be got from the local time of its interval
+         *          without the time zone database.
+         */
+        const std::time_t LocalTimeInterval = 15 * 60;
+
+        /*!
+         * \details The windows console colors are set with the API calls on the stream,
+         *          other systems use the escape sequences that can be written into the text.
+         */
+#if defined(_WIN32) || defined(_WIN64)
+        const bool InlineColors = false;
+#else
+        const bool InlineColors = true;
+#endif
+
+        const std::size_t StreamMutexCount = 16;
+
+        /*!
+         * \details The streams are locked by the mutexes chosen by their addresses,
+         *          so any stream can be locked without registering it.
+         */
+        std::mutex & streamMutex(const std::ostream & stream) noexcept {
+            static std::mutex mutexes[StreamMutexCount];
+            return mutexes[(reinterpret_cast<std::uintptr_t>(&stream) >> 4) % StreamMutexCount];
+        }
+
+        void flushStandardStreams() {
+            std::ostream * streams[] = {&std::clog, &std::cout, &std::cerr};
+            for (std::ostream * stream : streams) {
+                std::lock_guard<std::mutex> lock(streamMutex(*stream));
+                stream->flush();
+            }
+        }
+
+        /*!
+         * \details Marks the thread's buffer as used while a message is rendered into it.
+         */
+        class BufferGuard final {
+        public:
+
+            BufferGuard(internal::MessageBuffer & buffer, bool & busy) noexcept
+                : mBusy(busy),
+                  mWasBusy(busy) {
+                buffer.clear();
+                mBusy = true;
+            }
+
+            BufferGuard(const BufferGuard &) = delete;
+            BufferGuard & operator=(const BufferGuard &) = delete;
+
+            ~BufferGuard() noexcept {
+                mBusy = mWasBusy;
+            }
+
+        private:
+
+            bool & mBusy;
+            const bool mWasBusy;
+
+        };
+
+        /*!
+         * \details Writes the escape sequences of the color manipulators into the buffer.
+         *          The thread's message stream is borrowed only for the custom manipulators.
+         */
+        class ColorWriter final {
+        public:
+
+            ColorWriter(internal::MessageBuffer & buffer, const bool enabled) noexcept
+                : mBuffer(buffer),
+                  mEnabled(enabled) {}
+
+            ColorWriter(const ColorWriter &) = delete;
+            ColorWriter & operator=(const ColorWriter &) = delete;
+
+            ~ColorWriter() noexcept {
+                finish();
+            }
+
+            void write(const BaseLogger::ColorFn color) {
+                if (!mEnabled || !color) {
+                    return;
+                }
+                const colorize::StringView sequence = colorize::escapeSequence(color);
+                if (!sequence.empty()) {
+                    colorize::appendColor(mBuffer, sequence, true);
+                    return;
+                }
+                if (!mStream) {
+                    mStream = internal::acquireMessageStream(mBuffer);
+                    colorize::colorized(internal::messageOstream(mStream));
+                }
+                color(internal::messageOstream(mStream));
+            }
+
+            void finish() noexcept {
+                if (mStream) {
+                    colorize::nocolorized(internal::messageOstream(mStream));
+                    internal::releaseMessageStream(mStream);
+                    mStream = nullptr;
+                }
+            }
+
+        private:
+
+            internal::MessageBuffer & mBuffer;
+            internal::MessageStream * mStream = nullptr;
+            const bool mEnabled;
+
+        };
+
+        void platformLocalTime(const std::time_t second, tm & out) noexcept {
+#ifdef _MSC_VER
+            localtime_s(&out, &second);
+#else
+            localtime_r(&second, &out);
+#endif
+        }
+
+        void localTime(const std::time_t second, tm & out) noexcept {
+            thread_local std::time_t intervalStart = 1;
+            thread_local tm interval = {};
+            thread_local bool aligned = false;
+            //-------------------
+            std::time_t start = second - second % LocalTimeInterval;
+            if (start > second) {
+                start -= LocalTimeInterval;
+            }
+            if (start != intervalStart) {
+                intervalStart = start;
+                platformLocalTime(start, interval);
+                aligned = interval.tm_sec == 0 && interval.tm_min % 15 == 0;
+            }
+            if (!aligned) {
+                // e.g. local mean time of the old dates.
+                platformLocalTime(second, out);
+                return;
+            }
+            const int offset = int(second - start);
+            out = interval;
+            out.tm_min += offset / 60;
+            out.tm_sec = offset % 60;
+        }
+
+        /*!
+         * \details Checks whether the format has \%3N, \%6N or \%9N command at the position.
+         * \return Number of the digits or 0.
+         */
+        std::size_t fractionDigits(const char * format) noexcept {
+            if (format[0] != '%' || format[1] == '\0' || format[2] != 'N') {
+                return 0;
+            }
+            switch (format[1]) {
+                case '3': return 3;
+                case '6': return 6;
+                case '9': return 9;
+                default: return 0;
+            }
+        }
+
+        void writeFraction(char * out, const std::size_t digits, std::int64_t nanoseconds) noexcept {
+            for (std::size_t i = digits; i < 9; ++i) {
+                nanoseconds /= 10;
+            }
+            for (std::size_t i = digits; i > 0; --i) {
+                out[i - 1] = char('0' + nanoseconds % 10);
+                nanoseconds /= 10;
+            }
+        }
+
+    }
+
     /**************************************************************************************************/
     ////////////////////////////////////* Constructors/Destructor */////////////////////////////////////
     /**************************************************************************************************/
 
-    ///! [setup handlers]
     BaseLogger::BaseLogger(const StringView name) noexcept
-        : BaseLogger(name, {
+        : mHandlers(defaultHandlers()),
+          mCategory(name.data(), name.size()) { }
+
+    //-------------------------------------------------------------------------
+
+    ///! [setup handlers]
+    const std::shared_ptr<BaseLogger::HandlerSet> & BaseLogger::defaultHandlers() noexcept {
+        static const std::shared_ptr<HandlerSet> handlers = std::make_shared<HandlerSet>(LevelHandlers{
                 {
-                    LvlDebug, [](const BaseLogger & l, const LogMsg & m) {
-                        defaultHandler(l, m, std::clog, "DBG: %LN %MC %MS", colorize::magenta);
+                    LvlDebug, +[](const BaseLogger & l, const LogMsg & m) {
+                        static const FormatPattern pattern("DBG: %LN %MC %MS");
+                        defaultHandler(l, m, std::clog, pattern, colorize::magenta);
                     }
                 },
                 {
-                    LvlMsg, [](const BaseLogger & l, const LogMsg & m) {
-                        defaultHandler(l, m, std::clog, "--  %LN %MC %MS", nullptr);
+                    LvlMsg, +[](const BaseLogger & l, const LogMsg & m) {
+                        static const FormatPattern pattern("--  %LN %MC %MS");
+                        defaultHandler(l, m, std::clog, pattern, nullptr);
                     }
 
                 },
                 {
-                    LvlInfo, [](const BaseLogger & l, const LogMsg & m) {
-                        defaultHandler(l, m, std::clog, "INF: %LN %MC %MS", colorize::cyan);
+                    LvlInfo, +[](const BaseLogger & l, const LogMsg & m) {
+                        static const FormatPattern pattern("INF: %LN %MC %MS");
+                        defaultHandler(l, m, std::clog, pattern, colorize::cyan);
                     }
                 },
                 {
-                    LvlSuccess, [](const BaseLogger & l, const LogMsg & m) {
-                        defaultHandler(l, m, std::clog, "INF: %LN %MC %MS | OK", colorize::green);
+                    LvlSuccess, +[](const BaseLogger & l, const LogMsg & m) {
+                        static const FormatPattern pattern("INF: %LN %MC %MS | OK");
+                        defaultHandler(l, m, std::clog, pattern, colorize::green);
                     }
                 },
                 {
-                    LvlWarning, [](const BaseLogger & l, const LogMsg & m) {
-                        defaultHandler(l, m, std::clog, "WRN: %LN %MC %MS", colorize::yellow);
+                    LvlWarning, +[](const BaseLogger & l, const LogMsg & m) {
+                        static const FormatPattern pattern("WRN: %LN %MC %MS");
+                        defaultHandler(l, m, std::clog, pattern, colorize::yellow);
                     }
                 },
                 {
-                    LvlFail, [](const BaseLogger & l, const LogMsg & m) {
-                        defaultHandler(l, m, std::cerr, "ERR: %LN %MC %MS | FAIL\n\t[%TM(%Y-%m-%d] [%T)] [%FN -> %FI(%LI)]", colorize::red);
+                    LvlFail, +[](const BaseLogger & l, const LogMsg & m) {
+                        static const FormatPattern pattern("ERR: %LN %MC %MS | FAIL\n\t[%TM(%Y-%m-%d] [%T)] [%FN -> %FI(%LI)]");
+                        defaultHandler(l, m, std::cerr, pattern, colorize::red);
                     }
                 },
                 {
-                    LvlError, [](const BaseLogger & l, const LogMsg & m) {
-                        defaultHandler(l, m, std::cerr, "ERR: %LN %MC %MS \n\t[%TM(%Y-%m-%d] [%T)] [%FN -> %FI(%LI)]", colorize::red);
+                    LvlError, +[](const BaseLogger & l, const LogMsg & m) {
+                        static const FormatPattern pattern("ERR: %LN %MC %MS \n\t[%TM(%Y-%m-%d] [%T)] [%FN -> %FI(%LI)]");
+                        defaultHandler(l, m, std::cerr, pattern, colorize::red);
                     }
                 },
                 {
-                    LvlCritical, [](const BaseLogger & l, const LogMsg & m) {
-                        defaultHandler(l, m, std::cerr, "ERR: %LN %MC %MS \n\t[%TM(%Y-%m-%d] [%T)] [%FN -> %FI(%LI)]", colorize::red);
+                    LvlCritical, +[](const BaseLogger & l, const LogMsg & m) {
+                        static const FormatPattern pattern("ERR: %LN %MC %MS \n\t[%TM(%Y-%m-%d] [%T)] [%FN -> %FI(%LI)]");
+                        defaultHandler(l, m, std::cerr, pattern, colorize::red);
                     }
                 },
-        }) { }
+        });
+        return handlers;
+    }
 
     ///! [setup handlers]
 
@@ -94,7 +295,9 @@ namespace logging {
 
     BaseLogger::~BaseLogger() noexcept {
         try {
-            std::clog.flush();
+            if (mFlush.reset()) {
+                flushStandardStreams();
+            }
         }
         catch (const std::exception & e) {
             std::cerr << colorize::red << e.what() << " [" << __STS_FUNC_NAME__ << "]" << colorize::reset << std::endl;
@@ -109,189 +312,560 @@ namespace logging {
     /**************************************************************************************************/
 
     void BaseLogger::log(const LogMsg & logMsg) const {
-        if (logMsg.mLevel <= mLevel) {
-            const auto it = mLevels.find(logMsg.mLevel);
-            if (it != mLevels.end()) {
+        if (logMsg.mLevel <= mLevel.load(std::memory_order_relaxed)) {
+            const HandlerSnapshot::Reader reader(mHandlers);
+            const HandlerSet & handlers = *reader;
+            if (handlers.mRecorder && logMsg.mLevel <= handlers.mTriggerLevel) {
+                handlers.mRecorder->dump([&](const LogMsg & recorded) {
+                    dispatch(handlers, recorded);
+                });
+            }
+            dispatch(handlers, logMsg);
+        }
+        else if (logMsg.mLevel <= mCaptureLevel.load(std::memory_order_relaxed)) {
+            const HandlerSnapshot::Reader reader(mHandlers);
+            if (reader->mRecorder) {
+                reader->mRecorder->capture(logMsg);
+            }
+        }
+    }
+
+    void BaseLogger::dispatch(const HandlerSet & handlers, const LogMsg & logMsg) const {
+        const HandlerTable::Entry * entry = nullptr;
+        if (handlers.mTable.find(logMsg.mLevel, handlers.mLevels, entry)) {
+            if (entry) {
+                if (entry->mRaw) {
+                    entry->mRaw(*this, logMsg);
+                }
+                else {
+                    entry->mHandler(*this, logMsg);
+                }
+                return;
+            }
+        }
+        else {
+            const auto it = handlers.mLevels.find(logMsg.mLevel);
+            if (it != handlers.mLevels.end()) {
                 it->second(*this, logMsg);
+                return;
             }
-            else {
-                const auto formatting = std::string("LVL(")
-                                        .append(std::to_string(logMsg.mLevel))
-                                        .append("): %LN %MC %MS \n\t[%FN -> %FI(%LI)]");
-                defaultHandler(*this, logMsg, std::cout, formatting, colorize::yellow);
+        }
+        static const FormatPattern unknownLevel("LVL(%LV): %LN %MC %MS \n\t[%FN -> %FI(%LI)]");
+        defaultHandler(*this, logMsg, std::cout, unknownLevel, colorize::yellow);
+    }
+
+    /**************************************************************************************************/
+    //////////////////////////////////////////* Functions */////////////////////////////////////////////
+    /**************************************************************************************************/
+
+    void BaseLogger::setFlightRecorder(std::shared_ptr<FlightRecorder> recorder, const std::size_t captureLevel,
+                                       const std::size_t triggerLevel) noexcept {
+        try {
+            const std::size_t capture = recorder ? captureLevel : 0;
+            // the messages aren't captured while there is no recorder in the published set.
+            mCaptureLevel.store(0, std::memory_order_relaxed);
+            mHandlers.update([&](HandlerSet & set) {
+                set.mRecorder = std::move(recorder);
+                set.mTriggerLevel = triggerLevel;
+            });
+            mCaptureLevel.store(capture, std::memory_order_relaxed);
+        }
+        catch (const std::exception & e) {
+            std::cerr << colorize::red << e.what() << " [" << __STS_FUNC_NAME__ << "]" << colorize::reset << std::endl;
+        }
+        catch (...) {
+            std::cerr << colorize::red << "unknown exception [" << __STS_FUNC_NAME__ << "]" << colorize::reset << std::endl;
+        }
+    }
+
+    std::shared_ptr<FlightRecorder> BaseLogger::flightRecorder() const noexcept {
+        const HandlerSnapshot::Reader reader(mHandlers);
+        return reader->mRecorder;
+    }
+
+    std::size_t BaseLogger::dumpFlightRecorder() const noexcept {
+        try {
+            const HandlerSnapshot::Reader reader(mHandlers);
+            const HandlerSet & handlers = *reader;
+            if (handlers.mRecorder) {
+                return handlers.mRecorder->dump([&](const LogMsg & recorded) {
+                    dispatch(handlers, recorded);
+                });
             }
         }
+        catch (const std::exception & e) {
+            std::cerr << colorize::red << e.what() << " [" << __STS_FUNC_NAME__ << "]" << colorize::reset << std::endl;
+        }
+        catch (...) {
+            std::cerr << colorize::red << "unknown exception [" << __STS_FUNC_NAME__ << "]" << colorize::reset << std::endl;
+        }
+        return 0;
     }
 
     /**************************************************************************************************/
     //////////////////////////////////////////* Functions */////////////////////////////////////////////
     /**************************************************************************************************/
 
+    void BaseLogger::setFlushPolicy(const FlushPolicy & policy) noexcept {
+        mFlush.store(policy);
+    }
+
+    BaseLogger::FlushPolicy BaseLogger::flushPolicy() const noexcept {
+        return mFlush.load();
+    }
+
+    bool BaseLogger::flushRequired(const std::size_t level) const noexcept {
+        return mFlush.required(level);
+    }
+
+    void BaseLogger::flushStreams() const noexcept {
+        try {
+            mFlush.reset();
+            flushStandardStreams();
+        }
+        catch (const std::exception & e) {
+            std::cerr << colorize::red << e.what() << " [" << __STS_FUNC_NAME__ << "]" << colorize::reset << std::endl;
+        }
+        catch (...) {
+            std::cerr << colorize::red << "unknown exception [" << __STS_FUNC_NAME__ << "]" << colorize::reset << std::endl;
+        }
+    }
+
+    //-------------------------------------------------------------------------
+
     void BaseLogger::setHandler(const std::size_t level, const LevelHandler & handler) noexcept {
-        const auto it = mLevels.find(level);
-        if (it != mLevels.end()) {
-            it->second = handler;
+        try {
+            mHandlers.update([&](HandlerSet & set) {
+                set.mLevels[level] = handler;
+            });
         }
-        else {
-            mLevels.emplace(level, handler);
+        catch (const std::exception & e) {
+            std::cerr << colorize::red << e.what() << " [" << __STS_FUNC_NAME__ << "]" << colorize::reset << std::endl;
+        }
+        catch (...) {
+            std::cerr << colorize::red << "unknown exception [" << __STS_FUNC_NAME__ << "]" << colorize::reset << std::endl;
         }
     }
 
+    BaseLogger::LevelHandlers & BaseLogger::handlers() noexcept {
+        try {
+            HandlerSet & handlers = mHandlers.own();
+            handlers.mTable.detach();
+            return handlers.mLevels;
+        }
+        catch (const std::exception & e) {
+            std::cerr << colorize::red << e.what() << " [" << __STS_FUNC_NAME__ << "]" << colorize::reset << std::endl;
+        }
+        catch (...) {
+            std::cerr << colorize::red << "unknown exception [" << __STS_FUNC_NAME__ << "]" << colorize::reset << std::endl;
+        }
+        // the shared handlers are returned if they can't be copied.
+        HandlerSet & handlers = const_cast<HandlerSet &>(mHandlers.current());
+        handlers.mTable.detach();
+        return handlers.mLevels;
+    }
+
     /**************************************************************************************************/
     //////////////////////////////////////////* Functions */////////////////////////////////////////////
     /**************************************************************************************************/
 
-    void BaseLogger::defaultHandler(const BaseLogger & logger, const LogMsg & logMsg, std::ostream & stream,
-                                    const std::string & formatting, const ColorFn color) {
-
-        const std::uint32_t time = ('T' << 8) | 'M';
-        const std::uint32_t logCategory = ('L' << 8) | 'N';
-        const std::uint32_t messageCategory = ('M' << 8) | 'C';
-        const std::uint32_t message = ('M' << 8) | 'S';
-        const std::uint32_t functionName = ('F' << 8) | 'N';
-        const std::uint32_t fileName = ('F' << 8) | 'I';
-        const std::uint32_t fileLineNum = ('L' << 8) | 'I';
+    BaseLogger::HandlerSnapshot::HandlerSnapshot(const HandlerSnapshot & other) {
+        std::lock_guard<std::mutex> lock(other.mWriteMutex);
+        mOwner = other.mOwner;
+        mCurrent.store(mOwner.get(), std::memory_order_release);
+    }
 
-        if (color) {
-            color(stream);
+    BaseLogger::HandlerSnapshot & BaseLogger::HandlerSnapshot::operator=(const HandlerSnapshot & other) {
+        if (this != &other) {
+            std::shared_ptr<HandlerSet> set;
+            {
+                std::lock_guard<std::mutex> lock(other.mWriteMutex);
+                set = other.mOwner;
+            }
+            std::lock_guard<std::mutex> lock(mWriteMutex);
+            publish(std::move(set));
         }
+        return *this;
+    }
 
-        bool process = false;
-        auto ch = formatting.begin();
+    BaseLogger::HandlerSet & BaseLogger::HandlerSnapshot::own() {
+        std::lock_guard<std::mutex> lock(mWriteMutex);
+        if (mOwner.use_count() != 1) {
+            publish(std::make_shared<HandlerSet>(*mOwner));
+        }
+        return *mOwner;
+    }
 
-        while (ch != formatting.end()) {
-            if (*ch == '%') {
-                process = true;
-                ++ch;
-                continue;
+    void BaseLogger::HandlerSnapshot::publish(std::shared_ptr<HandlerSet> set) {
+        mRetired.reserve(mRetired.size() + 1);
+        mCurrent.store(set.get(), std::memory_order_seq_cst);
+        mRetired.emplace_back(mEpoch.load(std::memory_order_relaxed), std::move(mOwner));
+        mOwner = std::move(set);
+        // Each advance of the epoch requires the readers that registered in the other epoch to leave.
+        // The readers that loaded the retired set are registered in its epoch or in the previous one,
+        // so it isn't used after two advances.
+        for (int i = 0; i < 2; ++i) {
+            const std::uint64_t epoch = mEpoch.load(std::memory_order_relaxed);
+            if (mReaders[(epoch + 1) & 1].load(std::memory_order_seq_cst) != 0) {
+                break;
             }
-            if (!process) {
-                stream << *ch;
-                ++ch;
-                continue;
+            mEpoch.store(epoch + 1, std::memory_order_seq_cst);
+        }
+        const std::uint64_t epoch = mEpoch.load(std::memory_order_relaxed);
+        mRetired.erase(std::remove_if(mRetired.begin(), mRetired.end(),
+                                      [epoch](const std::pair<std::uint64_t, std::shared_ptr<HandlerSet>> & retired) {
+                                          return retired.first + 2 <= epoch;
+                                      }), mRetired.end());
+    }
+
+    /**************************************************************************************************/
+    //////////////////////////////////////////* Functions */////////////////////////////////////////////
+    /**************************************************************************************************/
+
+    BaseLogger::FlushPolicy BaseLogger::FlushControl::load() const noexcept {
+        FlushPolicy policy;
+        policy.mEveryMessages = mEveryMessages.load(std::memory_order_relaxed);
+        policy.mIntervalMs = mInterval.load(std::memory_order_relaxed) / 1000000;
+        policy.mLevel = mLevel.load(std::memory_order_relaxed);
+        return policy;
+    }
+
+    void BaseLogger::FlushControl::store(const FlushPolicy & policy) noexcept {
+        mLastFlush.store(policy.mIntervalMs > 0 ? TimeSource::now(TimeSource::ClockCoarse) : 0, std::memory_order_relaxed);
+        mEveryMessages.store(policy.mEveryMessages, std::memory_order_relaxed);
+        mInterval.store(policy.mIntervalMs > 0 ? policy.mIntervalMs * 1000000 : 0, std::memory_order_relaxed);
+        mLevel.store(policy.mLevel, std::memory_order_relaxed);
+    }
+
+    bool BaseLogger::FlushControl::required(const std::size_t level) noexcept {
+        const std::size_t everyMessages = mEveryMessages.load(std::memory_order_relaxed);
+        if (everyMessages == 1) {
+            return true;
+        }
+        if (level <= std::max<std::size_t>(mLevel.load(std::memory_order_relaxed), LvlCritical)) {
+            reset();
+            return true;
+        }
+        // The counters are shared by the threads without a lock,
+        // so the concurrent messages may be flushed a bit earlier or later than the policy says.
+        const std::size_t unflushed = mUnflushed.fetch_add(1, std::memory_order_relaxed) + 1;
+        if (everyMessages != 0 && unflushed >= everyMessages) {
+            reset();
+            return true;
+        }
+        const std::int64_t interval = mInterval.load(std::memory_order_relaxed);
+        if (interval != 0 &&
+            TimeSource::now(TimeSource::ClockCoarse) - mLastFlush.load(std::memory_order_relaxed) >= interval) {
+            reset();
+            return true;
+        }
+        return false;
+    }
+
+    bool BaseLogger::FlushControl::reset() noexcept {
+        if (mInterval.load(std::memory_order_relaxed) != 0) {
+            mLastFlush.store(TimeSource::now(TimeSource::ClockCoarse), std::memory_order_relaxed);
+        }
+        return mUnflushed.exchange(0, std::memory_order_relaxed) != 0;
+    }
+
+    /**************************************************************************************************/
+    //////////////////////////////////////////* Functions */////////////////////////////////////////////
+    /**************************************************************************************************/
+
+    bool BaseLogger::HandlerTable::rebuild(const LevelHandlers & levels) const noexcept {
+        int expected = Dirty;
+        if (!mState.compare_exchange_strong(expected, Building, std::memory_order_acquire)) {
+            return expected == Ready;
+        }
+        try {
+            for (auto & entry : mStandard) {
+                entry = Entry();
             }
-            process = false;
-            const auto second = ch + 1;
-            if (second == formatting.end()) {
-                stream << colorize::red
-                        << " unexpected end of formatting string after ["
-                        << *ch
-                        << "], expected the second command letter"
-                        << colorize::reset;
-                break;
+            mCustom.clear();
+            for (const auto & level : levels) {
+                Entry entry;
+                entry.mHandler = level.second;
+                const RawHandler * raw = level.second.target<RawHandler>();
+                entry.mRaw = raw ? *raw : nullptr;
+                if (level.first % 100 == 0 && level.first / 100 < StandardLevels) {
+                    mStandard[level.first / 100] = std::move(entry);
+                }
+                else {
+                    mCustom.emplace_back(level.first, std::move(entry));
+                }
             }
+            std::sort(mCustom.begin(), mCustom.end(), [](const std::pair<std::size_t, Entry> & left,
+                                                         const std::pair<std::size_t, Entry> & right) {
+                return left.first < right.first;
+            });
+            // the table may be invalidated while it is being built, then it stays dirty.
+            expected = Building;
+            return mState.compare_exchange_strong(expected, Ready, std::memory_order_release);
+        }
+        catch (const std::exception & e) {
+            std::cerr << colorize::red << e.what() << " [" << __STS_FUNC_NAME__ << "]" << colorize::reset << std::endl;
+        }
+        catch (...) {
+            std::cerr << colorize::red << "unknown exception [" << __STS_FUNC_NAME__ << "]" << colorize::reset << std::endl;
+        }
+        expected = Building;
+        mState.compare_exchange_strong(expected, Dirty, std::memory_order_release);
+        return false;
+    }
 
-            const std::uint32_t command = (*ch << 8) | *second;
-            ch = second + 1;
+    const BaseLogger::HandlerTable::Entry * BaseLogger::HandlerTable::findCustom(const std::size_t level) const noexcept {
+        const auto it = std::lower_bound(mCustom.begin(), mCustom.end(), level,
+                                         [](const std::pair<std::size_t, Entry> & entry, const std::size_t value) {
+                                             return entry.first < value;
+                                         });
+        if (it == mCustom.end() || it->first != level || !it->second.mHandler) {
+            return nullptr;
+        }
+        return &it->second;
+    }
 
-            switch (command) {
-                case logCategory: {
-                    if (!logger.mCategory.empty()) {
-                        stream.write(logger.mCategory.data(), logger.mCategory.size());
-                    }
+    /**************************************************************************************************/
+    //////////////////////////////////////////* Functions */////////////////////////////////////////////
+    /**************************************************************************************************/
+
+    void BaseLogger::defaultHandler(const BaseLogger & logger, const LogMsg & logMsg, std::ostream & stream,
+                                    const std::string & formatting, const ColorFn color) {
+        // The handlers usually pass the same string for each call, so the last parsed one is kept.
+        thread_local FormatPattern pattern;
+        if (pattern.formatting() != formatting) {
+            pattern = FormatPattern(formatting, FormatPattern::ErrorsInline);
+        }
+        defaultHandler(logger, logMsg, stream, pattern, color);
+    }
+
+    void BaseLogger::defaultHandler(const BaseLogger & logger, const LogMsg & logMsg, std::ostream & stream,
+                                    const FormatPattern & pattern, const ColorFn color) {
+        // The message is rendered completely and written with one call under the stream's lock,
+        // so the lines of the different threads are not mixed.
+        thread_local internal::MessageBuffer threadBuffer;
+        thread_local bool threadBufferBusy = false;
+        internal::MessageBuffer localBuffer;
+        internal::MessageBuffer & out = threadBufferBusy ? localBuffer : threadBuffer;
+        const BufferGuard guard(out, threadBufferBusy);
+
+        const bool colors = InlineColors && color && colorize::isColorized(stream);
+        ColorWriter colorWriter(out, colors);
+        colorWriter.write(color);
+        renderMessage(out, logger, logMsg, pattern,
+                      colors ? colorize::AnsiRed : colorize::StringView(),
+                      colors ? colorize::AnsiReset : colorize::StringView());
+        if (color) {
+            colorWriter.write(colorize::reset);
+        }
+        out.append('\n');
+        colorWriter.finish();
+
+        std::lock_guard<std::mutex> lock(streamMutex(stream));
+        const bool streamColors = !InlineColors && color;
+        if (streamColors) {
+            color(stream);
+        }
+        stream.write(out.data(), std::streamsize(out.size()));
+        if (streamColors) {
+            stream << colorize::reset;
+        }
+        if (logger.flushRequired(logMsg.mLevel)) {
+            stream.flush();
+        }
+    }
+
+    void BaseLogger::renderMessage(internal::MessageBuffer & out, const BaseLogger & logger, const LogMsg & logMsg,
+                                   const FormatPattern & pattern, const StringView errorPrefix, const StringView errorSuffix) {
+        for (const auto & token : pattern.tokens()) {
+            switch (token.mOp) {
+                case FormatPattern::OpLiteral: {
+                    const auto text = pattern.text(token);
+                    out.append(text.data(), text.size());
                     break;
                 }
-                case messageCategory: {
-                    if (!logMsg.mCategory.empty()) {
-                        stream.write(logMsg.mCategory.data(), logMsg.mCategory.size());
-                    }
+                case FormatPattern::OpError: {
+                    const auto text = pattern.text(token);
+                    out.append(errorPrefix.data(), errorPrefix.size());
+                    out.append(text.data(), text.size());
+                    out.append(errorSuffix.data(), errorSuffix.size());
                     break;
                 }
-                case message: {
-                    if (!logMsg.mMsg.empty()) {
-                        stream.write(logMsg.mMsg.data(), logMsg.mMsg.size());
-                    }
+                case FormatPattern::OpLevel: {
+                    out.commit(internal::FastFormat::formatUnsigned(out.reserve(internal::FastFormat::MaxUnsignedChars),
+                                                                    logMsg.mLevel));
                     break;
                 }
-                case functionName: {
-                    stream.write(logMsg.mCodeLocation.mFunction.data(), logMsg.mCodeLocation.mFunction.size());
+                case FormatPattern::OpLogName: {
+                    out.append(logger.mCategory.data(), logger.mCategory.size());
                     break;
                 }
-                case fileName: {
-                    stream.write(logMsg.mCodeLocation.mFile.data(), logMsg.mCodeLocation.mFile.size());
+                case FormatPattern::OpMessageCategory: {
+                    out.append(logMsg.mCategory.data(), logMsg.mCategory.size());
                     break;
                 }
-                case fileLineNum: {
-                    stream << logMsg.mCodeLocation.mLine;
+                case FormatPattern::OpMessage: {
+                    out.append(logMsg.mMsg.data(), logMsg.mMsg.size());
                     break;
                 }
-                case time: {
-                    if (ch == formatting.end()) {
-                        stream << colorize::red
-                                << " unexpected end of formatting string after the time command, expected '()'"
-                                << colorize::reset;
-                        break;
-                    }
-                    if (*ch != '(') {
-                        stream << colorize::red
-                                << " unexpected symbol " << *ch << " after time command, expected '('"
-                                << colorize::reset;
-                        ++ch;
-                        break;
-                    }
-                    ++ch; // skip '('
-                    std::size_t length = 0;
-                    auto endOfTimeFormat = std::find_if(ch, formatting.end(), [&](const char c) {
-                        ++length;
-                        return c == ')';
-                    });
-                    if (endOfTimeFormat == formatting.end()) {
-                        stream << colorize::red
-                                << " unexpected end of formatting string after the time command, missed ')'"
-                                << colorize::reset;
-                        break;
-                    }
-                    const std::string formattingTimeString(&*ch, length == 0 ? 0 : length - 1); // remove last ')' char
-                    ch = endOfTimeFormat;
-                    const auto t = timeStamp(formattingTimeString);
-                    stream << t;
-                    ++ch;
+                case FormatPattern::OpFunctionName: {
+                    out.append(logMsg.mCodeLocation.mFunction.data(), logMsg.mCodeLocation.mFunction.size());
+                    break;
+                }
+                case FormatPattern::OpFileName: {
+                    out.append(logMsg.mCodeLocation.mFile.data(), logMsg.mCodeLocation.mFile.size());
+                    break;
+                }
+                case FormatPattern::OpFileLine: {
+                    out.commit(internal::FastFormat::formatSigned(out.reserve(internal::FastFormat::MaxSignedChars),
+                                                                  logMsg.mCodeLocation.mLine));
                     break;
                 }
-                default: {
-                    stream << colorize::red
-                            << " unknown formatting command: [" << char(command >> 8) << char(command) << "]"
-                            << colorize::reset;
+                case FormatPattern::OpTime: {
+                    out.commit(timeStamp(out.reserve(TimeStampCacheStringSize), TimeStampCacheStringSize,
+                                         pattern.text(token).data(), logMsg.mTime));
+                    break;
                 }
             }
         }
-        if (color) {
-            stream << colorize::reset;
-        }
-        stream << std::endl;
     }
 
     std::string BaseLogger::timeStamp(const std::string & format) noexcept {
+        return timeStamp(format, 0);
+    }
+
+    std::string BaseLogger::timeStamp(const std::string & format, const std::int64_t time) noexcept {
         std::string out;
         if (format.empty()) {
             return out;
         }
         //-------------------
         const std::size_t timeBuffSize = 100;
-        char buffer[100] = {0};
+        char buffer[timeBuffSize];
         assert(format.size() < timeBuffSize - 1);
         //-------------------
-        time_t time = std::time(nullptr);
-        tm timeInfo = {};
-#ifdef _MSC_VER
-        localtime_s(&timeInfo, &time);
-#else
-		timeInfo = *localtime(&time);
-#endif
-        const auto byteNum = std::strftime(buffer, sizeof buffer, format.c_str(), &timeInfo);
+        const auto byteNum = timeStamp(buffer, sizeof buffer, format.c_str(), time);
         if (byteNum > 0) {
             out.append(buffer, byteNum);
         }
         return out;
     }
 
+    std::size_t BaseLogger::timeStamp(char * out, const std::size_t outSize,
+                                      const char * format, const std::int64_t time) noexcept {
+        // Each thread keeps the last rendered string for several formats,
+        // the messages of the same second just copy it and write the fractions of the second.
+        struct Fraction {
+            std::size_t mOffset;
+            std::size_t mDigits;
+        };
+        struct Entry {
+            std::time_t mSecond = 0;
+            bool mRendered = false;
+            std::size_t mSize = 0;
+            std::size_t mFractionsNum = 0;
+            Fraction mFractions[TimeStampMaxFractions];
+            char mFormat[TimeStampCacheStringSize] = {0};
+            char mOut[TimeStampCacheStringSize] = {0};
+        };
+        thread_local Entry cache[TimeStampCacheEntries];
+        thread_local std::size_t nextEntry = 0;
+        //-------------------
+        if (!format || *format == '\0') {
+            return 0;
+        }
+        const std::size_t formatSize = std::strlen(format);
+        if (formatSize >= TimeStampCacheStringSize) {
+            return 0;
+        }
+        const std::int64_t nanoseconds = time == 0 ? TimeSource::now() : time;
+        std::time_t second = std::time_t(nanoseconds / 1000000000);
+        std::int64_t fraction = nanoseconds % 1000000000;
+        if (fraction < 0) {
+            fraction += 1000000000;
+            --second;
+        }
+        //-------------------
+        Entry * entry = nullptr;
+        for (auto & e : cache) {
+            if (std::strcmp(e.mFormat, format) == 0) {
+                entry = &e;
+                break;
+            }
+        }
+        if (!entry) {
+            entry = &cache[nextEntry];
+            nextEntry = (nextEntry + 1) % TimeStampCacheEntries;
+            std::memcpy(entry->mFormat, format, formatSize + 1);
+            entry->mRendered = false;
+        }
+        if (!entry->mRendered || entry->mSecond != second) {
+            tm timeInfo = {};
+            localTime(second, timeInfo);
+            // The format is split by the fraction commands, the parts are rendered by std::strftime.
+            char part[TimeStampCacheStringSize];
+            std::size_t partSize = 0;
+            entry->mSize = 0;
+            entry->mFractionsNum = 0;
+            for (const char * ch = format;; ++ch) {
+                const std::size_t digits = fractionDigits(ch);
+                if (digits != 0 || *ch == '\0') {
+                    if (partSize != 0) {
+                        part[partSize] = '\0';
+                        entry->mSize += std::strftime(entry->mOut + entry->mSize,
+                                                      sizeof entry->mOut - entry->mSize, part, &timeInfo);
+                        partSize = 0;
+                    }
+                    if (*ch == '\0') {
+                        break;
+                    }
+                    if (entry->mFractionsNum < TimeStampMaxFractions) {
+                        entry->mFractions[entry->mFractionsNum++] = Fraction{entry->mSize, digits};
+                    }
+                    ch += 2;
+                    continue;
+                }
+                part[partSize++] = *ch;
+                if (*ch == '%' && ch[1] != '\0') {
+                    // the next symbol is the strftime command, e.g. %%3N is not the fraction.
+                    part[partSize++] = *++ch;
+                }
+            }
+            entry->mSecond = second;
+            entry->mRendered = true;
+        }
+        //-------------------
+        std::size_t size = entry->mSize;
+        for (std::size_t i = 0; i < entry->mFractionsNum; ++i) {
+            size += entry->mFractions[i].mDigits;
+        }
+        if (size > outSize) {
+            return 0;
+        }
+        std::size_t from = 0;
+        char * to = out;
+        for (std::size_t i = 0; i < entry->mFractionsNum; ++i) {
+            const Fraction & f = entry->mFractions[i];
+            std::memcpy(to, entry->mOut + from, f.mOffset - from);
+            to += f.mOffset - from;
+            writeFraction(to, f.mDigits, fraction);
+            to += f.mDigits;
+            from = f.mOffset;
+        }
+        std::memcpy(to, entry->mOut + from, entry->mSize - from);
+        return size;
+    }
+
     /**************************************************************************************************/
     //////////////////////////////////////////* Functions */////////////////////////////////////////////
     /**************************************************************************************************/
 
     LogMessage & LogMessage::write(const char * data, const std::size_t size) noexcept {
+        if (mSkipDisabled && !isEnabled()) {
+            return *this;
+        }
         try {
-            mStream.write(data, size);
+            mBuffer.append(data, size);
         }
         catch (const std::exception & e) {
             std::cerr << colorize::red << e.what() << " [" << __STS_FUNC_NAME__ << "]" << colorize::reset << std::endl;
@@ -307,14 +881,13 @@ namespace logging {
     /**************************************************************************************************/
 
     void LogMessage::push() noexcept {
-        if (mPushed || !mLog || mLogMsg.mLevel > mLog->level()) {
+        if (mPushed || !isEnabled()) {
             return;
         }
         mPushed = true;
         try {
-            const auto str = string();
-            if (!str.empty()) {
-                mLogMsg.mMsg = BaseLogger::StringView(str.data(), str.length());
+            if (!mBuffer.empty()) {
+                mLogMsg.mMsg = BaseLogger::StringView(mBuffer.data(), mBuffer.size());
                 mLog->log(mLogMsg);
             }
         }
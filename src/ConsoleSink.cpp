@@ -0,0 +1,267 @@
+/*
+**  Copyright(C) 2019, StepToSky and FlightFactor
+**  All rights reserved
+**
+**  Redistribution and use in source and binary forms, with or without
+**  modification, are permitted provided that the following conditions are met:
+**
+**  1.Redistributions of source code must retain the above copyright notice, this
+**    list of conditions and the following disclaimer.
+**  2.Redistributions in binary form must reproduce the above copyright notice,
+**    this list of conditions and the following disclaimer in the documentation
+**    and / or other materials provided with the distribution.
+**  3.The name of StepToSky or the name of FlightFactor or the names of its
+**    contributors may NOT be used to endorse or promote products derived from
+**    this software without specific prior written permission.
+**
+**  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+**  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+**  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+**  DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+**  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+**  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+**  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+**  ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+**  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+**  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**
+**  Contacts: www.steptosky.com or www.flightfactor.aero
+*/
+
+#include "stdafx.h"
+
+#include <cerrno>
+#include <sstream>
+#include <vector>
+#include "stsff/logging/ConsoleSink.h"
+#include "stsff/logging/utils/Colorize.h"
+
+#if defined(_WIN32) || defined(_WIN64)
+#   include <io.h>
+#else
+#   include <climits>
+#   include <unistd.h>
+#   include <sys/uio.h>
+#endif
+
+namespace stsff {
+namespace logging {
+
+    namespace {
+
+        const std::size_t TimeStampSize = 100;
+
+#if defined(_WIN32) || defined(_WIN64)
+        struct iovec {
+            void * iov_base;
+            std::size_t iov_len;
+        };
+#endif
+
+
+        /*!
+         * \details Gets the escape sequence that the color manipulator prints.
+         */
+        std::string escapeSequence(const BaseLogger::ColorFn color) {
+            if (!color) {
+                return std::string();
+            }
+            const colorize::StringView sequence = colorize::escapeSequence(color);
+            if (!sequence.empty()) {
+                return std::string(sequence.data(), sequence.size());
+            }
+            std::ostringstream stream;
+            stream << colorize::colorized;
+            color(stream);
+            return stream.str();
+        }
+
+        /*!
+         * \details Writes all the slices, the partially written slices are continued.
+         */
+        void writeSlices(const int fileDescriptor, iovec * slices, std::size_t count) noexcept {
+#if defined(_WIN32) || defined(_WIN64)
+            thread_local std::string buffer;
+            buffer.clear();
+            for (std::size_t i = 0; i < count; ++i) {
+                buffer.append(static_cast<const char *>(slices[i].iov_base), slices[i].iov_len);
+            }
+            const char * data = buffer.data();
+            std::size_t size = buffer.size();
+            while (size != 0) {
+                const int written = ::_write(fileDescriptor, data, unsigned(size));
+                if (written <= 0) {
+                    return;
+                }
+                data += written;
+                size -= std::size_t(written);
+            }
+#else
+            while (count != 0) {
+                const ssize_t written = ::writev(fileDescriptor, slices, int(count < IOV_MAX ? count : IOV_MAX));
+                if (written < 0) {
+                    if (errno == EINTR) {
+                        continue;
+                    }
+                    return;
+                }
+                std::size_t rest = std::size_t(written);
+                while (count != 0 && rest >= slices->iov_len) {
+                    rest -= slices->iov_len;
+                    ++slices;
+                    --count;
+                }
+                if (count != 0) {
+                    slices->iov_base = static_cast<char *>(slices->iov_base) + rest;
+                    slices->iov_len -= rest;
+                }
+            }
+#endif
+        }
+
+        /*!
+         * \details Slices of one message.
+         */
+        class Slices final {
+        public:
+
+            explicit Slices(std::vector<iovec> & slices) noexcept
+                : mSlices(slices) {
+                mSlices.clear();
+            }
+
+            void add(const char * data, const std::size_t size) {
+                if (size != 0) {
+                    mSlices.push_back(iovec{const_cast<char *>(data), size});
+                }
+            }
+
+            void add(const std::string & text) {
+                add(text.data(), text.size());
+            }
+
+            void add(const BaseLogger::StringView & text) {
+                add(text.data(), text.size());
+            }
+
+            iovec * data() noexcept { return mSlices.data(); }
+            std::size_t size() const noexcept { return mSlices.size(); }
+
+        private:
+
+            std::vector<iovec> & mSlices;
+
+        };
+
+    }
+
+    /**************************************************************************************************/
+    ////////////////////////////////////* Constructors/Destructor */////////////////////////////////////
+    /**************************************************************************************************/
+
+    ConsoleSink::ConsoleSink(const int fileDescriptor, const FormatPattern & pattern, const ColorFn color, const eColors colors)
+        : mPattern(pattern),
+          mFileDescriptor(fileDescriptor) {
+#if defined(_WIN32) || defined(_WIN64)
+        mColorized = colors == ColorsAlways;
+#else
+        mColorized = colors == ColorsAlways || (colors == ColorsAuto && ::isatty(fileDescriptor) != 0);
+#endif
+        if (mColorized) {
+            mPrefix = escapeSequence(color);
+            mErrorPrefix.assign(colorize::AnsiRed.data(), colorize::AnsiRed.size());
+            mErrorSuffix.assign(colorize::AnsiReset.data(), colorize::AnsiReset.size());
+            if (color) {
+                mSuffix = mErrorSuffix;
+            }
+        }
+        mSuffix.push_back('\n');
+        for (const auto & token : mPattern.tokens()) {
+            switch (token.mOp) {
+                case FormatPattern::OpLevel: mScratchSize += internal::FastFormat::MaxUnsignedChars;
+                    break;
+                case FormatPattern::OpFileLine: mScratchSize += internal::FastFormat::MaxSignedChars;
+                    break;
+                case FormatPattern::OpTime: mScratchSize += TimeStampSize;
+                    break;
+                default: break;
+            }
+        }
+    }
+
+    /**************************************************************************************************/
+    //////////////////////////////////////////* Functions */////////////////////////////////////////////
+    /**************************************************************************************************/
+
+    void ConsoleSink::operator()(const BaseLogger & logger, const BaseLogger::LogMsg & logMsg) const {
+        // The numbers and the time are rendered into the scratch that is reserved at once,
+        // so the slices that point to it stay valid.
+        thread_local internal::MessageBuffer scratchBuffer;
+        thread_local std::vector<iovec> slicesBuffer;
+        scratchBuffer.clear();
+        char * scratch = scratchBuffer.reserve(mScratchSize);
+        Slices slices(slicesBuffer);
+
+        slices.add(mPrefix);
+        for (const auto & token : mPattern.tokens()) {
+            switch (token.mOp) {
+                case FormatPattern::OpLiteral: {
+                    slices.add(mPattern.text(token));
+                    break;
+                }
+                case FormatPattern::OpError: {
+                    slices.add(mErrorPrefix);
+                    slices.add(mPattern.text(token));
+                    slices.add(mErrorSuffix);
+                    break;
+                }
+                case FormatPattern::OpLevel: {
+                    const std::size_t size = internal::FastFormat::formatUnsigned(scratch, logMsg.mLevel);
+                    slices.add(scratch, size);
+                    scratch += size;
+                    break;
+                }
+                case FormatPattern::OpLogName: {
+                    slices.add(logger.name());
+                    break;
+                }
+                case FormatPattern::OpMessageCategory: {
+                    slices.add(logMsg.mCategory);
+                    break;
+                }
+                case FormatPattern::OpMessage: {
+                    slices.add(logMsg.mMsg);
+                    break;
+                }
+                case FormatPattern::OpFunctionName: {
+                    slices.add(logMsg.mCodeLocation.mFunction);
+                    break;
+                }
+                case FormatPattern::OpFileName: {
+                    slices.add(logMsg.mCodeLocation.mFile);
+                    break;
+                }
+                case FormatPattern::OpFileLine: {
+                    const std::size_t size = internal::FastFormat::formatSigned(scratch, logMsg.mCodeLocation.mLine);
+                    slices.add(scratch, size);
+                    scratch += size;
+                    break;
+                }
+                case FormatPattern::OpTime: {
+                    const std::size_t size = BaseLogger::timeStamp(scratch, TimeStampSize, mPattern.text(token).data(), logMsg.mTime);
+                    slices.add(scratch, size);
+                    scratch += size;
+                    break;
+                }
+            }
+        }
+        slices.add(mSuffix);
+        writeSlices(mFileDescriptor, slices.data(), slices.size());
+    }
+
+    /**************************************************************************************************/
+    ////////////////////////////////////////////////////////////////////////////////////////////////////
+    /**************************************************************************************************/
+
+}
+}
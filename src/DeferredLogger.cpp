@@ -0,0 +1,271 @@
+/*
+**  Copyright(C) 2019, StepToSky and FlightFactor
+**  All rights reserved
+**
+**  Redistribution and use in source and binary forms, with or without
+**  modification, are permitted provided that the following conditions are met:
+**
+**  1.Redistributions of source code must retain the above copyright notice, this
+**    list of conditions and the following disclaimer.
+**  2.Redistributions in binary form must reproduce the above copyright notice,
+**    this list of conditions and the following disclaimer in the documentation
+**    and / or other materials provided with the distribution.
+**  3.The name of StepToSky or the name of FlightFactor or the names of its
+**    contributors may NOT be used to endorse or promote products derived from
+**    this software without specific prior written permission.
+**
+**  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+**  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+**  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+**  DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+**  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+**  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+**  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+**  ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+**  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+**  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**
+**  Contacts: www.steptosky.com or www.flightfactor.aero
+*/
+
+#include "stdafx.h"
+
+#include "stsff/logging/DeferredLogger.h"
+
+namespace stsff {
+namespace logging {
+
+    /**************************************************************************************************/
+    /////////////////////////////////////////* Static area *////////////////////////////////////////////
+    /**************************************************************************************************/
+
+    namespace {
+
+        //! The logger whose background thread is the current thread.
+        thread_local const DeferredLogger * gConsumerOf = nullptr;
+
+    }
+
+    /**************************************************************************************************/
+    ////////////////////////////////////* Constructors/Destructor */////////////////////////////////////
+    /**************************************************************************************************/
+
+    DeferredLogger::DeferredLogger(const BaseLogger & target, const std::size_t bufferSize)
+        : mTarget(target),
+          mRings(bufferSize) {
+        mThread = std::thread(&DeferredLogger::run, this);
+    }
+
+    DeferredLogger::~DeferredLogger() noexcept {
+        try {
+            {
+                std::lock_guard<std::mutex> lock(mMutex);
+                mStop = true;
+            }
+            mWake.notify_one();
+            if (mThread.joinable()) {
+                mThread.join();
+            }
+        }
+        catch (const std::exception & e) {
+            std::cerr << colorize::red << e.what() << " [" << __STS_FUNC_NAME__ << "]" << colorize::reset << std::endl;
+        }
+        catch (...) {
+            std::cerr << colorize::red << "unknown exception [" << __STS_FUNC_NAME__ << "]" << colorize::reset << std::endl;
+        }
+    }
+
+    /**************************************************************************************************/
+    //////////////////////////////////////////* Functions */////////////////////////////////////////////
+    /**************************************************************************************************/
+
+    void DeferredLogger::flush() noexcept {
+        try {
+            if (std::this_thread::get_id() == mThread.get_id()) {
+                return; // a handler of the target logger can't wait for itself.
+            }
+            std::unique_lock<std::mutex> lock(mMutex);
+            const std::uint64_t ticket = ++mFlushRequested;
+            mWake.notify_one();
+            mFlushed.wait(lock, [&]() { return mFlushDone >= ticket || mStop; });
+        }
+        catch (const std::exception & e) {
+            std::cerr << colorize::red << e.what() << " [" << __STS_FUNC_NAME__ << "]" << colorize::reset << std::endl;
+        }
+        catch (...) {
+            std::cerr << colorize::red << "unknown exception [" << __STS_FUNC_NAME__ << "]" << colorize::reset << std::endl;
+        }
+    }
+
+    char * DeferredLogger::reserve(internal::SpscRing & ring, const std::size_t size) noexcept {
+        char * out = ring.tryReserve(size);
+        if (out) {
+            return out;
+        }
+        if (gConsumerOf == this) {
+            // a handler of the target logger can't wait for itself.
+            mDropped.fetch_add(1, std::memory_order_relaxed);
+            return nullptr;
+        }
+        // the buffer is full, wake up the background thread and wait for the space.
+        mWake.notify_one();
+        while (!(out = ring.tryReserve(size))) {
+            std::this_thread::yield();
+        }
+        return out;
+    }
+
+    /**************************************************************************************************/
+    //////////////////////////////////////////* Functions */////////////////////////////////////////////
+    /**************************************************************************************************/
+
+    void DeferredLogger::run() noexcept {
+        gConsumerOf = this;
+        std::vector<internal::ThreadRings::RingPtr> rings;
+        std::uint64_t ringsVersion = 0;
+        internal::MessageBuffer buffer;
+        for (;;) {
+            std::uint64_t ticket;
+            bool stop;
+            {
+                std::lock_guard<std::mutex> lock(mMutex);
+                ticket = mFlushRequested;
+                stop = mStop;
+            }
+            std::size_t printed = 0;
+            try {
+                mRings.snapshot(rings, ringsVersion);
+            }
+            catch (...) {
+                // keeps the previous snapshot, the new threads will be processed next time.
+            }
+            for (auto & ring : rings) {
+                printed += drain(*ring, buffer);
+            }
+            mRings.collect();
+            {
+                std::lock_guard<std::mutex> lock(mMutex);
+                mFlushDone = ticket;
+            }
+            mFlushed.notify_all();
+            if (stop) {
+                break;
+            }
+            if (printed == 0) {
+                std::unique_lock<std::mutex> lock(mMutex);
+                mWake.wait_for(lock, std::chrono::milliseconds(1), [&]() {
+                    return mStop || mFlushRequested != ticket;
+                });
+            }
+        }
+    }
+
+    std::size_t DeferredLogger::drain(internal::SpscRing & ring, internal::MessageBuffer & buffer) noexcept {
+        std::size_t printed = 0;
+        std::size_t size = 0;
+        while (const char * record = ring.front(size)) {
+            try {
+                print(record, size, buffer);
+            }
+            catch (const std::exception & e) {
+                std::cerr << colorize::red << e.what() << " [" << __STS_FUNC_NAME__ << "]" << colorize::reset << std::endl;
+            }
+            catch (...) {
+                std::cerr << colorize::red << "unknown exception [" << __STS_FUNC_NAME__ << "]" << colorize::reset << std::endl;
+            }
+            ring.pop();
+            ++printed;
+        }
+        return printed;
+    }
+
+    void DeferredLogger::print(const char * record, const std::size_t size, internal::MessageBuffer & buffer) const {
+        typedef internal::FastFormat FastFormat;
+        typedef internal::DeferredArgs DeferredArgs;
+
+        const DeferredSite * site;
+        TimeSource::Stamp time;
+        std::memcpy(&site, record, sizeof(site));
+        std::memcpy(&time, record + sizeof(site), sizeof(time));
+
+        buffer.clear();
+        const char * arg = record + HeaderSize;
+        const char * end = record + size;
+        while (arg < end) {
+            const auto format = internal::eMessageFormat(*arg++);
+            switch (format) {
+                case internal::FmtChar: {
+                    buffer.append(*arg++);
+                    break;
+                }
+                case internal::FmtBool: {
+                    bool value;
+                    std::memcpy(&value, arg, sizeof(value));
+                    arg += sizeof(value);
+                    buffer.append(value ? '1' : '0');
+                    break;
+                }
+                case internal::FmtSigned: {
+                    DeferredArgs::ValueType<internal::FmtSigned>::type value;
+                    std::memcpy(&value, arg, sizeof(value));
+                    arg += sizeof(value);
+                    buffer.commit(FastFormat::formatSigned(buffer.reserve(FastFormat::MaxSignedChars), value));
+                    break;
+                }
+                case internal::FmtUnsigned: {
+                    DeferredArgs::ValueType<internal::FmtUnsigned>::type value;
+                    std::memcpy(&value, arg, sizeof(value));
+                    arg += sizeof(value);
+                    buffer.commit(FastFormat::formatUnsigned(buffer.reserve(FastFormat::MaxUnsignedChars), value));
+                    break;
+                }
+                case internal::FmtFloat: {
+                    DeferredArgs::ValueType<internal::FmtFloat>::type value;
+                    std::memcpy(&value, arg, sizeof(value));
+                    arg += sizeof(value);
+                    buffer.commit(FastFormat::formatFloat(buffer.reserve(FastFormat::MaxFloatChars), value));
+                    break;
+                }
+                case internal::FmtDouble: {
+                    DeferredArgs::ValueType<internal::FmtDouble>::type value;
+                    std::memcpy(&value, arg, sizeof(value));
+                    arg += sizeof(value);
+                    buffer.commit(FastFormat::formatDouble(buffer.reserve(FastFormat::MaxFloatChars), value));
+                    break;
+                }
+                case internal::FmtPointer: {
+                    DeferredArgs::ValueType<internal::FmtPointer>::type value;
+                    std::memcpy(&value, arg, sizeof(value));
+                    arg += sizeof(value);
+                    const auto pointer = reinterpret_cast<const void *>(std::uintptr_t(value));
+                    buffer.commit(FastFormat::formatPointer(buffer.reserve(FastFormat::MaxPointerChars), pointer));
+                    break;
+                }
+                case internal::FmtCString:
+                case internal::FmtString: {
+                    std::uint32_t length;
+                    std::memcpy(&length, arg, sizeof(length));
+                    arg += sizeof(length);
+                    buffer.append(arg, length);
+                    arg += length;
+                    break;
+                }
+                default: {
+                    assert(false);
+                    arg = end;
+                }
+            }
+        }
+
+        BaseLogger::LogMsg logMsg(site->mLevel, site->mCategory,
+                                  StringView(buffer.data(), buffer.size()), site->mCodeLocation);
+        logMsg.mTime = TimeSource::toNanoseconds(time);
+        mTarget.log(logMsg);
+    }
+
+    /**************************************************************************************************/
+    ////////////////////////////////////////////////////////////////////////////////////////////////////
+    /**************************************************************************************************/
+
+}
+}
@@ -0,0 +1,235 @@
+/*
+**  Copyright(C) 2019, StepToSky and FlightFactor
+**  All rights reserved
+**
+**  Redistribution and use in source and binary forms, with or without
+**  modification, are permitted provided that the following conditions are met:
+**
+**  1.Redistributions of source code must retain the above copyright notice, this
+**    list of conditions and the following disclaimer.
+**  2.Redistributions in binary form must reproduce the above copyright notice,
+**    this list of conditions and the following disclaimer in the documentation
+**    and / or other materials provided with the distribution.
+**  3.The name of StepToSky or the name of FlightFactor or the names of its
+**    contributors may NOT be used to endorse or promote products derived from
+**    this software without specific prior written permission.
+**
+**  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+**  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+**  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+**  DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+**  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+**  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+**  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+**  ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+**  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+**  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**
+**  Contacts: www.steptosky.com or www.flightfactor.aero
+*/
+
+#include "stdafx.h"
+
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <mutex>
+#include "stsff/logging/FileSink.h"
+#include "stsff/logging/internal/FileWriter.h"
+
+#if defined(_WIN32) || defined(_WIN64)
+#   include <io.h>
+#   include <fcntl.h>
+#   include <sys/stat.h>
+#else
+#   include <fcntl.h>
+#   include <unistd.h>
+#endif
+
+namespace stsff {
+namespace logging {
+
+    /**************************************************************************************************/
+    /////////////////////////////////////////* Static area *////////////////////////////////////////////
+    /**************************************************************************************************/
+
+    class FileSink::File final {
+    public:
+
+        File(const std::string & fileName, const FormatPattern & pattern, const std::size_t bufferSize)
+            : mWriter(fileName),
+              mPattern(pattern),
+              mBuffer(new char[bufferSize ? bufferSize : 1]),
+              mCapacity(bufferSize ? bufferSize : 1) {
+#if defined(_WIN32) || defined(_WIN64)
+            mFd = ::_open(fileName.c_str(), _O_WRONLY | _O_CREAT | _O_APPEND | _O_BINARY, _S_IREAD | _S_IWRITE);
+#else
+            mFd = ::open(fileName.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+#endif
+            if (mFd < 0) {
+                internal::FileWriter::printError("can't open the log file", fileName, errno, __STS_FUNC_NAME__);
+            }
+        }
+
+        File(const File &) = delete;
+        File & operator=(const File &) = delete;
+
+        ~File() noexcept {
+            if (mFd >= 0) {
+                writeOut(mBuffer.get(), mSize);
+#if defined(_WIN32) || defined(_WIN64)
+                ::_close(mFd);
+#else
+                ::close(mFd);
+#endif
+            }
+        }
+
+        //-------------------------------------------------------------------------
+
+        void write(const char * data, const std::size_t size, const std::size_t level) {
+            std::lock_guard<std::mutex> lock(mMutex);
+            if (size > mCapacity - mSize) {
+                flushLocked();
+            }
+            if (size >= mCapacity) {
+                writeOut(data, size);
+            }
+            else {
+                std::memcpy(mBuffer.get() + mSize, data, size);
+                mSize += size;
+            }
+            ++mUnflushed;
+            if (level <= mSyncLevel) {
+                flushLocked();
+                syncLocked();
+            }
+            else if (mPolicy.isDue(level, mUnflushed, mLastFlush)) {
+                flushLocked();
+            }
+        }
+
+        void flush(const bool sync) {
+            std::lock_guard<std::mutex> lock(mMutex);
+            flushLocked();
+            if (sync) {
+                syncLocked();
+            }
+        }
+
+        void setFlushPolicy(const FlushPolicy & policy) {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mPolicy = policy;
+            mLastFlush = TimeSource::now(TimeSource::ClockCoarse);
+        }
+
+        void setSyncLevel(const std::size_t level) {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mSyncLevel = level;
+        }
+
+        //-------------------------------------------------------------------------
+
+        internal::FileWriter mWriter;
+        const FormatPattern mPattern;
+        int mFd = -1;
+        std::atomic<std::uint64_t> mWritten{0};
+
+    private:
+
+        void flushLocked() noexcept {
+            writeOut(mBuffer.get(), mSize);
+            mSize = 0;
+            mUnflushed = 0;
+            if (mPolicy.mIntervalMs > 0) {
+                mLastFlush = TimeSource::now(TimeSource::ClockCoarse);
+            }
+        }
+
+        void syncLocked() noexcept {
+            if (mFd < 0) {
+                return;
+            }
+#if defined(_WIN32) || defined(_WIN64)
+            ::_commit(mFd);
+#elif defined(__APPLE__)
+            ::fsync(mFd);
+#else
+            ::fdatasync(mFd);
+#endif
+        }
+
+        void writeOut(const char * data, const std::size_t size) noexcept {
+            if (mFd >= 0) {
+                mWritten.fetch_add(mWriter.write(mFd, data, size), std::memory_order_relaxed);
+            }
+        }
+
+        std::mutex mMutex;
+        std::unique_ptr<char[]> mBuffer;
+        const std::size_t mCapacity;
+        std::size_t mSize = 0;
+        FlushPolicy mPolicy = FlushPolicy::never();
+        std::size_t mSyncLevel = 0;
+        std::size_t mUnflushed = 0;
+        std::int64_t mLastFlush = 0;
+
+    };
+
+    /**************************************************************************************************/
+    ////////////////////////////////////* Constructors/Destructor */////////////////////////////////////
+    /**************************************************************************************************/
+
+    FileSink::FileSink(const std::string & fileName, const FormatPattern & pattern, const std::size_t bufferSize)
+        : mFile(std::make_shared<File>(fileName, pattern, bufferSize)) {}
+
+    /**************************************************************************************************/
+    //////////////////////////////////////////* Functions */////////////////////////////////////////////
+    /**************************************************************************************************/
+
+    void FileSink::operator()(const BaseLogger & logger, const BaseLogger::LogMsg & logMsg) const {
+        if (mFile->mFd < 0) {
+            return;
+        }
+        const internal::MessageBuffer & line = internal::renderLine(logger, logMsg, mFile->mPattern);
+        mFile->write(line.data(), line.size(), logMsg.mLevel);
+    }
+
+    void FileSink::flush() const noexcept {
+        internal::callNoexcept(__STS_FUNC_NAME__, [&]() { mFile->flush(false); });
+    }
+
+    void FileSink::sync() const noexcept {
+        internal::callNoexcept(__STS_FUNC_NAME__, [&]() { mFile->flush(true); });
+    }
+
+    //-------------------------------------------------------------------------
+
+    void FileSink::setFlushPolicy(const FlushPolicy & policy) noexcept {
+        internal::callNoexcept(__STS_FUNC_NAME__, [&]() { mFile->setFlushPolicy(policy); });
+    }
+
+    void FileSink::setSyncLevel(const std::size_t level) noexcept {
+        internal::callNoexcept(__STS_FUNC_NAME__, [&]() { mFile->setSyncLevel(level); });
+    }
+
+    //-------------------------------------------------------------------------
+
+    const std::string & FileSink::fileName() const noexcept {
+        return mFile->mWriter.fileName();
+    }
+
+    bool FileSink::isOpen() const noexcept {
+        return mFile->mFd >= 0;
+    }
+
+    std::uint64_t FileSink::written() const noexcept {
+        return mFile->mWritten.load(std::memory_order_relaxed);
+    }
+
+    /**************************************************************************************************/
+    ////////////////////////////////////////////////////////////////////////////////////////////////////
+    /**************************************************************************************************/
+
+}
+}
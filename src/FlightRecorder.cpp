@@ -0,0 +1,279 @@
+/*
+**  Copyright(C) 2019, StepToSky and FlightFactor
+**  All rights reserved
+**
+**  Redistribution and use in source and binary forms, with or without
+**  modification, are permitted provided that the following conditions are met:
+**
+**  1.Redistributions of source code must retain the above copyright notice, this
+**    list of conditions and the following disclaimer.
+**  2.Redistributions in binary form must reproduce the above copyright notice,
+**    this list of conditions and the following disclaimer in the documentation
+**    and / or other materials provided with the distribution.
+**  3.The name of StepToSky or the name of FlightFactor or the names of its
+**    contributors may NOT be used to endorse or promote products derived from
+**    this software without specific prior written permission.
+**
+**  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+**  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+**  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+**  DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+**  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+**  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+**  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+**  ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+**  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+**  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**
+**  Contacts: www.steptosky.com or www.flightfactor.aero
+*/
+
+#include "stdafx.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <utility>
+#include <vector>
+#include "stsff/logging/FlightRecorder.h"
+#include "stsff/logging/utils/Colorize.h"
+#include "stsff/logging/utils/TimeSource.h"
+
+namespace stsff {
+namespace logging {
+
+    /**************************************************************************************************/
+    /////////////////////////////////////////* Static area *////////////////////////////////////////////
+    /**************************************************************************************************/
+
+    namespace {
+
+        /*!
+         * \details Message record in the ring, it is followed by
+         *          the category, the message, the function and the file strings
+         *          and by the alignment bytes.
+         * \details The unused end of the ring is marked with a padding record,
+         *          only its first two fields are written.
+         */
+        struct RecordHeader {
+            std::uint32_t mSize;    //!< bytes of the whole record.
+            std::uint32_t mPadding; //!< 1 for the padding record.
+            std::uint64_t mSequence;
+            std::int64_t mTime;
+            std::uint64_t mLevel;
+            std::int32_t mLine;
+            std::uint32_t mTicks;   //!< see TimeSource::Stamp::mTicks
+            std::uint32_t mCategorySize;
+            std::uint32_t mMsgSize;
+            std::uint32_t mFunctionSize;
+            std::uint32_t mFileSize;
+        };
+
+        const std::size_t RecordAlignment = 8;
+
+        std::size_t alignRecord(const std::size_t size) noexcept {
+            return (size + RecordAlignment - 1) & ~(RecordAlignment - 1);
+        }
+
+        /*!
+         * \details The threads are numbered in the order they capture the first message,
+         *          so the first threads get the different rings.
+         */
+        std::size_t threadNumber() noexcept {
+            static std::atomic<std::size_t> counter{0};
+            static thread_local const std::size_t number = counter.fetch_add(1, std::memory_order_relaxed);
+            return number;
+        }
+
+    }
+
+    /**************************************************************************************************/
+    ////////////////////////////////////////////////////////////////////////////////////////////////////
+    /**************************************************************************************************/
+
+    /*!
+     * \details The records are in [mHead, mTail) that wraps at the end of the ring,
+     *          mUsed counts the padding records too.
+     */
+    struct FlightRecorder::Ring {
+        std::mutex mMutex;
+        char * mData = nullptr;
+        std::size_t mHead = 0;
+        std::size_t mTail = 0;
+        std::size_t mUsed = 0;
+        std::size_t mRecords = 0;
+    };
+
+    /**************************************************************************************************/
+    //////////////////////////////////////////* Functions */////////////////////////////////////////////
+    /**************************************************************************************************/
+
+    FlightRecorder::FlightRecorder(const std::size_t ringSize, const std::size_t rings)
+        : mRingSize(alignRecord(std::max(ringSize, std::size_t(MinRingSize)))),
+          mRingCount(std::max(rings, std::size_t(1))),
+          mMemory(new char[mRingSize * mRingCount]),
+          mRings(new Ring[mRingCount]) {
+        for (std::size_t i = 0; i < mRingCount; ++i) {
+            mRings[i].mData = mMemory.get() + i * mRingSize;
+        }
+    }
+
+    FlightRecorder::~FlightRecorder() noexcept = default;
+
+    /**************************************************************************************************/
+    //////////////////////////////////////////* Functions */////////////////////////////////////////////
+    /**************************************************************************************************/
+
+    void FlightRecorder::capture(const LogMsg & logMsg) noexcept {
+        try {
+            const TimeSource::Stamp time = logMsg.mTime == 0 ? TimeSource::capture() : TimeSource::Stamp{logMsg.mTime, false};
+            RecordHeader header;
+            header.mPadding = 0;
+            header.mTime = time.mValue;
+            header.mTicks = time.mTicks ? 1 : 0;
+            header.mLevel = logMsg.mLevel;
+            header.mLine = logMsg.mCodeLocation.mLine;
+            // a record takes a quarter of the ring at most, the strings are cut to fit it.
+            const std::size_t available = ((mRingSize / 4) & ~(RecordAlignment - 1)) - sizeof(RecordHeader);
+            header.mCategorySize = std::uint32_t(std::min(logMsg.mCategory.size(), available / 4));
+            header.mFunctionSize = std::uint32_t(std::min(logMsg.mCodeLocation.mFunction.size(), available / 4));
+            header.mFileSize = std::uint32_t(std::min(logMsg.mCodeLocation.mFile.size(), available / 4));
+            header.mMsgSize = std::uint32_t(std::min(logMsg.mMsg.size(),
+                                                     available - header.mCategorySize - header.mFunctionSize - header.mFileSize));
+            const std::size_t size = alignRecord(sizeof(header) + header.mCategorySize + header.mMsgSize +
+                                                 header.mFunctionSize + header.mFileSize);
+            header.mSize = std::uint32_t(size);
+
+            Ring & ring = mRings[threadNumber() % mRingCount];
+            std::lock_guard<std::mutex> lock(ring.mMutex);
+            const auto reserve = [&](const std::size_t bytes) {
+                while (mRingSize - ring.mUsed < bytes) {
+                    RecordHeader oldest;
+                    std::memcpy(&oldest, ring.mData + ring.mHead, sizeof(oldest.mSize) + sizeof(oldest.mPadding));
+                    ring.mHead = (ring.mHead + oldest.mSize) % mRingSize;
+                    ring.mUsed -= oldest.mSize;
+                    if (!oldest.mPadding) {
+                        --ring.mRecords;
+                        mOverwritten.fetch_add(1, std::memory_order_relaxed);
+                    }
+                }
+            };
+            if (ring.mUsed == 0) {
+                ring.mHead = ring.mTail = 0;
+            }
+            if (mRingSize - ring.mTail < size) {
+                const std::uint32_t padding[2] = {std::uint32_t(mRingSize - ring.mTail), 1};
+                reserve(padding[0]);
+                std::memcpy(ring.mData + ring.mTail, padding, sizeof(padding));
+                ring.mUsed += padding[0];
+                ring.mTail = 0;
+            }
+            reserve(size);
+            header.mSequence = mSequence.fetch_add(1, std::memory_order_relaxed);
+
+            char * out = ring.mData + ring.mTail;
+            std::memcpy(out, &header, sizeof(header));
+            out += sizeof(header);
+            std::memcpy(out, logMsg.mCategory.data(), header.mCategorySize);
+            out += header.mCategorySize;
+            std::memcpy(out, logMsg.mMsg.data(), header.mMsgSize);
+            out += header.mMsgSize;
+            std::memcpy(out, logMsg.mCodeLocation.mFunction.data(), header.mFunctionSize);
+            out += header.mFunctionSize;
+            std::memcpy(out, logMsg.mCodeLocation.mFile.data(), header.mFileSize);
+            ring.mTail = (ring.mTail + size) % mRingSize;
+            ring.mUsed += size;
+            ++ring.mRecords;
+        }
+        catch (const std::exception & e) {
+            std::cerr << colorize::red << e.what() << " [" << __STS_FUNC_NAME__ << "]" << colorize::reset << std::endl;
+        }
+        catch (...) {
+            std::cerr << colorize::red << "unknown exception [" << __STS_FUNC_NAME__ << "]" << colorize::reset << std::endl;
+        }
+    }
+
+    std::size_t FlightRecorder::dump(const std::function<void(const LogMsg &)> & fn) {
+        // sequence, offset of the record in the data.
+        std::vector<std::pair<std::uint64_t, std::size_t>> entries;
+        std::vector<char> data;
+        for (std::size_t i = 0; i < mRingCount; ++i) {
+            Ring & ring = mRings[i];
+            std::lock_guard<std::mutex> lock(ring.mMutex);
+            data.reserve(data.size() + ring.mUsed);
+            entries.reserve(entries.size() + ring.mRecords);
+            for (std::size_t pos = ring.mHead, rest = ring.mUsed; rest != 0;) {
+                RecordHeader header;
+                std::memcpy(&header, ring.mData + pos, sizeof(header.mSize) + sizeof(header.mPadding));
+                if (!header.mPadding) {
+                    std::memcpy(&header, ring.mData + pos, sizeof(header));
+                    entries.emplace_back(header.mSequence, data.size());
+                    data.insert(data.end(), ring.mData + pos, ring.mData + pos + header.mSize);
+                }
+                pos = (pos + header.mSize) % mRingSize;
+                rest -= header.mSize;
+            }
+            ring.mHead = ring.mTail = ring.mUsed = ring.mRecords = 0;
+        }
+        std::sort(entries.begin(), entries.end());
+
+        for (const auto & entry : entries) {
+            const char * record = data.data() + entry.second;
+            RecordHeader header;
+            std::memcpy(&header, record, sizeof(header));
+            const char * strings = record + sizeof(header);
+            const BaseLogger::StringView category(strings, header.mCategorySize);
+            strings += header.mCategorySize;
+            const BaseLogger::StringView msg(strings, header.mMsgSize);
+            strings += header.mMsgSize;
+            const BaseLogger::StringView function(strings, header.mFunctionSize);
+            strings += header.mFunctionSize;
+            const BaseLogger::StringView file(strings, header.mFileSize);
+            LogMsg logMsg(std::size_t(header.mLevel), category, msg, CodeLocation(function, file, header.mLine));
+            logMsg.mTime = TimeSource::toNanoseconds(TimeSource::Stamp{header.mTime, header.mTicks != 0});
+            fn(logMsg);
+        }
+        return entries.size();
+    }
+
+    void FlightRecorder::clear() noexcept {
+        try {
+            for (std::size_t i = 0; i < mRingCount; ++i) {
+                Ring & ring = mRings[i];
+                std::lock_guard<std::mutex> lock(ring.mMutex);
+                ring.mHead = ring.mTail = ring.mUsed = ring.mRecords = 0;
+            }
+        }
+        catch (const std::exception & e) {
+            std::cerr << colorize::red << e.what() << " [" << __STS_FUNC_NAME__ << "]" << colorize::reset << std::endl;
+        }
+        catch (...) {
+            std::cerr << colorize::red << "unknown exception [" << __STS_FUNC_NAME__ << "]" << colorize::reset << std::endl;
+        }
+    }
+
+    std::size_t FlightRecorder::records() const noexcept {
+        std::size_t result = 0;
+        try {
+            for (std::size_t i = 0; i < mRingCount; ++i) {
+                Ring & ring = mRings[i];
+                std::lock_guard<std::mutex> lock(ring.mMutex);
+                result += ring.mRecords;
+            }
+        }
+        catch (const std::exception & e) {
+            std::cerr << colorize::red << e.what() << " [" << __STS_FUNC_NAME__ << "]" << colorize::reset << std::endl;
+        }
+        catch (...) {
+            std::cerr << colorize::red << "unknown exception [" << __STS_FUNC_NAME__ << "]" << colorize::reset << std::endl;
+        }
+        return result;
+    }
+
+    /**************************************************************************************************/
+    ////////////////////////////////////////////////////////////////////////////////////////////////////
+    /**************************************************************************************************/
+
+}
+}
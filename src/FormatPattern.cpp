@@ -0,0 +1,166 @@
+/*
+**  Copyright(C) 2019, StepToSky and FlightFactor
+**  All rights reserved
+**
+**  Redistribution and use in source and binary forms, with or without
+**  modification, are permitted provided that the following conditions are met:
+**
+**  1.Redistributions of source code must retain the above copyright notice, this
+**    list of conditions and the following disclaimer.
+**  2.Redistributions in binary form must reproduce the above copyright notice,
+**    this list of conditions and the following disclaimer in the documentation
+**    and / or other materials provided with the distribution.
+**  3.The name of StepToSky or the name of FlightFactor or the names of its
+**    contributors may NOT be used to endorse or promote products derived from
+**    this software without specific prior written permission.
+**
+**  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+**  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+**  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+**  DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+**  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+**  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+**  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+**  ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+**  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+**  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**
+**  Contacts: www.steptosky.com or www.flightfactor.aero
+*/
+
+#include "stdafx.h"
+
+#include <iostream>
+#include "stsff/logging/FormatPattern.h"
+#include "stsff/logging/utils/Colorize.h"
+
+namespace stsff {
+namespace logging {
+
+    /**************************************************************************************************/
+    ////////////////////////////////////* Constructors/Destructor */////////////////////////////////////
+    /**************************************************************************************************/
+
+    FormatPattern::FormatPattern(const std::string & formatting, const eErrors errors)
+        : mFormatting(formatting) {
+
+        const std::uint32_t time = ('T' << 8) | 'M';
+        const std::uint32_t logCategory = ('L' << 8) | 'N';
+        const std::uint32_t messageCategory = ('M' << 8) | 'C';
+        const std::uint32_t message = ('M' << 8) | 'S';
+        const std::uint32_t functionName = ('F' << 8) | 'N';
+        const std::uint32_t fileName = ('F' << 8) | 'I';
+        const std::uint32_t fileLineNum = ('L' << 8) | 'I';
+        const std::uint32_t level = ('L' << 8) | 'V';
+
+        bool process = false;
+        std::size_t ch = 0;
+        const std::size_t end = formatting.size();
+
+        while (ch != end) {
+            if (formatting[ch] == '%') {
+                process = true;
+                ++ch;
+                continue;
+            }
+            if (!process) {
+                add(OpLiteral, &formatting[ch], 1);
+                ++ch;
+                continue;
+            }
+            process = false;
+            const std::size_t second = ch + 1;
+            if (second == end) {
+                error(errors, std::string("unexpected end of formatting string after [")
+                              .append(1, formatting[ch])
+                              .append("], expected the second command letter"));
+                break;
+            }
+
+            const std::uint32_t command = (std::uint32_t(std::uint8_t(formatting[ch])) << 8) |
+                                          std::uint8_t(formatting[second]);
+            ch = second + 1;
+
+            switch (command) {
+                case logCategory: add(OpLogName, nullptr, 0);
+                    break;
+                case messageCategory: add(OpMessageCategory, nullptr, 0);
+                    break;
+                case message: add(OpMessage, nullptr, 0);
+                    break;
+                case functionName: add(OpFunctionName, nullptr, 0);
+                    break;
+                case fileName: add(OpFileName, nullptr, 0);
+                    break;
+                case fileLineNum: add(OpFileLine, nullptr, 0);
+                    break;
+                case level: add(OpLevel, nullptr, 0);
+                    break;
+                case time: {
+                    if (ch == end) {
+                        error(errors, "unexpected end of formatting string after the time command, expected '()'");
+                        break;
+                    }
+                    if (formatting[ch] != '(') {
+                        error(errors, std::string("unexpected symbol ").append(1, formatting[ch])
+                                                                       .append(" after time command, expected '('"));
+                        ++ch;
+                        break;
+                    }
+                    ++ch; // skip '('
+                    const std::size_t endOfTimeFormat = formatting.find(')', ch);
+                    if (endOfTimeFormat == std::string::npos) {
+                        error(errors, "unexpected end of formatting string after the time command, missed ')'");
+                        break;
+                    }
+                    add(OpTime, formatting.data() + ch, endOfTimeFormat - ch);
+                    ch = endOfTimeFormat + 1;
+                    break;
+                }
+                default: {
+                    error(errors, std::string("unknown formatting command: [")
+                                  .append(1, char(command >> 8)).append(1, char(command)).append("]"));
+                }
+            }
+        }
+    }
+
+    /**************************************************************************************************/
+    //////////////////////////////////////////* Functions */////////////////////////////////////////////
+    /**************************************************************************************************/
+
+    void FormatPattern::add(const eOp op, const char * data, const std::size_t size) {
+        if (op == OpLiteral && !mTokens.empty() && mTokens.back().mOp == OpLiteral) {
+            mText.append(data, size);
+            mTokens.back().mSize += std::uint32_t(size);
+            return;
+        }
+        Token token;
+        token.mOp = op;
+        token.mOffset = std::uint32_t(mText.size());
+        token.mSize = std::uint32_t(size);
+        mText.append(data, size);
+        if (op == OpTime) {
+            mText.append(1, '\0');
+        }
+        mTokens.push_back(token);
+    }
+
+    void FormatPattern::error(const eErrors errors, const std::string & text) {
+        mErrors.append(text).append(1, '\n');
+        if (errors == ErrorsInline) {
+            const std::string inlineText = std::string(" ").append(text);
+            add(OpError, inlineText.data(), inlineText.size());
+        }
+        else {
+            std::cerr << colorize::red << text << " in the formatting string [" << mFormatting << "]"
+                    << colorize::reset << std::endl;
+        }
+    }
+
+    /**************************************************************************************************/
+    ////////////////////////////////////////////////////////////////////////////////////////////////////
+    /**************************************************************************************************/
+
+}
+}
@@ -0,0 +1,538 @@
+/*
+**  Copyright(C) 2019, StepToSky and FlightFactor
+**  All rights reserved
+**
+**  Redistribution and use in source and binary forms, with or without
+**  modification, are permitted provided that the following conditions are met:
+**
+**  1.Redistributions of source code must retain the above copyright notice, this
+**    list of conditions and the following disclaimer.
+**  2.Redistributions in binary form must reproduce the above copyright notice,
+**    this list of conditions and the following disclaimer in the documentation
+**    and / or other materials provided with the distribution.
+**  3.The name of StepToSky or the name of FlightFactor or the names of its
+**    contributors may NOT be used to endorse or promote products derived from
+**    this software without specific prior written permission.
+**
+**  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+**  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+**  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+**  DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+**  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+**  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+**  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+**  ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+**  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+**  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**
+**  Contacts: www.steptosky.com or www.flightfactor.aero
+*/
+
+#include "stdafx.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "stsff/logging/MappedFileSink.h"
+#include "stsff/logging/internal/FileWriter.h"
+
+#if !defined(_WIN32) && !defined(_WIN64)
+#   include <dirent.h>
+#   include <fcntl.h>
+#   include <sys/mman.h>
+#   include <sys/stat.h>
+#   include <unistd.h>
+#endif
+
+namespace stsff {
+namespace logging {
+
+    /**************************************************************************************************/
+    /////////////////////////////////////////* Static area *////////////////////////////////////////////
+    /**************************************************************************************************/
+
+    namespace {
+
+        struct Segment {
+            std::size_t mNumber = 0;
+            int mFd = -1;
+            char * mData = nullptr;
+            std::size_t mCapacity = 0;
+            std::atomic<std::size_t> mReserved{0};
+            std::atomic<std::size_t> mCommitted{0};
+            std::size_t mUsed = 0; //!< It is set when the segment is full or closed.
+        };
+
+        std::string segmentName(const std::string & fileName, const std::size_t number) {
+            return fileName + "." + std::to_string(number);
+        }
+
+        void printFileError(const char * what, const std::string & fileName, const char * function) {
+            internal::FileWriter::printError(what, fileName, errno, function);
+        }
+
+#if !defined(_WIN32) && !defined(_WIN64)
+
+        std::size_t lastSegmentNumber(const std::string & fileName) {
+            const std::size_t slash = fileName.find_last_of('/');
+            const std::string directory = slash == std::string::npos ? "." : slash == 0 ? "/" : fileName.substr(0, slash);
+            const std::string prefix = (slash == std::string::npos ? fileName : fileName.substr(slash + 1)) + ".";
+            DIR * dir = ::opendir(directory.c_str());
+            if (!dir) {
+                return 0;
+            }
+            std::size_t last = 0;
+            while (const dirent * entry = ::readdir(dir)) {
+                const char * name = entry->d_name;
+                if (std::strncmp(name, prefix.c_str(), prefix.size()) != 0 || name[prefix.size()] == '\0') {
+                    continue;
+                }
+                std::size_t number = 0;
+                const char * digit = name + prefix.size();
+                for (; *digit >= '0' && *digit <= '9'; ++digit) {
+                    number = number * 10 + std::size_t(*digit - '0');
+                }
+                if (*digit == '\0') {
+                    last = std::max(last, number);
+                }
+            }
+            ::closedir(dir);
+            return last;
+        }
+
+        /*!
+         * \details Creates the segment with the number or the next free one, preallocates and maps it.
+         */
+        bool openSegment(Segment & segment, const std::string & fileName, std::size_t number, const std::size_t capacity) {
+            std::string name = segmentName(fileName, number);
+            int fd;
+            while ((fd = ::open(name.c_str(), O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0644)) < 0 && errno == EEXIST) {
+                name = segmentName(fileName, ++number);
+            }
+            if (fd < 0) {
+                printFileError("can't create the log segment", name, __STS_FUNC_NAME__);
+                return false;
+            }
+#if defined(__linux__)
+            int result = ::fallocate(fd, 0, 0, off_t(capacity));
+            if (result != 0 && (errno == EOPNOTSUPP || errno == ENOSYS)) {
+                result = ::ftruncate(fd, off_t(capacity));
+            }
+#else
+            const int result = ::ftruncate(fd, off_t(capacity));
+#endif
+            void * data = result == 0 ? ::mmap(nullptr, capacity, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0) : MAP_FAILED;
+            if (data == MAP_FAILED) {
+                printFileError("can't allocate the log segment", name, __STS_FUNC_NAME__);
+                ::close(fd);
+                ::unlink(name.c_str());
+                return false;
+            }
+            // The pages are written here, so the logging threads don't take the page faults
+            // that the system uses to track the first write into a page of the shared mapping.
+            static const std::size_t pageSize = std::size_t(::sysconf(_SC_PAGESIZE));
+            volatile char * pages = static_cast<char *>(data);
+            for (std::size_t offset = 0; offset < capacity; offset += pageSize) {
+                pages[offset] = 0;
+            }
+            segment.mNumber = number;
+            segment.mFd = fd;
+            segment.mData = static_cast<char *>(data);
+            segment.mCapacity = capacity;
+            return true;
+        }
+
+        void syncSegment(const Segment & segment, std::size_t from, const std::size_t to) noexcept {
+            static const std::size_t pageSize = std::size_t(::sysconf(_SC_PAGESIZE));
+            from -= from % pageSize;
+            if (to > from) {
+                ::msync(segment.mData + from, to - from, MS_SYNC);
+            }
+        }
+
+        void closeSegment(Segment & segment, const std::string & fileName, const bool sync) noexcept {
+            if (sync) {
+                syncSegment(segment, 0, segment.mUsed);
+            }
+            ::munmap(segment.mData, segment.mCapacity);
+            segment.mData = nullptr;
+            if (::ftruncate(segment.mFd, off_t(segment.mUsed)) != 0) {
+                printFileError("can't truncate the log segment", segmentName(fileName, segment.mNumber), __STS_FUNC_NAME__);
+            }
+            ::close(segment.mFd);
+            segment.mFd = -1;
+        }
+
+        void removeSegment(const std::string & fileName, const std::size_t number) noexcept {
+            ::unlink(segmentName(fileName, number).c_str());
+        }
+
+        /*!
+         * \details Recovers the segments from the last one down to the one that was closed,
+         *          after a crash the last segments are the current one and the empty spare one.
+         *          The empty segments at the end are removed.
+         * \return Number of the last remaining segment.
+         */
+        std::size_t recoverSegments(const std::string & fileName) {
+            std::size_t last = lastSegmentNumber(fileName);
+            for (std::size_t number = last; number != 0; --number) {
+                const std::string name = segmentName(fileName, number);
+                struct stat info;
+                if (::stat(name.c_str(), &info) != 0) {
+                    break;
+                }
+                const std::int64_t size = MappedFileSink::recover(name);
+                if (size == 0 && number == last) {
+                    removeSegment(fileName, number);
+                    --last;
+                    continue;
+                }
+                // the closed segment has the complete lines only and so do the older ones.
+                if (size < 0 || size == std::int64_t(info.st_size)) {
+                    break;
+                }
+            }
+            return last;
+        }
+
+#else
+
+        std::size_t recoverSegments(const std::string &) {
+            return 0;
+        }
+
+        bool openSegment(Segment &, const std::string &, std::size_t, std::size_t) {
+            std::cerr << colorize::red << "the memory-mapped log files aren't supported on this platform"
+                    << " [" << __STS_FUNC_NAME__ << "]" << colorize::reset << std::endl;
+            return false;
+        }
+
+        void syncSegment(const Segment &, std::size_t, std::size_t) noexcept {}
+        void closeSegment(Segment &, const std::string &, bool) noexcept {}
+        void removeSegment(const std::string &, std::size_t) noexcept {}
+
+#endif
+
+    }
+
+    /**************************************************************************************************/
+    ////////////////////////////////////////////////////////////////////////////////////////////////////
+    /**************************************************************************************************/
+
+    class MappedFileSink::Mapping final {
+    public:
+
+        Mapping(const std::string & fileName, const FormatPattern & pattern, const std::size_t segmentSize)
+            : mFileName(fileName),
+              mPattern(pattern),
+              mSegmentSize(segmentSize ? segmentSize : 1) {
+            mNextNumber = recoverSegments(fileName) + 1;
+            Segment * first = createSegment();
+            if (!first) {
+                return;
+            }
+            mCurrent.store(first, std::memory_order_release);
+            mOpen = true;
+            mWorker = std::thread(&Mapping::work, this);
+        }
+
+        Mapping(const Mapping &) = delete;
+        Mapping & operator=(const Mapping &) = delete;
+
+        ~Mapping() noexcept {
+            if (!mOpen) {
+                return;
+            }
+            {
+                std::lock_guard<std::mutex> lock(mMutex);
+                mStop = true;
+            }
+            mCondition.notify_one();
+            if (mWorker.joinable()) {
+                mWorker.join();
+            }
+            // there are no writing threads here and the background thread has closed the full segments.
+            Segment * current = mCurrent.load(std::memory_order_acquire);
+            if (current) {
+                current->mUsed = std::min(current->mReserved.load(std::memory_order_acquire), current->mCapacity);
+                closeSegment(*current, mFileName, isSynchronized());
+            }
+            Segment * spare = mSpare.exchange(nullptr, std::memory_order_acq_rel);
+            if (spare) {
+                closeSegment(*spare, mFileName, false);
+                removeSegment(mFileName, spare->mNumber);
+            }
+        }
+
+        //-------------------------------------------------------------------------
+
+        void write(const char * data, std::size_t size, const std::size_t level) {
+            // the line longer than the segment is cut, so it fits the next one.
+            size = std::min(size, mSegmentSize);
+            for (;;) {
+                Segment * segment = mCurrent.load(std::memory_order_acquire);
+                if (!segment) {
+                    return;
+                }
+                const std::size_t offset = segment->mReserved.fetch_add(size, std::memory_order_relaxed);
+                if (offset + size <= segment->mCapacity) {
+                    char * out = segment->mData + offset;
+                    std::memcpy(out + 1, data + 1, size - 1);
+                    out[size - 1] = '\n';
+                    // the first byte marks the line as complete for the recovery.
+                    std::atomic_thread_fence(std::memory_order_release);
+                    out[0] = data[0];
+                    if (level <= mSyncLevel.load(std::memory_order_relaxed)) {
+                        syncSegment(*segment, offset, offset + size);
+                    }
+                    segment->mCommitted.fetch_add(size, std::memory_order_release);
+                    mWritten.fetch_add(size, std::memory_order_relaxed);
+                    return;
+                }
+                if (offset <= segment->mCapacity) {
+                    // this thread is the first one that doesn't fit the segment.
+                    switchSegment(segment, offset);
+                }
+                else {
+                    while (mCurrent.load(std::memory_order_acquire) == segment) {
+                        std::this_thread::yield();
+                    }
+                }
+            }
+        }
+
+        void setSyncInterval(const std::int64_t milliseconds) {
+            {
+                std::lock_guard<std::mutex> lock(mMutex);
+                mSyncInterval.store(milliseconds, std::memory_order_relaxed);
+            }
+            mCondition.notify_one();
+        }
+
+        std::size_t segment() const noexcept {
+            const Segment * current = mCurrent.load(std::memory_order_acquire);
+            return current ? current->mNumber : 0;
+        }
+
+        //-------------------------------------------------------------------------
+
+        const std::string mFileName;
+        const FormatPattern mPattern;
+        const std::size_t mSegmentSize;
+        bool mOpen = false;
+        std::atomic<std::size_t> mSyncLevel{0};
+        std::atomic<std::uint64_t> mWritten{0};
+
+    private:
+
+        bool isSynchronized() const noexcept {
+            return mSyncLevel.load(std::memory_order_relaxed) != 0 || mSyncInterval.load(std::memory_order_relaxed) > 0;
+        }
+
+        void switchSegment(Segment * segment, const std::size_t used) {
+            segment->mUsed = used;
+            Segment * next;
+            while (!(next = mSpare.exchange(nullptr, std::memory_order_acq_rel))) {
+                if (mFailed.load(std::memory_order_acquire)) {
+                    break;
+                }
+                // the background thread hasn't prepared the next segment yet.
+                std::this_thread::yield();
+            }
+            mCurrent.store(next, std::memory_order_release);
+            {
+                std::lock_guard<std::mutex> lock(mMutex);
+                mClosing.push_back(segment);
+            }
+            mCondition.notify_one();
+        }
+
+        //-------------------------------------------------------------------------
+
+        /*!
+         * \details It is called by the constructor and the background thread only.
+         */
+        Segment * createSegment() {
+            std::unique_ptr<Segment> segment(new Segment);
+            if (!openSegment(*segment, mFileName, mNextNumber, mSegmentSize)) {
+                return nullptr;
+            }
+            mNextNumber = segment->mNumber + 1;
+            // the segments are kept until the sink is destroyed because the threads may still have
+            // the pointer of the switched segment, only its mapping is released when it is closed.
+            mSegments.push_back(std::move(segment));
+            return mSegments.back().get();
+        }
+
+        void work() noexcept {
+            internal::callNoexcept(__STS_FUNC_NAME__, [this]() { workLoop(); });
+        }
+
+        void workLoop() {
+            std::unique_lock<std::mutex> lock(mMutex);
+            auto lastSync = std::chrono::steady_clock::now();
+            for (;;) {
+                if (!mStop && !mFailed.load(std::memory_order_relaxed) && !mSpare.load(std::memory_order_acquire)) {
+                    lock.unlock();
+                    Segment * spare = createSegment();
+                    if (spare) {
+                        mSpare.store(spare, std::memory_order_release);
+                    }
+                    else {
+                        mFailed.store(true, std::memory_order_release);
+                    }
+                    lock.lock();
+                    continue;
+                }
+                if (!mClosing.empty()) {
+                    Segment * segment = mClosing.front();
+                    mClosing.pop_front();
+                    lock.unlock();
+                    while (segment->mCommitted.load(std::memory_order_acquire) != segment->mUsed) {
+                        std::this_thread::yield();
+                    }
+                    closeSegment(*segment, mFileName, isSynchronized());
+                    lock.lock();
+                    continue;
+                }
+                if (mStop) {
+                    break;
+                }
+                const std::int64_t interval = mSyncInterval.load(std::memory_order_relaxed);
+                if (interval <= 0) {
+                    mCondition.wait(lock);
+                    continue;
+                }
+                const auto syncTime = lastSync + std::chrono::milliseconds(interval);
+                if (mCondition.wait_until(lock, syncTime) == std::cv_status::timeout) {
+                    // the current segment is unmapped by this thread only.
+                    const Segment * current = mCurrent.load(std::memory_order_acquire);
+                    if (current) {
+                        syncSegment(*current, 0, std::min(current->mReserved.load(std::memory_order_relaxed),
+                                                          current->mCapacity));
+                    }
+                    lastSync = std::chrono::steady_clock::now();
+                }
+            }
+        }
+
+        //-------------------------------------------------------------------------
+
+        std::atomic<Segment *> mCurrent{nullptr};
+        std::atomic<Segment *> mSpare{nullptr};
+        std::atomic<bool> mFailed{false};
+        std::atomic<std::int64_t> mSyncInterval{0};
+
+        std::mutex mMutex;
+        std::condition_variable mCondition;
+        std::deque<Segment *> mClosing;
+        bool mStop = false;
+        std::thread mWorker;
+
+        std::vector<std::unique_ptr<Segment>> mSegments;
+        std::size_t mNextNumber = 1;
+
+    };
+
+    /**************************************************************************************************/
+    ////////////////////////////////////* Constructors/Destructor */////////////////////////////////////
+    /**************************************************************************************************/
+
+    MappedFileSink::MappedFileSink(const std::string & fileName, const FormatPattern & pattern, const std::size_t segmentSize)
+        : mMapping(std::make_shared<Mapping>(fileName, pattern, segmentSize)) {}
+
+    /**************************************************************************************************/
+    //////////////////////////////////////////* Functions */////////////////////////////////////////////
+    /**************************************************************************************************/
+
+    void MappedFileSink::operator()(const BaseLogger & logger, const BaseLogger::LogMsg & logMsg) const {
+        if (!mMapping->mOpen) {
+            return;
+        }
+        const internal::MessageBuffer & line = internal::renderLine(logger, logMsg, mMapping->mPattern);
+        mMapping->write(line.data(), line.size(), logMsg.mLevel);
+    }
+
+    void MappedFileSink::setSyncInterval(const std::int64_t milliseconds) noexcept {
+        internal::callNoexcept(__STS_FUNC_NAME__, [&]() { mMapping->setSyncInterval(milliseconds); });
+    }
+
+    void MappedFileSink::setSyncLevel(const std::size_t level) noexcept {
+        mMapping->mSyncLevel.store(level, std::memory_order_relaxed);
+    }
+
+    //-------------------------------------------------------------------------
+
+    const std::string & MappedFileSink::fileName() const noexcept {
+        return mMapping->mFileName;
+    }
+
+    std::size_t MappedFileSink::segmentSize() const noexcept {
+        return mMapping->mSegmentSize;
+    }
+
+    bool MappedFileSink::isOpen() const noexcept {
+        return mMapping->mOpen;
+    }
+
+    std::size_t MappedFileSink::segment() const noexcept {
+        return mMapping->segment();
+    }
+
+    std::uint64_t MappedFileSink::written() const noexcept {
+        return mMapping->mWritten.load(std::memory_order_relaxed);
+    }
+
+    //-------------------------------------------------------------------------
+
+    std::int64_t MappedFileSink::recover(const std::string & segmentFileName) noexcept {
+#if !defined(_WIN32) && !defined(_WIN64)
+        const int fd = ::open(segmentFileName.c_str(), O_RDWR | O_CLOEXEC);
+        if (fd < 0) {
+            return -1;
+        }
+        struct stat info;
+        if (::fstat(fd, &info) != 0) {
+            ::close(fd);
+            return -1;
+        }
+        const std::size_t size = std::size_t(info.st_size);
+        std::size_t end = 0;
+        if (size != 0) {
+            void * mapped = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+            if (mapped == MAP_FAILED) {
+                ::close(fd);
+                return -1;
+            }
+            const char * data = static_cast<const char *>(mapped);
+            while (end < size && data[end] != '\0') {
+                const void * newLine = std::memchr(data + end, '\n', size - end);
+                if (!newLine) {
+                    break;
+                }
+                end = std::size_t(static_cast<const char *>(newLine) - data) + 1;
+            }
+            ::munmap(mapped, size);
+        }
+        const bool truncated = end == size || ::ftruncate(fd, off_t(end)) == 0;
+        ::close(fd);
+        return truncated ? std::int64_t(end) : -1;
+#else
+        (void)segmentFileName;
+        return -1;
+#endif
+    }
+
+    /**************************************************************************************************/
+    ////////////////////////////////////////////////////////////////////////////////////////////////////
+    /**************************************************************************************************/
+
+}
+}
@@ -0,0 +1,500 @@
+/*
+**  Copyright(C) 2019, StepToSky and FlightFactor
+**  All rights reserved
+**
+**  Redistribution and use in source and binary forms, with or without
+**  modification, are permitted provided that the following conditions are met:
+**
+**  1.Redistributions of source code must retain the above copyright notice, this
+**    list of conditions and the following disclaimer.
+**  2.Redistributions in binary form must reproduce the above copyright notice,
+**    this list of conditions and the following disclaimer in the documentation
+**    and / or other materials provided with the distribution.
+**  3.The name of StepToSky or the name of FlightFactor or the names of its
+**    contributors may NOT be used to endorse or promote products derived from
+**    this software without specific prior written permission.
+**
+**  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+**  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+**  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+**  DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+**  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+**  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+**  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+**  ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+**  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+**  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**
+**  Contacts: www.steptosky.com or www.flightfactor.aero
+*/
+
+#include "stdafx.h"
+
+#include <atomic>
+#include <cerrno>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "stsff/logging/RotatingFileSink.h"
+#include "stsff/logging/internal/FileWriter.h"
+#include "stsff/logging/utils/LzCodec.h"
+
+#if defined(_WIN32) || defined(_WIN64)
+#   include <io.h>
+#   include <fcntl.h>
+#   include <sys/stat.h>
+#else
+#   include <fcntl.h>
+#   include <unistd.h>
+#endif
+
+namespace stsff {
+namespace logging {
+
+    /**************************************************************************************************/
+    /////////////////////////////////////////* Static area *////////////////////////////////////////////
+    /**************************************************************************************************/
+
+    namespace {
+
+        const std::size_t CompressChunk = 1024 * 1024;
+
+        void printFileError(const char * what, const std::string & fileName, const char * function) {
+            internal::FileWriter::printError(what, fileName, errno, function);
+        }
+
+        int openFile(const std::string & fileName, const bool truncate) noexcept {
+#if defined(_WIN32) || defined(_WIN64)
+            return ::_open(fileName.c_str(), _O_WRONLY | _O_CREAT | _O_APPEND | _O_BINARY | (truncate ? _O_TRUNC : 0),
+                           _S_IREAD | _S_IWRITE);
+#else
+            return ::open(fileName.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC | (truncate ? O_TRUNC : 0), 0644);
+#endif
+        }
+
+        void closeFile(const int fd) noexcept {
+#if defined(_WIN32) || defined(_WIN64)
+            ::_close(fd);
+#else
+            ::close(fd);
+#endif
+        }
+
+        std::uint64_t fileSize(const int fd) noexcept {
+#if defined(_WIN32) || defined(_WIN64)
+            const auto size = ::_lseeki64(fd, 0, SEEK_END);
+#else
+            const auto size = ::lseek(fd, 0, SEEK_END);
+#endif
+            return size > 0 ? std::uint64_t(size) : 0;
+        }
+
+        bool fileExists(const std::string & fileName) noexcept {
+            std::FILE * file = std::fopen(fileName.c_str(), "rb");
+            if (file) {
+                std::fclose(file);
+            }
+            return file != nullptr;
+        }
+
+        bool fileHasData(const std::string & fileName) noexcept {
+            std::FILE * file = std::fopen(fileName.c_str(), "rb");
+            if (!file) {
+                return false;
+            }
+            const bool result = std::fgetc(file) != EOF;
+            std::fclose(file);
+            return result;
+        }
+
+    }
+
+    /**************************************************************************************************/
+    ////////////////////////////////////////////////////////////////////////////////////////////////////
+    /**************************************************************************************************/
+
+    class RotatingFileSink::File final {
+    public:
+
+        File(const std::string & fileName, const FormatPattern & pattern, const Rotation & rotation,
+             const std::size_t bufferSize)
+            : mFileName(fileName),
+              mPattern(pattern),
+              mRotation(rotation),
+              mNextName(fileName + ".next"),
+              mWriter(fileName),
+              mBuffer(new char[bufferSize ? bufferSize : 1]),
+              mCapacity(bufferSize ? bufferSize : 1) {
+            // the spare file always exists while the sink works, it has the messages
+            // only if the process was stopped after the switch and before the renaming.
+            const bool interrupted = fileHasData(mNextName);
+            if (interrupted) {
+                renameFiles();
+            }
+            mFd = openFile(fileName, false);
+            if (mFd < 0) {
+                printFileError("can't open the log file", fileName, __STS_FUNC_NAME__);
+                return;
+            }
+            mOpen = true;
+            mSegmentSize = fileSize(mFd);
+            mNextBoundary = nextBoundary();
+            if (interrupted || mRotation.mCompress) {
+                // the background thread compresses the renamed file
+                // and the ones left uncompressed by the previous process.
+                mJobs.push_back(-1);
+            }
+            openSpare();
+            mWorker = std::thread(&File::work, this);
+        }
+
+        File(const File &) = delete;
+        File & operator=(const File &) = delete;
+
+        ~File() noexcept {
+            if (!mOpen) {
+                return;
+            }
+            writeOut(mBuffer.get(), mSize);
+            closeFile(mFd);
+            {
+                std::lock_guard<std::mutex> lock(mJobsMutex);
+                mStop = true;
+            }
+            mJobsCondition.notify_one();
+            if (mWorker.joinable()) {
+                mWorker.join();
+            }
+        }
+
+        //-------------------------------------------------------------------------
+
+        void write(const char * data, const std::size_t size, const std::size_t level) {
+            std::lock_guard<std::mutex> lock(mMutex);
+            if (size > mCapacity - mSize) {
+                flushLocked();
+            }
+            if (size >= mCapacity) {
+                writeOut(data, size);
+            }
+            else {
+                std::memcpy(mBuffer.get() + mSize, data, size);
+                mSize += size;
+            }
+            mSegmentSize += size;
+            ++mUnflushed;
+            if (!(rotationRequired() && rotateLocked()) && mPolicy.isDue(level, mUnflushed, mLastFlush)) {
+                flushLocked();
+            }
+        }
+
+        void flush() {
+            std::lock_guard<std::mutex> lock(mMutex);
+            flushLocked();
+        }
+
+        void setFlushPolicy(const FlushPolicy & policy) {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mPolicy = policy;
+            mLastFlush = TimeSource::now(TimeSource::ClockCoarse);
+        }
+
+        //-------------------------------------------------------------------------
+
+        const std::string mFileName;
+        const FormatPattern mPattern;
+        const Rotation mRotation;
+        bool mOpen = false;
+        std::atomic<std::size_t> mRotations{0};
+
+    private:
+
+        //-------------------------------------------------------------------------
+        // The logging threads
+
+        bool rotationRequired() const noexcept {
+            if (mRotation.mMaxSize != 0 && mSegmentSize >= mRotation.mMaxSize) {
+                return true;
+            }
+            return mRotation.mIntervalSec > 0 && TimeSource::now(TimeSource::ClockCoarse) >= mNextBoundary;
+        }
+
+        std::int64_t nextBoundary() const noexcept {
+            if (mRotation.mIntervalSec <= 0) {
+                return 0;
+            }
+            const std::int64_t interval = mRotation.mIntervalSec * 1000000000;
+            return (TimeSource::now(TimeSource::ClockCoarse) / interval + 1) * interval;
+        }
+
+        /*!
+         * \details Switches to the spare file and gives the old one to the background thread.
+         * \return False if the spare file isn't ready yet.
+         */
+        bool rotateLocked() {
+            int spare;
+            {
+                std::lock_guard<std::mutex> lock(mJobsMutex);
+                if (mSpareFd < 0) {
+                    return false;
+                }
+                spare = mSpareFd;
+                mSpareFd = -1;
+            }
+            flushLocked();
+            const int old = mFd;
+            mFd = spare;
+            mSegmentSize = 0;
+            mNextBoundary = nextBoundary();
+            {
+                std::lock_guard<std::mutex> lock(mJobsMutex);
+                mJobs.push_back(old);
+            }
+            mJobsCondition.notify_one();
+            return true;
+        }
+
+        void flushLocked() noexcept {
+            writeOut(mBuffer.get(), mSize);
+            mSize = 0;
+            mUnflushed = 0;
+            if (mPolicy.mIntervalMs > 0) {
+                mLastFlush = TimeSource::now(TimeSource::ClockCoarse);
+            }
+        }
+
+        void writeOut(const char * data, const std::size_t size) noexcept {
+            if (mFd >= 0) {
+                mWriter.write(mFd, data, size);
+            }
+        }
+
+        //-------------------------------------------------------------------------
+        // The background thread
+
+        void work() noexcept {
+            try {
+                std::unique_lock<std::mutex> lock(mJobsMutex);
+                for (;;) {
+                    mJobsCondition.wait(lock, [this]() { return mStop || !mJobs.empty(); });
+                    if (mJobs.empty()) {
+                        break;
+                    }
+                    const int fd = mJobs.front();
+                    mJobs.pop_front();
+                    lock.unlock();
+                    if (fd >= 0) {
+                        closeFile(fd);
+                        renameFiles();
+                        // the spare file is ready before the compression that may take a while,
+                        // so the current file doesn't grow over the limit meanwhile.
+                        openSpare();
+                    }
+                    if (mRotation.mCompress && mRotation.mKeepFiles != 0) {
+                        compressHistory();
+                    }
+                    if (fd >= 0) {
+                        mRotations.fetch_add(1, std::memory_order_release);
+                    }
+                    lock.lock();
+                }
+                if (mSpareFd >= 0) {
+                    closeFile(mSpareFd);
+                    mSpareFd = -1;
+                    std::remove(mNextName.c_str());
+                }
+            }
+            catch (const std::exception & e) {
+                std::cerr << colorize::red << e.what() << " [" << __STS_FUNC_NAME__ << "]" << colorize::reset << std::endl;
+            }
+            catch (...) {
+                std::cerr << colorize::red << "unknown exception [" << __STS_FUNC_NAME__ << "]" << colorize::reset << std::endl;
+            }
+        }
+
+        void openSpare() {
+            const int fd = openFile(mNextName, true);
+            if (fd < 0) {
+                printFileError("can't open the log file", mNextName, __STS_FUNC_NAME__);
+                return;
+            }
+            std::lock_guard<std::mutex> lock(mJobsMutex);
+            mSpareFd = fd;
+        }
+
+        std::string historyName(const std::size_t index, const char * extension = "") const {
+            return mFileName + "." + std::to_string(index) + extension;
+        }
+
+        /*!
+         * \details Shifts the old files, the current file becomes the first old one
+         *          and the spare file becomes the current one.
+         */
+        void renameFiles() const {
+            const std::size_t keep = mRotation.mKeepFiles;
+            if (keep == 0) {
+                std::remove(mFileName.c_str());
+            }
+            else {
+                const char * extensions[] = {"", ".lz"};
+                // the old files are numbered without the gaps, so only the existing ones are touched.
+                std::size_t last = 0;
+                while (fileExists(historyName(last + 1)) || fileExists(historyName(last + 1, ".lz"))) {
+                    ++last;
+                }
+                for (std::size_t i = last; i != 0; --i) {
+                    for (const char * extension : extensions) {
+                        const std::string from = historyName(i, extension);
+                        if (i >= keep) {
+                            std::remove(from.c_str());
+                        }
+                        else {
+                            // the missing files are skipped silently.
+                            std::rename(from.c_str(), historyName(i + 1, extension).c_str());
+                        }
+                    }
+                }
+                if (std::rename(mFileName.c_str(), historyName(1).c_str()) != 0 && errno != ENOENT) {
+                    printFileError("can't rename the log file", mFileName, __STS_FUNC_NAME__);
+                }
+            }
+            if (std::rename(mNextName.c_str(), mFileName.c_str()) != 0) {
+                printFileError("can't rename the log file", mNextName, __STS_FUNC_NAME__);
+            }
+        }
+
+        /*!
+         * \details Compresses all the old files that aren't compressed yet,
+         *          usually it is the first one but the compression may have been interrupted before.
+         */
+        void compressHistory() const {
+            for (std::size_t i = 1; fileExists(historyName(i)) || fileExists(historyName(i, ".lz")); ++i) {
+                compressFile(historyName(i));
+            }
+        }
+
+        /*!
+         * \details Compresses the file by chunks into the temporary file
+         *          that is renamed when it is complete, then the original file is deleted.
+         */
+        void compressFile(const std::string & fileName) const {
+            std::FILE * in = std::fopen(fileName.c_str(), "rb");
+            if (!in) {
+                return;
+            }
+            const std::string packedName = fileName + ".lz";
+            const std::string tmpName = packedName + ".tmp";
+            std::FILE * out = std::fopen(tmpName.c_str(), "wb");
+            if (!out) {
+                printFileError("can't open the log file", tmpName, __STS_FUNC_NAME__);
+                std::fclose(in);
+                return;
+            }
+            std::vector<char> chunk(CompressChunk);
+            std::string packed;
+            bool ok = true;
+            bool empty = true;
+            std::size_t size;
+            while (ok && (size = std::fread(chunk.data(), 1, chunk.size(), in)) != 0) {
+                packed.clear();
+                LzCodec::compress(chunk.data(), size, packed);
+                ok = std::fwrite(packed.data(), 1, packed.size(), out) == packed.size();
+                empty = false;
+            }
+            if (ok && empty) {
+                LzCodec::compress(chunk.data(), 0, packed);
+                ok = std::fwrite(packed.data(), 1, packed.size(), out) == packed.size();
+            }
+            ok = !std::ferror(in) && ok;
+            std::fclose(in);
+            ok = std::fclose(out) == 0 && ok;
+            if (ok && std::rename(tmpName.c_str(), packedName.c_str()) == 0) {
+                std::remove(fileName.c_str());
+            }
+            else {
+                printFileError("can't compress the log file", fileName, __STS_FUNC_NAME__);
+                std::remove(tmpName.c_str());
+            }
+        }
+
+        //-------------------------------------------------------------------------
+
+        const std::string mNextName;
+        internal::FileWriter mWriter;
+        int mFd = -1;
+
+        std::mutex mMutex;
+        std::unique_ptr<char[]> mBuffer;
+        const std::size_t mCapacity;
+        std::size_t mSize = 0;
+        std::uint64_t mSegmentSize = 0;
+        std::int64_t mNextBoundary = 0;
+        FlushPolicy mPolicy = FlushPolicy::never();
+        std::size_t mUnflushed = 0;
+        std::int64_t mLastFlush = 0;
+
+        std::mutex mJobsMutex;
+        std::condition_variable mJobsCondition;
+        std::deque<int> mJobs;
+        int mSpareFd = -1;
+        bool mStop = false;
+        std::thread mWorker;
+
+    };
+
+    /**************************************************************************************************/
+    ////////////////////////////////////* Constructors/Destructor */////////////////////////////////////
+    /**************************************************************************************************/
+
+    RotatingFileSink::RotatingFileSink(const std::string & fileName, const FormatPattern & pattern,
+                                       const Rotation & rotation, const std::size_t bufferSize)
+        : mFile(std::make_shared<File>(fileName, pattern, rotation, bufferSize)) {}
+
+    /**************************************************************************************************/
+    //////////////////////////////////////////* Functions */////////////////////////////////////////////
+    /**************************************************************************************************/
+
+    void RotatingFileSink::operator()(const BaseLogger & logger, const BaseLogger::LogMsg & logMsg) const {
+        if (!mFile->mOpen) {
+            return;
+        }
+        const internal::MessageBuffer & line = internal::renderLine(logger, logMsg, mFile->mPattern);
+        mFile->write(line.data(), line.size(), logMsg.mLevel);
+    }
+
+    void RotatingFileSink::flush() const noexcept {
+        internal::callNoexcept(__STS_FUNC_NAME__, [&]() { mFile->flush(); });
+    }
+
+    void RotatingFileSink::setFlushPolicy(const FlushPolicy & policy) noexcept {
+        internal::callNoexcept(__STS_FUNC_NAME__, [&]() { mFile->setFlushPolicy(policy); });
+    }
+
+    //-------------------------------------------------------------------------
+
+    const std::string & RotatingFileSink::fileName() const noexcept {
+        return mFile->mFileName;
+    }
+
+    const RotatingFileSink::Rotation & RotatingFileSink::rotation() const noexcept {
+        return mFile->mRotation;
+    }
+
+    bool RotatingFileSink::isOpen() const noexcept {
+        return mFile->mOpen;
+    }
+
+    std::size_t RotatingFileSink::rotations() const noexcept {
+        return mFile->mRotations.load(std::memory_order_acquire);
+    }
+
+    /**************************************************************************************************/
+    ////////////////////////////////////////////////////////////////////////////////////////////////////
+    /**************************************************************************************************/
+
+}
+}
@@ -0,0 +1,118 @@
+/*
+**  Copyright(C) 2019, StepToSky and FlightFactor
+**  All rights reserved
+**
+**  Redistribution and use in source and binary forms, with or without
+**  modification, are permitted provided that the following conditions are met:
+**
+**  1.Redistributions of source code must retain the above copyright notice, this
+**    list of conditions and the following disclaimer.
+**  2.Redistributions in binary form must reproduce the above copyright notice,
+**    this list of conditions and the following disclaimer in the documentation
+**    and / or other materials provided with the distribution.
+**  3.The name of StepToSky or the name of FlightFactor or the names of its
+**    contributors may NOT be used to endorse or promote products derived from
+**    this software without specific prior written permission.
+**
+**  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+**  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+**  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+**  DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+**  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+**  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+**  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+**  ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+**  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+**  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**
+**  Contacts: www.steptosky.com or www.flightfactor.aero
+*/
+
+#include "stdafx.h"
+
+#include "stsff/logging/internal/AsyncQueue.h"
+
+namespace stsff {
+namespace logging {
+    namespace internal {
+
+        /**************************************************************************************************/
+        //////////////////////////////////////////* Functions */////////////////////////////////////////////
+        /**************************************************************************************************/
+
+        void LogRecord::assign(const BaseLogger::LogMsg & logMsg, const TimeSource::Stamp & time) {
+            const CodeLocation & location = logMsg.mCodeLocation;
+            mText.clear();
+            mCategorySize = mMsgSize = mFunctionSize = mFileSize = 0;
+            mText.reserve(logMsg.mCategory.size() + logMsg.mMsg.size() + location.mFunction.size() + location.mFile.size());
+            mText.append(logMsg.mCategory.data(), logMsg.mCategory.size());
+            mCategorySize = logMsg.mCategory.size();
+            mText.append(logMsg.mMsg.data(), logMsg.mMsg.size());
+            mMsgSize = logMsg.mMsg.size();
+            mText.append(location.mFunction.data(), location.mFunction.size());
+            mFunctionSize = location.mFunction.size();
+            mText.append(location.mFile.data(), location.mFile.size());
+            mFileSize = location.mFile.size();
+            mLevel = logMsg.mLevel;
+            mTime = time;
+            mLine = location.mLine;
+        }
+
+        BaseLogger::LogMsg LogRecord::logMsg() const noexcept {
+            typedef BaseLogger::StringView StringView;
+            const char * text = mText.data();
+            const StringView category(text, mCategorySize);
+            text += mCategorySize;
+            const StringView msg(text, mMsgSize);
+            text += mMsgSize;
+            const StringView function(text, mFunctionSize);
+            text += mFunctionSize;
+            const StringView file(text, mFileSize);
+            BaseLogger::LogMsg logMsg(mLevel, category, msg, CodeLocation(function, file, mLine));
+            logMsg.mTime = TimeSource::toNanoseconds(mTime);
+            return logMsg;
+        }
+
+        /**************************************************************************************************/
+        ////////////////////////////////////* Constructors/Destructor */////////////////////////////////////
+        /**************************************************************************************************/
+
+        AsyncQueue::AsyncQueue(std::size_t capacity) {
+            std::size_t size = 2;
+            while (size < capacity) {
+                size <<= 1;
+            }
+            mCells.reset(new Cell[size]);
+            mMask = size - 1;
+            for (std::size_t i = 0; i < size; ++i) {
+                mCells[i].mSequence.store(i, std::memory_order_relaxed);
+                mCells[i].mValid = false;
+            }
+        }
+
+        /**************************************************************************************************/
+        //////////////////////////////////////////* Functions */////////////////////////////////////////////
+        /**************************************************************************************************/
+
+        bool AsyncQueue::copy(LogRecord & record, const BaseLogger::LogMsg & logMsg,
+                              const TimeSource::Stamp & time) noexcept {
+            try {
+                record.assign(logMsg, time);
+                return true;
+            }
+            catch (const std::exception & e) {
+                std::cerr << colorize::red << e.what() << " [" << __STS_FUNC_NAME__ << "]" << colorize::reset << std::endl;
+            }
+            catch (...) {
+                std::cerr << colorize::red << "unknown exception [" << __STS_FUNC_NAME__ << "]" << colorize::reset << std::endl;
+            }
+            return false;
+        }
+
+        /**************************************************************************************************/
+        ////////////////////////////////////////////////////////////////////////////////////////////////////
+        /**************************************************************************************************/
+
+    }
+}
+}
@@ -0,0 +1,490 @@
+/*
+**  Copyright(C) 2019, StepToSky and FlightFactor
+**  All rights reserved
+**
+**  Redistribution and use in source and binary forms, with or without
+**  modification, are permitted provided that the following conditions are met:
+**
+**  1.Redistributions of source code must retain the above copyright notice, this
+**    list of conditions and the following disclaimer.
+**  2.Redistributions in binary form must reproduce the above copyright notice,
+**    this list of conditions and the following disclaimer in the documentation
+**    and / or other materials provided with the distribution.
+**  3.The name of StepToSky or the name of FlightFactor or the names of its
+**    contributors may NOT be used to endorse or promote products derived from
+**    this software without specific prior written permission.
+**
+**  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+**  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+**  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+**  DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+**  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+**  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+**  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+**  ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+**  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+**  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**
+**  Contacts: www.steptosky.com or www.flightfactor.aero
+*/
+
+#include "stdafx.h"
+
+#include <cstring>
+#include <limits>
+#include "stsff/logging/internal/FastFormat.h"
+
+#if __cplusplus >= 201703L
+#   include <charconv>
+#endif
+
+#if defined(__cpp_lib_to_chars) && (__cpp_lib_to_chars >= 201611L)
+#   define STSFF_LOGGER_USE_TO_CHARS
+#endif
+
+namespace stsff {
+namespace logging {
+    namespace internal {
+
+        /**************************************************************************************************/
+        /////////////////////////////////////////* Static area *////////////////////////////////////////////
+        /**************************************************************************************************/
+
+        static const char gDigitPairs[201] =
+                "00010203040506070809"
+                "10111213141516171819"
+                "20212223242526272829"
+                "30313233343536373839"
+                "40414243444546474849"
+                "50515253545556575859"
+                "60616263646566676869"
+                "70717273747576777879"
+                "80818283848586878889"
+                "90919293949596979899";
+
+        inline std::size_t countDigits(const std::uint64_t value) noexcept {
+            std::size_t count = 1;
+            for (std::uint64_t v = value; v >= 10; v /= 10) {
+                ++count;
+            }
+            return count;
+        }
+
+        /*!
+         * \details Writes the digits backward, the end must be the position after the last digit.
+         */
+        inline void writeDigits(char * end, std::uint64_t value) noexcept {
+            while (value >= 100) {
+                const auto pair = std::size_t(value % 100) * 2;
+                value /= 100;
+                *--end = gDigitPairs[pair + 1];
+                *--end = gDigitPairs[pair];
+            }
+            if (value >= 10) {
+                const auto pair = std::size_t(value) * 2;
+                *--end = gDigitPairs[pair + 1];
+                *--end = gDigitPairs[pair];
+            }
+            else {
+                *--end = char('0' + value);
+            }
+        }
+
+        inline std::size_t writeSpecial(char * out, const double value) noexcept {
+            std::size_t length = 0;
+            if (value != value) {
+                std::memcpy(out, "nan", 3);
+                return 3;
+            }
+            if (value < 0) {
+                out[length++] = '-';
+            }
+            std::memcpy(out + length, "inf", 3);
+            return length + 3;
+        }
+
+        /**************************************************************************************************/
+        /////////////////////////////////////////* Static area *////////////////////////////////////////////
+        /**************************************************************************************************/
+
+#ifndef STSFF_LOGGER_USE_TO_CHARS
+
+        // Grisu2 algorithm by Florian Loitsch
+        // "Printing Floating-Point Numbers Quickly and Accurately with Integers".
+        // The result is always read back to the same value and in most cases it is the shortest one.
+
+        struct DiyFp {
+            DiyFp() = default;
+
+            DiyFp(const std::uint64_t f, const int e) noexcept
+                : mF(f),
+                  mE(e) {}
+
+            DiyFp operator-(const DiyFp & other) const noexcept {
+                return DiyFp(mF - other.mF, mE);
+            }
+
+            DiyFp operator*(const DiyFp & other) const noexcept {
+                const std::uint64_t mask32 = 0xFFFFFFFFu;
+                const std::uint64_t a = mF >> 32;
+                const std::uint64_t b = mF & mask32;
+                const std::uint64_t c = other.mF >> 32;
+                const std::uint64_t d = other.mF & mask32;
+                const std::uint64_t ac = a * c;
+                const std::uint64_t bc = b * c;
+                const std::uint64_t ad = a * d;
+                const std::uint64_t bd = b * d;
+                std::uint64_t tmp = (bd >> 32) + (ad & mask32) + (bc & mask32);
+                tmp += std::uint64_t(1) << 31; // round
+                return DiyFp(ac + (ad >> 32) + (bc >> 32) + (tmp >> 32), mE + other.mE + 64);
+            }
+
+            DiyFp normalized() const noexcept {
+                DiyFp res = *this;
+                while (!(res.mF & (std::uint64_t(1) << 63))) {
+                    res.mF <<= 1;
+                    --res.mE;
+                }
+                return res;
+            }
+
+            std::uint64_t mF = 0;
+            int mE = 0;
+        };
+
+        static const std::uint64_t gCachedPowersF[] = {
+            0xfa8fd5a0081c0288ULL, 0xbaaee17fa23ebf76ULL, 0x8b16fb203055ac76ULL,
+            0xcf42894a5dce35eaULL, 0x9a6bb0aa55653b2dULL, 0xe61acf033d1a45dfULL,
+            0xab70fe17c79ac6caULL, 0xff77b1fcbebcdc4fULL, 0xbe5691ef416bd60cULL,
+            0x8dd01fad907ffc3cULL, 0xd3515c2831559a83ULL, 0x9d71ac8fada6c9b5ULL,
+            0xea9c227723ee8bcbULL, 0xaecc49914078536dULL, 0x823c12795db6ce57ULL,
+            0xc21094364dfb5637ULL, 0x9096ea6f3848984fULL, 0xd77485cb25823ac7ULL,
+            0xa086cfcd97bf97f4ULL, 0xef340a98172aace5ULL, 0xb23867fb2a35b28eULL,
+            0x84c8d4dfd2c63f3bULL, 0xc5dd44271ad3cdbaULL, 0x936b9fcebb25c996ULL,
+            0xdbac6c247d62a584ULL, 0xa3ab66580d5fdaf6ULL, 0xf3e2f893dec3f126ULL,
+            0xb5b5ada8aaff80b8ULL, 0x87625f056c7c4a8bULL, 0xc9bcff6034c13053ULL,
+            0x964e858c91ba2655ULL, 0xdff9772470297ebdULL, 0xa6dfbd9fb8e5b88fULL,
+            0xf8a95fcf88747d94ULL, 0xb94470938fa89bcfULL, 0x8a08f0f8bf0f156bULL,
+            0xcdb02555653131b6ULL, 0x993fe2c6d07b7facULL, 0xe45c10c42a2b3b06ULL,
+            0xaa242499697392d3ULL, 0xfd87b5f28300ca0eULL, 0xbce5086492111aebULL,
+            0x8cbccc096f5088ccULL, 0xd1b71758e219652cULL, 0x9c40000000000000ULL,
+            0xe8d4a51000000000ULL, 0xad78ebc5ac620000ULL, 0x813f3978f8940984ULL,
+            0xc097ce7bc90715b3ULL, 0x8f7e32ce7bea5c70ULL, 0xd5d238a4abe98068ULL,
+            0x9f4f2726179a2245ULL, 0xed63a231d4c4fb27ULL, 0xb0de65388cc8ada8ULL,
+            0x83c7088e1aab65dbULL, 0xc45d1df942711d9aULL, 0x924d692ca61be758ULL,
+            0xda01ee641a708deaULL, 0xa26da3999aef774aULL, 0xf209787bb47d6b85ULL,
+            0xb454e4a179dd1877ULL, 0x865b86925b9bc5c2ULL, 0xc83553c5c8965d3dULL,
+            0x952ab45cfa97a0b3ULL, 0xde469fbd99a05fe3ULL, 0xa59bc234db398c25ULL,
+            0xf6c69a72a3989f5cULL, 0xb7dcbf5354e9beceULL, 0x88fcf317f22241e2ULL,
+            0xcc20ce9bd35c78a5ULL, 0x98165af37b2153dfULL, 0xe2a0b5dc971f303aULL,
+            0xa8d9d1535ce3b396ULL, 0xfb9b7cd9a4a7443cULL, 0xbb764c4ca7a44410ULL,
+            0x8bab8eefb6409c1aULL, 0xd01fef10a657842cULL, 0x9b10a4e5e9913129ULL,
+            0xe7109bfba19c0c9dULL, 0xac2820d9623bf429ULL, 0x80444b5e7aa7cf85ULL,
+            0xbf21e44003acdd2dULL, 0x8e679c2f5e44ff8fULL, 0xd433179d9c8cb841ULL,
+            0x9e19db92b4e31ba9ULL, 0xeb96bf6ebadf77d9ULL, 0xaf87023b9bf0ee6bULL,
+        };
+
+        static const short gCachedPowersE[] = {
+            -1220, -1193, -1166, -1140, -1113, -1087, -1060, -1034, -1007, -980, -954, -927,
+            -901, -874, -847, -821, -794, -768, -741, -715, -688, -661, -635, -608,
+            -582, -555, -529, -502, -475, -449, -422, -396, -369, -343, -316, -289,
+            -263, -236, -210, -183, -157, -130, -103, -77, -50, -24, 3, 30,
+            56, 83, 109, 136, 162, 189, 216, 242, 269, 295, 322, 348,
+            375, 402, 428, 455, 481, 508, 534, 561, 588, 614, 641, 667,
+            694, 720, 747, 774, 800, 827, 853, 880, 907, 933, 960, 986,
+            1013, 1039, 1066,
+        };
+
+        static const std::uint64_t gPow10[] = {
+            1ULL, 10ULL, 100ULL, 1000ULL, 10000ULL, 100000ULL, 1000000ULL, 10000000ULL, 100000000ULL,
+            1000000000ULL, 10000000000ULL, 100000000000ULL, 1000000000000ULL, 10000000000000ULL,
+            100000000000000ULL, 1000000000000000ULL, 10000000000000000ULL, 100000000000000000ULL,
+            1000000000000000000ULL, 10000000000000000000ULL
+        };
+
+        inline DiyFp cachedPower(const int e, int & k) noexcept {
+            const double dk = (-61 - e) * 0.30102999566398114 + 347; // dk must be positive
+            int ik = static_cast<int>(dk);
+            if (dk - ik > 0.0) {
+                ++ik;
+            }
+            const auto index = static_cast<std::size_t>((ik >> 3) + 1);
+            k = -(-348 + static_cast<int>(index << 3)); // decimal exponent
+            return DiyFp(gCachedPowersF[index], gCachedPowersE[index]);
+        }
+
+        inline void grisuRound(char * buffer, const int length, const std::uint64_t delta, std::uint64_t rest,
+                               const std::uint64_t tenKappa, const std::uint64_t wpW) noexcept {
+            while (rest < wpW && delta - rest >= tenKappa &&
+                   (rest + tenKappa < wpW || wpW - rest > rest + tenKappa - wpW)) {
+                --buffer[length - 1];
+                rest += tenKappa;
+            }
+        }
+
+        inline void digitGen(const DiyFp & w, const DiyFp & mp, std::uint64_t delta,
+                             char * buffer, int & length, int & k) noexcept {
+            const DiyFp one(std::uint64_t(1) << -mp.mE, mp.mE);
+            const DiyFp wpW = mp - w;
+            auto p1 = static_cast<std::uint32_t>(mp.mF >> -one.mE);
+            std::uint64_t p2 = mp.mF & (one.mF - 1);
+            auto kappa = static_cast<int>(countDigits(p1));
+            length = 0;
+
+            while (kappa > 0) {
+                const auto pow10 = static_cast<std::uint32_t>(gPow10[kappa - 1]);
+                const std::uint32_t d = p1 / pow10;
+                p1 %= pow10;
+                if (d || length) {
+                    buffer[length++] = static_cast<char>('0' + d);
+                }
+                --kappa;
+                const std::uint64_t tmp = (static_cast<std::uint64_t>(p1) << -one.mE) + p2;
+                if (tmp <= delta) {
+                    k += kappa;
+                    grisuRound(buffer, length, delta, tmp, gPow10[kappa] << -one.mE, wpW.mF);
+                    return;
+                }
+            }
+
+            for (;;) {
+                p2 *= 10;
+                delta *= 10;
+                const auto d = static_cast<char>(p2 >> -one.mE);
+                if (d || length) {
+                    buffer[length++] = static_cast<char>('0' + d);
+                }
+                p2 &= one.mF - 1;
+                --kappa;
+                if (p2 < delta) {
+                    k += kappa;
+                    const int index = -kappa;
+                    grisuRound(buffer, length, delta, p2, one.mF, wpW.mF * (index < 20 ? gPow10[index] : 0));
+                    return;
+                }
+            }
+        }
+
+        /*!
+         * \param [in] f significand with the hidden bit.
+         * \param [in] e binary exponent.
+         * \param [in] lowerCloser the lower boundary is closer (the significand is power of 2).
+         * \param [out] buffer digits.
+         * \param [out] length number of the digits.
+         * \param [out] k decimal exponent of the last digit.
+         */
+        inline void grisu2(const std::uint64_t f, const int e, const bool lowerCloser,
+                           char * buffer, int & length, int & k) noexcept {
+            const DiyFp v(f, e);
+            const DiyFp plus = DiyFp((f << 1) + 1, e - 1).normalized();
+            DiyFp minus = lowerCloser ? DiyFp((f << 2) - 1, e - 2) : DiyFp((f << 1) - 1, e - 1);
+            minus.mF <<= minus.mE - plus.mE;
+            minus.mE = plus.mE;
+
+            const DiyFp cMk = cachedPower(plus.mE, k);
+            const DiyFp w = v.normalized() * cMk;
+            DiyFp wp = plus * cMk;
+            DiyFp wm = minus * cMk;
+            ++wm.mF;
+            --wp.mF;
+            digitGen(w, wp, wp.mF - wm.mF, buffer, length, k);
+        }
+
+        /*!
+         * \details Chooses the fixed or the scientific notation by the length as std::to_chars does.
+         * \param [out] out
+         * \param [in] digits
+         * \param [in] length number of the digits.
+         * \param [in] k decimal exponent of the last digit.
+         * \return Number of written chars.
+         */
+        inline std::size_t prettify(char * out, const char * digits, const int length, const int k) noexcept {
+            const int point = length + k; // position of the decimal point
+            const int exponent = point - 1;
+            const int exponentDigits = (exponent >= 100 || exponent <= -100) ? 3 : 2;
+            const int scientificLength = length + (length > 1 ? 1 : 0) + 2 + exponentDigits;
+            int fixedLength = 0;
+            if (point >= length) {
+                fixedLength = point;
+            }
+            else if (point > 0) {
+                fixedLength = length + 1;
+            }
+            else {
+                fixedLength = 2 - point + length;
+            }
+
+            char * ch = out;
+            if (fixedLength <= scientificLength) {
+                if (point >= length) {
+                    std::memcpy(ch, digits, std::size_t(length));
+                    std::memset(ch + length, '0', std::size_t(point - length));
+                }
+                else if (point > 0) {
+                    std::memcpy(ch, digits, std::size_t(point));
+                    ch[point] = '.';
+                    std::memcpy(ch + point + 1, digits + point, std::size_t(length - point));
+                }
+                else {
+                    *ch++ = '0';
+                    *ch++ = '.';
+                    std::memset(ch, '0', std::size_t(-point));
+                    std::memcpy(ch - point, digits, std::size_t(length));
+                    return std::size_t(fixedLength);
+                }
+                return std::size_t(fixedLength);
+            }
+
+            *ch++ = digits[0];
+            if (length > 1) {
+                *ch++ = '.';
+                std::memcpy(ch, digits + 1, std::size_t(length - 1));
+                ch += length - 1;
+            }
+            *ch++ = 'e';
+            *ch++ = exponent < 0 ? '-' : '+';
+            const auto absExponent = static_cast<std::uint64_t>(exponent < 0 ? -exponent : exponent);
+            writeDigits(ch + exponentDigits, absExponent);
+            if (exponentDigits == 2 && absExponent < 10) {
+                *ch = '0';
+            }
+            return std::size_t(ch + exponentDigits - out);
+        }
+
+#endif
+
+        /**************************************************************************************************/
+        //////////////////////////////////////////* Functions */////////////////////////////////////////////
+        /**************************************************************************************************/
+
+        std::size_t FastFormat::formatUnsigned(char * out, const std::uint64_t value) noexcept {
+            const auto length = countDigits(value);
+            writeDigits(out + length, value);
+            return length;
+        }
+
+        std::size_t FastFormat::formatSigned(char * out, const std::int64_t value) noexcept {
+            if (value >= 0) {
+                return formatUnsigned(out, static_cast<std::uint64_t>(value));
+            }
+            *out = '-';
+            // it is safe for the minimal value too
+            return formatUnsigned(out + 1, std::uint64_t(0) - static_cast<std::uint64_t>(value)) + 1;
+        }
+
+        std::size_t FastFormat::formatPointer(char * out, const void * value) noexcept {
+            static const char hex[] = "0123456789abcdef";
+            auto address = reinterpret_cast<std::uintptr_t>(value);
+            std::size_t length = 1;
+            for (auto v = address; v >= 16; v >>= 4) {
+                ++length;
+            }
+            out[0] = '0';
+            out[1] = 'x';
+            char * ch = out + 2 + length;
+            do {
+                *--ch = hex[address & 0xF];
+                address >>= 4;
+            } while (address);
+            return length + 2;
+        }
+
+        /**************************************************************************************************/
+        //////////////////////////////////////////* Functions */////////////////////////////////////////////
+        /**************************************************************************************************/
+
+#ifdef STSFF_LOGGER_USE_TO_CHARS
+
+        std::size_t FastFormat::formatDouble(char * out, const double value) noexcept {
+            if (value != value || value == std::numeric_limits<double>::infinity() ||
+                value == -std::numeric_limits<double>::infinity()) {
+                return writeSpecial(out, value);
+            }
+            return std::size_t(std::to_chars(out, out + MaxFloatChars, value).ptr - out);
+        }
+
+        std::size_t FastFormat::formatFloat(char * out, const float value) noexcept {
+            if (value != value || value == std::numeric_limits<float>::infinity() ||
+                value == -std::numeric_limits<float>::infinity()) {
+                return writeSpecial(out, double(value));
+            }
+            return std::size_t(std::to_chars(out, out + MaxFloatChars, value).ptr - out);
+        }
+
+#else
+
+        std::size_t FastFormat::formatDouble(char * out, const double value) noexcept {
+            std::uint64_t bits = 0;
+            std::memcpy(&bits, &value, sizeof(bits));
+            const std::uint64_t significandMask = (std::uint64_t(1) << 52) - 1;
+            const std::uint64_t hiddenBit = std::uint64_t(1) << 52;
+            const auto biasedExponent = static_cast<int>((bits >> 52) & 0x7FF);
+            const std::uint64_t significand = bits & significandMask;
+
+            if (biasedExponent == 0x7FF) {
+                return writeSpecial(out, value);
+            }
+            std::size_t length = 0;
+            if (bits >> 63) {
+                out[length++] = '-';
+            }
+            if (biasedExponent == 0 && significand == 0) {
+                out[length++] = '0';
+                return length;
+            }
+
+            char digits[24];
+            int digitsLength = 0;
+            int k = 0;
+            if (biasedExponent != 0) {
+                grisu2(significand | hiddenBit, biasedExponent - 1075, significand == 0 && biasedExponent > 1,
+                       digits, digitsLength, k);
+            }
+            else {
+                grisu2(significand, -1074, false, digits, digitsLength, k);
+            }
+            return length + prettify(out + length, digits, digitsLength, k);
+        }
+
+        std::size_t FastFormat::formatFloat(char * out, const float value) noexcept {
+            std::uint32_t bits = 0;
+            std::memcpy(&bits, &value, sizeof(bits));
+            const std::uint32_t significandMask = (std::uint32_t(1) << 23) - 1;
+            const std::uint32_t hiddenBit = std::uint32_t(1) << 23;
+            const auto biasedExponent = static_cast<int>((bits >> 23) & 0xFF);
+            const std::uint32_t significand = bits & significandMask;
+
+            if (biasedExponent == 0xFF) {
+                return writeSpecial(out, double(value));
+            }
+            std::size_t length = 0;
+            if (bits >> 31) {
+                out[length++] = '-';
+            }
+            if (biasedExponent == 0 && significand == 0) {
+                out[length++] = '0';
+                return length;
+            }
+
+            char digits[24];
+            int digitsLength = 0;
+            int k = 0;
+            if (biasedExponent != 0) {
+                grisu2(significand | hiddenBit, biasedExponent - 150, significand == 0 && biasedExponent > 1,
+                       digits, digitsLength, k);
+            }
+            else {
+                grisu2(significand, -149, false, digits, digitsLength, k);
+            }
+            return length + prettify(out + length, digits, digitsLength, k);
+        }
+
+#endif
+
+        /**************************************************************************************************/
+        ////////////////////////////////////////////////////////////////////////////////////////////////////
+        /**************************************************************************************************/
+
+    }
+}
+}
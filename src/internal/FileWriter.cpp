@@ -0,0 +1,100 @@
+/*
+**  Copyright(C) 2019, StepToSky and FlightFactor
+**  All rights reserved
+**
+**  Redistribution and use in source and binary forms, with or without
+**  modification, are permitted provided that the following conditions are met:
+**
+**  1.Redistributions of source code must retain the above copyright notice, this
+**    list of conditions and the following disclaimer.
+**  2.Redistributions in binary form must reproduce the above copyright notice,
+**    this list of conditions and the following disclaimer in the documentation
+**    and / or other materials provided with the distribution.
+**  3.The name of StepToSky or the name of FlightFactor or the names of its
+**    contributors may NOT be used to endorse or promote products derived from
+**    this software without specific prior written permission.
+**
+**  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+**  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+**  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+**  DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+**  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+**  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+**  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+**  ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+**  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+**  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**
+**  Contacts: www.steptosky.com or www.flightfactor.aero
+*/
+
+#include "stdafx.h"
+
+#include <cerrno>
+#include <cstring>
+#include "stsff/logging/internal/FileWriter.h"
+
+#if defined(_WIN32) || defined(_WIN64)
+#   include <io.h>
+#else
+#   include <unistd.h>
+#endif
+
+namespace stsff {
+namespace logging {
+    namespace internal {
+
+        /**************************************************************************************************/
+        //////////////////////////////////////////* Functions */////////////////////////////////////////////
+        /**************************************************************************************************/
+
+        std::size_t FileWriter::write(const int fd, const char * data, const std::size_t size) noexcept {
+            std::size_t done = 0;
+            while (done != size) {
+#if defined(_WIN32) || defined(_WIN64)
+                const int written = ::_write(fd, data + done, unsigned(size - done));
+#else
+                const ssize_t written = ::write(fd, data + done, size - done);
+                if (written < 0 && errno == EINTR) {
+                    continue;
+                }
+#endif
+                if (written <= 0) {
+                    reportWriteError(written < 0 ? errno : EIO);
+                    break;
+                }
+                done += std::size_t(written);
+            }
+            return done;
+        }
+
+        void FileWriter::reportWriteError(const int error) noexcept {
+            if (!mWriteFailed.exchange(true, std::memory_order_relaxed)) {
+                printError("can't write the log file", mFileName, error, __STS_FUNC_NAME__);
+            }
+        }
+
+        void FileWriter::printError(const char * what, const std::string & fileName, const int error,
+                                    const char * function) {
+            std::cerr << colorize::red << what << " \"" << fileName << "\": " << std::strerror(error)
+                    << " [" << function << "]" << colorize::reset << std::endl;
+        }
+
+        //-------------------------------------------------------------------------
+
+        const MessageBuffer & renderLine(const BaseLogger & logger, const BaseLogger::LogMsg & logMsg,
+                                         const FormatPattern & pattern) {
+            thread_local MessageBuffer buffer;
+            buffer.clear();
+            BaseLogger::renderMessage(buffer, logger, logMsg, pattern);
+            buffer.append('\n');
+            return buffer;
+        }
+
+        /**************************************************************************************************/
+        ////////////////////////////////////////////////////////////////////////////////////////////////////
+        /**************************************************************************************************/
+
+    }
+}
+}
@@ -0,0 +1,184 @@
+/*
+**  Copyright(C) 2019, StepToSky and FlightFactor
+**  All rights reserved
+**
+**  Redistribution and use in source and binary forms, with or without
+**  modification, are permitted provided that the following conditions are met:
+**
+**  1.Redistributions of source code must retain the above copyright notice, this
+**    list of conditions and the following disclaimer.
+**  2.Redistributions in binary form must reproduce the above copyright notice,
+**    this list of conditions and the following disclaimer in the documentation
+**    and / or other materials provided with the distribution.
+**  3.The name of StepToSky or the name of FlightFactor or the names of its
+**    contributors may NOT be used to endorse or promote products derived from
+**    this software without specific prior written permission.
+**
+**  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+**  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+**  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+**  DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+**  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+**  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+**  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+**  ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+**  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+**  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**
+**  Contacts: www.steptosky.com or www.flightfactor.aero
+*/
+
+#include "stdafx.h"
+
+#include <ostream>
+#include <streambuf>
+#include "stsff/logging/internal/MessageBuffer.h"
+
+namespace stsff {
+namespace logging {
+    namespace internal {
+
+        /**************************************************************************************************/
+        //////////////////////////////////////////* Functions */////////////////////////////////////////////
+        /**************************************************************************************************/
+
+        void MessageBuffer::grow(const std::size_t required) {
+            std::size_t capacity = mCapacity * 2;
+            if (capacity < required) {
+                capacity = required;
+            }
+            char * data = new char[capacity];
+            std::memcpy(data, mData, mSize);
+            if (!isInline()) {
+                delete[] mData;
+            }
+            mData = data;
+            mCapacity = capacity;
+        }
+
+        /**************************************************************************************************/
+        /////////////////////////////////////////* Static area *////////////////////////////////////////////
+        /**************************************************************************************************/
+
+        /*!
+         * \details Unbuffered stream buffer that writes into the \link MessageBuffer \endlink.
+         */
+        class MessageStreamBuf final : public std::streambuf {
+        public:
+
+            void setBuffer(MessageBuffer * buffer) noexcept {
+                mBuffer = buffer;
+            }
+
+        protected:
+
+            int_type overflow(const int_type ch) override {
+                if (!mBuffer) {
+                    return traits_type::eof();
+                }
+                if (!traits_type::eq_int_type(ch, traits_type::eof())) {
+                    mBuffer->append(traits_type::to_char_type(ch));
+                }
+                return traits_type::not_eof(ch);
+            }
+
+            std::streamsize xsputn(const char * data, const std::streamsize size) override {
+                if (!mBuffer) {
+                    return 0;
+                }
+                mBuffer->append(data, std::size_t(size));
+                return size;
+            }
+
+        private:
+
+            MessageBuffer * mBuffer = nullptr;
+
+        };
+
+        class MessageStream final {
+        public:
+
+            MessageStream()
+                : mStream(&mStreamBuf) {}
+
+            MessageStream(const MessageStream &) = delete;
+            MessageStream & operator=(const MessageStream &) = delete;
+
+            void attach(MessageBuffer & buffer) noexcept {
+                mStreamBuf.setBuffer(&buffer);
+                mStream.clear();
+                mStream.flags(std::ios_base::skipws | std::ios_base::dec);
+                mStream.precision(6);
+                mStream.width(0);
+                mStream.fill(' ');
+            }
+
+            void retarget(MessageBuffer & buffer) noexcept {
+                mStreamBuf.setBuffer(&buffer);
+            }
+
+            void detach() noexcept {
+                mStreamBuf.setBuffer(nullptr);
+            }
+
+            std::ostream & stream() noexcept {
+                return mStream;
+            }
+
+            bool mBorrowed = false;
+            bool mHeap = false;
+
+        private:
+
+            MessageStreamBuf mStreamBuf;
+            std::ostream mStream;
+
+        };
+
+        // The stream is reused by all messages of the thread.
+        // A new one is created only for a message that is written while
+        // another one of the same thread is using the stream (e.g. logging inside operator <<).
+        static thread_local MessageStream gThreadStream;
+
+        /**************************************************************************************************/
+        //////////////////////////////////////////* Functions */////////////////////////////////////////////
+        /**************************************************************************************************/
+
+        MessageStream * acquireMessageStream(MessageBuffer & buffer) {
+            MessageStream * stream = &gThreadStream;
+            if (stream->mBorrowed) {
+                stream = new MessageStream();
+                stream->mHeap = true;
+            }
+            stream->mBorrowed = true;
+            stream->attach(buffer);
+            return stream;
+        }
+
+        void releaseMessageStream(MessageStream * stream) noexcept {
+            if (!stream) {
+                return;
+            }
+            stream->detach();
+            stream->mBorrowed = false;
+            if (stream->mHeap) {
+                delete stream;
+            }
+        }
+
+        void retargetMessageStream(MessageStream * stream, MessageBuffer & buffer) noexcept {
+            stream->retarget(buffer);
+        }
+
+        std::ostream & messageOstream(MessageStream * stream) noexcept {
+            return stream->stream();
+        }
+
+        /**************************************************************************************************/
+        ////////////////////////////////////////////////////////////////////////////////////////////////////
+        /**************************************************************************************************/
+
+    }
+}
+}
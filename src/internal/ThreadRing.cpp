@@ -0,0 +1,186 @@
+/*
+**  Copyright(C) 2019, StepToSky and FlightFactor
+**  All rights reserved
+**
+**  Redistribution and use in source and binary forms, with or without
+**  modification, are permitted provided that the following conditions are met:
+**
+**  1.Redistributions of source code must retain the above copyright notice, this
+**    list of conditions and the following disclaimer.
+**  2.Redistributions in binary form must reproduce the above copyright notice,
+**    this list of conditions and the following disclaimer in the documentation
+**    and / or other materials provided with the distribution.
+**  3.The name of StepToSky or the name of FlightFactor or the names of its
+**    contributors may NOT be used to endorse or promote products derived from
+**    this software without specific prior written permission.
+**
+**  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+**  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+**  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+**  DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+**  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+**  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+**  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+**  ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+**  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+**  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**
+**  Contacts: www.steptosky.com or www.flightfactor.aero
+*/
+
+#include "stdafx.h"
+
+#include <algorithm>
+#include "stsff/logging/internal/ThreadRing.h"
+
+namespace stsff {
+namespace logging {
+    namespace internal {
+
+        /**************************************************************************************************/
+        /////////////////////////////////////////* Static area *////////////////////////////////////////////
+        /**************************************************************************************************/
+
+        /*!
+         * \details The rings of the thread, one for each \link ThreadRings \endlink the thread has written to.
+         *          The rings are abandoned when the thread exits.
+         */
+        class ThreadRingCache final {
+        public:
+
+            struct Entry {
+                std::uint64_t mOwner;
+                ThreadRings::RingPtr mRing;
+            };
+
+            ThreadRingCache() = default;
+            ThreadRingCache(const ThreadRingCache &) = delete;
+            ThreadRingCache & operator=(const ThreadRingCache &) = delete;
+
+            ~ThreadRingCache() noexcept {
+                for (auto & entry : mEntries) {
+                    entry.mRing->abandon();
+                }
+            }
+
+            std::vector<Entry> mEntries;
+            std::uint64_t mLastOwner = 0;
+            SpscRing * mLastRing = nullptr;
+
+        };
+
+        static thread_local ThreadRingCache gThreadRings;
+
+        // The ids are never reused so a stale thread's entry can't match a new owner at the same address.
+        static std::atomic<std::uint64_t> gNextRingsId{1};
+
+        static std::size_t roundUpPow2(const std::size_t value) noexcept {
+            std::size_t result = 64;
+            while (result < value) {
+                result <<= 1;
+            }
+            return result;
+        }
+
+        /**************************************************************************************************/
+        ////////////////////////////////////* Constructors/Destructor */////////////////////////////////////
+        /**************************************************************************************************/
+
+        SpscRing::SpscRing(const std::size_t capacity)
+            : mCapacity(roundUpPow2(capacity)),
+              mMask(mCapacity - 1) {
+            mData.reset(new char[mCapacity]);
+        }
+
+        //-------------------------------------------------------------------------
+
+        ThreadRings::ThreadRings(const std::size_t ringCapacity)
+            : mId(gNextRingsId.fetch_add(1, std::memory_order_relaxed)),
+              mRingCapacity(roundUpPow2(ringCapacity)) {}
+
+        ThreadRings::~ThreadRings() noexcept {
+            std::lock_guard<std::mutex> lock(mMutex);
+            for (auto & ring : mRings) {
+                ring->close();
+            }
+        }
+
+        /**************************************************************************************************/
+        //////////////////////////////////////////* Functions */////////////////////////////////////////////
+        /**************************************************************************************************/
+
+        SpscRing & ThreadRings::local() {
+            ThreadRingCache & cache = gThreadRings;
+            if (cache.mLastOwner == mId) {
+                return *cache.mLastRing;
+            }
+            for (auto & entry : cache.mEntries) {
+                if (entry.mOwner == mId) {
+                    cache.mLastOwner = mId;
+                    cache.mLastRing = entry.mRing.get();
+                    return *cache.mLastRing;
+                }
+            }
+            cache.mEntries.erase(std::remove_if(cache.mEntries.begin(), cache.mEntries.end(),
+                                                [](const ThreadRingCache::Entry & entry) {
+                                                    return entry.mRing->isClosed();
+                                                }), cache.mEntries.end());
+            RingPtr ring = std::make_shared<SpscRing>(mRingCapacity);
+            cache.mEntries.push_back(ThreadRingCache::Entry{mId, ring});
+            {
+                std::lock_guard<std::mutex> lock(mMutex);
+                mRings.push_back(ring);
+                mVersion.fetch_add(1, std::memory_order_release);
+            }
+            cache.mLastOwner = mId;
+            cache.mLastRing = ring.get();
+            return *ring;
+        }
+
+        //-------------------------------------------------------------------------
+
+        void ThreadRings::snapshot(std::vector<RingPtr> & rings, std::uint64_t & version) const {
+            if (mVersion.load(std::memory_order_acquire) == version) {
+                return;
+            }
+            std::lock_guard<std::mutex> lock(mMutex);
+            rings = mRings;
+            version = mVersion.load(std::memory_order_relaxed);
+        }
+
+        std::size_t ThreadRings::collect() noexcept {
+            std::lock_guard<std::mutex> lock(mMutex);
+            const auto end = std::remove_if(mRings.begin(), mRings.end(), [](const RingPtr & ring) {
+                return ring->isAbandoned() && ring->empty();
+            });
+            const auto removed = std::size_t(std::distance(end, mRings.end()));
+            if (removed != 0) {
+                mRings.erase(end, mRings.end());
+                mVersion.fetch_add(1, std::memory_order_release);
+            }
+            return removed;
+        }
+
+        std::size_t ThreadRings::size() const noexcept {
+            std::lock_guard<std::mutex> lock(mMutex);
+            return mRings.size();
+        }
+
+        std::size_t ThreadRings::records() const noexcept {
+            std::lock_guard<std::mutex> lock(mMutex);
+            std::size_t result = 0;
+            for (const auto & ring : mRings) {
+                const std::size_t consumed = ring->consumed();
+                const std::size_t committed = ring->committed();
+                result += committed > consumed ? committed - consumed : 0;
+            }
+            return result;
+        }
+
+        /**************************************************************************************************/
+        ////////////////////////////////////////////////////////////////////////////////////////////////////
+        /**************************************************************************************************/
+
+    }
+}
+}
@@ -68,8 +68,10 @@
 #   include <windows.h>
 #endif
 
+#include <atomic>
 #include <iostream>
 #include <cstdio>
+#include <cstring>
 
 namespace stsff {
 namespace logging {
@@ -91,11 +93,22 @@ namespace logging {
                 return stderr;
             }
             if (&stream == &std::clog) {
-                return stdout;
+                return stderr;
             }
             return nullptr;
         }
 
+        // The terminal state of stdout and stderr, it is checked once
+        // as the check is a system call. -1 means not checked yet.
+        static std::atomic<int> gAttyStdout{-1};
+        static std::atomic<int> gAttyStderr{-1};
+
+        inline bool queryAtty(FILE * stdStream) noexcept {
+            COLORIZE_ON_MACOS(return static_cast<bool>(::isatty(fileno(stdStream))));
+            COLORIZE_ON_LINUX(return static_cast<bool>(::isatty(fileno(stdStream))));
+            COLORIZE_ON_WINDOWS(return ::_isatty(_fileno(stdStream)) != 0;);
+        }
+
         //! Test whether a given `std::ostream` object refers to
         //! a terminal.
         inline bool isAtty(const std::ostream & stream) noexcept {
@@ -108,16 +121,25 @@ namespace logging {
             if (!stdStream) {
                 return false;
             }
-            COLORIZE_ON_MACOS(return static_cast<bool>(::isatty(fileno(stdStream))));
-            COLORIZE_ON_LINUX(return static_cast<bool>(::isatty(fileno(stdStream))));
-            COLORIZE_ON_WINDOWS(return ::_isatty(_fileno(stdStream)) != 0;);
+            std::atomic<int> & cached = stdStream == stdout ? gAttyStdout : gAttyStderr;
+            int state = cached.load(std::memory_order_relaxed);
+            if (state < 0) {
+                state = queryAtty(stdStream) ? 1 : 0;
+                cached.store(state, std::memory_order_relaxed);
+            }
+            return state != 0;
         }
 
         // Say whether a given stream should be colorized or not. It's always
         // true for ATTY streams and may be true for streams marked with
         // colorize flag.
-        inline bool isColorized(std::ostream & stream) noexcept {
-            return isAtty(stream) || stream.iword(gColorizeIndex) != 0;
+        bool isColorized(std::ostream & stream) noexcept {
+            return stream.iword(gColorizeIndex) != 0 || isAtty(stream);
+        }
+
+        void refreshTerminals() noexcept {
+            gAttyStdout.store(-1, std::memory_order_relaxed);
+            gAttyStderr.store(-1, std::memory_order_relaxed);
         }
 
         /**************************************************************************************************/
@@ -147,7 +169,7 @@ namespace logging {
                 hTerminal = GetStdHandle(STD_ERROR_HANDLE);
             }
             else if (&stream == &std::clog) {
-                hTerminal = GetStdHandle(STD_OUTPUT_HANDLE);
+                hTerminal = GetStdHandle(STD_ERROR_HANDLE);
             }
 
             // save default terminal attributes if it unsaved
@@ -501,6 +523,86 @@ namespace logging {
         ////////////////////////////////////////////////////////////////////////////////////////////////////
         /**************************************************************************************************/
 
+        std::ostream & colorized(std::ostream & stream) noexcept {
+            stream.iword(gColorizeIndex) = 1;
+            return stream;
+        }
+
+        std::ostream & nocolorized(std::ostream & stream) noexcept {
+            stream.iword(gColorizeIndex) = 0;
+            return stream;
+        }
+
+        /**************************************************************************************************/
+        ////////////////////////////////////////////////////////////////////////////////////////////////////
+        /**************************************************************************************************/
+
+        namespace {
+
+            struct Escape {
+                Manipulator mManipulator;
+                StringView mSequence;
+            };
+
+            const Escape gEscapes[] = {
+                {grey, AnsiGrey}, {red, AnsiRed}, {green, AnsiGreen}, {blue, AnsiBlue},
+                {yellow, AnsiYellow}, {magenta, AnsiMagenta}, {cyan, AnsiCyan}, {white, AnsiWhite},
+                {onGrey, AnsiOnGrey}, {onRed, AnsiOnRed}, {onGreen, AnsiOnGreen}, {onBlue, AnsiOnBlue},
+                {onYellow, AnsiOnYellow}, {onMagenta, AnsiOnMagenta}, {onCyan, AnsiOnCyan}, {onWhite, AnsiOnWhite},
+                {darkGrey, AnsiGrey}, {darkRed, AnsiRed}, {darkGreen, AnsiGreen}, {darkBlue, AnsiBlue},
+                {darkYellow, AnsiYellow}, {darkMagenta, AnsiMagenta}, {darkCyan, AnsiCyan},
+                {onDarkGrey, AnsiOnGrey}, {onDarkRed, AnsiOnRed}, {onDarkGreen, AnsiOnGreen}, {onDarkBlue, AnsiOnBlue},
+                {onDarkYellow, AnsiOnYellow}, {onDarkMagenta, AnsiOnMagenta}, {onDarkCyan, AnsiOnCyan}, {onDarkWhite, AnsiOnWhite},
+                {reset, AnsiReset},
+            };
+
+        }
+
+        StringView escapeSequence(const Manipulator manipulator) noexcept {
+            for (const auto & escape : gEscapes) {
+                if (escape.mManipulator == manipulator) {
+                    return escape.mSequence;
+                }
+            }
+            return StringView();
+        }
+
+        std::size_t stripAnsi(const char * text, const std::size_t size, char * out) noexcept {
+            const char * end = text + size;
+            char * outBegin = out;
+            while (text < end) {
+                // the plain text is copied in chunks up to the next escape character.
+                const char * escape = static_cast<const char *>(std::memchr(text, '\033', std::size_t(end - text)));
+                const char * chunkEnd = escape ? escape : end;
+                if (out != text) {
+                    std::memmove(out, text, std::size_t(chunkEnd - text));
+                }
+                out += chunkEnd - text;
+                if (!escape) {
+                    break;
+                }
+                text = escape + 1;
+                if (text < end && *text == '[') {
+                    // control sequence: parameter and intermediate bytes, then the final byte.
+                    ++text;
+                    while (text < end && *text >= 0x20 && *text <= 0x3F) {
+                        ++text;
+                    }
+                    if (text < end && *text >= 0x40 && *text <= 0x7E) {
+                        ++text;
+                    }
+                }
+                else if (text < end) {
+                    ++text;
+                }
+            }
+            return std::size_t(out - outBegin);
+        }
+
+        /**************************************************************************************************/
+        ////////////////////////////////////////////////////////////////////////////////////////////////////
+        /**************************************************************************************************/
+
     }
 }
 }
@@ -0,0 +1,239 @@
+/*
+**  Copyright(C) 2019, StepToSky and FlightFactor
+**  All rights reserved
+**
+**  Redistribution and use in source and binary forms, with or without
+**  modification, are permitted provided that the following conditions are met:
+**
+**  1.Redistributions of source code must retain the above copyright notice, this
+**    list of conditions and the following disclaimer.
+**  2.Redistributions in binary form must reproduce the above copyright notice,
+**    this list of conditions and the following disclaimer in the documentation
+**    and / or other materials provided with the distribution.
+**  3.The name of StepToSky or the name of FlightFactor or the names of its
+**    contributors may NOT be used to endorse or promote products derived from
+**    this software without specific prior written permission.
+**
+**  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+**  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+**  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+**  DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+**  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+**  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+**  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+**  ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+**  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+**  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**
+**  Contacts: www.steptosky.com or www.flightfactor.aero
+*/
+
+#include "stdafx.h"
+
+#include <cstring>
+#include <vector>
+#include "stsff/logging/utils/LzCodec.h"
+
+namespace stsff {
+namespace logging {
+
+    /**************************************************************************************************/
+    /////////////////////////////////////////* Static area *////////////////////////////////////////////
+    /**************************************************************************************************/
+
+    namespace {
+
+        const char Magic[4] = {'S', 'L', 'Z', '1'};
+        const std::size_t MinMatch = 4;
+        const std::size_t MaxOffset = 65535;
+        const unsigned HashBits = 12;
+
+        inline std::uint32_t read32(const unsigned char * data) noexcept {
+            std::uint32_t value;
+            std::memcpy(&value, data, sizeof value);
+            return value;
+        }
+
+        inline std::uint32_t hash(const std::uint32_t value) noexcept {
+            return (value * 2654435761u) >> (32 - HashBits);
+        }
+
+        void writeLe32(std::string & out, const std::uint32_t value) {
+            const char bytes[4] = {
+                char(value & 0xFF), char((value >> 8) & 0xFF), char((value >> 16) & 0xFF), char((value >> 24) & 0xFF),
+            };
+            out.append(bytes, sizeof bytes);
+        }
+
+        std::uint32_t readLe32(const unsigned char * data) noexcept {
+            return std::uint32_t(data[0]) | (std::uint32_t(data[1]) << 8) |
+                   (std::uint32_t(data[2]) << 16) | (std::uint32_t(data[3]) << 24);
+        }
+
+        void writeLength(std::string & out, std::size_t length) {
+            while (length >= 255) {
+                out.push_back(char(255));
+                length -= 255;
+            }
+            out.push_back(char(length));
+        }
+
+        void writeSequence(std::string & out, const unsigned char * literals, const std::size_t literalsSize,
+                           const std::size_t offset, const std::size_t matchSize) {
+            const std::size_t matchCode = matchSize ? matchSize - MinMatch : 0;
+            const unsigned token = unsigned(literalsSize < 15 ? literalsSize : 15) << 4 |
+                                   unsigned(matchCode < 15 ? matchCode : 15);
+            out.push_back(char(token));
+            if (literalsSize >= 15) {
+                writeLength(out, literalsSize - 15);
+            }
+            out.append(reinterpret_cast<const char *>(literals), literalsSize);
+            if (matchSize) {
+                out.push_back(char(offset & 0xFF));
+                out.push_back(char(offset >> 8));
+                if (matchCode >= 15) {
+                    writeLength(out, matchCode - 15);
+                }
+            }
+        }
+
+        void compressBlock(const unsigned char * data, const std::size_t size, std::string & out) {
+            // positions + 1, so 0 means no position.
+            std::vector<std::uint32_t> table(std::size_t(1) << HashBits, 0);
+            std::size_t anchor = 0;
+            std::size_t i = 0;
+            while (i + MinMatch <= size) {
+                const std::uint32_t value = read32(data + i);
+                std::uint32_t & slot = table[hash(value)];
+                const std::size_t candidate = slot;
+                slot = std::uint32_t(i + 1);
+                if (candidate != 0 && i - (candidate - 1) <= MaxOffset && read32(data + candidate - 1) == value) {
+                    const std::size_t reference = candidate - 1;
+                    std::size_t matchSize = MinMatch;
+                    while (i + matchSize < size && data[reference + matchSize] == data[i + matchSize]) {
+                        ++matchSize;
+                    }
+                    writeSequence(out, data + anchor, i - anchor, i - reference, matchSize);
+                    i += matchSize;
+                    anchor = i;
+                }
+                else {
+                    ++i;
+                }
+            }
+            writeSequence(out, data + anchor, size - anchor, 0, 0);
+        }
+
+        bool readLength(const unsigned char *& in, const unsigned char * end, std::size_t & length) noexcept {
+            unsigned char byte;
+            do {
+                if (in >= end) {
+                    return false;
+                }
+                byte = *in++;
+                length += byte;
+            } while (byte == 255);
+            return true;
+        }
+
+        bool decompressBlock(const unsigned char * in, const unsigned char * end, char * out, const std::size_t size) noexcept {
+            std::size_t position = 0;
+            while (in < end) {
+                const unsigned token = *in++;
+                std::size_t literalsSize = token >> 4;
+                if (literalsSize == 15 && !readLength(in, end, literalsSize)) {
+                    return false;
+                }
+                if (literalsSize > std::size_t(end - in) || literalsSize > size - position) {
+                    return false;
+                }
+                std::memcpy(out + position, in, literalsSize);
+                in += literalsSize;
+                position += literalsSize;
+                if (in == end) {
+                    break;
+                }
+                if (end - in < 2) {
+                    return false;
+                }
+                const std::size_t offset = std::size_t(in[0]) | (std::size_t(in[1]) << 8);
+                in += 2;
+                std::size_t matchSize = token & 0x0F;
+                if (matchSize == 15 && !readLength(in, end, matchSize)) {
+                    return false;
+                }
+                matchSize += MinMatch;
+                if (offset == 0 || offset > position || matchSize > size - position) {
+                    return false;
+                }
+                // the match may overlap the output, so it is copied byte by byte.
+                const char * from = out + position - offset;
+                for (std::size_t i = 0; i < matchSize; ++i) {
+                    out[position + i] = from[i];
+                }
+                position += matchSize;
+            }
+            return position == size;
+        }
+
+    }
+
+    /**************************************************************************************************/
+    //////////////////////////////////////////* Functions */////////////////////////////////////////////
+    /**************************************************************************************************/
+
+    void LzCodec::compress(const char * data, const std::size_t size, std::string & out) {
+        out.append(Magic, sizeof Magic);
+        const unsigned char * bytes = reinterpret_cast<const unsigned char *>(data);
+        for (std::size_t offset = 0; offset < size; offset += BlockSize) {
+            const std::size_t blockSize = size - offset < BlockSize ? size - offset : BlockSize;
+            const std::size_t header = out.size();
+            writeLe32(out, std::uint32_t(blockSize));
+            writeLe32(out, 0);
+            compressBlock(bytes + offset, blockSize, out);
+            const std::uint32_t compressedSize = std::uint32_t(out.size() - header - 8);
+            for (unsigned i = 0; i < 4; ++i) {
+                out[header + 4 + i] = char((compressedSize >> (8 * i)) & 0xFF);
+            }
+        }
+    }
+
+    bool LzCodec::decompress(const char * data, const std::size_t size, std::string & out) {
+        const unsigned char * in = reinterpret_cast<const unsigned char *>(data);
+        const unsigned char * end = in + size;
+        if (size < sizeof Magic || std::memcmp(in, Magic, sizeof Magic) != 0) {
+            return false;
+        }
+        in += sizeof Magic;
+        while (in < end) {
+            // the concatenated streams are decompressed as one.
+            if (std::size_t(end - in) >= sizeof Magic && std::memcmp(in, Magic, sizeof Magic) == 0) {
+                in += sizeof Magic;
+                continue;
+            }
+            if (end - in < 8) {
+                return false;
+            }
+            const std::size_t blockSize = readLe32(in);
+            const std::size_t compressedSize = readLe32(in + 4);
+            in += 8;
+            if (blockSize > BlockSize || compressedSize > std::size_t(end - in)) {
+                return false;
+            }
+            const std::size_t position = out.size();
+            out.resize(position + blockSize);
+            if (!decompressBlock(in, in + compressedSize, &out[0] + position, blockSize)) {
+                out.resize(position);
+                return false;
+            }
+            in += compressedSize;
+        }
+        return true;
+    }
+
+    /**************************************************************************************************/
+    ////////////////////////////////////////////////////////////////////////////////////////////////////
+    /**************************************************************************************************/
+
+}
+}
@@ -0,0 +1,288 @@
+/*
+**  Copyright(C) 2019, StepToSky and FlightFactor
+**  All rights reserved
+**
+**  Redistribution and use in source and binary forms, with or without
+**  modification, are permitted provided that the following conditions are met:
+**
+**  1.Redistributions of source code must retain the above copyright notice, this
+**    list of conditions and the following disclaimer.
+**  2.Redistributions in binary form must reproduce the above copyright notice,
+**    this list of conditions and the following disclaimer in the documentation
+**    and / or other materials provided with the distribution.
+**  3.The name of StepToSky or the name of FlightFactor or the names of its
+**    contributors may NOT be used to endorse or promote products derived from
+**    this software without specific prior written permission.
+**
+**  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+**  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+**  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+**  DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+**  ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+**  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+**  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+**  ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+**  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+**  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**
+**  Contacts: www.steptosky.com or www.flightfactor.aero
+*/
+
+#include "stdafx.h"
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#ifdef __linux__
+#   include <time.h>
+#endif
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#   define STSFF_LOGGING_HAS_TSC
+#   ifdef _MSC_VER
+#       include <intrin.h>
+#   else
+#       include <cpuid.h>
+#       include <x86intrin.h>
+#   endif
+#endif
+#include "stsff/logging/utils/TimeSource.h"
+
+namespace stsff {
+namespace logging {
+
+    /**************************************************************************************************/
+    ////////////////////////////////////////////////////////////////////////////////////////////////////
+    /**************************************************************************************************/
+
+    namespace {
+
+        std::atomic<int> gClock(TimeSource::ClockSystem);
+
+        std::int64_t systemNow() noexcept {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::system_clock::now().time_since_epoch()).count();
+        }
+
+#ifdef STSFF_LOGGING_HAS_TSC
+
+        std::int64_t readTsc() noexcept {
+            return std::int64_t(__rdtsc());
+        }
+
+        bool hasInvariantTsc() noexcept {
+            // CPUID.80000007H:EDX[8]
+#ifdef _MSC_VER
+            int regs[4] = {0};
+            __cpuid(regs, int(0x80000000));
+            if (unsigned(regs[0]) < 0x80000007u) {
+                return false;
+            }
+            __cpuid(regs, int(0x80000007));
+            return (unsigned(regs[3]) & (1u << 8)) != 0;
+#else
+            unsigned a = 0, b = 0, c = 0, d = 0;
+            if (!__get_cpuid(0x80000000, &a, &b, &c, &d) || a < 0x80000007u) {
+                return false;
+            }
+            __get_cpuid(0x80000007, &a, &b, &c, &d);
+            return (d & (1u << 8)) != 0;
+#endif
+        }
+
+#else
+
+        std::int64_t readTsc() noexcept {
+            return 0;
+        }
+
+        bool hasInvariantTsc() noexcept {
+            return false;
+        }
+
+#endif
+
+        /*!
+         * \details Conversion of the timestamp counter ticks to the wall clock time:
+         *          nanoseconds = base nanoseconds + (ticks - base ticks) * ratio.
+         * \details The readers use it without locking (seqlock),
+         *          the base is moved forward once per \link TscCalibration::Interval \endlink
+         *          by the thread that converts the ticks after it.
+         */
+        class TscCalibration {
+        public:
+
+            /*!
+             * \details Time that is waited for the first ratio.
+             */
+            static const std::int64_t InitialInterval = 10 * 1000 * 1000;
+
+            /*!
+             * \details Time after that the base is moved and the ratio is updated.
+             */
+            static const std::int64_t Interval = 1000 * 1000 * 1000;
+
+            static TscCalibration & instance() {
+                static TscCalibration calibration;
+                return calibration;
+            }
+
+            std::int64_t toNanoseconds(const std::int64_t ticks) noexcept {
+                std::int64_t baseTicks;
+                std::int64_t baseNanoseconds;
+                double ratio;
+                read(baseTicks, baseNanoseconds, ratio);
+                const std::int64_t nanoseconds = baseNanoseconds + std::int64_t(double(ticks - baseTicks) * ratio);
+                if (nanoseconds - baseNanoseconds > Interval) {
+                    recalibrate(ticks);
+                }
+                return nanoseconds;
+            }
+
+        private:
+
+            TscCalibration() {
+                std::int64_t ticks;
+                std::int64_t nanoseconds;
+                sample(ticks, nanoseconds);
+                std::int64_t endTicks;
+                std::int64_t endNanoseconds;
+                do {
+                    std::this_thread::yield();
+                    sample(endTicks, endNanoseconds);
+                } while (endNanoseconds - nanoseconds < InitialInterval);
+                write(endTicks, endNanoseconds, double(endNanoseconds - nanoseconds) / double(endTicks - ticks));
+            }
+
+            static void sample(std::int64_t & ticks, std::int64_t & nanoseconds) noexcept {
+                const std::int64_t before = readTsc();
+                nanoseconds = systemNow();
+                const std::int64_t after = readTsc();
+                ticks = before + (after - before) / 2;
+            }
+
+            void recalibrate(const std::int64_t ticks) noexcept {
+                std::unique_lock<std::mutex> lock(mMutex, std::try_to_lock);
+                if (!lock.owns_lock() || ticks <= mTicks.load(std::memory_order_relaxed)) {
+                    return;
+                }
+                std::int64_t baseTicks;
+                std::int64_t baseNanoseconds;
+                double ratio;
+                read(baseTicks, baseNanoseconds, ratio);
+                std::int64_t newTicks;
+                std::int64_t newNanoseconds;
+                sample(newTicks, newNanoseconds);
+                if (newTicks <= baseTicks) {
+                    return;
+                }
+                const double newRatio = double(newNanoseconds - baseNanoseconds) / double(newTicks - baseTicks);
+                // a big difference means that the wall clock was set, the base follows it but the ratio is kept.
+                if (newRatio > ratio * 0.99 && newRatio < ratio * 1.01) {
+                    ratio = newRatio;
+                }
+                write(newTicks, newNanoseconds, ratio);
+            }
+
+            void read(std::int64_t & ticks, std::int64_t & nanoseconds, double & ratio) const noexcept {
+                for (;;) {
+                    const std::uint32_t sequence = mSequence.load(std::memory_order_acquire);
+                    ticks = mTicks.load(std::memory_order_relaxed);
+                    nanoseconds = mNanoseconds.load(std::memory_order_relaxed);
+                    ratio = mRatio.load(std::memory_order_relaxed);
+                    std::atomic_thread_fence(std::memory_order_acquire);
+                    if ((sequence & 1) == 0 && mSequence.load(std::memory_order_relaxed) == sequence) {
+                        return;
+                    }
+                    std::this_thread::yield();
+                }
+            }
+
+            void write(const std::int64_t ticks, const std::int64_t nanoseconds, const double ratio) noexcept {
+                const std::uint32_t sequence = mSequence.load(std::memory_order_relaxed);
+                mSequence.store(sequence + 1, std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_release);
+                mTicks.store(ticks, std::memory_order_relaxed);
+                mNanoseconds.store(nanoseconds, std::memory_order_relaxed);
+                mRatio.store(ratio, std::memory_order_relaxed);
+                mSequence.store(sequence + 2, std::memory_order_release);
+            }
+
+            std::mutex mMutex;
+            std::atomic<std::uint32_t> mSequence{0};
+            std::atomic<std::int64_t> mTicks{0};
+            std::atomic<std::int64_t> mNanoseconds{0};
+            std::atomic<double> mRatio{0.0};
+
+        };
+
+        const std::int64_t TscCalibration::InitialInterval;
+        const std::int64_t TscCalibration::Interval;
+
+    }
+
+    /**************************************************************************************************/
+    //////////////////////////////////////////* Functions */////////////////////////////////////////////
+    /**************************************************************************************************/
+
+    void TimeSource::setClock(const eClock clock) noexcept {
+        if (clock == ClockTsc && isTscAvailable()) {
+            // the first calibration takes several milliseconds, it is better to make it here than with a message.
+            TscCalibration::instance();
+        }
+        gClock.store(clock, std::memory_order_relaxed);
+    }
+
+    TimeSource::eClock TimeSource::clock() noexcept {
+        return eClock(gClock.load(std::memory_order_relaxed));
+    }
+
+    std::int64_t TimeSource::now() noexcept {
+        return now(clock());
+    }
+
+    std::int64_t TimeSource::now(const eClock clock) noexcept {
+        switch (clock) {
+            case ClockCoarse: {
+#if defined(__linux__) && defined(CLOCK_REALTIME_COARSE)
+                timespec time;
+                if (clock_gettime(CLOCK_REALTIME_COARSE, &time) == 0) {
+                    return std::int64_t(time.tv_sec) * 1000000000 + std::int64_t(time.tv_nsec);
+                }
+#endif
+                break;
+            }
+            case ClockTsc: {
+                if (isTscAvailable()) {
+                    return TscCalibration::instance().toNanoseconds(readTsc());
+                }
+                break;
+            }
+            case ClockSystem: break;
+        }
+        return systemNow();
+    }
+
+    TimeSource::Stamp TimeSource::capture() noexcept {
+        const eClock current = clock();
+        if (current == ClockTsc && isTscAvailable()) {
+            return Stamp{readTsc(), true};
+        }
+        return Stamp{now(current), false};
+    }
+
+    std::int64_t TimeSource::toNanoseconds(const Stamp & stamp) noexcept {
+        return stamp.mTicks ? TscCalibration::instance().toNanoseconds(stamp.mValue) : stamp.mValue;
+    }
+
+    bool TimeSource::isTscAvailable() noexcept {
+        static const bool available = hasInvariantTsc();
+        return available;
+    }
+
+    /**************************************************************************************************/
+    ////////////////////////////////////////////////////////////////////////////////////////////////////
+    /**************************************************************************************************/
+
+}
+}